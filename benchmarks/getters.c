@@ -0,0 +1,111 @@
+/*
+ * gpte - GObject bindings for public-transport-enabler
+ * Copyright (C) 2024  Florian "sp1rit" <sp1rit@disroot.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Latency of the first getter call on a location, which is the one that
+// goes through JNI. The lookup rows repeat the same field access with
+// FindClass/GetFieldID on every call, like the getters did before the
+// IDs were resolved once per GpteJvm.
+
+#include <gptelocation.h>
+#include <gptejavaobject-priv.h>
+
+#define N_LOCATIONS 20000
+
+typedef void (*GetterFunc)(GpteJvm* vm, GpteLocation* location);
+
+static void get_name(GpteJvm*, GpteLocation* location) {
+	gpte_location_get_name(location);
+}
+
+static void get_coords(GpteJvm*, GpteLocation* location) {
+	gpte_location_get_coords(location);
+}
+
+static void get_location_type(GpteJvm*, GpteLocation* location) {
+	gpte_location_get_location_type(location);
+}
+
+static void lookup_name(GpteJvm* vm, GpteLocation* location) {
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Location");
+	jfieldID field = (*env)->GetFieldID(env, class, "name", "Ljava/lang/String;");
+	jstring name = (*env)->GetObjectField(env, gpte_java_object_get(GPTE_JAVA_OBJECT(location)), field);
+	const gchar* utf8 = (*env)->GetStringUTFChars(env, name, NULL);
+	(*env)->ReleaseStringUTFChars(env, name, utf8);
+}
+
+static void lookup_coords(GpteJvm* vm, GpteLocation* location) {
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Location");
+	jfieldID field = (*env)->GetFieldID(env, class, "coord", "Lde/schildbach/pte/dto/Point;");
+	jobject point = (*env)->GetObjectField(env, gpte_java_object_get(GPTE_JAVA_OBJECT(location)), field);
+	jclass point_class = (*env)->FindClass(env, "de/schildbach/pte/dto/Point");
+	(*env)->CallDoubleMethod(env, point, (*env)->GetMethodID(env, point_class, "getLatAsDouble", "()D"));
+	(*env)->CallDoubleMethod(env, point, (*env)->GetMethodID(env, point_class, "getLonAsDouble", "()D"));
+}
+
+static GpteLocation** create_locations(GpteJvm* vm) {
+	GpteLocation** locations = g_new(GpteLocation*, N_LOCATIONS);
+	for (gsize i = 0; i < N_LOCATIONS; i++) {
+		g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 4);
+		jobject point = (*env)->CallStaticObjectMethod(env, vm->jni.point.class, vm->jni.point.from_double, 52.5 + i * 1e-6, 13.4);
+		g_autofree gchar* id = g_strdup_printf("%zu", i);
+		jobject object = (*env)->NewObject(env, vm->jni.location.class, vm->jni.location.init,
+			vm->jni.location_type.constants[GPTE_LOCATION_STATION], (*env)->NewStringUTF(env, id), point,
+			(*env)->NewStringUTF(env, "Berlin"), (*env)->NewStringUTF(env, "Hauptbahnhof"), NULL);
+		locations[i] = g_object_new(GPTE_TYPE_LOCATION, "vm", vm, "object", object, NULL);
+	}
+	return locations;
+}
+
+static void free_locations(GpteLocation** locations) {
+	for (gsize i = 0; i < N_LOCATIONS; i++)
+		g_object_unref(locations[i]);
+	g_free(locations);
+}
+
+// every getter gets fresh locations, as they cache the first result
+static void run(GpteJvm* vm, const gchar* name, GetterFunc getter) {
+	GpteLocation** locations = create_locations(vm);
+	gint64 started = g_get_monotonic_time();
+	for (gsize i = 0; i < N_LOCATIONS; i++)
+		getter(vm, locations[i]);
+	gint64 elapsed = g_get_monotonic_time() - started;
+	free_locations(locations);
+	g_print("%-24s %8.0f ns/call\n", name, elapsed * 1000.0 / N_LOCATIONS);
+}
+
+int main(void) {
+	g_autoptr(GError) err = NULL;
+	g_autoptr(GpteJvm) vm = gpte_jvm_create(&err);
+	if (!vm) {
+		g_printerr("Unable to create the JVM: %s\n", err->message);
+		return 1;
+	}
+
+	// let the JIT settle before measuring anything
+	run(vm, "warmup", get_name);
+	run(vm, "warmup", lookup_name);
+
+	run(vm, "get_name", get_name);
+	run(vm, "get_name (lookup)", lookup_name);
+	run(vm, "get_coords", get_coords);
+	run(vm, "get_coords (lookup)", lookup_coords);
+	run(vm, "get_location_type", get_location_type);
+	return 0;
+}
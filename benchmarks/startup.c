@@ -0,0 +1,153 @@
+/*
+ * gpte - GObject bindings for public-transport-enabler
+ * Copyright (C) 2024  Florian "sp1rit" <sp1rit@disroot.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Time to create the JVM and to complete the first provider call. A
+// process can only create one JVM, so every sample is a child process of
+// its own. Cold samples start with an empty cache dir, warm ones reuse
+// the jar copy and class data sharing archive a previous child left
+// behind. The first call doesn't touch the network, so the numbers don't
+// depend on it.
+//
+// Without a usable cache dir the jar is exposed through a memfd instead,
+// which the memfd samples force. Builds with -Dinstalled_jar=true load
+// the installed jar in the cold and warm samples as long as it exists.
+
+#include <gpteproviders.h>
+
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_RUNS 5
+
+typedef enum {
+	STARTUP_COLD,
+	STARTUP_WARM,
+	STARTUP_MEMFD
+} StartupMode;
+
+typedef struct {
+	gdouble create_ms;
+	gdouble first_call_ms;
+	gdouble rss_kb;
+} StartupSample;
+
+// resident set size in kB, as reported by the kernel
+static glong rss(void) {
+	g_autofree gchar* status = NULL;
+	if (!g_file_get_contents("/proc/self/status", &status, NULL, NULL))
+		return -1;
+	const gchar* rss = strstr(status, "VmRSS:");
+	return rss ? strtol(rss + strlen("VmRSS:"), NULL, 10) : -1;
+}
+
+static int child(void) {
+	gint64 started = g_get_monotonic_time();
+	g_autoptr(GError) err = NULL;
+	g_autoptr(GpteJvm) vm = gpte_jvm_create(&err);
+	if (!vm) {
+		g_printerr("Unable to create the JVM: %s\n", err->message);
+		return 1;
+	}
+	gint64 created = g_get_monotonic_time();
+
+	g_autoptr(GpteProvider) provider = gpte_provider_registry_create(vm, "vvs", NULL, &err);
+	if (!provider) {
+		g_printerr("Unable to create the provider: %s\n", err->message);
+		return 1;
+	}
+	gpte_provider_default_products(provider);
+	gint64 first_call = g_get_monotonic_time();
+
+	g_print("%" G_GINT64_FORMAT " %" G_GINT64_FORMAT " %ld\n", created - started, first_call - started, rss());
+	return 0;
+}
+
+static void remove_dir(const gchar* path) {
+	g_autoptr(GDir) dir = g_dir_open(path, 0, NULL);
+	const gchar* name;
+	while (dir && (name = g_dir_read_name(dir))) {
+		g_autofree gchar* child = g_build_filename(path, name, NULL);
+		if (g_file_test(child, G_FILE_TEST_IS_DIR) && !g_file_test(child, G_FILE_TEST_IS_SYMLINK))
+			remove_dir(child);
+		else
+			g_unlink(child);
+	}
+	g_rmdir(path);
+}
+
+static gboolean sample(const gchar* self, const gchar* cache_dir, StartupSample* total) {
+	g_auto(GStrv) envp = g_environ_setenv(g_get_environ(), "XDG_CACHE_HOME", cache_dir, TRUE);
+	const gchar* argv[] = { self, "--child", NULL };
+	g_autofree gchar* out = NULL;
+	gint status;
+	g_autoptr(GError) err = NULL;
+	if (!g_spawn_sync(NULL, (gchar**)argv, envp, G_SPAWN_DEFAULT, NULL, NULL, &out, NULL, &status, &err)) {
+		g_printerr("Unable to spawn %s: %s\n", self, err->message);
+		return FALSE;
+	}
+	gint64 create, first_call;
+	glong rss_kb;
+	if (!g_spawn_check_wait_status(status, NULL) || sscanf(out, "%" G_GINT64_FORMAT " %" G_GINT64_FORMAT " %ld", &create, &first_call, &rss_kb) != 3)
+		return FALSE;
+	total->create_ms += create / 1000.0;
+	total->first_call_ms += first_call / 1000.0;
+	total->rss_kb += rss_kb;
+	return TRUE;
+}
+
+static gboolean run(const gchar* self, const gchar* name, StartupMode mode) {
+	StartupSample total = { 0 };
+	for (guint i = 0; i < N_RUNS; i++) {
+		g_autoptr(GError) err = NULL;
+		g_autofree gchar* tmp = g_dir_make_tmp("gpte-bench-XXXXXX", &err);
+		if (!tmp) {
+			g_printerr("Unable to create a cache dir: %s\n", err->message);
+			return FALSE;
+		}
+		g_autofree gchar* cache_dir = g_strdup(tmp);
+		// a regular file can't be turned into the cache dir
+		if (mode == STARTUP_MEMFD) {
+			g_free(cache_dir);
+			cache_dir = g_build_filename(tmp, "file", NULL);
+			g_file_set_contents(cache_dir, "", 0, NULL);
+		}
+
+		// populates the cache dir and the archive
+		StartupSample ignored = { 0 };
+		gboolean ok = mode != STARTUP_WARM || sample(self, cache_dir, &ignored);
+		ok = ok && sample(self, cache_dir, &total);
+
+		remove_dir(tmp);
+		if (!ok)
+			return FALSE;
+	}
+	g_print("%-8s create %8.1f ms  first call %8.1f ms  RSS %8.0f kB\n", name,
+		total.create_ms / N_RUNS, total.first_call_ms / N_RUNS, total.rss_kb / N_RUNS);
+	return TRUE;
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1 && g_str_equal(argv[1], "--child"))
+		return child();
+
+	if (!run(argv[0], "cold", STARTUP_COLD) || !run(argv[0], "warm", STARTUP_WARM) || !run(argv[0], "memfd", STARTUP_MEMFD))
+		return 1;
+	return 0;
+}
@@ -0,0 +1,150 @@
+import java.io.File;
+import java.lang.reflect.Constructor;
+import java.lang.reflect.Method;
+import java.lang.reflect.Modifier;
+import java.net.URL;
+import java.net.URLClassLoader;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.Enumeration;
+import java.util.List;
+import java.util.Locale;
+import java.util.TreeSet;
+import java.util.jar.JarEntry;
+import java.util.jar.JarFile;
+
+/*
+ * Writes the areas of all providers in the given jar as a C header, so
+ * they can be looked up without starting a JVM. Navitia providers are
+ * skipped, as they fetch their area from the network.
+ */
+public class GpteAreasGen {
+	// size of the grid cells of the index in degrees
+	private static final double CELL = 1.0;
+
+	private static Object defaultValue(Class<?> type) {
+		if (type == String.class)
+			return "";
+		if (type == byte[].class)
+			return new byte[0];
+		if (type == boolean.class)
+			return false;
+		if (type == int.class)
+			return 0;
+		if (type == long.class)
+			return 0L;
+		if (type.isEnum())
+			return type.getEnumConstants()[0];
+		return null;
+	}
+
+	private static Object instantiate(Class<?> cls) {
+		for (Constructor<?> constructor : cls.getConstructors()) {
+			Class<?>[] types = constructor.getParameterTypes();
+			Object[] args = new Object[types.length];
+			for (int i = 0; i < types.length; i++)
+				args[i] = defaultValue(types[i]);
+			try {
+				return constructor.newInstance(args);
+			} catch (Throwable e) {
+				// try the next constructor
+			}
+		}
+		return null;
+	}
+
+	private static int cell(double deg) {
+		return (int)Math.floor(deg / CELL);
+	}
+
+	public static void main(String[] args) throws Exception {
+		File jar = new File(args[0]);
+		URLClassLoader loader = new URLClassLoader(new URL[] { jar.toURI().toURL() });
+		Class<?> network = loader.loadClass("de.schildbach.pte.NetworkProvider");
+		Class<?> navitia = loader.loadClass("de.schildbach.pte.AbstractNavitiaProvider");
+		Class<?> point = loader.loadClass("de.schildbach.pte.dto.Point");
+		Method getLat = point.getMethod("getLatAsDouble");
+		Method getLon = point.getMethod("getLonAsDouble");
+
+		TreeSet<String> classes = new TreeSet<>();
+		try (JarFile file = new JarFile(jar)) {
+			Enumeration<JarEntry> entries = file.entries();
+			while (entries.hasMoreElements()) {
+				String name = entries.nextElement().getName();
+				if (name.matches("de/schildbach/pte/[A-Za-z0-9]+Provider\\.class"))
+					classes.add(name.substring(0, name.length() - ".class".length()));
+			}
+		}
+
+		StringBuilder points = new StringBuilder();
+		StringBuilder areas = new StringBuilder();
+		List<int[]> cells = new ArrayList<>();
+		int n_areas = 0;
+		for (String name : classes) {
+			Class<?> cls = loader.loadClass(name.replace('/', '.'));
+			if (Modifier.isAbstract(cls.getModifiers()) || !network.isAssignableFrom(cls) || navitia.isAssignableFrom(cls))
+				continue;
+
+			Object[] area;
+			try {
+				Object provider = instantiate(cls);
+				if (provider == null)
+					continue;
+				area = (Object[])cls.getMethod("getArea").invoke(provider);
+			} catch (Throwable e) {
+				continue;
+			}
+			if (area == null || area.length < 3)
+				continue;
+
+			double min_lat = Double.MAX_VALUE, min_lon = Double.MAX_VALUE;
+			double max_lat = -Double.MAX_VALUE, max_lon = -Double.MAX_VALUE;
+			String array = "gpte_area_" + n_areas;
+			points.append(String.format(Locale.ROOT, "static const GpteGeoPoint %s[] = {\n", array));
+			for (Object p : area) {
+				double lat = (Double)getLat.invoke(p);
+				double lon = (Double)getLon.invoke(p);
+				min_lat = Math.min(min_lat, lat);
+				min_lon = Math.min(min_lon, lon);
+				max_lat = Math.max(max_lat, lat);
+				max_lon = Math.max(max_lon, lon);
+				points.append(String.format(Locale.ROOT, "\t{ %.6f, %.6f },\n", lat, lon));
+			}
+			points.append("};\n");
+
+			areas.append(String.format(Locale.ROOT, "\t{ \"%s\", %s, G_N_ELEMENTS(%s), { %.6f, %.6f }, { %.6f, %.6f } },\n",
+				name, array, array, min_lat, min_lon, max_lat, max_lon));
+			for (int lat = cell(min_lat); lat <= cell(max_lat); lat++)
+				for (int lon = cell(min_lon); lon <= cell(max_lon); lon++)
+					cells.add(new int[] { lat, lon, n_areas });
+			n_areas++;
+		}
+
+		Collections.sort(cells, (a, b) -> a[0] != b[0] ? Integer.compare(a[0], b[0]) : a[1] != b[1] ? Integer.compare(a[1], b[1]) : Integer.compare(a[2], b[2]));
+
+		System.out.println("// generated by GpteAreasGen.java from " + jar.getName() + ", do not edit");
+		System.out.println();
+		System.out.println(String.format(Locale.ROOT, "#define GPTE_PROVIDER_AREA_CELL %.6f", CELL));
+		System.out.println("#define GPTE_PROVIDER_N_AREAS " + n_areas);
+		System.out.println("#define GPTE_PROVIDER_N_AREA_CELLS " + cells.size());
+		System.out.println();
+		System.out.print(points);
+		System.out.println();
+		System.out.println("static const GpteProviderArea gpte_provider_areas[] = {");
+		System.out.print(areas);
+		// empty initializers are only valid from C23 on, always end with a
+		// sentinel that is not counted in GPTE_PROVIDER_N_AREAS
+		System.out.println("\t{ NULL, NULL, 0, { 0, 0 }, { 0, 0 } },");
+		System.out.println("};");
+		System.out.println();
+		System.out.println("// sorted by cell");
+		System.out.println("static const GpteProviderAreaCell gpte_provider_area_cells[] = {");
+		for (int[] c : cells)
+			System.out.println(String.format(Locale.ROOT, "\t{ %d, %d, %d },", c[0], c[1], c[2]));
+		System.out.println("\t{ G_MAXINT, G_MAXINT, 0 },");
+		System.out.println("};");
+
+		// loading providers may have started non-daemon threads
+		System.exit(0);
+	}
+}
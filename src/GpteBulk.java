@@ -0,0 +1,196 @@
+/*
+ * gpte - GObject bindings for public-transport-enabler
+ * Copyright (C) 2024  Florian "sp1rit" <sp1rit@disroot.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+import java.io.ByteArrayOutputStream;
+import java.nio.charset.StandardCharsets;
+import java.util.Date;
+import java.util.Set;
+
+import de.schildbach.pte.dto.Departure;
+import de.schildbach.pte.dto.Product;
+import de.schildbach.pte.dto.Stop;
+import de.schildbach.pte.dto.Trip;
+
+/*
+ * Packs the scalar fields of query results into a single long[], so gpte
+ * can read all of them with one call instead of one per getter. Missing
+ * values are stored as NULL, times as milliseconds since the epoch and
+ * enums by their ordinal.
+ *
+ * Trip records start with their own length, so records of items that are
+ * already read can be skipped; departure records have a fixed size. The
+ * layout has to match the *_unpack() functions on the C side.
+ */
+public final class GpteBulk {
+	private static final long NULL = Long.MIN_VALUE;
+
+	private static final int TRIP_SIZE = 10;
+	private static final int LEG_SIZE = 5;
+	private static final int INDIVIDUAL_SIZE = 2;
+	private static final int STOP_SIZE = 6;
+	private static final int DEPARTURE_SIZE = 9;
+
+	private static final long LEG_OTHER = -1;
+	private static final long LEG_INDIVIDUAL = 0;
+	private static final long LEG_PUBLIC = 1;
+
+	private GpteBulk() {}
+
+	private static long time(final Date date) {
+		return date != null ? date.getTime() : NULL;
+	}
+
+	private static long products(final Set<Product> products) {
+		long ret = 0;
+		if (products != null)
+			for (final Product product : products)
+				ret |= 1L << product.ordinal();
+		return ret;
+	}
+
+	/*
+	 * offset and length of the string in the UTF-8 buffer, length -1 if
+	 * the string is null
+	 */
+	private static int packString(final long[] out, int i, final String str, final ByteArrayOutputStream strings) {
+		if (str == null) {
+			out[i++] = 0;
+			out[i++] = -1;
+			return i;
+		}
+		final byte[] utf8 = str.getBytes(StandardCharsets.UTF_8);
+		out[i++] = strings.size();
+		out[i++] = utf8.length;
+		strings.write(utf8, 0, utf8.length);
+		return i;
+	}
+
+	private static int tripSize(final Trip trip) {
+		int size = TRIP_SIZE;
+		for (final Trip.Leg leg : trip.legs) {
+			size += LEG_SIZE;
+			if (leg instanceof Trip.Individual)
+				size += INDIVIDUAL_SIZE;
+			else if (leg instanceof Trip.Public)
+				size += 2 * STOP_SIZE;
+		}
+		return size;
+	}
+
+	/*
+	 * arrival time, arrival time predicted, departure time, departure
+	 * time predicted, arrival delay, departure delay
+	 */
+	private static int packStop(final long[] out, int i, final Stop stop) {
+		final Long arrivalDelay = stop.getArrivalDelay();
+		final Long departureDelay = stop.getDepartureDelay();
+		out[i++] = time(stop.getArrivalTime());
+		out[i++] = stop.isArrivalTimePredicted() ? 1 : 0;
+		out[i++] = time(stop.getDepartureTime());
+		out[i++] = stop.isDepartureTimePredicted() ? 1 : 0;
+		out[i++] = arrivalDelay != null ? arrivalDelay : NULL;
+		out[i++] = departureDelay != null ? departureDelay : NULL;
+		return i;
+	}
+
+	/*
+	 * kind, departure time, arrival time, min time, max time, followed by
+	 * type and distance for individual legs or the departure and arrival
+	 * stop for public ones
+	 */
+	private static int packLeg(final long[] out, int i, final Trip.Leg leg) {
+		if (leg instanceof Trip.Individual)
+			out[i++] = LEG_INDIVIDUAL;
+		else if (leg instanceof Trip.Public)
+			out[i++] = LEG_PUBLIC;
+		else
+			out[i++] = LEG_OTHER;
+		out[i++] = time(leg.getDepartureTime());
+		out[i++] = time(leg.getArrivalTime());
+		out[i++] = time(leg.getMinTime());
+		out[i++] = time(leg.getMaxTime());
+
+		if (leg instanceof Trip.Individual) {
+			final Trip.Individual individual = (Trip.Individual) leg;
+			out[i++] = individual.type != null ? individual.type.ordinal() : NULL;
+			out[i++] = individual.distance;
+		} else if (leg instanceof Trip.Public) {
+			final Trip.Public pub = (Trip.Public) leg;
+			i = packStop(out, i, pub.departureStop);
+			i = packStop(out, i, pub.arrivalStop);
+		}
+		return i;
+	}
+
+	/*
+	 * record length, number of changes, duration, first departure time,
+	 * last arrival time, min time, max time, travelable, products,
+	 * number of legs, followed by the legs
+	 */
+	public static long[] packTrips(final Object[] trips) {
+		int size = 0;
+		for (final Object trip : trips)
+			size += tripSize((Trip) trip);
+
+		final long[] out = new long[size];
+		int i = 0;
+		for (final Object object : trips) {
+			final Trip trip = (Trip) object;
+			final Integer changes = trip.getNumChanges();
+			out[i++] = tripSize(trip);
+			out[i++] = changes != null ? changes : -1;
+			out[i++] = trip.getDuration();
+			out[i++] = time(trip.getFirstDepartureTime());
+			out[i++] = time(trip.getLastArrivalTime());
+			out[i++] = time(trip.getMinTime());
+			out[i++] = time(trip.getMaxTime());
+			out[i++] = trip.isTravelable() ? 1 : 0;
+			out[i++] = products(trip.products());
+			out[i++] = trip.legs.size();
+			for (final Trip.Leg leg : trip.legs)
+				i = packLeg(out, i, leg);
+		}
+		return out;
+	}
+
+	/*
+	 * Returns { long[], byte[], Object[] }. The long[] holds planned time,
+	 * predicted time, time, position name, position section and message
+	 * of each departure, with the strings stored in the byte[]. The
+	 * Object[] holds line and destination of each departure.
+	 */
+	public static Object[] packDepartures(final Object[] departures) {
+		final long[] out = new long[departures.length * DEPARTURE_SIZE];
+		final Object[] objects = new Object[departures.length * 2];
+		final ByteArrayOutputStream strings = new ByteArrayOutputStream();
+		int i = 0;
+		int j = 0;
+		for (final Object object : departures) {
+			final Departure departure = (Departure) object;
+			out[i++] = time(departure.plannedTime);
+			out[i++] = time(departure.predictedTime);
+			out[i++] = time(departure.getTime());
+			i = packString(out, i, departure.position != null ? departure.position.name : null, strings);
+			i = packString(out, i, departure.position != null ? departure.position.section : null, strings);
+			i = packString(out, i, departure.message, strings);
+			objects[j++] = departure.line;
+			objects[j++] = departure.destination;
+		}
+		return new Object[] { out, strings.toByteArray(), objects };
+	}
+}
@@ -0,0 +1,129 @@
+/*
+ * gpte - GObject bindings for public-transport-enabler
+ * Copyright (C) 2024  Florian "sp1rit" <sp1rit@disroot.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+import java.io.InterruptedIOException;
+import java.lang.reflect.InvocationTargetException;
+import java.lang.reflect.Method;
+import java.net.SocketTimeoutException;
+import java.util.concurrent.TimeUnit;
+
+/*
+ * Runs a single provider query on a virtual thread of its own, so it can
+ * be aborted. OkHttp 3.12 doesn't notice an interrupt while it blocks in
+ * a socket read, but socket I/O of a virtual thread is interruptible:
+ * interrupting it closes the socket and the read fails right away.
+ *
+ * Some blocking operations ignore interrupts nonetheless (DNS lookups,
+ * for one). A query that hasn't finished GRACE_MS after being aborted is
+ * left behind, its result is dropped once it eventually returns.
+ *
+ * The calling thread only waits for the query. cancel() may be called
+ * from any thread, also before execute().
+ */
+public final class GpteCall implements Runnable {
+	private static final long GRACE_MS = 1000;
+
+	private final Object target;
+	private final Method method;
+	private final Object[] args;
+
+	// guarded by this
+	private Thread thread;
+	private boolean cancelled;
+	private boolean done;
+	private Object result;
+	private Throwable error;
+
+	public GpteCall(final Object target, final Method method, final Object[] args) {
+		this.target = target;
+		this.method = method;
+		this.args = args;
+	}
+
+	@Override
+	public void run() {
+		Object result = null;
+		Throwable error = null;
+		try {
+			result = method.invoke(target, args);
+		} catch (final InvocationTargetException e) {
+			error = e.getCause();
+		} catch (final Throwable e) {
+			error = e;
+		}
+		synchronized (this) {
+			this.result = result;
+			this.error = error;
+			done = true;
+			notifyAll();
+		}
+	}
+
+	/*
+	 * Runs the query and returns its result or throws its exception. It is
+	 * aborted once cancelled or after timeout milliseconds, unless timeout
+	 * is 0.
+	 */
+	public Object execute(final long timeout) throws Throwable {
+		final Thread query = Thread.ofVirtual().name("gpte-call").unstarted(this);
+		synchronized (this) {
+			if (cancelled)
+				throw new InterruptedIOException("Canceled");
+			thread = query;
+		}
+		query.start();
+
+		final long deadline = timeout > 0 ? System.nanoTime() + TimeUnit.MILLISECONDS.toNanos(timeout) : 0;
+		long abandon = 0;
+		boolean expired = false;
+		synchronized (this) {
+			while (!done) {
+				final long now = System.nanoTime();
+				if (abandon == 0 && (cancelled || (deadline != 0 && now - deadline >= 0))) {
+					expired = !cancelled;
+					query.interrupt();
+					abandon = now + TimeUnit.MILLISECONDS.toNanos(GRACE_MS);
+				} else if (abandon != 0 && now - abandon >= 0) {
+					break;
+				}
+
+				final long until = abandon != 0 ? abandon : deadline;
+				if (until == 0)
+					wait();
+				else
+					wait(Math.max(1, TimeUnit.NANOSECONDS.toMillis(until - now)));
+			}
+
+			if (cancelled)
+				throw new InterruptedIOException("Canceled");
+			if (expired && (!done || error != null))
+				throw new SocketTimeoutException("Request timed out after " + timeout + " ms");
+			if (error != null)
+				throw error;
+			return result;
+		}
+	}
+
+	public synchronized void cancel() {
+		cancelled = true;
+		if (thread != null)
+			thread.interrupt();
+		notifyAll();
+	}
+}
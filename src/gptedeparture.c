@@ -16,132 +16,285 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include "gptedeparture.h"
+#include "gptedeparture-priv.h"
 #include "gptejavaobject-priv.h"
 
 #include "gpteutils-priv.h"
-#include "gptegeo-priv.h"
+#include "gptestop-priv.h"
+#include "gptestyle-priv.h"
+
+typedef enum {
+	GPTE_DEPARTURE_CACHED_PLANNED_TIME = 1 << 0,
+	GPTE_DEPARTURE_CACHED_PREDICTED_TIME = 1 << 1,
+	GPTE_DEPARTURE_CACHED_TIME = 1 << 2,
+	GPTE_DEPARTURE_CACHED_LINE = 1 << 3,
+	GPTE_DEPARTURE_CACHED_POSITION = 1 << 4,
+	GPTE_DEPARTURE_CACHED_DESTINATION = 1 << 5,
+	GPTE_DEPARTURE_CACHED_MESSAGE = 1 << 6
+} GpteDepartureCachedValues;
 
 struct _GpteDeparture {
 	GpteJavaObject parent_instance;
+
+	GpteDepartureCachedValues cached;
+	GDateTime* cached_planned_time;
+	GDateTime* cached_predicted_time;
+	GDateTime* cached_time;
+	GpteLine* cached_line;
+	GptePosition* cached_position;
+	GpteLocation* cached_destination;
+	gchar* cached_message;
 };
 
 G_DEFINE_TYPE (GpteDeparture, gpte_departure, GPTE_TYPE_JAVA_OBJECT)
 
-static void gpte_departure_class_init(GpteDepartureClass*) {}
-static void gpte_departure_init(GpteDeparture*) {}
+static void gpte_departure_dispose(GObject* object) {
+	GpteDeparture* self = GPTE_DEPARTURE(object);
+	if (self->cached & GPTE_DEPARTURE_CACHED_PLANNED_TIME)
+		g_clear_pointer(&self->cached_planned_time, g_date_time_unref);
+	if (self->cached & GPTE_DEPARTURE_CACHED_PREDICTED_TIME)
+		g_clear_pointer(&self->cached_predicted_time, g_date_time_unref);
+	if (self->cached & GPTE_DEPARTURE_CACHED_TIME)
+		g_clear_pointer(&self->cached_time, g_date_time_unref);
+	if (self->cached & GPTE_DEPARTURE_CACHED_LINE)
+		g_clear_object(&self->cached_line);
+	if (self->cached & GPTE_DEPARTURE_CACHED_POSITION)
+		g_clear_pointer(&self->cached_position, gpte_position_free);
+	if (self->cached & GPTE_DEPARTURE_CACHED_DESTINATION)
+		g_clear_object(&self->cached_destination);
+	if (self->cached & GPTE_DEPARTURE_CACHED_MESSAGE)
+		g_clear_pointer(&self->cached_message, g_free);
+	self->cached = 0;
+	G_OBJECT_CLASS(gpte_departure_parent_class)->dispose(object);
+}
 
-GDateTime* gpte_departure_get_planned_time(GpteDeparture* self) {
-	g_return_val_if_fail(GPTE_IS_DEPARTURE(self), NULL);
+static void gpte_departure_hydrate(GpteJavaObject* object);
 
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+static void gpte_departure_class_init(GpteDepartureClass* class) {
+	G_OBJECT_CLASS(class)->dispose = gpte_departure_dispose;
+	GPTE_JAVA_OBJECT_CLASS(class)->hydrate = gpte_departure_hydrate;
+}
+static void gpte_departure_init(GpteDeparture* self) {
+	self->cached = 0;
+}
 
+static GDateTime* gpte_departure_date_field(GpteDeparture* self, GpteJvm* vm, jfieldID field, GDateTime** cache, GpteDepartureCachedValues cache_value) {
+	if (self->cached & cache_value)
+		return *cache;
+
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Departure");
+	jobject date = (*env)->GetObjectField(env, this, field);
 
-	jfieldID field_id = (*env)->GetFieldID(env, class, "plannedTime", "Ljava/util/Date;");
-	jobject date = (*env)->GetObjectField(env, this, field_id);
-	if (!date)
-		return NULL;
-	return gpte_date_from_java(vm, date);
+	*cache = date ? gpte_date_from_java(vm, date) : NULL;
+	self->cached |= cache_value;
+	return *cache;
+}
+
+GDateTime* gpte_departure_get_planned_time(GpteDeparture* self) {
+	g_return_val_if_fail(GPTE_IS_DEPARTURE(self), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	GDateTime* time = gpte_departure_date_field(self, vm, vm->jni.departure.planned_time, &self->cached_planned_time, GPTE_DEPARTURE_CACHED_PLANNED_TIME);
+	return time ? g_date_time_ref(time) : NULL;
 }
 
 GDateTime* gpte_departure_get_predicted_time(GpteDeparture* self) {
 	g_return_val_if_fail(GPTE_IS_DEPARTURE(self), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	GDateTime* time = gpte_departure_date_field(self, vm, vm->jni.departure.predicted_time, &self->cached_predicted_time, GPTE_DEPARTURE_CACHED_PREDICTED_TIME);
+	return time ? g_date_time_ref(time) : NULL;
+}
+
+static GDateTime* gpte_departure_time(GpteDeparture* self) {
+	if (self->cached & GPTE_DEPARTURE_CACHED_TIME)
+		return self->cached_time;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Departure");
-
-	jfieldID field_id = (*env)->GetFieldID(env, class, "predictedTime", "Ljava/util/Date;");
-	jobject date = (*env)->GetObjectField(env, this, field_id);
-	if (!date)
-		return NULL;
-	return gpte_date_from_java(vm, date);
+	jobject date = (*env)->CallObjectMethod(env, this, vm->jni.departure.get_time);
+	self->cached_time = date ? gpte_date_from_java(vm, date) : NULL;
+	self->cached |= GPTE_DEPARTURE_CACHED_TIME;
+	return self->cached_time;
 }
-
 GDateTime* gpte_departure_get_time(GpteDeparture* self) {
 	g_return_val_if_fail(GPTE_IS_DEPARTURE(self), NULL);
+	GDateTime* time = gpte_departure_time(self);
+	return time ? g_date_time_ref(time) : NULL;
+}
+
+static GpteLine* gpte_departure_line(GpteDeparture* self) {
+	if (self->cached & GPTE_DEPARTURE_CACHED_LINE)
+		return self->cached_line;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Departure");
+	jobject line = (*env)->GetObjectField(env, this, vm->jni.departure.line);
 
-	jmethodID get_time = (*env)->GetMethodID(env, class, "getTime", "()Ljava/util/Date;");
-	jobject date = (*env)->CallObjectMethod(env, this, get_time);
-	if (!date)
-		return NULL;
-	return gpte_date_from_java(vm, date);
+	self->cached_line = g_object_new(GPTE_TYPE_LINE, "vm", vm, "object", line, NULL);
+	gpte_style_cache_inherit(self->cached_line, self);
+	self->cached |= GPTE_DEPARTURE_CACHED_LINE;
+	return self->cached_line;
 }
-
 GpteLine* gpte_departure_get_line(GpteDeparture* self) {
 	g_return_val_if_fail(GPTE_IS_DEPARTURE(self), NULL);
+	return g_object_ref(gpte_departure_line(self));
+}
+
+static GptePosition* gpte_departure_position(GpteDeparture* self) {
+	if (self->cached & GPTE_DEPARTURE_CACHED_POSITION)
+		return self->cached_position;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Departure");
+	jobject pos = (*env)->GetObjectField(env, this, vm->jni.departure.position);
 
-	jfieldID field_id = (*env)->GetFieldID(env, class, "line", "Lde/schildbach/pte/dto/Line;");
-	jobject line = (*env)->GetObjectField(env, this, field_id);
-
-	return g_object_new(GPTE_TYPE_LINE, "vm", vm, "object", line, NULL);
+	self->cached_position = pos ? gpte_position_from_java(vm, pos) : NULL;
+	self->cached |= GPTE_DEPARTURE_CACHED_POSITION;
+	return self->cached_position;
 }
-
-GpteGeoPoint* gpte_departure_get_position(GpteDeparture* self) {
+GptePosition* gpte_departure_get_position(GpteDeparture* self) {
 	g_return_val_if_fail(GPTE_IS_DEPARTURE(self), NULL);
+	return gpte_position_copy(gpte_departure_position(self));
+}
+
+static GpteLocation* gpte_departure_destination(GpteDeparture* self) {
+	if (self->cached & GPTE_DEPARTURE_CACHED_DESTINATION)
+		return self->cached_destination;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Departure");
+	jobject dest = (*env)->GetObjectField(env, this, vm->jni.departure.destination);
 
-	jfieldID field_id = (*env)->GetFieldID(env, class, "destination", "Lde/schildbach/pte/dto/Position;");
-	jobject pos = (*env)->GetObjectField(env, this, field_id);
-	if (!pos)
-		return NULL;
-	GpteGeoPoint p = gpte_geo_point_from_java(vm, pos);
-	return gpte_geo_point_copy(&p);
+	self->cached_destination = dest ? g_object_new(GPTE_TYPE_LOCATION, "vm", vm, "object", dest, NULL) : NULL;
+	self->cached |= GPTE_DEPARTURE_CACHED_DESTINATION;
+	return self->cached_destination;
 }
-
 GpteLocation* gpte_departure_get_destination(GpteDeparture* self) {
 	g_return_val_if_fail(GPTE_IS_DEPARTURE(self), NULL);
+	GpteLocation* destination = gpte_departure_destination(self);
+	return destination ? g_object_ref(destination) : NULL;
+}
+
+static const gchar* gpte_departure_message(GpteDeparture* self) {
+	if (self->cached & GPTE_DEPARTURE_CACHED_MESSAGE)
+		return self->cached_message;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Departure");
-
-	jfieldID field_id = (*env)->GetFieldID(env, class, "destination", "Lde/schildbach/pte/dto/Location;");
-	jobject dest = (*env)->GetObjectField(env, this, field_id);
-	if (!dest)
+	jstring msg = (*env)->GetObjectField(env, this, vm->jni.departure.message);
+	if (!msg) {
+		self->cached_message = NULL;
+		self->cached |= GPTE_DEPARTURE_CACHED_MESSAGE;
 		return NULL;
-
-	return g_object_new(GPTE_TYPE_LOCATION, "vm", vm, "object", dest, NULL);
+	}
+	const char* utf = (*env)->GetStringUTFChars(env, msg, NULL);
+	self->cached_message = g_strdup(utf);
+	(*env)->ReleaseStringUTFChars(env, msg, utf);
+	self->cached |= GPTE_DEPARTURE_CACHED_MESSAGE;
+	return self->cached_message;
 }
-
 gchar* gpte_departure_get_message(GpteDeparture* self) {
 	g_return_val_if_fail(GPTE_IS_DEPARTURE(self), NULL);
+	return g_strdup(gpte_departure_message(self));
+}
 
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self)), 3);
+#define GPTE_DEPARTURE_PACKED_SIZE 9
 
-	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Departure");
+static void gpte_departure_unpack_date(GpteDeparture* self, jlong packed, GDateTime** cache, GpteDepartureCachedValues cache_value) {
+	if (self->cached & cache_value)
+		return;
+	*cache = gpte_date_from_packed(packed);
+	self->cached |= cache_value;
+}
+// a string GpteBulk.packDepartures() stored as offset and length into @strings
+static gchar* gpte_departure_unpack_string(const gchar* strings, const jlong* packed) {
+	return packed[1] >= 0 ? g_strndup(strings + packed[0], packed[1]) : NULL;
+}
+// fills the cached values of @self from the record GpteBulk.packDepartures()
+// wrote at @packed; line and destination are at 2*@idx in @objects
+static void gpte_departure_unpack(GpteDeparture* self, GpteJvm* vm, const jlong* packed, const gchar* strings, jobjectArray objects, guint idx) {
+	JNIEnv* env = gpte_jvm_get_env(vm);
+
+	gpte_departure_unpack_date(self, packed[0], &self->cached_planned_time, GPTE_DEPARTURE_CACHED_PLANNED_TIME);
+	gpte_departure_unpack_date(self, packed[1], &self->cached_predicted_time, GPTE_DEPARTURE_CACHED_PREDICTED_TIME);
+	gpte_departure_unpack_date(self, packed[2], &self->cached_time, GPTE_DEPARTURE_CACHED_TIME);
+
+	if (!(self->cached & GPTE_DEPARTURE_CACHED_POSITION)) {
+		self->cached_position = NULL;
+		if (packed[4] >= 0) {
+			self->cached_position = g_new0(GptePosition, 1);
+			self->cached_position->name = gpte_departure_unpack_string(strings, &packed[3]);
+			self->cached_position->section = gpte_departure_unpack_string(strings, &packed[5]);
+		}
+		self->cached |= GPTE_DEPARTURE_CACHED_POSITION;
+	}
+	if (!(self->cached & GPTE_DEPARTURE_CACHED_MESSAGE)) {
+		self->cached_message = gpte_departure_unpack_string(strings, &packed[7]);
+		self->cached |= GPTE_DEPARTURE_CACHED_MESSAGE;
+	}
+
+	if (!(self->cached & GPTE_DEPARTURE_CACHED_LINE)) {
+		jobject line = (*env)->GetObjectArrayElement(env, objects, 2 * idx);
+		self->cached_line = g_object_new(GPTE_TYPE_LINE, "vm", vm, "object", line, NULL);
+		gpte_style_cache_inherit(self->cached_line, self);
+		self->cached |= GPTE_DEPARTURE_CACHED_LINE;
+		(*env)->DeleteLocalRef(env, line);
+	}
+	if (!(self->cached & GPTE_DEPARTURE_CACHED_DESTINATION)) {
+		jobject dest = (*env)->GetObjectArrayElement(env, objects, 2 * idx + 1);
+		self->cached_destination = dest ? g_object_new(GPTE_TYPE_LOCATION, "vm", vm, "object", dest, NULL) : NULL;
+		self->cached |= GPTE_DEPARTURE_CACHED_DESTINATION;
+		if (dest)
+			(*env)->DeleteLocalRef(env, dest);
+	}
+}
 
-	jfieldID field_id = (*env)->GetFieldID(env, class, "message", "Ljava/lang/String;");
-	jobject msg = (*env)->GetObjectField(env, this, field_id);
-	if (!msg)
-		return NULL;
-	const char* utf = (*env)->GetStringUTFChars(env, msg, NULL);
-	gchar* copy = g_strdup(utf);
-	(*env)->ReleaseStringUTFChars(env, msg, utf);
-	return copy;
+void gpte_departure_unpack_window(GpteJvm* vm, jobjectArray items, GObject** wrapped, guint n_items) {
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 6);
+	jobjectArray jpacked = (*env)->CallStaticObjectMethod(env, vm->jni.bulk.class, vm->jni.bulk.pack_departures, items);
+	g_autoptr(GError) err = NULL;
+	if (gpte_jvm_error(vm, &err)) {
+		// the getters still read the fields one by one
+		g_warning("Failed packing departures: %s", err->message);
+		return;
+	}
+
+	jlongArray jvalues = (*env)->GetObjectArrayElement(env, jpacked, 0);
+	jbyteArray jstrings = (*env)->GetObjectArrayElement(env, jpacked, 1);
+	jobjectArray objects = (*env)->GetObjectArrayElement(env, jpacked, 2);
+
+	jlong* values = (*env)->GetLongArrayElements(env, jvalues, NULL);
+	jbyte* strings = (*env)->GetByteArrayElements(env, jstrings, NULL);
+	for (guint i = 0; i < n_items; i++)
+		if (wrapped[i])
+			gpte_departure_unpack(GPTE_DEPARTURE(wrapped[i]), vm, &values[i * GPTE_DEPARTURE_PACKED_SIZE], (const gchar*)strings, objects, i);
+	(*env)->ReleaseByteArrayElements(env, jstrings, strings, JNI_ABORT);
+	(*env)->ReleaseLongArrayElements(env, jvalues, values, JNI_ABORT);
+}
+
+static void gpte_departure_hydrate(GpteJavaObject* object) {
+	GpteDeparture* self = GPTE_DEPARTURE(object);
+	GpteJvm* vm = gpte_java_object_get_vm(object);
+	gpte_departure_date_field(self, vm, vm->jni.departure.planned_time, &self->cached_planned_time, GPTE_DEPARTURE_CACHED_PLANNED_TIME);
+	gpte_departure_date_field(self, vm, vm->jni.departure.predicted_time, &self->cached_predicted_time, GPTE_DEPARTURE_CACHED_PREDICTED_TIME);
+	gpte_departure_time(self);
+	gpte_java_object_detach(gpte_departure_line(self));
+	gpte_departure_position(self);
+	gpte_java_object_detach(gpte_departure_destination(self));
+	gpte_departure_message(self);
+}
+
+GpteDeparture* gpte_departure_snapshot(GpteDeparture* self) {
+	g_return_val_if_fail(GPTE_IS_DEPARTURE(self), NULL);
+	return GPTE_DEPARTURE(gpte_java_object_snapshot(GPTE_JAVA_OBJECT(self)));
 }
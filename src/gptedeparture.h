@@ -23,7 +23,7 @@
 #include <gptejavaobject.h>
 
 #include <gpteline.h>
-#include <gptegeo.h>
+#include <gptestop.h>
 #include <gptelocation.h>
 
 G_BEGIN_DECLS
@@ -79,7 +79,7 @@ GpteLine* gpte_departure_get_line(GpteDeparture* self);
  * Gets the position where the product will depart at.
  * Returns: (nullable) (transfer full): the position of the departure
  */
-GpteGeoPoint* gpte_departure_get_position(GpteDeparture* self);
+GptePosition* gpte_departure_get_position(GpteDeparture* self);
 
 /**
  * gpte_departure_get_destination:
@@ -101,6 +101,17 @@ GpteLocation* gpte_departure_get_destination(GpteDeparture* self);
  */
 gchar* gpte_departure_get_message(GpteDeparture* self);
 
+/**
+ * gpte_departure_snapshot:
+ * @self: the departure
+ *
+ * Copies @self into native memory, see
+ * [method@Gpte.JavaObject.snapshot].
+ *
+ * Returns: (transfer full): a detached copy of @self
+ */
+GpteDeparture* gpte_departure_snapshot(GpteDeparture* self);
+
 G_END_DECLS
 
 #endif // __GPTEDEPARTURE_H__
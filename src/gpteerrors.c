@@ -23,7 +23,8 @@ G_DEFINE_ENUM_TYPE(GpteJavaError, gpte_java_error,
 	G_DEFINE_ENUM_VALUE(GPTE_JAVA_ERROR_JVM_INIT_FAILED, "jvm-init-failed"),
 	G_DEFINE_ENUM_VALUE(GPTE_JAVA_ERROR_JVM_THREADING, "jvm-threading"),
 	G_DEFINE_ENUM_VALUE(GPTE_JAVA_ERROR_IO_EXCEPTION, "io-exception"),
-	G_DEFINE_ENUM_VALUE(GPTE_JAVA_ERROR_UNHANLED_EXCEPTION, "unhandled-exception")
+	G_DEFINE_ENUM_VALUE(GPTE_JAVA_ERROR_UNHANLED_EXCEPTION, "unhandled-exception"),
+	G_DEFINE_ENUM_VALUE(GPTE_JAVA_ERROR_UNKNOWN_PROVIDER, "unknown-provider")
 )
 
 G_DEFINE_QUARK(gpte_pte_quark, gpte_pte_error)
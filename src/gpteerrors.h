@@ -29,6 +29,8 @@ G_BEGIN_DECLS
  * @GPTE_JAVA_ERROR_JVM_THREADING: threading routine issue
  * @GPTE_JAVA_ERROR_IO_EXCEPTION: the JVM has a pending [java.io.IOException](https://docs.oracle.com/en/java/javase/17/docs/api/java.base/java/io/IOException.html)
  * @GPTE_JAVA_ERROR_UNHANLED_EXCEPTION: the JVM has a pending exception
+ * @GPTE_JAVA_ERROR_UNKNOWN_PROVIDER: no provider with the requested
+ *   identifier exists
  *
  * Various errors that can occur either during
  * [JNI Invocation](https://docs.oracle.com/en/java/javase/17/docs/specs/jni/invocation.html)
@@ -44,7 +46,8 @@ typedef enum {
 	GPTE_JAVA_ERROR_JVM_INIT_FAILED,
 	GPTE_JAVA_ERROR_JVM_THREADING,
 	GPTE_JAVA_ERROR_IO_EXCEPTION,
-	GPTE_JAVA_ERROR_UNHANLED_EXCEPTION
+	GPTE_JAVA_ERROR_UNHANLED_EXCEPTION,
+	GPTE_JAVA_ERROR_UNKNOWN_PROVIDER
 } GpteJavaError;
 
 
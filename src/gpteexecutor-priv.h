@@ -0,0 +1,57 @@
+/*
+ * gpte - GObject bindings for public-transport-enabler
+ * Copyright (C) 2024  Florian "sp1rit" <sp1rit@disroot.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __GPTEEXECUTOR_PRIV_H__
+#define __GPTEEXECUTOR_PRIV_H__
+
+#include <gio/gio.h>
+#include <gptejvm.h>
+#include <gptelimiter-priv.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Pool of worker threads that stay attached to the JVM for their whole
+ * lifetime. Jobs are GTasks, ordered by g_task_get_priority() and FIFO
+ * within the same priority.
+ */
+typedef struct _GpteExecutor GpteExecutor;
+
+#define GPTE_EXECUTOR_DEFAULT_THREADS 4
+#define GPTE_EXECUTOR_DEFAULT_MAX_QUEUED 64
+
+GpteExecutor* gpte_executor_new(GpteJvm* vm, guint n_threads, guint max_queued);
+void gpte_executor_free(GpteExecutor* self);
+// whether the calling thread is one of the workers of @self
+gboolean gpte_executor_is_current(GpteExecutor* self);
+
+void gpte_executor_set_limits(GpteExecutor* self, guint n_threads, guint max_queued);
+
+void gpte_executor_run_task(GpteExecutor* self, GTask* task, GTaskThreadFunc func);
+// runs a job that already holds @slot, it is released once the job is
+// done unless the job takes it with gpte_executor_steal_slot()
+void gpte_executor_run_task_with_slot(GpteExecutor* self, GTask* task, GTaskThreadFunc func, GpteLimiterSlot* slot);
+// whether the calling thread is running a job of any executor
+gboolean gpte_executor_in_job(void);
+// the slot of the job running on the calling worker, if any
+GpteLimiterSlot* gpte_executor_steal_slot(void);
+
+G_END_DECLS
+
+#endif // __GPTEEXECUTOR_PRIV_H__
@@ -0,0 +1,229 @@
+/*
+ * gpte - GObject bindings for public-transport-enabler
+ * Copyright (C) 2024  Florian "sp1rit" <sp1rit@disroot.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "gpteexecutor-priv.h"
+#include "gptejvm-priv.h"
+
+#include "gpteerrors.h"
+
+struct _GpteExecutor {
+	GpteJvm* vm;
+	GAsyncQueue* queue;
+
+	// protects the thread counters
+	GMutex lock;
+	GCond cond;
+	guint n_threads;
+	guint n_running;
+	guint next_thread_id;
+
+	gint max_queued;
+	gint queued;
+	// protected by the queue lock
+	guint64 seq;
+};
+
+typedef struct {
+	gint priority;
+	guint64 seq;
+	GTask* task;
+	GTaskThreadFunc func;
+	GpteLimiterSlot* slot;
+} GpteExecutorJob;
+
+static GPrivate gpte_executor_current;
+static GPrivate gpte_executor_current_job;
+
+static gint gpte_executor_job_compare(const GpteExecutorJob* a, const GpteExecutorJob* b, gpointer) {
+	if (a->priority != b->priority)
+		return a->priority < b->priority ? -1 : 1;
+	return a->seq < b->seq ? -1 : (a->seq > b->seq);
+}
+
+static void gpte_executor_push(GpteExecutor* self, gint priority, GTask* task, GTaskThreadFunc func, GpteLimiterSlot* slot) {
+	GpteExecutorJob* job = g_new(GpteExecutorJob, 1);
+	job->priority = priority;
+	job->task = task;
+	job->func = func;
+	job->slot = slot;
+
+	g_async_queue_lock(self->queue);
+	job->seq = self->seq++;
+	g_async_queue_push_sorted_unlocked(self->queue, job, (GCompareDataFunc)gpte_executor_job_compare, NULL);
+	g_async_queue_unlock(self->queue);
+}
+
+// a job without task stops the first worker that picks it up, after
+// everything that was queued before it
+static void gpte_executor_push_stop(GpteExecutor* self) {
+	gpte_executor_push(self, G_MAXINT, NULL, NULL, NULL);
+}
+
+static gboolean gpte_executor_release_task(GTask* task) {
+	g_object_unref(task);
+	return G_SOURCE_REMOVE;
+}
+
+static gpointer gpte_executor_worker(GpteExecutor* self) {
+	g_private_set(&gpte_executor_current, self);
+
+	g_mutex_lock(&self->lock);
+	g_autofree gchar* name = g_strdup_printf("gpte-worker-%u", self->next_thread_id++);
+	g_mutex_unlock(&self->lock);
+
+	JNIEnv* env;
+	gboolean attached = (*self->vm->vm)->AttachCurrentThreadAsDaemon(self->vm->vm, (void**)&env, &(JavaVMAttachArgs){
+		.version = JNI_VERSION_21,
+		.name = name,
+		.group = NULL
+	}) == JNI_OK;
+	if (!attached)
+		g_critical("Gpte.Executor was unable to attach %s", name);
+
+	for (;;) {
+		GpteExecutorJob* job = g_async_queue_pop(self->queue);
+		if (!job->task) {
+			g_free(job);
+			break;
+		}
+		g_atomic_int_dec_and_test(&self->queued);
+
+		if (!attached)
+			g_task_return_new_error(job->task, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_THREADING, "Unable to attach thread");
+		else if (!g_task_return_error_if_cancelled(job->task)) {
+			GCancellable* cancellable = g_task_get_cancellable(job->task);
+			// lets the blocking calls the job makes notice the cancellation
+			if (cancellable)
+				g_cancellable_push_current(cancellable);
+			g_private_set(&gpte_executor_current_job, job);
+			job->func(job->task, g_task_get_source_object(job->task), g_task_get_task_data(job->task), cancellable);
+			g_private_set(&gpte_executor_current_job, NULL);
+			if (cancellable)
+				g_cancellable_pop_current(cancellable);
+		}
+		if (job->slot)
+			gpte_limiter_release(job->slot);
+
+		// The task may hold the last reference to a provider (and thus the
+		// JVM), so drop it on the task's context instead of on this thread.
+		GSource* release = g_idle_source_new();
+		g_source_set_callback(release, (GSourceFunc)gpte_executor_release_task, job->task, NULL);
+		g_source_attach(release, g_task_get_context(job->task));
+		g_source_unref(release);
+		g_free(job);
+	}
+
+	if (attached)
+		(*self->vm->vm)->DetachCurrentThread(self->vm->vm);
+
+	g_mutex_lock(&self->lock);
+	self->n_running--;
+	g_cond_broadcast(&self->cond);
+	g_mutex_unlock(&self->lock);
+	return NULL;
+}
+
+// must be called with self->lock held
+static void gpte_executor_resize(GpteExecutor* self, guint n_threads) {
+	for (; self->n_threads < n_threads; self->n_threads++) {
+		self->n_running++;
+		g_thread_unref(g_thread_new("gpte-worker", (GThreadFunc)gpte_executor_worker, self));
+	}
+	for (; self->n_threads > n_threads; self->n_threads--)
+		gpte_executor_push_stop(self);
+}
+
+GpteExecutor* gpte_executor_new(GpteJvm* vm, guint n_threads, guint max_queued) {
+	GpteExecutor* self = g_new(GpteExecutor, 1);
+	self->vm = vm;
+	self->queue = g_async_queue_new();
+	g_mutex_init(&self->lock);
+	g_cond_init(&self->cond);
+	self->n_threads = 0;
+	self->n_running = 0;
+	self->next_thread_id = 0;
+	self->queued = 0;
+	self->seq = 0;
+
+	g_mutex_lock(&self->lock);
+	g_atomic_int_set(&self->max_queued, max_queued ? max_queued : GPTE_EXECUTOR_DEFAULT_MAX_QUEUED);
+	gpte_executor_resize(self, n_threads ? n_threads : GPTE_EXECUTOR_DEFAULT_THREADS);
+	g_mutex_unlock(&self->lock);
+	return self;
+}
+
+void gpte_executor_free(GpteExecutor* self) {
+	if (!self)
+		return;
+
+	// the worker would be left running on freed memory
+	if (gpte_executor_is_current(self)) {
+		g_critical("Gpte.Executor freed from one of its own workers");
+		return;
+	}
+
+	g_mutex_lock(&self->lock);
+	gpte_executor_resize(self, 0);
+	while (self->n_running > 0)
+		g_cond_wait(&self->cond, &self->lock);
+	g_mutex_unlock(&self->lock);
+
+	g_async_queue_unref(self->queue);
+	g_cond_clear(&self->cond);
+	g_mutex_clear(&self->lock);
+	g_free(self);
+}
+
+gboolean gpte_executor_is_current(GpteExecutor* self) {
+	return g_private_get(&gpte_executor_current) == self;
+}
+
+void gpte_executor_set_limits(GpteExecutor* self, guint n_threads, guint max_queued) {
+	g_mutex_lock(&self->lock);
+	g_atomic_int_set(&self->max_queued, max_queued ? max_queued : GPTE_EXECUTOR_DEFAULT_MAX_QUEUED);
+	gpte_executor_resize(self, n_threads ? n_threads : GPTE_EXECUTOR_DEFAULT_THREADS);
+	g_mutex_unlock(&self->lock);
+}
+
+void gpte_executor_run_task_with_slot(GpteExecutor* self, GTask* task, GTaskThreadFunc func, GpteLimiterSlot* slot) {
+	g_return_if_fail(G_IS_TASK(task));
+
+	if (g_atomic_int_add(&self->queued, 1) >= g_atomic_int_get(&self->max_queued)) {
+		g_atomic_int_dec_and_test(&self->queued);
+		if (slot)
+			gpte_limiter_release(slot);
+		g_task_return_new_error(task, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_THREADING, "Too many pending requests");
+		return;
+	}
+
+	gpte_executor_push(self, g_task_get_priority(task), g_object_ref(task), func, slot);
+}
+
+void gpte_executor_run_task(GpteExecutor* self, GTask* task, GTaskThreadFunc func) {
+	gpte_executor_run_task_with_slot(self, task, func, NULL);
+}
+
+gboolean gpte_executor_in_job(void) {
+	return g_private_get(&gpte_executor_current_job) != NULL;
+}
+
+GpteLimiterSlot* gpte_executor_steal_slot(void) {
+	GpteExecutorJob* job = g_private_get(&gpte_executor_current_job);
+	return job ? g_steal_pointer(&job->slot) : NULL;
+}
@@ -24,6 +24,7 @@
 G_DEFINE_ENUM_TYPE(GpteFareType, gpte_fare_type,
 	G_DEFINE_ENUM_VALUE(GPTE_FARE_ADULT, "adult"),
 	G_DEFINE_ENUM_VALUE(GPTE_FARE_BIKE, "bike"),
+	G_DEFINE_ENUM_VALUE(GPTE_FARE_CHILD, "child"),
 	G_DEFINE_ENUM_VALUE(GPTE_FARE_DISABLED, "disabled"),
 	G_DEFINE_ENUM_VALUE(GPTE_FARE_MILITARY, "military"),
 	G_DEFINE_ENUM_VALUE(GPTE_FARE_SENIOR, "senior"),
@@ -76,8 +77,11 @@ static void gpte_fare_finalize(GObject* object) {
 	G_OBJECT_CLASS(gpte_fare_parent_class)->finalize(object);
 }
 
+static void gpte_fare_hydrate(GpteJavaObject* object);
+
 static void gpte_fare_class_init(GpteFareClass* class) {
 	G_OBJECT_CLASS(class)->finalize = gpte_fare_finalize;
+	GPTE_JAVA_OBJECT_CLASS(class)->hydrate = gpte_fare_hydrate;
 }
 
 static void gpte_fare_init(GpteFare* self) {
@@ -90,12 +94,10 @@ const gchar* gpte_fare_get_name(GpteFare* self) {
 		return self->cached_name;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Fare");
-	jfieldID name_id = (*env)->GetFieldID(env, class, "name", "Ljava/lang/String;");
-	jstring jname = (*env)->GetObjectField(env, this, name_id);
+	jstring jname = (*env)->GetObjectField(env, this, vm->jni.fare.name);
 
 	const char* utf = (*env)->GetStringUTFChars(env, jname, NULL);
 	self->cached_name = g_strdup(utf);
@@ -110,34 +112,16 @@ GpteFareType gpte_fare_get_fare_type(GpteFare* self) {
 		return self->cached_type;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 20);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Fare");
-	jfieldID type_id = (*env)->GetFieldID(env, class, "type", "Lde/schildbach/pte/dto/Fare$Type;");
-	jobject type = (*env)->GetObjectField(env, this, type_id);
-
-	jclass enum_class = (*env)->FindClass(env, "de/schildbach/pte/dto/Fare$Type");
-	if ((*env)->IsSameObject(env, type, (*env)->GetStaticObjectField(env, enum_class, (*env)->GetStaticFieldID(env, enum_class, "ADULT", "Lde/schildbach/pte/dto/Fare$Type;"))))
-		self->cached_type = GPTE_FARE_ADULT;
-	else if ((*env)->IsSameObject(env, type, (*env)->GetStaticObjectField(env, enum_class, (*env)->GetStaticFieldID(env, enum_class, "BIKE", "Lde/schildbach/pte/dto/Fare$Type;"))))
-		self->cached_type = GPTE_FARE_BIKE;
-	else if ((*env)->IsSameObject(env, type, (*env)->GetStaticObjectField(env, enum_class, (*env)->GetStaticFieldID(env, enum_class, "CHILD", "Lde/schildbach/pte/dto/Fare$Type;"))))
-		self->cached_type = GPTE_FARE_CHILD;
-	else if ((*env)->IsSameObject(env, type, (*env)->GetStaticObjectField(env, enum_class, (*env)->GetStaticFieldID(env, enum_class, "DISABLED", "Lde/schildbach/pte/dto/Fare$Type;"))))
-		self->cached_type = GPTE_FARE_DISABLED;
-	else if ((*env)->IsSameObject(env, type, (*env)->GetStaticObjectField(env, enum_class, (*env)->GetStaticFieldID(env, enum_class, "MILITARY", "Lde/schildbach/pte/dto/Fare$Type;"))))
-		self->cached_type = GPTE_FARE_MILITARY;
-	else if ((*env)->IsSameObject(env, type, (*env)->GetStaticObjectField(env, enum_class, (*env)->GetStaticFieldID(env, enum_class, "SENIOR", "Lde/schildbach/pte/dto/Fare$Type;"))))
-		self->cached_type = GPTE_FARE_SENIOR;
-	else if ((*env)->IsSameObject(env, type, (*env)->GetStaticObjectField(env, enum_class, (*env)->GetStaticFieldID(env, enum_class, "STUDENT", "Lde/schildbach/pte/dto/Fare$Type;"))))
-		self->cached_type = GPTE_FARE_STUDENT;
-	else if ((*env)->IsSameObject(env, type, (*env)->GetStaticObjectField(env, enum_class, (*env)->GetStaticFieldID(env, enum_class, "YOUTH", "Lde/schildbach/pte/dto/Fare$Type;"))))
-		self->cached_type = GPTE_FARE_YOUTH;
-	else {
+	jobject type = (*env)->GetObjectField(env, this, vm->jni.fare.type);
+	gint fare_type = gpte_jni_enum_decode(&vm->jni, env, &vm->jni.fare_type, type);
+	if (fare_type < 0) {
 		g_critical("Unknown fare type: %p", type);
 		return -1;
 	}
+	self->cached_type = fare_type;
 
 	self->cached |= GPTE_FARE_CACHED_TYPE;
 	return self->cached_type;
@@ -149,22 +133,17 @@ const GpteCurrency* gpte_fare_get_currency(GpteFare* self) {
 		return &self->cached_currency;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 8);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Fare");
-	jfieldID currency_id = (*env)->GetFieldID(env, class, "currency", "Ljava/util/Currency;");
-	jobject currency = (*env)->GetObjectField(env, this, currency_id);
+	jobject currency = (*env)->GetObjectField(env, this, vm->jni.fare.currency);
 
-	jclass currency_class = (*env)->FindClass(env, "java/util/Currency");
-	jmethodID get_code = (*env)->GetMethodID(env, currency_class, "getCurrencyCode", "()Ljava/lang/String;");
-	jstring code = (*env)->CallObjectMethod(env, currency, get_code);
+	jstring code = (*env)->CallObjectMethod(env, currency, vm->jni.currency.get_currency_code);
 	const char* code_utf = (*env)->GetStringUTFChars(env, code, NULL);
 	self->cached_currency.name = g_strdup(code_utf);
 	(*env)->ReleaseStringUTFChars(env, code, code_utf);
 
-	jmethodID get_symbol = (*env)->GetMethodID(env, currency_class, "getSymbol", "()Ljava/lang/String;");
-	jstring symbol = (*env)->CallObjectMethod(env, currency, get_symbol);
+	jstring symbol = (*env)->CallObjectMethod(env, currency, vm->jni.currency.get_symbol);
 	const char* symbol_utf = (*env)->GetStringUTFChars(env, symbol, NULL);
 	self->cached_currency.symbol = g_strdup(symbol_utf);
 	(*env)->ReleaseStringUTFChars(env, symbol, symbol_utf);
@@ -179,13 +158,24 @@ gfloat gpte_fare_get_fare(GpteFare* self) {
 		return self->cached_fare;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 2);
+	JNIEnv* env = gpte_jvm_get_env(vm);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Fare");
-	jfieldID fare_id = (*env)->GetFieldID(env, class, "fare", "F");
-	self->cached_fare = (*env)->GetFloatField(env, this, fare_id);
+	self->cached_fare = (*env)->GetFloatField(env, this, vm->jni.fare.fare);
 
 	self->cached |= GPTE_FARE_CACHED_FARE;
 	return self->cached_fare;
 }
+
+static void gpte_fare_hydrate(GpteJavaObject* object) {
+	GpteFare* self = GPTE_FARE(object);
+	gpte_fare_get_name(self);
+	gpte_fare_get_fare_type(self);
+	gpte_fare_get_currency(self);
+	gpte_fare_get_fare(self);
+}
+
+GpteFare* gpte_fare_snapshot(GpteFare* self) {
+	g_return_val_if_fail(GPTE_IS_FARE(self), NULL);
+	return GPTE_FARE(gpte_java_object_snapshot(GPTE_JAVA_OBJECT(self)));
+}
@@ -141,6 +141,17 @@ const GpteCurrency* gpte_fare_get_currency(GpteFare* self);
  */
 gfloat gpte_fare_get_fare(GpteFare* self);
 
+/**
+ * gpte_fare_snapshot:
+ * @self: the fare
+ *
+ * Copies @self into native memory, see
+ * [method@Gpte.JavaObject.snapshot].
+ *
+ * Returns: (transfer full): a detached copy of @self
+ */
+GpteFare* gpte_fare_snapshot(GpteFare* self);
+
 G_END_DECLS
 
 #endif // __GPTEFARE_H__
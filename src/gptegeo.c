@@ -34,13 +34,10 @@ void gpte_geo_point_free(GpteGeoPoint* self) {
 }
 
 GpteGeoPoint gpte_geo_point_from_java(GpteJvm* vm, jobject point) {
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	JNIEnv* env = gpte_jvm_get_env(vm);
 
-	jclass point_class = (*env)->FindClass(env, "de/schildbach/pte/dto/Point");
-	jmethodID get_lat = (*env)->GetMethodID(env, point_class, "getLatAsDouble", "()D");
-	jmethodID get_lon = (*env)->GetMethodID(env, point_class, "getLonAsDouble", "()D");
 	return (GpteGeoPoint){
-		.lat = (*env)->CallDoubleMethod(env, point, get_lat),
-		.lon = (*env)->CallDoubleMethod(env, point, get_lon)
+		.lat = (*env)->CallDoubleMethod(env, point, vm->jni.point.get_lat),
+		.lon = (*env)->CallDoubleMethod(env, point, vm->jni.point.get_lon)
 	};
 }
@@ -21,12 +21,19 @@
 
 #include <gptejavaobject.h>
 #include <gptejvm-priv.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
 jobject gpte_java_object_get(GpteJavaObject* self);
 JNIEnv* gpte_java_object_env(GpteJavaObject* self);
 
+// hydrates @self in place and releases its Java object, for children
+// that are owned by the object being snapshotted
+void gpte_java_object_detach(gpointer self);
+// replaces *@list by a detached copy
+void gpte_java_object_detach_list(GListModel** list);
+
 G_END_DECLS
 
 #endif // __GPTEJAVAOBJECT_PRIV_H__
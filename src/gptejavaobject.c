@@ -19,6 +19,8 @@
 #include "gptejavaobject.h"
 #include "gptejavaobject-priv.h"
 #include "gptejvm-priv.h"
+#include "gptelist.h"
+#include "gptestyle-priv.h"
 
 typedef struct {
 	GpteJvm* vm;
@@ -36,9 +38,11 @@ static GParamSpec* obj_properties[N_PROPERTIES] = { 0, };
 
 static void gpte_java_object_finalize(GObject* object) {
 	GpteJavaObjectPrivate* priv = gpte_java_object_get_instance_private(GPTE_JAVA_OBJECT(object));
-	JNIEnv* env = gpte_jvm_get_env(priv->vm);
-	(*env)->DeleteGlobalRef(env, priv->object);
-	gpte_jvm_unref(priv->vm);
+	// snapshots hold neither
+	if (priv->vm) {
+		gpte_jvm_release_global(priv->vm, priv->object);
+		gpte_jvm_unref(priv->vm);
+	}
 	G_OBJECT_CLASS(gpte_java_object_parent_class)->finalize(object);
 }
 
@@ -117,7 +121,7 @@ gboolean gpte_java_object_same(GpteJavaObject* a, GpteJavaObject* b) {
 		return TRUE;
 	GpteJavaObjectPrivate* ap = gpte_java_object_get_instance_private(a);
 	GpteJavaObjectPrivate* bp = gpte_java_object_get_instance_private(b);
-	if (ap->vm != bp->vm)
+	if (ap->vm != bp->vm || !ap->object || !bp->object)
 		return FALSE;
 	JNIEnv* env = gpte_jvm_get_env(ap->vm);
 	return (*env)->IsSameObject(env, ap->object, bp->object);
@@ -129,15 +133,13 @@ gboolean gpte_java_object_equal(GpteJavaObject* a, GpteJavaObject* b) {
 		return TRUE;
 	GpteJavaObjectPrivate* ap = gpte_java_object_get_instance_private(a);
 	GpteJavaObjectPrivate* bp = gpte_java_object_get_instance_private(b);
-	if (ap->vm != bp->vm)
+	// snapshots are only equal to themselves
+	if (ap->vm != bp->vm || !ap->object || !bp->object)
 		return FALSE;
 	JNIEnv* env = gpte_jvm_get_env(ap->vm);
 	if ((*env)->IsSameObject(env, ap->object, bp->object))
 		return TRUE;
-	g_auto(GpteScopeGuard) guard = gpte_jvm_enter_scope(ap->vm, 2);
-	jclass object_class = (*env)->FindClass(env, "java/lang/Object");
-	jmethodID equal_fun = (*env)->GetMethodID(env, object_class, "equals", "(Ljava/lang/Object;)Z");
-	return (*env)->CallBooleanMethod(env, ap->object, equal_fun, bp->object);
+	return (*env)->CallBooleanMethod(env, ap->object, ap->vm->jni.object.equals, bp->object);
 }
 
 typedef union {
@@ -147,10 +149,57 @@ typedef union {
 guint gpte_java_object_hash(GpteJavaObject* self) {
 	g_return_val_if_fail(GPTE_IS_JAVA_OBJECT(self), 0);
 	GpteJavaObjectPrivate* priv = gpte_java_object_get_instance_private(self);
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(priv->vm, 2);
-	jclass object_class = (*env)->FindClass(env, "java/lang/Object");
-	jmethodID hash_fun = (*env)->GetMethodID(env, object_class, "hashCode", "()I");
+	if (!priv->object)
+		return g_direct_hash(self);
+	JNIEnv* env = gpte_jvm_get_env(priv->vm);
 	GpteJavaObjetSignedNess hash;
-	hash.i = (*env)->CallIntMethod(env, priv->object, hash_fun);
+	hash.i = (*env)->CallIntMethod(env, priv->object, priv->vm->jni.object.hash_code);
 	return hash.u;
 }
+
+gboolean gpte_java_object_is_detached(GpteJavaObject* self) {
+	g_return_val_if_fail(GPTE_IS_JAVA_OBJECT(self), FALSE);
+	GpteJavaObjectPrivate* priv = gpte_java_object_get_instance_private(self);
+	return priv->object == NULL;
+}
+
+void gpte_java_object_detach(gpointer self) {
+	if (!self)
+		return;
+	GpteJavaObjectPrivate* priv = gpte_java_object_get_instance_private(self);
+	if (!priv->object)
+		return;
+
+	GpteJavaObjectClass* class = GPTE_JAVA_OBJECT_GET_CLASS(self);
+	if (class->hydrate)
+		class->hydrate(self);
+	gpte_jvm_release_global(priv->vm, priv->object);
+	priv->object = NULL;
+	// dropping a snapshot must never be the one to destroy the JVM
+	g_clear_pointer(&priv->vm, gpte_jvm_unref);
+}
+
+void gpte_java_object_detach_list(GListModel** list) {
+	if (!*list)
+		return;
+	GListModel* snapshot = gpte_list_snapshot(*list);
+	g_object_unref(*list);
+	*list = snapshot;
+}
+
+GpteJavaObject* gpte_java_object_snapshot(GpteJavaObject* self) {
+	g_return_val_if_fail(GPTE_IS_JAVA_OBJECT(self), NULL);
+	// lists are copied with gpte_list_snapshot()
+	g_return_val_if_fail(GPTE_JAVA_OBJECT_GET_CLASS(self)->hydrate != NULL, NULL);
+	GpteJavaObjectPrivate* priv = gpte_java_object_get_instance_private(self);
+	if (!priv->object)
+		return g_object_ref(self);
+
+	// a fresh wrapper, so the caches of @self are left alone
+	GpteJvm* vm = priv->vm;
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 16);
+	GpteJavaObject* copy = g_object_new(G_OBJECT_TYPE(self), "vm", vm, "object", priv->object, NULL);
+	gpte_style_cache_inherit(copy, self);
+	gpte_java_object_detach(copy);
+	return copy;
+}
@@ -32,8 +32,19 @@ G_BEGIN_DECLS
 #define GPTE_TYPE_JAVA_OBJECT (gpte_java_object_get_type())
 G_DECLARE_DERIVABLE_TYPE (GpteJavaObject, gpte_java_object, GPTE, JAVA_OBJECT, GObject)
 
+/**
+ * GpteJavaObjectClass:
+ * @parent_class: the parent class
+ * @hydrate: reads every field of the object from Java into native
+ *   storage, used by [method@Gpte.JavaObject.snapshot]
+ */
 struct _GpteJavaObjectClass {
 	GObjectClass parent_class;
+
+	void (*hydrate)(GpteJavaObject* self);
+
+	/*< private >*/
+	gpointer padding[7];
 };
 
 /**
@@ -41,7 +52,8 @@ struct _GpteJavaObjectClass {
  * @self: a java object wrapper
  *
  * Gets the Java VM wrapper that created/contains the object.
- * Returns: (transfer none): the Java VM wrapper
+ * Returns: (transfer none) (nullable): the Java VM wrapper, or %NULL if
+ *   @self is a snapshot
  */
 GpteJvm* gpte_java_object_get_vm(GpteJavaObject* self);
 
@@ -83,6 +95,38 @@ gboolean gpte_java_object_equal(GpteJavaObject* a, GpteJavaObject* b);
  */
 guint gpte_java_object_hash(GpteJavaObject* self);
 
+/**
+ * gpte_java_object_snapshot:
+ * @self: a java object wrapper
+ *
+ * Deep-copies @self, and every object reachable through its getters,
+ * into native memory. The returned object has no Java object behind it:
+ * its getters never call into the JVM, it may be read from any thread
+ * and freeing it doesn't need the JVM, it doesn't keep the
+ * [struct@Gpte.Jvm] alive either. Lists are copied into a
+ * [class@Gio.ListStore].
+ *
+ * The Java object of @self is released once @self is freed, so a
+ * query result may be snapshotted and dropped right away.
+ *
+ * Only data transfer objects can be snapshotted, use
+ * [func@Gpte.list_snapshot] for lists.
+ *
+ * Returns: (transfer full): a detached copy of @self, or @self if it is
+ *   detached already
+ */
+GpteJavaObject* gpte_java_object_snapshot(GpteJavaObject* self);
+
+/**
+ * gpte_java_object_is_detached:
+ * @self: a java object wrapper
+ *
+ * Checks if @self is a snapshot, see [method@Gpte.JavaObject.snapshot].
+ *
+ * Returns: %TRUE if @self has no Java object behind it
+ */
+gboolean gpte_java_object_is_detached(GpteJavaObject* self);
+
 G_END_DECLS
 
 #endif // __GPTEJAVAOBJECT_H__
@@ -0,0 +1,356 @@
+/*
+ * gpte - GObject bindings for public-transport-enabler
+ * Copyright (C) 2024  Florian "sp1rit" <sp1rit@disroot.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GPTEJNI_PRIV_H__
+#define __GPTEJNI_PRIV_H__
+
+#include <glib.h>
+#include <jni.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Pinned constants of a Java enum. constants is indexed by the GPTE side
+ * of the mapping (the matching C enum value, or the bit index for flags)
+ * and ordinals maps Enum.ordinal() back onto that index (-1 if unmapped).
+ */
+typedef struct {
+	jclass class;
+	jobject* constants;
+	gsize n_constants;
+	gint* ordinals;
+	gsize n_ordinals;
+} GpteJniEnum;
+
+typedef enum {
+	GPTE_JNI_DEPARTURES_STATUS_OK,
+	GPTE_JNI_DEPARTURES_STATUS_INVALID_STATION,
+	GPTE_JNI_DEPARTURES_STATUS_SERVICE_DOWN
+} GpteJniDeparturesStatus;
+
+typedef enum {
+	GPTE_JNI_TRIPS_STATUS_OK,
+	GPTE_JNI_TRIPS_STATUS_AMBIGUOUS,
+	GPTE_JNI_TRIPS_STATUS_TOO_CLOSE,
+	GPTE_JNI_TRIPS_STATUS_UNKNOWN_FROM,
+	GPTE_JNI_TRIPS_STATUS_UNKNOWN_VIA,
+	GPTE_JNI_TRIPS_STATUS_UNKNOWN_TO,
+	GPTE_JNI_TRIPS_STATUS_UNKNOWN_LOCATION,
+	GPTE_JNI_TRIPS_STATUS_UNRESOLVABLE_ADDRESS,
+	GPTE_JNI_TRIPS_STATUS_NO_TRIPS,
+	GPTE_JNI_TRIPS_STATUS_INVALID_DATE,
+	GPTE_JNI_TRIPS_STATUS_SERVICE_DOWN
+} GpteJniTripsStatus;
+
+typedef enum {
+	GPTE_JNI_NEARBY_STATUS_OK,
+	GPTE_JNI_NEARBY_STATUS_INVALID_ID,
+	GPTE_JNI_NEARBY_STATUS_SERVICE_DOWN
+} GpteJniNearbyStatus;
+
+typedef enum {
+	GPTE_JNI_SUGGEST_STATUS_OK,
+	GPTE_JNI_SUGGEST_STATUS_SERVICE_DOWN
+} GpteJniSuggestStatus;
+
+/*
+ * Classes, method and field IDs of everything GPTE touches on the Java
+ * side. They are resolved once when the JVM is created, so the getters
+ * only have to do the actual call.
+ * All jclass members and enum constants are global references.
+ */
+typedef struct {
+	GPtrArray* global_refs;
+	GPtrArray* enum_tables;
+
+	// java.*
+	struct {
+		jclass class;
+		jmethodID equals;
+		jmethodID hash_code;
+	} object;
+	struct {
+		jclass class;
+		jmethodID ordinal;
+	} enum_;
+	struct {
+		jclass class;
+		jmethodID get_system_class_loader;
+	} class_loader;
+	struct {
+		jclass class;
+		jmethodID get_message;
+	} throwable;
+	struct {
+		jclass class;
+	} io_exception;
+	struct {
+		jclass class;
+		jmethodID int_value;
+		jmethodID value_of;
+	} integer;
+	struct {
+		jclass class;
+		jmethodID value_of;
+	} boolean_;
+	struct {
+		jclass class;
+		jmethodID long_value;
+	} long_;
+	struct {
+		jclass class;
+		jmethodID init;
+		jmethodID get_time;
+	} date;
+	struct {
+		jclass class;
+		jmethodID get_currency_code;
+		jmethodID get_symbol;
+	} currency;
+	struct {
+		jclass class;
+		jmethodID size;
+		jmethodID get;
+		jmethodID sub_list;
+		jmethodID to_array;
+		jmethodID add_all;
+		jmethodID add_all_at;
+	} list;
+	struct {
+		jclass class;
+		jmethodID to_array;
+	} set;
+	struct {
+		jclass class;
+		jmethodID init;
+		jmethodID add;
+	} hash_set;
+
+	// de.schildbach.pte.dto.*
+	struct {
+		jclass class;
+		jmethodID from_double;
+		jmethodID get_lat;
+		jmethodID get_lon;
+	} point;
+	struct {
+		jclass class;
+		jfieldID code;
+	} product;
+	GpteJniEnum products;
+	struct {
+		jclass class;
+		jfieldID shape;
+		jfieldID background_color;
+		jfieldID background_color2;
+		jfieldID foreground_color;
+		jfieldID border_color;
+	} style;
+	GpteJniEnum style_shape;
+	GpteJniEnum location_type;
+	struct {
+		jclass class;
+		jfieldID type;
+		jfieldID id;
+		jfieldID coord;
+		jfieldID place;
+		jfieldID name;
+		jfieldID products;
+		jmethodID init;
+		jmethodID new_coord;
+	} location;
+	struct {
+		jclass class;
+		jfieldID id;
+		jfieldID network;
+		jfieldID product;
+		jfieldID label;
+		jfieldID name;
+		jfieldID style;
+		jfieldID attrs;
+		jfieldID message;
+	} line;
+	GpteJniEnum line_attr;
+	struct {
+		jclass class;
+		jfieldID line;
+		jfieldID destination;
+	} line_destination;
+	struct {
+		jclass class;
+		jfieldID name;
+		jfieldID section;
+	} position;
+	struct {
+		jclass class;
+		jfieldID planned_time;
+		jfieldID predicted_time;
+		jfieldID line;
+		jfieldID position;
+		jfieldID destination;
+		jfieldID message;
+		jmethodID get_time;
+	} departure;
+	struct {
+		jclass class;
+		jfieldID location;
+		jfieldID departures;
+		jfieldID lines;
+	} station_departures;
+	struct {
+		jclass class;
+		jfieldID location;
+		jmethodID get_arrival_time;
+		jmethodID get_departure_time;
+		jmethodID is_arrival_time_predicted;
+		jmethodID is_departure_time_predicted;
+		jmethodID get_arrival_delay;
+		jmethodID get_departure_delay;
+		jmethodID get_arrival_position;
+		jmethodID get_departure_position;
+		jmethodID is_arrival_position_predicted;
+		jmethodID is_departure_position_predicted;
+	} stop;
+	struct {
+		jclass class;
+		jfieldID name;
+		jfieldID type;
+		jfieldID currency;
+		jfieldID fare;
+	} fare;
+	GpteJniEnum fare_type;
+	struct {
+		jclass class;
+		jfieldID from;
+		jfieldID to;
+		jfieldID legs;
+		jfieldID fares;
+		jmethodID get_num_changes;
+		jmethodID get_duration;
+		jmethodID get_first_public_leg;
+		jmethodID get_last_public_leg;
+		jmethodID get_first_departure_time;
+		jmethodID get_last_arrival_time;
+		jmethodID get_min_time;
+		jmethodID get_max_time;
+		jmethodID is_travelable;
+		jmethodID products;
+	} trip;
+	struct {
+		jclass class;
+		jfieldID departure;
+		jfieldID arrival;
+		jfieldID path;
+		jmethodID get_departure_time;
+		jmethodID get_arrival_time;
+		jmethodID get_min_time;
+		jmethodID get_max_time;
+	} trip_leg;
+	struct {
+		jclass class;
+		jfieldID type;
+		jfieldID distance;
+	} trip_individual;
+	GpteJniEnum trip_individual_type;
+	struct {
+		jclass class;
+		jfieldID line;
+		jfieldID destination;
+		jfieldID departure_stop;
+		jfieldID arrival_stop;
+		jfieldID intermediate_stops;
+		jfieldID message;
+	} trip_public;
+	struct {
+		jclass class;
+		jmethodID init;
+	} trip_options;
+	struct {
+		jclass class;
+		jfieldID status;
+		jfieldID station_departures;
+	} query_departures_result;
+	GpteJniEnum query_departures_status;
+	struct {
+		jclass class;
+		jfieldID status;
+		jfieldID ambiguous_from;
+		jfieldID ambiguous_via;
+		jfieldID ambiguous_to;
+		jfieldID from;
+		jfieldID via;
+		jfieldID to;
+		jfieldID context;
+		jfieldID trips;
+	} query_trips_result;
+	GpteJniEnum query_trips_status;
+	struct {
+		jclass class;
+		jfieldID status;
+		jfieldID locations;
+	} nearby_locations_result;
+	GpteJniEnum nearby_locations_status;
+	struct {
+		jclass class;
+		jfieldID status;
+		jmethodID get_locations;
+	} suggest_locations_result;
+	GpteJniEnum suggest_locations_status;
+
+	// de.schildbach.pte.*
+	struct {
+		jclass class;
+		jmethodID default_products;
+		jmethodID has_capabilities;
+		jmethodID get_area;
+		jmethodID line_style;
+		jmethodID query_departures;
+		jmethodID query_trips;
+		jmethodID query_more_trips;
+		jmethodID query_nearby_locations;
+		jmethodID suggest_locations;
+	} network_provider;
+	GpteJniEnum capability;
+	GpteJniEnum optimize;
+	GpteJniEnum walk_speed;
+	GpteJniEnum accessibility;
+	GpteJniEnum trip_flag;
+
+	// gpte helpers, see src/GpteBulk.java and src/GpteCall.java
+	struct {
+		jclass class;
+		jmethodID pack_trips;
+		jmethodID pack_departures;
+	} bulk;
+	struct {
+		jclass class;
+		jmethodID init;
+		jmethodID execute;
+		jmethodID cancel;
+	} call;
+} GpteJni;
+
+gboolean gpte_jni_init(GpteJni* self, JNIEnv* env, GError** err);
+void gpte_jni_clear(GpteJni* self, JNIEnv* env);
+
+#define GPTE_JNI_ENUM_CONSTANT(type,i) ((gsize)(i) < (type).n_constants ? (type).constants[(i)] : NULL)
+gint gpte_jni_enum_decode(const GpteJni* self, JNIEnv* env, const GpteJniEnum* type, jobject value);
+
+G_END_DECLS
+
+#endif // __GPTEJNI_PRIV_H__
@@ -0,0 +1,512 @@
+/*
+ * gpte - GObject bindings for public-transport-enabler
+ * Copyright (C) 2024  Florian "sp1rit" <sp1rit@disroot.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gptejni-priv.h"
+
+#include <gio/gio.h>
+
+#include "gpteerrors.h"
+#include "gptelocation.h"
+#include "gptestyle.h"
+#include "gptefare.h"
+#include "gptetripleg.h"
+#include "gptetrips.h"
+
+// Flags (GpteProducts, GpteLineAttrs, ...) are indexed by bit, everything
+// else by the value of the matching C enum.
+static const gchar* const gpte_jni_products_names[] = {
+	"HIGH_SPEED_TRAIN", "REGIONAL_TRAIN", "SUBURBAN_TRAIN", "SUBWAY", "TRAM", "BUS", "FERRY", "CABLECAR", "ON_DEMAND"
+};
+static const gchar* const gpte_jni_style_shape_names[] = {
+	[GPTE_STYLE_SHAPE_RECT] = "RECT",
+	[GPTE_STYLE_SHAPE_ROUNDED] = "ROUNDED",
+	[GPTE_STYLE_SHAPE_CIRCLE] = "CIRCLE"
+};
+static const gchar* const gpte_jni_location_type_names[] = {
+	[GPTE_LOCATION_ANY] = "ANY",
+	[GPTE_LOCATION_STATION] = "STATION",
+	[GPTE_LOCATION_POI] = "POI",
+	[GPTE_LOCATION_ADDRESS] = "ADDRESS",
+	[GPTE_LOCATION_COORD] = "COORD"
+};
+static const gchar* const gpte_jni_line_attr_names[] = {
+	"CIRCLE_CLOCKWISE", "CIRCLE_ANTICLOCKWISE", "SERVICE_REPLACEMENT", "LINE_AIRPORT", "WHEEL_CHAIR_ACCESS", "BICYCLE_CARRIAGE"
+};
+static const gchar* const gpte_jni_fare_type_names[] = {
+	[GPTE_FARE_ADULT] = "ADULT",
+	[GPTE_FARE_BIKE] = "BIKE",
+	[GPTE_FARE_CHILD] = "CHILD",
+	[GPTE_FARE_DISABLED] = "DISABLED",
+	[GPTE_FARE_MILITARY] = "MILITARY",
+	[GPTE_FARE_SENIOR] = "SENIOR",
+	[GPTE_FARE_STUDENT] = "STUDENT",
+	[GPTE_FARE_YOUTH] = "YOUTH"
+};
+static const gchar* const gpte_jni_trip_individual_type_names[] = {
+	[GPTE_TRIP_INDIVIDUAL_NULL] = NULL,
+	[GPTE_TRIP_INDIVIDUAL_BIKE] = "BIKE",
+	[GPTE_TRIP_INDIVIDUAL_CAR] = "CAR",
+	[GPTE_TRIP_INDIVIDUAL_CHECK_IN] = "CHECK_IN",
+	[GPTE_TRIP_INDIVIDUAL_CHECK_OUT] = "CHECK_OUT",
+	[GPTE_TRIP_INDIVIDUAL_TRANSFER] = "TRANSFER",
+	[GPTE_TRIP_INDIVIDUAL_WALK] = "WALK"
+};
+static const gchar* const gpte_jni_query_departures_status_names[] = {
+	[GPTE_JNI_DEPARTURES_STATUS_OK] = "OK",
+	[GPTE_JNI_DEPARTURES_STATUS_INVALID_STATION] = "INVALID_STATION",
+	[GPTE_JNI_DEPARTURES_STATUS_SERVICE_DOWN] = "SERVICE_DOWN"
+};
+static const gchar* const gpte_jni_query_trips_status_names[] = {
+	[GPTE_JNI_TRIPS_STATUS_OK] = "OK",
+	[GPTE_JNI_TRIPS_STATUS_AMBIGUOUS] = "AMBIGUOUS",
+	[GPTE_JNI_TRIPS_STATUS_TOO_CLOSE] = "TOO_CLOSE",
+	[GPTE_JNI_TRIPS_STATUS_UNKNOWN_FROM] = "UNKNOWN_FROM",
+	[GPTE_JNI_TRIPS_STATUS_UNKNOWN_VIA] = "UNKNOWN_VIA",
+	[GPTE_JNI_TRIPS_STATUS_UNKNOWN_TO] = "UNKNOWN_TO",
+	[GPTE_JNI_TRIPS_STATUS_UNKNOWN_LOCATION] = "UNKNOWN_LOCATION",
+	[GPTE_JNI_TRIPS_STATUS_UNRESOLVABLE_ADDRESS] = "UNRESOLVABLE_ADDRESS",
+	[GPTE_JNI_TRIPS_STATUS_NO_TRIPS] = "NO_TRIPS",
+	[GPTE_JNI_TRIPS_STATUS_INVALID_DATE] = "INVALID_DATE",
+	[GPTE_JNI_TRIPS_STATUS_SERVICE_DOWN] = "SERVICE_DOWN"
+};
+static const gchar* const gpte_jni_nearby_locations_status_names[] = {
+	[GPTE_JNI_NEARBY_STATUS_OK] = "OK",
+	[GPTE_JNI_NEARBY_STATUS_INVALID_ID] = "INVALID_ID",
+	[GPTE_JNI_NEARBY_STATUS_SERVICE_DOWN] = "SERVICE_DOWN"
+};
+static const gchar* const gpte_jni_suggest_locations_status_names[] = {
+	[GPTE_JNI_SUGGEST_STATUS_OK] = "OK",
+	[GPTE_JNI_SUGGEST_STATUS_SERVICE_DOWN] = "SERVICE_DOWN"
+};
+static const gchar* const gpte_jni_capability_names[] = {
+	"DEPARTURES", "NEARBY_LOCATIONS", "SUGGEST_LOCATIONS", "TRIPS", "TRIPS_VIA"
+};
+static const gchar* const gpte_jni_optimize_names[] = {
+	[GPTE_OPTIMIZE_LEAST_DURATION] = "LEAST_DURATION",
+	[GPTE_OPTIMIZE_LEAST_CHANGES] = "LEAST_CHANGES",
+	[GPTE_OPTIMIZE_LEAST_WALKING] = "LEAST_WALKING"
+};
+static const gchar* const gpte_jni_walk_speed_names[] = {
+	[GPTE_WALK_SLOW] = "SLOW",
+	[GPTE_WALK_NORMAL] = "NORMAL",
+	[GPTE_WALK_FAST] = "FAST"
+};
+static const gchar* const gpte_jni_accessibility_names[] = {
+	[GPTE_ACCESSIBILITY_NEUTRAL] = "NEUTRAL",
+	[GPTE_ACCESSIBILITY_LIMITED] = "LIMITED",
+	[GPTE_ACCESSIBILITY_BARRIER_FREE] = "BARRIER_FREE"
+};
+static const gchar* const gpte_jni_trip_flag_names[] = {
+	"BIKE"
+};
+
+// turns @local into a global reference owned by @self
+static jclass gpte_jni_pin_class(GpteJni* self, JNIEnv* env, jclass local) {
+	jclass global = (*env)->NewGlobalRef(env, local);
+	(*env)->DeleteLocalRef(env, local);
+	g_ptr_array_add(self->global_refs, global);
+	return global;
+}
+
+static jclass gpte_jni_find_class(GpteJni* self, JNIEnv* env, const gchar* name, GError** err) {
+	jclass local = (*env)->FindClass(env, name);
+	if (!local) {
+		(*env)->ExceptionClear(env);
+		g_set_error(err, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_INIT_FAILED, "Unable to resolve class %s", name);
+		return NULL;
+	}
+	return gpte_jni_pin_class(self, env, local);
+}
+
+// defines a class shipped in the resources, using the system class
+// loader so it can see the classes of the jar. Another GpteJvm on the
+// same JVM may have defined it already.
+static jclass gpte_jni_define_class(GpteJni* self, JNIEnv* env, const gchar* name, GError** err) {
+	jclass local = (*env)->FindClass(env, name);
+	if (local)
+		return gpte_jni_pin_class(self, env, local);
+	(*env)->ExceptionClear(env);
+
+	g_autofree gchar* path = g_strdup_printf("/arpa/sp1rit/gpte/helpers/%s.class", name);
+	g_autoptr(GBytes) bytes = g_resources_lookup_data(path, G_RESOURCE_LOOKUP_FLAGS_NONE, err);
+	if (!bytes)
+		return NULL;
+
+	jobject loader = (*env)->CallStaticObjectMethod(env, self->class_loader.class, self->class_loader.get_system_class_loader);
+	gsize len;
+	const jbyte* data = g_bytes_get_data(bytes, &len);
+	local = (*env)->DefineClass(env, name, loader, data, len);
+	(*env)->DeleteLocalRef(env, loader);
+	if (!local) {
+		(*env)->ExceptionClear(env);
+		g_set_error(err, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_INIT_FAILED, "Unable to define class %s", name);
+		return NULL;
+	}
+	return gpte_jni_pin_class(self, env, local);
+}
+
+static gpointer gpte_jni_check_id(JNIEnv* env, gpointer id, const gchar* kind, const gchar* class_name, const gchar* name, const gchar* sig, GError** err) {
+	if (!id) {
+		(*env)->ExceptionClear(env);
+		g_set_error(err, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_INIT_FAILED, "Unable to resolve %s %s.%s %s", kind, class_name, name, sig);
+	}
+	return id;
+}
+
+static gboolean gpte_jni_enum_init(GpteJni* self, JNIEnv* env, GpteJniEnum* type, const gchar* class_name, const gchar* const* names, gsize n_names, GError** err) {
+	if (!(type->class = gpte_jni_find_class(self, env, class_name, err)))
+		return FALSE;
+
+	g_autofree gchar* sig = g_strdup_printf("L%s;", class_name);
+	g_autofree jint* ordinals = g_new(jint, n_names);
+	jint max_ordinal = -1;
+
+	type->constants = g_new0(jobject, n_names);
+	type->n_constants = n_names;
+	g_ptr_array_add(self->enum_tables, type->constants);
+
+	for (gsize i = 0; i < n_names; i++) {
+		ordinals[i] = -1;
+		if (!names[i])
+			continue;
+
+		jfieldID id = gpte_jni_check_id(env, (*env)->GetStaticFieldID(env, type->class, names[i], sig), "static field", class_name, names[i], sig, err);
+		if (!id)
+			return FALSE;
+		jobject local = (*env)->GetStaticObjectField(env, type->class, id);
+		type->constants[i] = (*env)->NewGlobalRef(env, local);
+		(*env)->DeleteLocalRef(env, local);
+		g_ptr_array_add(self->global_refs, type->constants[i]);
+
+		ordinals[i] = (*env)->CallIntMethod(env, type->constants[i], self->enum_.ordinal);
+		max_ordinal = MAX(max_ordinal, ordinals[i]);
+	}
+
+	type->n_ordinals = max_ordinal + 1;
+	type->ordinals = g_new(gint, type->n_ordinals);
+	g_ptr_array_add(self->enum_tables, type->ordinals);
+	for (gsize i = 0; i < type->n_ordinals; i++)
+		type->ordinals[i] = -1;
+	for (gsize i = 0; i < n_names; i++)
+		if (ordinals[i] >= 0)
+			type->ordinals[ordinals[i]] = i;
+	return TRUE;
+}
+
+gint gpte_jni_enum_decode(const GpteJni* self, JNIEnv* env, const GpteJniEnum* type, jobject value) {
+	if (!value)
+		return -1;
+	jint ordinal = (*env)->CallIntMethod(env, value, self->enum_.ordinal);
+	if (ordinal < 0 || (gsize)ordinal >= type->n_ordinals)
+		return -1;
+	return type->ordinals[ordinal];
+}
+
+#define GPTE_JNI_CLASS(m,name) \
+	class_name = (name); \
+	if (!(self->m.class = gpte_jni_find_class(self, env, class_name, err))) \
+		goto err;
+#define GPTE_JNI_HELPER_CLASS(m,name) \
+	class_name = (name); \
+	if (!(self->m.class = gpte_jni_define_class(self, env, class_name, err))) \
+		goto err;
+#define GPTE_JNI_METHOD(m,id,name,sig) \
+	if (!(self->m.id = gpte_jni_check_id(env, (*env)->GetMethodID(env, self->m.class, (name), (sig)), "method", class_name, (name), (sig), err))) \
+		goto err;
+#define GPTE_JNI_STATIC_METHOD(m,id,name,sig) \
+	if (!(self->m.id = gpte_jni_check_id(env, (*env)->GetStaticMethodID(env, self->m.class, (name), (sig)), "static method", class_name, (name), (sig), err))) \
+		goto err;
+#define GPTE_JNI_FIELD(m,id,name,sig) \
+	if (!(self->m.id = gpte_jni_check_id(env, (*env)->GetFieldID(env, self->m.class, (name), (sig)), "field", class_name, (name), (sig), err))) \
+		goto err;
+
+#define GPTE_JNI_ENUM(m,name) \
+	class_name = (name); \
+	if (!gpte_jni_enum_init(self, env, &self->m, class_name, gpte_jni_##m##_names, G_N_ELEMENTS(gpte_jni_##m##_names), err)) \
+		goto err;
+
+#define GPTE_JNI_DTO(cn) "de/schildbach/pte/dto/" cn
+#define GPTE_JNI_DTO_SIG(cn) "Lde/schildbach/pte/dto/" cn ";"
+
+gboolean gpte_jni_init(GpteJni* self, JNIEnv* env, GError** err) {
+	g_return_val_if_fail(!err || !*err, FALSE);
+	const gchar* class_name;
+
+	*self = (GpteJni){ 0 };
+	self->global_refs = g_ptr_array_new();
+	self->enum_tables = g_ptr_array_new_with_free_func(g_free);
+
+	GPTE_JNI_CLASS(object, "java/lang/Object")
+	GPTE_JNI_METHOD(object, equals, "equals", "(Ljava/lang/Object;)Z")
+	GPTE_JNI_METHOD(object, hash_code, "hashCode", "()I")
+
+	GPTE_JNI_CLASS(enum_, "java/lang/Enum")
+	GPTE_JNI_METHOD(enum_, ordinal, "ordinal", "()I")
+
+	GPTE_JNI_CLASS(class_loader, "java/lang/ClassLoader")
+	GPTE_JNI_STATIC_METHOD(class_loader, get_system_class_loader, "getSystemClassLoader", "()Ljava/lang/ClassLoader;")
+
+	GPTE_JNI_CLASS(throwable, "java/lang/Throwable")
+	GPTE_JNI_METHOD(throwable, get_message, "getMessage", "()Ljava/lang/String;")
+
+	GPTE_JNI_CLASS(io_exception, "java/io/IOException")
+
+	GPTE_JNI_CLASS(integer, "java/lang/Integer")
+	GPTE_JNI_METHOD(integer, int_value, "intValue", "()I")
+	GPTE_JNI_STATIC_METHOD(integer, value_of, "valueOf", "(I)Ljava/lang/Integer;")
+
+	GPTE_JNI_CLASS(boolean_, "java/lang/Boolean")
+	GPTE_JNI_STATIC_METHOD(boolean_, value_of, "valueOf", "(Z)Ljava/lang/Boolean;")
+
+	GPTE_JNI_CLASS(long_, "java/lang/Long")
+	GPTE_JNI_METHOD(long_, long_value, "longValue", "()J")
+
+	GPTE_JNI_CLASS(date, "java/util/Date")
+	GPTE_JNI_METHOD(date, init, "<init>", "(J)V")
+	GPTE_JNI_METHOD(date, get_time, "getTime", "()J")
+
+	GPTE_JNI_CLASS(currency, "java/util/Currency")
+	GPTE_JNI_METHOD(currency, get_currency_code, "getCurrencyCode", "()Ljava/lang/String;")
+	GPTE_JNI_METHOD(currency, get_symbol, "getSymbol", "()Ljava/lang/String;")
+
+	GPTE_JNI_CLASS(list, "java/util/List")
+	GPTE_JNI_METHOD(list, size, "size", "()I")
+	GPTE_JNI_METHOD(list, get, "get", "(I)Ljava/lang/Object;")
+	GPTE_JNI_METHOD(list, sub_list, "subList", "(II)Ljava/util/List;")
+	GPTE_JNI_METHOD(list, to_array, "toArray", "()[Ljava/lang/Object;")
+	GPTE_JNI_METHOD(list, add_all, "addAll", "(Ljava/util/Collection;)Z")
+	GPTE_JNI_METHOD(list, add_all_at, "addAll", "(ILjava/util/Collection;)Z")
+
+	GPTE_JNI_CLASS(set, "java/util/Set")
+	GPTE_JNI_METHOD(set, to_array, "toArray", "()[Ljava/lang/Object;")
+
+	GPTE_JNI_CLASS(hash_set, "java/util/HashSet")
+	GPTE_JNI_METHOD(hash_set, init, "<init>", "()V")
+	GPTE_JNI_METHOD(hash_set, add, "add", "(Ljava/lang/Object;)Z")
+
+
+	GPTE_JNI_CLASS(point, GPTE_JNI_DTO("Point"))
+	GPTE_JNI_STATIC_METHOD(point, from_double, "fromDouble", "(DD)" GPTE_JNI_DTO_SIG("Point"))
+	GPTE_JNI_METHOD(point, get_lat, "getLatAsDouble", "()D")
+	GPTE_JNI_METHOD(point, get_lon, "getLonAsDouble", "()D")
+
+	GPTE_JNI_CLASS(product, GPTE_JNI_DTO("Product"))
+	GPTE_JNI_FIELD(product, code, "code", "C")
+	GPTE_JNI_ENUM(products, GPTE_JNI_DTO("Product"))
+
+	GPTE_JNI_CLASS(style, GPTE_JNI_DTO("Style"))
+	GPTE_JNI_FIELD(style, shape, "shape", GPTE_JNI_DTO_SIG("Style$Shape"))
+	GPTE_JNI_FIELD(style, background_color, "backgroundColor", "I")
+	GPTE_JNI_FIELD(style, background_color2, "backgroundColor2", "I")
+	GPTE_JNI_FIELD(style, foreground_color, "foregroundColor", "I")
+	GPTE_JNI_FIELD(style, border_color, "borderColor", "I")
+
+	GPTE_JNI_ENUM(style_shape, GPTE_JNI_DTO("Style$Shape"))
+	GPTE_JNI_ENUM(location_type, GPTE_JNI_DTO("LocationType"))
+
+	GPTE_JNI_CLASS(location, GPTE_JNI_DTO("Location"))
+	GPTE_JNI_FIELD(location, type, "type", GPTE_JNI_DTO_SIG("LocationType"))
+	GPTE_JNI_FIELD(location, id, "id", "Ljava/lang/String;")
+	GPTE_JNI_FIELD(location, coord, "coord", GPTE_JNI_DTO_SIG("Point"))
+	GPTE_JNI_FIELD(location, place, "place", "Ljava/lang/String;")
+	GPTE_JNI_FIELD(location, name, "name", "Ljava/lang/String;")
+	GPTE_JNI_FIELD(location, products, "products", "Ljava/util/Set;")
+	GPTE_JNI_METHOD(location, init, "<init>", "(" GPTE_JNI_DTO_SIG("LocationType") "Ljava/lang/String;" GPTE_JNI_DTO_SIG("Point") "Ljava/lang/String;Ljava/lang/String;Ljava/util/Set;)V")
+	GPTE_JNI_STATIC_METHOD(location, new_coord, "coord", "(" GPTE_JNI_DTO_SIG("Point") ")" GPTE_JNI_DTO_SIG("Location"))
+
+	GPTE_JNI_CLASS(line, GPTE_JNI_DTO("Line"))
+	GPTE_JNI_FIELD(line, id, "id", "Ljava/lang/String;")
+	GPTE_JNI_FIELD(line, network, "network", "Ljava/lang/String;")
+	GPTE_JNI_FIELD(line, product, "product", GPTE_JNI_DTO_SIG("Product"))
+	GPTE_JNI_FIELD(line, label, "label", "Ljava/lang/String;")
+	GPTE_JNI_FIELD(line, name, "name", "Ljava/lang/String;")
+	GPTE_JNI_FIELD(line, style, "style", GPTE_JNI_DTO_SIG("Style"))
+	GPTE_JNI_FIELD(line, attrs, "attrs", "Ljava/util/Set;")
+	GPTE_JNI_FIELD(line, message, "message", "Ljava/lang/String;")
+
+	GPTE_JNI_ENUM(line_attr, GPTE_JNI_DTO("Line$Attr"))
+
+	GPTE_JNI_CLASS(line_destination, GPTE_JNI_DTO("LineDestination"))
+	GPTE_JNI_FIELD(line_destination, line, "line", GPTE_JNI_DTO_SIG("Line"))
+	GPTE_JNI_FIELD(line_destination, destination, "destination", GPTE_JNI_DTO_SIG("Location"))
+
+	GPTE_JNI_CLASS(position, GPTE_JNI_DTO("Position"))
+	GPTE_JNI_FIELD(position, name, "name", "Ljava/lang/String;")
+	GPTE_JNI_FIELD(position, section, "section", "Ljava/lang/String;")
+
+	GPTE_JNI_CLASS(departure, GPTE_JNI_DTO("Departure"))
+	GPTE_JNI_FIELD(departure, planned_time, "plannedTime", "Ljava/util/Date;")
+	GPTE_JNI_FIELD(departure, predicted_time, "predictedTime", "Ljava/util/Date;")
+	GPTE_JNI_FIELD(departure, line, "line", GPTE_JNI_DTO_SIG("Line"))
+	GPTE_JNI_FIELD(departure, position, "position", GPTE_JNI_DTO_SIG("Position"))
+	GPTE_JNI_FIELD(departure, destination, "destination", GPTE_JNI_DTO_SIG("Location"))
+	GPTE_JNI_FIELD(departure, message, "message", "Ljava/lang/String;")
+	GPTE_JNI_METHOD(departure, get_time, "getTime", "()Ljava/util/Date;")
+
+	GPTE_JNI_CLASS(station_departures, GPTE_JNI_DTO("StationDepartures"))
+	GPTE_JNI_FIELD(station_departures, location, "location", GPTE_JNI_DTO_SIG("Location"))
+	GPTE_JNI_FIELD(station_departures, departures, "departures", "Ljava/util/List;")
+	GPTE_JNI_FIELD(station_departures, lines, "lines", "Ljava/util/List;")
+
+	GPTE_JNI_CLASS(stop, GPTE_JNI_DTO("Stop"))
+	GPTE_JNI_FIELD(stop, location, "location", GPTE_JNI_DTO_SIG("Location"))
+	GPTE_JNI_METHOD(stop, get_arrival_time, "getArrivalTime", "()Ljava/util/Date;")
+	GPTE_JNI_METHOD(stop, get_departure_time, "getDepartureTime", "()Ljava/util/Date;")
+	GPTE_JNI_METHOD(stop, is_arrival_time_predicted, "isArrivalTimePredicted", "()Z")
+	GPTE_JNI_METHOD(stop, is_departure_time_predicted, "isDepartureTimePredicted", "()Z")
+	GPTE_JNI_METHOD(stop, get_arrival_delay, "getArrivalDelay", "()Ljava/lang/Long;")
+	GPTE_JNI_METHOD(stop, get_departure_delay, "getDepartureDelay", "()Ljava/lang/Long;")
+	GPTE_JNI_METHOD(stop, get_arrival_position, "getArrivalPosition", "()" GPTE_JNI_DTO_SIG("Position"))
+	GPTE_JNI_METHOD(stop, get_departure_position, "getDeparturePosition", "()" GPTE_JNI_DTO_SIG("Position"))
+	GPTE_JNI_METHOD(stop, is_arrival_position_predicted, "isArrivalPositionPredicted", "()Z")
+	GPTE_JNI_METHOD(stop, is_departure_position_predicted, "isDeparturePositionPredicted", "()Z")
+
+	GPTE_JNI_CLASS(fare, GPTE_JNI_DTO("Fare"))
+	GPTE_JNI_FIELD(fare, name, "name", "Ljava/lang/String;")
+	GPTE_JNI_FIELD(fare, type, "type", GPTE_JNI_DTO_SIG("Fare$Type"))
+	GPTE_JNI_FIELD(fare, currency, "currency", "Ljava/util/Currency;")
+	GPTE_JNI_FIELD(fare, fare, "fare", "F")
+
+	GPTE_JNI_ENUM(fare_type, GPTE_JNI_DTO("Fare$Type"))
+
+	GPTE_JNI_CLASS(trip, GPTE_JNI_DTO("Trip"))
+	GPTE_JNI_FIELD(trip, from, "from", GPTE_JNI_DTO_SIG("Location"))
+	GPTE_JNI_FIELD(trip, to, "to", GPTE_JNI_DTO_SIG("Location"))
+	GPTE_JNI_FIELD(trip, legs, "legs", "Ljava/util/List;")
+	GPTE_JNI_FIELD(trip, fares, "fares", "Ljava/util/List;")
+	GPTE_JNI_METHOD(trip, get_num_changes, "getNumChanges", "()Ljava/lang/Integer;")
+	GPTE_JNI_METHOD(trip, get_duration, "getDuration", "()J")
+	GPTE_JNI_METHOD(trip, get_first_public_leg, "getFirstPublicLeg", "()" GPTE_JNI_DTO_SIG("Trip$Public"))
+	GPTE_JNI_METHOD(trip, get_last_public_leg, "getLastPublicLeg", "()" GPTE_JNI_DTO_SIG("Trip$Public"))
+	GPTE_JNI_METHOD(trip, get_first_departure_time, "getFirstDepartureTime", "()Ljava/util/Date;")
+	GPTE_JNI_METHOD(trip, get_last_arrival_time, "getLastArrivalTime", "()Ljava/util/Date;")
+	GPTE_JNI_METHOD(trip, get_min_time, "getMinTime", "()Ljava/util/Date;")
+	GPTE_JNI_METHOD(trip, get_max_time, "getMaxTime", "()Ljava/util/Date;")
+	GPTE_JNI_METHOD(trip, is_travelable, "isTravelable", "()Z")
+	GPTE_JNI_METHOD(trip, products, "products", "()Ljava/util/Set;")
+
+	GPTE_JNI_CLASS(trip_leg, GPTE_JNI_DTO("Trip$Leg"))
+	GPTE_JNI_FIELD(trip_leg, departure, "departure", GPTE_JNI_DTO_SIG("Location"))
+	GPTE_JNI_FIELD(trip_leg, arrival, "arrival", GPTE_JNI_DTO_SIG("Location"))
+	GPTE_JNI_FIELD(trip_leg, path, "path", "Ljava/util/List;")
+	GPTE_JNI_METHOD(trip_leg, get_departure_time, "getDepartureTime", "()Ljava/util/Date;")
+	GPTE_JNI_METHOD(trip_leg, get_arrival_time, "getArrivalTime", "()Ljava/util/Date;")
+	GPTE_JNI_METHOD(trip_leg, get_min_time, "getMinTime", "()Ljava/util/Date;")
+	GPTE_JNI_METHOD(trip_leg, get_max_time, "getMaxTime", "()Ljava/util/Date;")
+
+	GPTE_JNI_CLASS(trip_individual, GPTE_JNI_DTO("Trip$Individual"))
+	GPTE_JNI_FIELD(trip_individual, type, "type", GPTE_JNI_DTO_SIG("Trip$Individual$Type"))
+	GPTE_JNI_FIELD(trip_individual, distance, "distance", "I")
+
+	GPTE_JNI_ENUM(trip_individual_type, GPTE_JNI_DTO("Trip$Individual$Type"))
+
+	GPTE_JNI_CLASS(trip_public, GPTE_JNI_DTO("Trip$Public"))
+	GPTE_JNI_FIELD(trip_public, line, "line", GPTE_JNI_DTO_SIG("Line"))
+	GPTE_JNI_FIELD(trip_public, destination, "destination", GPTE_JNI_DTO_SIG("Location"))
+	GPTE_JNI_FIELD(trip_public, departure_stop, "departureStop", GPTE_JNI_DTO_SIG("Stop"))
+	GPTE_JNI_FIELD(trip_public, arrival_stop, "arrivalStop", GPTE_JNI_DTO_SIG("Stop"))
+	GPTE_JNI_FIELD(trip_public, intermediate_stops, "intermediateStops", "Ljava/util/List;")
+	GPTE_JNI_FIELD(trip_public, message, "message", "Ljava/lang/String;")
+
+	GPTE_JNI_CLASS(trip_options, GPTE_JNI_DTO("TripOptions"))
+	GPTE_JNI_METHOD(trip_options, init, "<init>", "("
+		"Ljava/util/Set;"
+		"Lde/schildbach/pte/NetworkProvider$Optimize;"
+		"Lde/schildbach/pte/NetworkProvider$WalkSpeed;"
+		"Lde/schildbach/pte/NetworkProvider$Accessibility;"
+		"Ljava/util/Set;"
+	")V")
+
+	GPTE_JNI_CLASS(query_departures_result, GPTE_JNI_DTO("QueryDeparturesResult"))
+	GPTE_JNI_FIELD(query_departures_result, status, "status", GPTE_JNI_DTO_SIG("QueryDeparturesResult$Status"))
+	GPTE_JNI_FIELD(query_departures_result, station_departures, "stationDepartures", "Ljava/util/List;")
+	GPTE_JNI_ENUM(query_departures_status, GPTE_JNI_DTO("QueryDeparturesResult$Status"))
+
+	GPTE_JNI_CLASS(query_trips_result, GPTE_JNI_DTO("QueryTripsResult"))
+	GPTE_JNI_FIELD(query_trips_result, status, "status", GPTE_JNI_DTO_SIG("QueryTripsResult$Status"))
+	GPTE_JNI_FIELD(query_trips_result, ambiguous_from, "ambiguousFrom", "Ljava/util/List;")
+	GPTE_JNI_FIELD(query_trips_result, ambiguous_via, "ambiguousVia", "Ljava/util/List;")
+	GPTE_JNI_FIELD(query_trips_result, ambiguous_to, "ambiguousTo", "Ljava/util/List;")
+	GPTE_JNI_FIELD(query_trips_result, from, "from", GPTE_JNI_DTO_SIG("Location"))
+	GPTE_JNI_FIELD(query_trips_result, via, "via", GPTE_JNI_DTO_SIG("Location"))
+	GPTE_JNI_FIELD(query_trips_result, to, "to", GPTE_JNI_DTO_SIG("Location"))
+	GPTE_JNI_FIELD(query_trips_result, context, "context", GPTE_JNI_DTO_SIG("QueryTripsContext"))
+	GPTE_JNI_FIELD(query_trips_result, trips, "trips", "Ljava/util/List;")
+	GPTE_JNI_ENUM(query_trips_status, GPTE_JNI_DTO("QueryTripsResult$Status"))
+
+	GPTE_JNI_CLASS(nearby_locations_result, GPTE_JNI_DTO("NearbyLocationsResult"))
+	GPTE_JNI_FIELD(nearby_locations_result, status, "status", GPTE_JNI_DTO_SIG("NearbyLocationsResult$Status"))
+	GPTE_JNI_FIELD(nearby_locations_result, locations, "locations", "Ljava/util/List;")
+	GPTE_JNI_ENUM(nearby_locations_status, GPTE_JNI_DTO("NearbyLocationsResult$Status"))
+
+	GPTE_JNI_CLASS(suggest_locations_result, GPTE_JNI_DTO("SuggestLocationsResult"))
+	GPTE_JNI_FIELD(suggest_locations_result, status, "status", GPTE_JNI_DTO_SIG("SuggestLocationsResult$Status"))
+	GPTE_JNI_METHOD(suggest_locations_result, get_locations, "getLocations", "()Ljava/util/List;")
+	GPTE_JNI_ENUM(suggest_locations_status, GPTE_JNI_DTO("SuggestLocationsResult$Status"))
+
+
+	GPTE_JNI_CLASS(network_provider, "de/schildbach/pte/NetworkProvider")
+	GPTE_JNI_METHOD(network_provider, default_products, "defaultProducts", "()Ljava/util/Set;")
+	GPTE_JNI_METHOD(network_provider, has_capabilities, "hasCapabilities", "([Lde/schildbach/pte/NetworkProvider$Capability;)Z")
+	GPTE_JNI_METHOD(network_provider, get_area, "getArea", "()[" GPTE_JNI_DTO_SIG("Point"))
+	GPTE_JNI_METHOD(network_provider, line_style, "lineStyle", "(Ljava/lang/String;" GPTE_JNI_DTO_SIG("Product") "Ljava/lang/String;)" GPTE_JNI_DTO_SIG("Style"))
+	GPTE_JNI_METHOD(network_provider, query_departures, "queryDepartures", "(Ljava/lang/String;Ljava/util/Date;IZ)" GPTE_JNI_DTO_SIG("QueryDeparturesResult"))
+	GPTE_JNI_METHOD(network_provider, query_trips, "queryTrips", "("
+		GPTE_JNI_DTO_SIG("Location")
+		GPTE_JNI_DTO_SIG("Location")
+		GPTE_JNI_DTO_SIG("Location")
+		"Ljava/util/Date;"
+		"Z"
+		GPTE_JNI_DTO_SIG("TripOptions")
+	")" GPTE_JNI_DTO_SIG("QueryTripsResult"))
+	GPTE_JNI_METHOD(network_provider, query_more_trips, "queryMoreTrips", "(" GPTE_JNI_DTO_SIG("QueryTripsContext") "Z)" GPTE_JNI_DTO_SIG("QueryTripsResult"))
+	GPTE_JNI_METHOD(network_provider, query_nearby_locations, "queryNearbyLocations", "(Ljava/util/Set;" GPTE_JNI_DTO_SIG("Location") "II)" GPTE_JNI_DTO_SIG("NearbyLocationsResult"))
+	GPTE_JNI_METHOD(network_provider, suggest_locations, "suggestLocations", "(Ljava/lang/CharSequence;Ljava/util/Set;I)" GPTE_JNI_DTO_SIG("SuggestLocationsResult"))
+
+	GPTE_JNI_ENUM(capability, "de/schildbach/pte/NetworkProvider$Capability")
+	GPTE_JNI_ENUM(optimize, "de/schildbach/pte/NetworkProvider$Optimize")
+	GPTE_JNI_ENUM(walk_speed, "de/schildbach/pte/NetworkProvider$WalkSpeed")
+	GPTE_JNI_ENUM(accessibility, "de/schildbach/pte/NetworkProvider$Accessibility")
+	GPTE_JNI_ENUM(trip_flag, "de/schildbach/pte/NetworkProvider$TripFlag")
+
+
+	GPTE_JNI_HELPER_CLASS(bulk, "GpteBulk")
+	GPTE_JNI_STATIC_METHOD(bulk, pack_trips, "packTrips", "([Ljava/lang/Object;)[J")
+	GPTE_JNI_STATIC_METHOD(bulk, pack_departures, "packDepartures", "([Ljava/lang/Object;)[Ljava/lang/Object;")
+
+	GPTE_JNI_HELPER_CLASS(call, "GpteCall")
+	GPTE_JNI_METHOD(call, init, "<init>", "(Ljava/lang/Object;Ljava/lang/reflect/Method;[Ljava/lang/Object;)V")
+	GPTE_JNI_METHOD(call, execute, "execute", "(J)Ljava/lang/Object;")
+	GPTE_JNI_METHOD(call, cancel, "cancel", "()V")
+
+	return TRUE;
+err:
+	gpte_jni_clear(self, env);
+	return FALSE;
+}
+
+void gpte_jni_clear(GpteJni* self, JNIEnv* env) {
+	if (!self->global_refs)
+		return;
+	if (env)
+		for (guint i = 0; i < self->global_refs->len; i++)
+			(*env)->DeleteGlobalRef(env, g_ptr_array_index(self->global_refs, i));
+	g_ptr_array_unref(self->global_refs);
+	g_ptr_array_unref(self->enum_tables);
+	*self = (GpteJni){ 0 };
+}
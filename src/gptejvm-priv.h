@@ -20,6 +20,9 @@
 #define __GPTEJVM_PRIV_H__
 
 #include <gptejvm.h>
+#include <gptejni-priv.h>
+#include <gpteexecutor-priv.h>
+#include <gptereaper-priv.h>
 #include <jni.h>
 
 G_BEGIN_DECLS
@@ -31,16 +34,78 @@ jobject gpte_scope_guard_leave_with_ref(GpteScopeGuard* self, jobject ref);
 
 G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC(GpteScopeGuard, gpte_scope_guard_leave)
 
+// shared between a GpteJvm and every thread it implicitly attached, so
+// that exiting threads don't detach from an already destroyed JVM
+typedef struct {
+	gatomicrefcount rc;
+	JavaVM* vm;
+} GpteJvmAttachment;
+
+// a provider class and its constructor, resolved on first use
+typedef struct {
+	jclass class;
+	jmethodID constructor;
+} GpteJvmProviderClass;
+
 struct _GpteJvm {
 	gatomicrefcount rc;
 
 	gint jar_fd;
 	JavaVM* vm;
 	JNIEnv* main_env;
+	// FALSE for adopted VMs, which outlive the wrapper
+	gboolean owns_vm;
+	gboolean is_default;
+	// the instance owning an adopted VM, kept alive until this one is freed
+	GpteJvm* owner;
+
+	GpteJni jni;
+	GpteReaper* reaper;
+
+	GMutex executor_lock;
+	GpteExecutor* executor;
+	guint executor_threads;
+	guint executor_max_queued;
+
+	gint implicit_attach;
+	GpteJvmAttachment* attachment;
+
+	// milliseconds, 0 for no limit
+	guint request_timeout;
+
+	// provider registry: id -> GpteJvmProviderClass, key -> GWeakRef*
+	GMutex registry_lock;
+	GHashTable* provider_classes;
+	GHashTable* provider_instances;
+
+	// startup timing, logged with g_debug()
+	gint64 started;
+	gint first_query;
 };
 
 JNIEnv* gpte_jvm_get_env(GpteJvm* self);
 GpteScopeGuard gpte_jvm_enter_scope(GpteJvm* self, gint capacity);
+GpteExecutor* gpte_jvm_get_executor(GpteJvm* self);
+
+// logs the time to the first query
+void gpte_jvm_timing_query_done(GpteJvm* self);
+
+// boxes primitive arguments for gpte_jvm_call_provider()
+jobject gpte_jvm_box_int(GpteJvm* self, gint value);
+jobject gpte_jvm_box_boolean(GpteJvm* self, gboolean value);
+
+/*
+ * Calls the NetworkProvider @method on @provider with the (boxed) @args
+ * like CallObjectMethod(). The query runs on a Java virtual thread that is
+ * interrupted once the current cancellable is cancelled or the request
+ * timeout passes, which closes the socket it blocks on. Exceptions are
+ * left pending.
+ */
+jobject gpte_jvm_call_provider(GpteJvm* self, jobject provider, jmethodID method, jsize n_args, const jobject* args);
+
+// usable from any thread, even unattached ones
+void gpte_jvm_release_global(GpteJvm* self, jobject ref);
+void gpte_jvm_release_string(GpteJvm* self, jstring string, const char* utf8);
 
 G_END_DECLS
 
@@ -20,10 +20,14 @@
 #include "gptejvm-priv.h"
 
 #include "gpteerrors.h"
+#include "gpteprovider-priv.h"
+#include "gpteproviders.h"
+#include "gptejavaobject-priv.h"
 
 #include <gio/gio.h>
 #include "gpte_res.h"
 
+#include <jvmti.h>
 #include <sys/mman.h>
 
 G_DEFINE_BOXED_TYPE(GpteThreadGuard, gpte_thread_guard, gpte_thread_guard_ref, gpte_thread_guard_unref)
@@ -76,27 +80,163 @@ jobject gpte_scope_guard_leave_with_ref(GpteScopeGuard* self, jobject ref) {
 
 G_DEFINE_BOXED_TYPE(GpteJvm, gpte_jvm, gpte_jvm_ref, gpte_jvm_unref)
 
+G_DEFINE_ENUM_TYPE(GpteJvmPreset, gpte_jvm_preset,
+	G_DEFINE_ENUM_VALUE(GPTE_JVM_PRESET_DEFAULT, "default"),
+	G_DEFINE_ENUM_VALUE(GPTE_JVM_PRESET_LOW_MEMORY, "low-memory"),
+	G_DEFINE_ENUM_VALUE(GPTE_JVM_PRESET_THROUGHPUT, "throughput")
+)
+
+G_LOCK_DEFINE_STATIC(gpte_jvm_attachment);
+
+static GpteJvmAttachment* gpte_jvm_attachment_ref(GpteJvmAttachment* self) {
+	g_atomic_ref_count_inc(&self->rc);
+	return self;
+}
+
+static void gpte_jvm_attachment_unref(GpteJvmAttachment* self) {
+	if (g_atomic_ref_count_dec(&self->rc))
+		g_free(self);
+}
+
+// runs on thread exit of every implicitly attached thread
+static void gpte_jvm_attachment_detach(GpteJvmAttachment* self) {
+	G_LOCK(gpte_jvm_attachment);
+	if (self->vm) {
+		gint rc = (*self->vm)->DetachCurrentThread(self->vm);
+		if (rc != JNI_OK)
+			g_critical("Gpte.Jvm was unable to detach implicitly attached thread (error %d)", rc);
+	}
+	G_UNLOCK(gpte_jvm_attachment);
+	gpte_jvm_attachment_unref(self);
+}
+
+static GPrivate gpte_jvm_implicit_thread = G_PRIVATE_INIT((GDestroyNotify)gpte_jvm_attachment_detach);
+
 static void gpte_load_resources(void) {
-	static int loaded = 0;
-	if (loaded)
-		return;
-	g_resources_register(gpte_get_resource());
+	// JVMs may be created from several threads at once
+	static gsize loaded = 0;
+	if (g_once_init_enter(&loaded)) {
+		g_resources_register(gpte_get_resource());
+		g_once_init_leave(&loaded, 1);
+	}
 }
 
-static gint gpte_expose_jar(GError** err) {
-	gpte_load_resources();
+#define GPTE_JAR_RESOURCE "/arpa/sp1rit/gpte/dist.jar"
+
+typedef enum {
+	GPTE_JAR_INSTALLED,
+	GPTE_JAR_CACHED,
+	GPTE_JAR_MEMFD
+} GpteJarMode;
+
+static const gchar* const gpte_jar_mode_names[] = {
+	[GPTE_JAR_INSTALLED] = "installed",
+	[GPTE_JAR_CACHED] = "cached",
+	[GPTE_JAR_MEMFD] = "memfd"
+};
+
+/*
+ * Class data sharing archives are only accepted if the class path
+ * matches the one they were dumped with, so they are only used with a
+ * jar at a stable location. The cache directory is keyed by the hash of
+ * the jar (computed at build time), so a changed jar never reuses a
+ * stale archive, and the JVM regenerates archives it doesn't accept
+ * itself (-XX:+AutoCreateSharedArchive).
+ */
+static gchar* gpte_jar_cache_dir(void) {
+	gchar* dir = g_build_filename(g_get_user_cache_dir(), "gpte", GPTE_JAR_HASH, NULL);
+	if (g_mkdir_with_parents(dir, 0700) != 0) {
+		g_free(dir);
+		return NULL;
+	}
+	return dir;
+}
+
+// whether the file at @path is the jar gpte was built with
+static gboolean gpte_jar_is_valid(const gchar* path, gsize jar_len) {
+	g_autoptr(GMappedFile) file = g_mapped_file_new(path, FALSE, NULL);
+	if (!file || g_mapped_file_get_length(file) != jar_len)
+		return FALSE;
+
+	g_autoptr(GChecksum) checksum = g_checksum_new(G_CHECKSUM_SHA256);
+	g_checksum_update(checksum, (const guchar*)g_mapped_file_get_contents(file), jar_len);
+	return g_str_equal(g_checksum_get_string(checksum), GPTE_JAR_HASH);
+}
+
+// Stores the jar in the cache dir. The resource data is only looked up
+// (and thus paged in) if there is no valid copy yet.
+static gchar* gpte_expose_cached_jar(const gchar* dir) {
+	gsize jar_len;
+	if (!g_resources_get_info(GPTE_JAR_RESOURCE, G_RESOURCE_LOOKUP_FLAGS_NONE, &jar_len, NULL, NULL))
+		return NULL;
+
+	g_autofree gchar* path = g_build_filename(dir, "dist.jar", NULL);
+	// hashing the copy is cheap compared to starting the JVM, and catches
+	// truncated or corrupted files of the right size
+	if (gpte_jar_is_valid(path, jar_len))
+		return g_steal_pointer(&path);
 
-	gint fd = memfd_create("pte.jar", 0);
-	GBytes* bytes = g_resources_lookup_data("/arpa/sp1rit/gpte/dist.jar", G_RESOURCE_LOOKUP_FLAGS_NONE, err);
+	g_autoptr(GBytes) bytes = g_resources_lookup_data(GPTE_JAR_RESOURCE, G_RESOURCE_LOOKUP_FLAGS_NONE, NULL);
+	// written to a temporary file and renamed, so concurrently starting
+	// processes never see a partial jar
+	if (!bytes || !g_file_set_contents(path, g_bytes_get_data(bytes, NULL), g_bytes_get_size(bytes), NULL))
+		return NULL;
+	return g_steal_pointer(&path);
+}
+
+static gchar* gpte_expose_memfd_jar(gint* fd, GError** err) {
+	g_autoptr(GBytes) bytes = g_resources_lookup_data(GPTE_JAR_RESOURCE, G_RESOURCE_LOOKUP_FLAGS_NONE, err);
 	if (!bytes)
-		return -1;
+		return NULL;
+
+	*fd = memfd_create("pte.jar", 0);
 	gsize jar_len;
 	const guchar* jar_data = g_bytes_get_data(bytes, &jar_len);
-	if (write(fd, jar_data, jar_len) != (gssize)jar_len) {
+	if (write(*fd, jar_data, jar_len) != (gssize)jar_len) {
 		g_set_error(err, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_INIT_FAILED, "Failed writing jar to memfd: %s", g_strerror(errno));
-		return -1;
+		close(*fd);
+		*fd = -1;
+		return NULL;
 	}
-	return fd;
+	return g_strdup_printf("/proc/%d/fd/%d", getpid(), *fd);
+}
+
+// Returns the class path of the jar. In order of preference, this is the
+// installed jar, a copy in the cache dir or a memfd (stored in @fd).
+static gchar* gpte_expose_jar(gint* fd, gchar** archive, GpteJarMode* mode, GError** err) {
+	gpte_load_resources();
+	*fd = -1;
+	*archive = NULL;
+
+	g_autofree gchar* dir = gpte_jar_cache_dir();
+	if (dir)
+		*archive = g_build_filename(dir, "dist.jsa", NULL);
+
+#ifdef GPTE_INSTALLED_JAR
+	if (g_file_test(GPTE_INSTALLED_JAR, G_FILE_TEST_IS_REGULAR)) {
+		*mode = GPTE_JAR_INSTALLED;
+		return g_strdup(GPTE_INSTALLED_JAR);
+	}
+#endif
+
+	gchar* path = dir ? gpte_expose_cached_jar(dir) : NULL;
+	if (path) {
+		*mode = GPTE_JAR_CACHED;
+		return path;
+	}
+
+	g_clear_pointer(archive, g_free);
+	*mode = GPTE_JAR_MEMFD;
+	return gpte_expose_memfd_jar(fd, err);
+}
+
+// resident set size in kB, as reported by the kernel
+static glong gpte_jvm_rss(void) {
+	g_autofree gchar* status = NULL;
+	if (!g_file_get_contents("/proc/self/status", &status, NULL, NULL))
+		return -1;
+	const gchar* rss = strstr(status, "VmRSS:");
+	return rss ? strtol(rss + strlen("VmRSS:"), NULL, 10) : -1;
 }
 
 static gboolean gpte_jvm_strv_contains(const gchar** strv, const gchar* value) {
@@ -108,20 +248,151 @@ static gboolean gpte_jvm_strv_contains(const gchar** strv, const gchar* value) {
 	return FALSE;
 }
 
-GpteJvm* gpte_jvm_create(GError** err) {
-	g_return_val_if_fail(!err || !*err, NULL);
+static guint64 gpte_jvm_read_limit(const gchar* path) {
+	g_autofree gchar* contents = NULL;
+	if (!g_file_get_contents(path, &contents, NULL, NULL))
+		return 0;
+	g_strstrip(contents);
+	// cgroup v2 reports "max" if unlimited
+	guint64 limit;
+	if (!g_ascii_string_to_unsigned(contents, 10, 1, G_MAXUINT64, &limit, NULL))
+		return 0;
+	return limit;
+}
+
+static guint64 gpte_jvm_memory_limit(void) {
+	guint64 physical = (guint64)sysconf(_SC_PHYS_PAGES) * (guint64)sysconf(_SC_PAGESIZE);
+
+	guint64 limit = gpte_jvm_read_limit("/sys/fs/cgroup/memory.max");
+	if (!limit)
+		limit = gpte_jvm_read_limit("/sys/fs/cgroup/memory/memory.limit_in_bytes");
+	// cgroup v1 reports a huge page aligned number if unlimited
+	if (!limit || limit > physical)
+		limit = physical;
+	return limit;
+}
+
+#define GPTE_JVM_MIB (G_GUINT64_CONSTANT(1024) * 1024)
+
+static void gpte_jvm_add_preset(GStrvBuilder* builder, GpteJvmPreset preset) {
+	guint64 limit = gpte_jvm_memory_limit() / GPTE_JVM_MIB;
+
+	switch (preset) {
+		case GPTE_JVM_PRESET_LOW_MEMORY: {
+			guint64 heap = CLAMP(limit / 4, 32, 256);
+			g_strv_builder_add(builder, "-XX:+UseSerialGC");
+			g_strv_builder_take(builder, g_strdup_printf("-Xmx%" G_GUINT64_FORMAT "m", heap));
+			g_strv_builder_add(builder, "-Xms16m");
+			g_strv_builder_add(builder, "-Xss256k");
+			g_strv_builder_add(builder, "-XX:TieredStopAtLevel=1");
+			g_strv_builder_add(builder, "-XX:ReservedCodeCacheSize=32m");
+			g_strv_builder_add(builder, "-XX:MaxMetaspaceSize=96m");
+			g_strv_builder_add(builder, "-XX:+UseCompressedOops");
+		} break;
+		case GPTE_JVM_PRESET_THROUGHPUT: {
+			guint64 heap = CLAMP(limit / 2, 256, 16 * 1024);
+			// G1 only pays off once there is enough heap to partition
+			g_strv_builder_add(builder, heap >= 2048 ? "-XX:+UseG1GC" : "-XX:+UseParallelGC");
+			g_strv_builder_take(builder, g_strdup_printf("-Xmx%" G_GUINT64_FORMAT "m", heap));
+			g_strv_builder_take(builder, g_strdup_printf("-Xms%" G_GUINT64_FORMAT "m", heap / 4));
+			g_strv_builder_add(builder, "-XX:+UseCompressedOops");
+		} break;
+		case GPTE_JVM_PRESET_DEFAULT:
+		default:
+			break;
+	}
+}
 
+static gboolean gpte_jvm_add_env_options(GStrvBuilder* builder, GError** err) {
+	const gchar* env = g_getenv("GPTE_JVM_OPTIONS");
+	if (!env || !*env)
+		return TRUE;
+
+	g_auto(GStrv) argv = NULL;
+	GError* parse_err = NULL;
+	if (!g_shell_parse_argv(env, NULL, &argv, &parse_err)) {
+		// an empty/whitespace-only value is not an error
+		if (g_error_matches(parse_err, G_SHELL_ERROR, G_SHELL_ERROR_EMPTY_STRING)) {
+			g_error_free(parse_err);
+			return TRUE;
+		}
+		g_set_error(err, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_INIT_FAILED, "Failed parsing GPTE_JVM_OPTIONS: %s", parse_err->message);
+		g_error_free(parse_err);
+		return FALSE;
+	}
+	g_strv_builder_addv(builder, (const gchar**)argv);
+	return TRUE;
+}
+
+// The instance that created the JVM of this process. Instances adopting
+// that JVM hold a reference on it, so it is only destroyed once none of
+// them uses it anymore.
+G_LOCK_DEFINE_STATIC(gpte_jvm_owner);
+static GpteJvm* gpte_jvm_owner = NULL;
+
+static GpteJvm* gpte_jvm_alloc(void) {
 	GpteJvm* self = g_new(GpteJvm, 1);
 	g_atomic_ref_count_init(&self->rc);
+	self->jar_fd = -1;
+	self->owns_vm = TRUE;
+	self->is_default = FALSE;
+	self->owner = NULL;
+	g_mutex_init(&self->executor_lock);
+	self->executor = NULL;
+	self->executor_threads = 0;
+	self->executor_max_queued = 0;
+	self->implicit_attach = FALSE;
+	self->attachment = NULL;
 
-	self->jar_fd = gpte_expose_jar(err);
-	if (self->jar_fd < 0)
-		//goto err;
-		return NULL;
+	self->started = g_get_monotonic_time();
+	self->first_query = FALSE;
+	return self;
+}
 
+static void gpte_jvm_weak_ref_free(GWeakRef* ref) {
+	g_weak_ref_clear(ref);
+	g_free(ref);
+}
+
+// sets up everything that needs the JNI registry to be initialized
+static void gpte_jvm_init_runtime(GpteJvm* self) {
+	self->reaper = gpte_reaper_new(self->vm);
+
+	self->attachment = g_new(GpteJvmAttachment, 1);
+	g_atomic_ref_count_init(&self->attachment->rc);
+	self->attachment->vm = self->vm;
+
+	g_mutex_init(&self->registry_lock);
+	self->provider_classes = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_free);
+	self->provider_instances = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)gpte_jvm_weak_ref_free);
+}
 
-	GStrvBuilder* builder = g_strv_builder_new();
-	g_strv_builder_take(builder, g_strdup_printf("-Djava.class.path=/proc/%d/fd/%d", getpid(), self->jar_fd));
+GpteJvm* gpte_jvm_create(GError** err) {
+	return gpte_jvm_create_with_options(GPTE_JVM_PRESET_DEFAULT, NULL, err);
+}
+
+GpteJvm* gpte_jvm_create_with_options(GpteJvmPreset preset, const gchar* const* jvm_options, GError** err) {
+	g_return_val_if_fail(!err || !*err, NULL);
+
+	GpteJvm* self = gpte_jvm_alloc();
+	gint64 started = self->started;
+
+	g_autofree gchar* archive = NULL;
+	GpteJarMode jar_mode;
+	g_autofree gchar* class_path = gpte_expose_jar(&self->jar_fd, &archive, &jar_mode, err);
+	if (!class_path) {
+		g_mutex_clear(&self->executor_lock);
+		g_free(self);
+		return NULL;
+	}
+
+	g_autoptr(GStrvBuilder) builder = g_strv_builder_new();
+	g_strv_builder_take(builder, g_strdup_printf("-Djava.class.path=%s", class_path));
+	if (archive) {
+		g_strv_builder_take(builder, g_strdup_printf("-XX:SharedArchiveFile=%s", archive));
+		g_strv_builder_add(builder, "-XX:+AutoCreateSharedArchive");
+	}
+	gpte_jvm_add_preset(builder, preset);
 
 	const gchar* debug = g_getenv("GPTE_DEBUG");
 	if (debug) {
@@ -156,6 +427,17 @@ GpteJvm* gpte_jvm_create(GError** err) {
 		g_strv_builder_add(builder, "-XX:OnError=kill -9 %p");
 	}
 
+	if (jvm_options)
+		g_strv_builder_addv(builder, (const gchar**)jvm_options);
+	// not jumping to err, which would skip the autoptr initializations below
+	if (!gpte_jvm_add_env_options(builder, err)) {
+		if (self->jar_fd >= 0)
+			close(self->jar_fd);
+		g_mutex_clear(&self->executor_lock);
+		g_free(self);
+		return NULL;
+	}
+
 	g_auto(GStrv) options_data = g_strv_builder_end(builder);
 	gsize n_options = 0;
 	while (options_data[n_options])
@@ -172,39 +454,508 @@ GpteJvm* gpte_jvm_create(GError** err) {
 	};
 
 	gint rc = JNI_CreateJavaVM(&self->vm, (void**)&self->main_env, &args);
-	if (rc) {
+	if (rc == JNI_EEXIST) {
+		g_set_error(err, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_INIT_FAILED, "A Java VM already exists in this process, use gpte_jvm_get_default() to share it");
+		goto err;
+	} else if (rc) {
 		g_set_error(err, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_INIT_FAILED, "Failed creating Java VM (error %d)", rc);
 		goto err;
 	}
+
+	if (!gpte_jni_init(&self->jni, self->main_env, err)) {
+		(*self->vm)->DestroyJavaVM(self->vm);
+		goto err;
+	}
+
+	gpte_jvm_init_runtime(self);
+
+	G_LOCK(gpte_jvm_owner);
+	gpte_jvm_owner = self;
+	G_UNLOCK(gpte_jvm_owner);
+
+	g_debug("Gpte.Jvm created in %.1f ms from the %s jar (class data sharing archive: %s, RSS: %ld kB)",
+		(g_get_monotonic_time() - started) / 1000.0, gpte_jar_mode_names[jar_mode], archive ? archive : "none", gpte_jvm_rss());
 	return self;
 err:
+	if (self->jar_fd >= 0)
+		close(self->jar_fd);
+	g_mutex_clear(&self->executor_lock);
 	g_free(self);
 	return NULL;
 }
 
+// makes the classes of the jar available in a VM that wasn't created by us
+static gboolean gpte_jvm_append_jar(GpteJvm* self, GError** err) {
+	jvmtiEnv* jvmti;
+	gint rc = (*self->vm)->GetEnv(self->vm, (void**)&jvmti, JVMTI_VERSION_1_2);
+	if (rc != JNI_OK) {
+		g_set_error(err, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_INIT_FAILED, "Failed acquiring JVMTI environment (error %d)", rc);
+		return FALSE;
+	}
+
+	gint fd;
+	g_autofree gchar* archive = NULL;
+	GpteJarMode mode;
+	g_autofree gchar* class_path = gpte_expose_jar(&fd, &archive, &mode, err);
+	if (!class_path) {
+		(*jvmti)->DisposeEnvironment(jvmti);
+		return FALSE;
+	}
+
+	jvmtiError jrc = (*jvmti)->AddToSystemClassLoaderSearch(jvmti, class_path);
+	(*jvmti)->DisposeEnvironment(jvmti);
+	if (jrc != JVMTI_ERROR_NONE) {
+		if (fd >= 0)
+			close(fd);
+		g_set_error(err, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_INIT_FAILED, "Failed adding %s to the system class loader (error %d)", class_path, jrc);
+		return FALSE;
+	}
+	// the class loader reads from the jar for the rest of the process, so
+	// a memfd is intentionally kept open
+	return TRUE;
+}
+
+static GpteJvm* gpte_jvm_adopt(JavaVM* vm, GError** err) {
+	GpteJvm* self = gpte_jvm_alloc();
+	self->vm = vm;
+	self->owns_vm = FALSE;
+
+	gint rc = (*vm)->GetEnv(vm, (void**)&self->main_env, JNI_VERSION_21);
+	if (rc == JNI_EDETACHED)
+		rc = (*vm)->AttachCurrentThread(vm, (void**)&self->main_env, NULL);
+	if (rc != JNI_OK) {
+		g_set_error(err, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_THREADING, "Failed attaching to existing Java VM (error %d)", rc);
+		goto err;
+	}
+
+	JNIEnv* env = self->main_env;
+	jclass probe = (*env)->FindClass(env, "de/schildbach/pte/NetworkProvider");
+	if (probe) {
+		(*env)->DeleteLocalRef(env, probe);
+	} else {
+		(*env)->ExceptionClear(env);
+		if (!gpte_jvm_append_jar(self, err))
+			goto err;
+	}
+
+	if (!gpte_jni_init(&self->jni, env, err))
+		goto err;
+
+	gpte_jvm_init_runtime(self);
+	return self;
+err:
+	g_mutex_clear(&self->executor_lock);
+	g_free(self);
+	return NULL;
+}
+
+G_LOCK_DEFINE_STATIC(gpte_jvm_default);
+static GpteJvm* gpte_jvm_default = NULL;
+
+GpteJvm* gpte_jvm_get_default(GError** err) {
+	g_return_val_if_fail(!err || !*err, NULL);
+
+	G_LOCK(gpte_jvm_default);
+	if (gpte_jvm_default) {
+		GpteJvm* self = gpte_jvm_ref(gpte_jvm_default);
+		G_UNLOCK(gpte_jvm_default);
+		return self;
+	}
+
+	JavaVM* vm;
+	jsize n_vms = 0;
+	GpteJvm* self;
+	if (JNI_GetCreatedJavaVMs(&vm, 1, &n_vms) == JNI_OK && n_vms > 0) {
+		// the owner must not destroy the JVM while it is in use here
+		G_LOCK(gpte_jvm_owner);
+		GpteJvm* owner = gpte_jvm_owner && gpte_jvm_owner->vm == vm ? gpte_jvm_ref(gpte_jvm_owner) : NULL;
+		G_UNLOCK(gpte_jvm_owner);
+
+		self = gpte_jvm_adopt(vm, err);
+		if (self)
+			self->owner = owner;
+		else if (owner)
+			gpte_jvm_unref(owner);
+	} else {
+		// once the last reference to it is dropped, the JVM is destroyed
+		// and can't be created again in this process
+		self = gpte_jvm_create(err);
+	}
+
+	if (self) {
+		self->is_default = TRUE;
+		gpte_jvm_default = self;
+	}
+	G_UNLOCK(gpte_jvm_default);
+	return self;
+}
+
+typedef struct {
+	GpteJvmPreset preset;
+	GStrv options;
+	GStrv warmup_providers;
+} GpteJvmCreateData;
+static void gpte_jvm_create_data_free(GpteJvmCreateData* self) {
+	g_strfreev(self->options);
+	g_strfreev(self->warmup_providers);
+	g_free(self);
+}
+
+static void gpte_jvm_create_thread(GTask* task, gpointer, GpteJvmCreateData* data, GCancellable* cancellable) {
+	if (g_task_return_error_if_cancelled(task))
+		return;
+
+	GError* err = NULL;
+	GpteJvm* self = gpte_jvm_create_with_options(data->preset, (const gchar* const*)data->options, &err);
+	if (!self) {
+		g_task_return_error(task, err);
+		return;
+	}
+
+	if (data->warmup_providers)
+		gpte_jvm_warmup(self, (const gchar* const*)data->warmup_providers, cancellable);
+
+	// this is a GLib pool thread, so it must not stay the JVM main thread
+	(*self->vm)->DetachCurrentThread(self->vm);
+	self->main_env = NULL;
+	g_task_return_pointer(task, self, (GDestroyNotify)gpte_jvm_unref);
+}
+
+void gpte_jvm_create_async(GpteJvmPreset preset, const gchar* const* options, const gchar* const* warmup_providers, GCancellable* cancellable, GAsyncReadyCallback callback, gpointer user_data) {
+	GpteJvmCreateData* data = g_new(GpteJvmCreateData, 1);
+	data->preset = preset;
+	data->options = g_strdupv((GStrv)options);
+	data->warmup_providers = g_strdupv((GStrv)warmup_providers);
+
+	GTask* task = g_task_new(NULL, cancellable, callback, user_data);
+	g_task_set_source_tag(task, gpte_jvm_create_async);
+	g_task_set_task_data(task, data, (GDestroyNotify)gpte_jvm_create_data_free);
+	g_task_run_in_thread(task, (GTaskThreadFunc)gpte_jvm_create_thread);
+	g_object_unref(task);
+}
+
+GpteJvm* gpte_jvm_create_finish(GAsyncResult* result, GError** err) {
+	g_return_val_if_fail(g_task_is_valid(result, NULL), NULL);
+	GpteJvm* self = g_task_propagate_pointer(G_TASK(result), err);
+	if (!self)
+		return NULL;
+
+	JNIEnv* env = gpte_jvm_get_env(self);
+	if (!env) {
+		gint rc = (*self->vm)->AttachCurrentThread(self->vm, (void**)&env, NULL);
+		if (rc != JNI_OK) {
+			g_set_error(err, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_THREADING, "Failed attaching thread to Java VM (error %d)", rc);
+			gpte_jvm_unref(self);
+			return NULL;
+		}
+	}
+	self->main_env = env;
+	return self;
+}
+
+#define GPTE_JVM_WARMUP_ITERATIONS 2000
+
+static const gchar* const gpte_jvm_warmup_classes[] = {
+	"okhttp3/OkHttpClient",
+	"okhttp3/HttpUrl",
+	"okhttp3/Request",
+	"org/json/JSONObject",
+	"org/json/JSONArray",
+	"de/schildbach/pte/util/ParserUtils",
+};
+
+/*
+ * Parse helpers of the provider families the response parsing goes
+ * through, with a typical fragment of a response as arguments. They are
+ * called on an instance of the provider, so overrides of its subclass
+ * are compiled as well. Each argument is passed as the type in
+ * @signature: a String, or a JSONArray/JSONObject parsed from it.
+ */
+typedef struct {
+	const gchar* class_name;
+	const gchar* method;
+	const gchar* signature;
+	const gchar* args[9];
+} GpteJvmWarmupParser;
+
+static const GpteJvmWarmupParser gpte_jvm_warmup_parsers[] = {
+	{
+		"de/schildbach/pte/AbstractHafasClientInterfaceProvider",
+		"parseLocList", "(Lorg/json/JSONArray;Lorg/json/JSONArray;)Ljava/util/List;",
+		{
+			"[{\"lid\":\"A=1@O=Alexanderplatz@X=13411267@Y=52521508@L=900000100003@\","
+			"\"type\":\"S\",\"name\":\"Alexanderplatz\",\"extId\":\"900000100003\",\"pCls\":127,"
+			"\"crd\":{\"x\":13411267,\"y\":52521508}},"
+			"{\"lid\":\"A=4@O=Berlin, Fernsehturm@X=13409422@Y=52520803@\","
+			"\"type\":\"P\",\"name\":\"Berlin, Fernsehturm\","
+			"\"crd\":{\"x\":13409422,\"y\":52520803}}]",
+			"[{\"id\":\"standard\",\"index\":0,\"type\":\"WGS84\"}]"
+		}
+	},
+	{
+		"de/schildbach/pte/AbstractEfaProvider",
+		"parseLine", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;"
+			"Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)Lde/schildbach/pte/dto/Line;",
+		{ "vvs:20001: :H:j24", "vvs", "2", "U1", "U1", "Stadtbahn U1", NULL, "U1", NULL }
+	},
+	{
+		"de/schildbach/pte/AbstractNavitiaProvider",
+		"parseLocation", "(Lorg/json/JSONObject;)Lde/schildbach/pte/dto/Location;",
+		{
+			"{\"embedded_type\":\"stop_area\",\"stop_area\":{\"id\":\"stop_area:RAT:SA:GDLYO\","
+			"\"name\":\"Gare de Lyon\",\"coord\":{\"lat\":\"48.844\",\"lon\":\"2.374\"},"
+			"\"administrative_regions\":[{\"name\":\"Paris\"}]}}"
+		}
+	},
+};
+
+static void gpte_jvm_warmup_class(JNIEnv* env, const gchar* name) {
+	// FindClass also initializes the class
+	jclass class = (*env)->FindClass(env, name);
+	if (!class) {
+		(*env)->ExceptionClear(env);
+		g_debug("Gpte.Jvm could not warm up class %s", name);
+		return;
+	}
+	(*env)->DeleteLocalRef(env, class);
+}
+
+// calls @parser on @provider until it is compiled, if @provider is of the
+// family of @parser
+static void gpte_jvm_warmup_parser(JNIEnv* env, jobject provider, const GpteJvmWarmupParser* parser, GCancellable* cancellable) {
+	(*env)->PushLocalFrame(env, 8);
+	jclass family = (*env)->FindClass(env, parser->class_name);
+	jclass json_array = (*env)->FindClass(env, "org/json/JSONArray");
+	jclass json_object = (*env)->FindClass(env, "org/json/JSONObject");
+	if (!family || !json_array || !json_object || !(*env)->IsInstanceOf(env, provider, family)) {
+		(*env)->ExceptionClear(env);
+		(*env)->PopLocalFrame(env, NULL);
+		return;
+	}
+
+	jmethodID method = (*env)->GetMethodID(env, family, parser->method, parser->signature);
+	jmethodID array_init = (*env)->GetMethodID(env, json_array, "<init>", "(Ljava/lang/String;)V");
+	jmethodID object_init = (*env)->GetMethodID(env, json_object, "<init>", "(Ljava/lang/String;)V");
+	if (!method || !array_init || !object_init) {
+		(*env)->ExceptionClear(env);
+		(*env)->PopLocalFrame(env, NULL);
+		g_debug("Gpte.Jvm could not warm up %s.%s", parser->class_name, parser->method);
+		return;
+	}
+
+	jvalue args[G_N_ELEMENTS(parser->args)];
+	for (guint i = 0; i < GPTE_JVM_WARMUP_ITERATIONS && !g_cancellable_is_cancelled(cancellable); i++) {
+		(*env)->PushLocalFrame(env, G_N_ELEMENTS(args) * 2);
+		const gchar* type = parser->signature + 1;
+		for (gsize n = 0; *type != ')'; n++) {
+			jstring arg = parser->args[n] ? (*env)->NewStringUTF(env, parser->args[n]) : NULL;
+			if (g_str_has_prefix(type, "Lorg/json/JSONArray;"))
+				args[n].l = (*env)->NewObject(env, json_array, array_init, arg);
+			else if (g_str_has_prefix(type, "Lorg/json/JSONObject;"))
+				args[n].l = (*env)->NewObject(env, json_object, object_init, arg);
+			else
+				args[n].l = arg;
+			type = strchr(type, ';') + 1;
+		}
+		(*env)->CallObjectMethodA(env, provider, method, args);
+		gboolean failed = (*env)->ExceptionCheck(env);
+		(*env)->ExceptionClear(env);
+		(*env)->PopLocalFrame(env, NULL);
+		if (failed) {
+			g_debug("Gpte.Jvm failed warming up %s.%s", parser->class_name, parser->method);
+			break;
+		}
+	}
+	(*env)->PopLocalFrame(env, NULL);
+}
+
+void gpte_jvm_warmup(GpteJvm* self, const gchar* const* providers, GCancellable* cancellable) {
+	g_return_if_fail(self != NULL);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(self, 4);
+
+	for (gsize i = 0; i < G_N_ELEMENTS(gpte_jvm_warmup_classes); i++)
+		gpte_jvm_warmup_class(env, gpte_jvm_warmup_classes[i]);
+
+	// the DTO classes are already loaded by gpte_jni_init
+	for (gsize i = 0; providers && providers[i] && !g_cancellable_is_cancelled(cancellable); i++) {
+		const gchar* class_name = gpte_provider_class_name(providers[i]);
+		if (!class_name) {
+			g_warning("Gpte.Jvm can't warm up unknown provider %s", providers[i]);
+			continue;
+		}
+		gpte_jvm_warmup_class(env, class_name);
+
+		// providers that require credentials may refuse to be created
+		// without, those only get their classes loaded
+		g_autoptr(GError) err = NULL;
+		g_autoptr(GpteProvider) provider = gpte_provider_registry_create(self, providers[i], NULL, &err);
+		if (!provider) {
+			g_debug("Gpte.Jvm could not create %s for warming up: %s", providers[i], err->message);
+			continue;
+		}
+		jobject object = gpte_java_object_get(GPTE_JAVA_OBJECT(provider));
+		for (gsize j = 0; j < G_N_ELEMENTS(gpte_jvm_warmup_parsers); j++)
+			gpte_jvm_warmup_parser(env, object, &gpte_jvm_warmup_parsers[j], cancellable);
+	}
+}
+
 GpteJvm* gpte_jvm_ref(GpteJvm* self) {
 	g_atomic_ref_count_inc(&self->rc);
 	return self;
 }
-void gpte_jvm_unref(GpteJvm* self) {
-	if (g_atomic_ref_count_dec(&self->rc)) {
+static void gpte_jvm_free(GpteJvm* self) {
+	gpte_executor_free(self->executor);
+	gpte_reaper_free(self->reaper);
+
+	// the cached classes are global refs released by gpte_jni_clear()
+	g_hash_table_destroy(self->provider_instances);
+	g_hash_table_destroy(self->provider_classes);
+	g_mutex_clear(&self->registry_lock);
+
+	// The last reference may be dropped on a thread that was never
+	// attached, e.g. if gpte_jvm_create_async() was never finished. Such
+	// a thread is attached as a daemon only for as long as it takes,
+	// a stray attachment would hold up DestroyJavaVM() of an adopted
+	// VM's owner. Not through gpte_jvm_get_env(), an implicit
+	// attachment would outlive this instance.
+	JNIEnv* env = NULL;
+	gboolean attached = FALSE;
+	if ((*self->vm)->GetEnv(self->vm, (void**)&env, JNI_VERSION_21) != JNI_OK) {
+		env = NULL;
+		attached = (*self->vm)->AttachCurrentThreadAsDaemon(self->vm, (void**)&env, NULL) == JNI_OK;
+	}
+	gpte_jni_clear(&self->jni, env);
+	if (attached)
+		(*self->vm)->DetachCurrentThread(self->vm);
+
+	G_LOCK(gpte_jvm_attachment);
+	self->attachment->vm = NULL;
+	G_UNLOCK(gpte_jvm_attachment);
+	gpte_jvm_attachment_unref(self->attachment);
+
+	if (self->owns_vm) {
 		(*self->vm)->DestroyJavaVM(self->vm);
-		close(self->jar_fd);
-		free(self);
+		if (self->jar_fd >= 0)
+			close(self->jar_fd);
 	}
+	if (self->owner)
+		gpte_jvm_unref(self->owner);
+	g_mutex_clear(&self->executor_lock);
+	free(self);
+}
+
+// The executor can't join the worker it is freed from, and that worker
+// still detaches from the JVM after its job, so a last reference dropped
+// by a job is released on a thread of its own.
+static gpointer gpte_jvm_free_thread(GpteJvm* self) {
+	gpte_jvm_free(self);
+	return NULL;
+}
+
+void gpte_jvm_unref(GpteJvm* self) {
+	// gpte_jvm_get_default() must neither hand out nor adopt from a dying
+	// instance
+	if (self->is_default)
+		G_LOCK(gpte_jvm_default);
+	if (self->owns_vm)
+		G_LOCK(gpte_jvm_owner);
+	gboolean last = g_atomic_ref_count_dec(&self->rc);
+	if (last && self->is_default)
+		gpte_jvm_default = NULL;
+	if (last && gpte_jvm_owner == self)
+		gpte_jvm_owner = NULL;
+	if (self->owns_vm)
+		G_UNLOCK(gpte_jvm_owner);
+	if (self->is_default)
+		G_UNLOCK(gpte_jvm_default);
+
+	if (!last)
+		return;
+	if (self->executor && gpte_executor_is_current(self->executor))
+		g_thread_unref(g_thread_new("gpte-jvm-free", (GThreadFunc)gpte_jvm_free_thread, self));
+	else
+		gpte_jvm_free(self);
+}
+
+static JNIEnv* gpte_jvm_attach_implicitly(GpteJvm* self) {
+	g_autofree gchar* name = g_strdup_printf("gpte-implicit-%p", (gpointer)g_thread_self());
+
+	JNIEnv* env;
+	gint rc = (*self->vm)->AttachCurrentThreadAsDaemon(self->vm, (void**)&env, &(JavaVMAttachArgs){
+		.version = JNI_VERSION_21,
+		.name = name,
+		.group = NULL
+	});
+	if (rc != JNI_OK) {
+		g_critical("Gpte.Jvm was unable to implicitly attach thread (error %d)", rc);
+		return NULL;
+	}
+
+	// replacing a stale attachment of a previous JVM runs its destructor,
+	// which is a no-op as that JVM is already gone
+	if (g_private_get(&gpte_jvm_implicit_thread) != self->attachment)
+		g_private_replace(&gpte_jvm_implicit_thread, gpte_jvm_attachment_ref(self->attachment));
+	return env;
 }
 
 JNIEnv* gpte_jvm_get_env(GpteJvm* self) {
 	JNIEnv* env;
-	if ((*self->vm)->GetEnv(self->vm, (void**)&env, JNI_VERSION_21) != JNI_OK)
+	gint rc = (*self->vm)->GetEnv(self->vm, (void**)&env, JNI_VERSION_21);
+	if (rc == JNI_EDETACHED && g_atomic_int_get(&self->implicit_attach))
+		return gpte_jvm_attach_implicitly(self);
+	if (rc != JNI_OK)
 		return NULL;
 	return env;
 }
 
+void gpte_jvm_set_implicit_attach(GpteJvm* self, gboolean implicit_attach) {
+	g_return_if_fail(self != NULL);
+	g_atomic_int_set(&self->implicit_attach, !!implicit_attach);
+}
+
 GpteThreadGuard* gpte_jvm_attach_thread(GpteJvm* self, const gchar* name) {
 	return gpte_thread_guard_create(self, name);
 }
 
+GpteExecutor* gpte_jvm_get_executor(GpteJvm* self) {
+	g_mutex_lock(&self->executor_lock);
+	if (!self->executor)
+		self->executor = gpte_executor_new(self, self->executor_threads, self->executor_max_queued);
+	GpteExecutor* executor = self->executor;
+	g_mutex_unlock(&self->executor_lock);
+	return executor;
+}
+
+void gpte_jvm_set_executor_limits(GpteJvm* self, guint n_threads, guint max_queued) {
+	g_return_if_fail(self != NULL);
+	g_mutex_lock(&self->executor_lock);
+	self->executor_threads = n_threads;
+	self->executor_max_queued = max_queued;
+	if (self->executor)
+		gpte_executor_set_limits(self->executor, n_threads, max_queued);
+	g_mutex_unlock(&self->executor_lock);
+}
+
+void gpte_jvm_release_global(GpteJvm* self, jobject ref) {
+	gpte_reaper_release(self->reaper, ref);
+}
+
+void gpte_jvm_release_string(GpteJvm* self, jstring string, const char* utf8) {
+	gpte_reaper_release_string(self->reaper, string, utf8);
+}
+
+void gpte_jvm_get_release_stats(GpteJvm* self, gsize* pending, gsize* freed) {
+	g_return_if_fail(self != NULL);
+	gpte_reaper_get_stats(self->reaper, pending, freed);
+}
+
+void gpte_jvm_timing_query_done(GpteJvm* self) {
+	if (!g_atomic_int_compare_and_exchange(&self->first_query, FALSE, TRUE))
+		return;
+	g_debug("Gpte.Jvm completed its first query %.1f ms after creation started (RSS: %ld kB)",
+		(g_get_monotonic_time() - self->started) / 1000.0, gpte_jvm_rss());
+}
+
 GpteScopeGuard gpte_jvm_enter_scope(GpteJvm* self, gint capacity) {
 	JNIEnv* env = gpte_jvm_get_env(self);
 	if ((*env)->PushLocalFrame(env, capacity) < 0)
@@ -221,15 +972,13 @@ gboolean gpte_jvm_error(GpteJvm* self, GError** err) {
 	jthrowable exception = (*env)->ExceptionOccurred(env);
 	if (exception) {
 		ret = TRUE;
+		(*env)->ExceptionClear(env);
 
-		jclass throwable = (*env)->FindClass(env, "java/lang/Throwable");
-		jmethodID get_msg = (*env)->GetMethodID(env, throwable, "getMessage", "()Ljava/lang/String;");
-		jstring msg = (*env)->CallObjectMethod(env, exception, get_msg);
+		jstring msg = (*env)->CallObjectMethod(env, exception, self->jni.throwable.get_message);
 		const char* utf = msg ? (*env)->GetStringUTFChars(env, msg, NULL) : NULL;
 
-		jclass ioexc = (*env)->FindClass(env, "java/io/IOException");
 		GpteJavaError det_err;
-		if ((*env)->IsInstanceOf(env, exception, ioexc))
+		if ((*env)->IsInstanceOf(env, exception, self->jni.io_exception.class))
 			det_err = GPTE_JAVA_ERROR_IO_EXCEPTION;
 		else
 			det_err = GPTE_JAVA_ERROR_UNHANLED_EXCEPTION;
@@ -239,3 +988,75 @@ gboolean gpte_jvm_error(GpteJvm* self, GError** err) {
 	}
 	return ret;
 }
+
+void gpte_jvm_set_request_timeout(GpteJvm* self, guint timeout) {
+	g_return_if_fail(self != NULL);
+	g_atomic_int_set(&self->request_timeout, timeout);
+}
+
+jobject gpte_jvm_box_int(GpteJvm* self, gint value) {
+	JNIEnv* env = gpte_jvm_get_env(self);
+	return (*env)->CallStaticObjectMethod(env, self->jni.integer.class, self->jni.integer.value_of, (jint)value);
+}
+
+jobject gpte_jvm_box_boolean(GpteJvm* self, gboolean value) {
+	JNIEnv* env = gpte_jvm_get_env(self);
+	return (*env)->CallStaticObjectMethod(env, self->jni.boolean_.class, self->jni.boolean_.value_of, (jboolean)(value != FALSE));
+}
+
+typedef struct {
+	GpteJvm* vm;
+	jobject call;
+} GpteJvmCallCancel;
+
+static void gpte_jvm_call_cancelled(GCancellable*, GpteJvmCallCancel* self) {
+	JNIEnv* env = gpte_jvm_get_env(self->vm);
+	gboolean attached = FALSE;
+	if (!env) {
+		if ((*self->vm->vm)->AttachCurrentThreadAsDaemon(self->vm->vm, (void**)&env, NULL) != JNI_OK) {
+			g_critical("Gpte.Jvm was unable to attach thread to abort a cancelled request");
+			return;
+		}
+		attached = TRUE;
+	}
+
+	// closes the socket the query blocks on, see src/GpteCall.java
+	(*env)->CallVoidMethod(env, self->call, self->vm->jni.call.cancel);
+	(*env)->ExceptionClear(env);
+
+	if (attached)
+		(*self->vm->vm)->DetachCurrentThread(self->vm->vm);
+}
+
+jobject gpte_jvm_call_provider(GpteJvm* self, jobject provider, jmethodID method, jsize n_args, const jobject* args) {
+	JNIEnv* env = gpte_jvm_get_env(self);
+	if ((*env)->PushLocalFrame(env, 4) < 0)
+		g_error("GPTE out of stack memory");
+
+	jobject jmethod = (*env)->ToReflectedMethod(env, self->jni.network_provider.class, method, JNI_FALSE);
+	jobjectArray jargs = (*env)->NewObjectArray(env, n_args, self->jni.object.class, NULL);
+	if ((*env)->ExceptionCheck(env))
+		return (*env)->PopLocalFrame(env, NULL);
+	for (jsize i = 0; i < n_args; i++)
+		(*env)->SetObjectArrayElement(env, jargs, i, args[i]);
+	jobject call = (*env)->NewObject(env, self->jni.call.class, self->jni.call.init, provider, jmethod, jargs);
+	if ((*env)->ExceptionCheck(env))
+		return (*env)->PopLocalFrame(env, NULL);
+
+	GCancellable* cancellable = g_cancellable_get_current();
+	GpteJvmCallCancel cancel = { self, NULL };
+	gulong handler = 0;
+	if (cancellable) {
+		cancel.call = (*env)->NewGlobalRef(env, call);
+		handler = g_cancellable_connect(cancellable, G_CALLBACK(gpte_jvm_call_cancelled), &cancel, NULL);
+	}
+
+	jobject ret = (*env)->CallObjectMethod(env, call, self->jni.call.execute, (jlong)g_atomic_int_get(&self->request_timeout));
+
+	if (cancellable) {
+		// waits for a handler running on another thread
+		g_cancellable_disconnect(cancellable, handler);
+		(*env)->DeleteGlobalRef(env, cancel.call);
+	}
+	return (*env)->PopLocalFrame(env, ret);
+}
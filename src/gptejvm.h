@@ -19,7 +19,7 @@
 #ifndef __GPTEJVM_H__
 #define __GPTEJVM_H__
 
-#include <glib-object.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
@@ -78,13 +78,39 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(GpteThreadGuard, gpte_thread_guard_unref)
  * [Java Virtual Machine](https://docs.oracle.com/en/java/javase/17/vm/java-virtual-machine-technology-overview.html).
  *
  *
- * There may only be one instance alive at a time.
+ * There may only be one instance alive at a time. Use
+ * [func@Gpte.Jvm.get_default] if other components of the same process
+ * may use a JVM as well.
  */
 
 #define GPTE_TYPE_JVM (gpte_jvm_get_type())
 GType gpte_jvm_get_type(void);
 typedef struct _GpteJvm GpteJvm;
 
+/**
+ * GpteJvmPreset:
+ * @GPTE_JVM_PRESET_DEFAULT: leave the JVM defaults untouched
+ * @GPTE_JVM_PRESET_LOW_MEMORY: serial GC, a small heap and C1 only,
+ *   meant for devices with little memory
+ * @GPTE_JVM_PRESET_THROUGHPUT: a parallel GC and a large heap, meant
+ *   for servers handling many requests
+ *
+ * Set of JVM tunings applied by [func@Gpte.Jvm.create_with_options].
+ *
+ * The heap limits of the presets are derived from the memory limit of
+ * the cgroup the process is running in, or the physical memory if there
+ * is none.
+ */
+
+#define GPTE_TYPE_JVM_PRESET (gpte_jvm_preset_get_type())
+GType gpte_jvm_preset_get_type(void);
+
+typedef enum {
+	GPTE_JVM_PRESET_DEFAULT,
+	GPTE_JVM_PRESET_LOW_MEMORY,
+	GPTE_JVM_PRESET_THROUGHPUT
+} GpteJvmPreset;
+
 /**
  * gpte_vm_create:
  * @err: a #GError, or %NULL
@@ -95,6 +121,75 @@ typedef struct _GpteJvm GpteJvm;
  */
 GpteJvm* gpte_jvm_create(GError** err);
 
+/**
+ * gpte_jvm_get_default:
+ * @err: a #GError, or %NULL
+ *
+ * Returns the process wide JVM wrapper, creating it if necessary.
+ *
+ * If the process already runs a Java VM (e.g. created by another
+ * library), that VM is adopted and the GPTE classes are added to its
+ * system class loader. If it was created by another #GpteJvm, that
+ * instance is kept alive until the default one is freed.
+ *
+ * A JVM created here is destroyed once the last reference is dropped.
+ * As it can't be created again in the same process, applications
+ * should keep a reference for as long as they may use GPTE.
+ *
+ * Returns: (transfer full): the JVM wrapper
+ */
+GpteJvm* gpte_jvm_get_default(GError** err);
+
+/**
+ * gpte_jvm_create_with_options:
+ * @preset: the preset to start from
+ * @options: (array zero-terminated=1) (nullable): additional JVM options,
+ *   such as `-Xmx512m` or `-XX:+UseSerialGC`
+ * @err: a #GError, or %NULL
+ *
+ * Creates and initializes the Java VM, tuned by @preset and @options.
+ *
+ * Options given later take precedence. @options are applied after the
+ * preset and are themselves followed by the whitespace separated options
+ * in the `GPTE_JVM_OPTIONS` environment variable.
+ *
+ * Returns: (transfer full): the JVM wrapper
+ */
+GpteJvm* gpte_jvm_create_with_options(GpteJvmPreset preset, const gchar* const* options, GError** err);
+
+/**
+ * gpte_jvm_create_async:
+ * @preset: the preset to start from
+ * @options: (array zero-terminated=1) (nullable): additional JVM options
+ * @warmup_providers: (array zero-terminated=1) (nullable): providers to
+ *   warm up, or %NULL to skip [method@Gpte.Jvm.warmup]
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: (scope async): callback to call once the JVM is ready
+ * @user_data: (closure): data for @callback
+ *
+ * Asynchronous version of [func@Gpte.Jvm.create_with_options], which
+ * creates the JVM on a background thread and optionally warms it up
+ * there before calling @callback.
+ *
+ * The thread calling [func@Gpte.Jvm.create_finish] takes the role of
+ * the thread that created the JVM.
+ *
+ * A JVM can only be created once per process, so cancelling
+ * @cancellable after the JVM was created only cuts the warmup short.
+ */
+void gpte_jvm_create_async(GpteJvmPreset preset, const gchar* const* options, const gchar* const* warmup_providers, GCancellable* cancellable, GAsyncReadyCallback callback, gpointer user_data);
+
+/**
+ * gpte_jvm_create_finish:
+ * @result: the #GAsyncResult passed to the callback
+ * @err: a #GError, or %NULL
+ *
+ * Finishes [func@Gpte.Jvm.create_async].
+ *
+ * Returns: (transfer full): the JVM wrapper
+ */
+GpteJvm* gpte_jvm_create_finish(GAsyncResult* result, GError** err);
+
 /**
  * gpte_jvm_ref:
  * @self: the JVM wrapper
@@ -131,6 +226,77 @@ void gpte_jvm_unref(GpteJvm* self);
  */
 GpteThreadGuard* gpte_jvm_attach_thread(GpteJvm* self, const gchar* name);
 
+/**
+ * gpte_jvm_warmup:
+ * @self: the JVM wrapper
+ * @providers: (array zero-terminated=1) (nullable): ids of the providers
+ *   to load, e.g. `"db"`
+ * @cancellable: (nullable): a #GCancellable
+ *
+ * Loads and initializes the classes of @providers and of the libraries
+ * used for network requests, and runs the response parsers of their
+ * provider families on a sample often enough for the JIT to compile
+ * them. This moves work off the first real query.
+ *
+ * Cancelling @cancellable stops the warmup between two parser runs.
+ */
+void gpte_jvm_warmup(GpteJvm* self, const gchar* const* providers, GCancellable* cancellable);
+
+/**
+ * gpte_jvm_set_implicit_attach:
+ * @self: the JVM wrapper
+ * @implicit_attach: whether to attach threads implicitly
+ *
+ * If enabled, threads that call GPTE methods without holding a
+ * [struct@Gpte.ThreadGuard] are attached to the JVM (as daemon threads)
+ * on first use. The attachment is kept until the thread exits, so
+ * threads that are reused for many requests only pay for it once.
+ *
+ * This is disabled by default.
+ */
+void gpte_jvm_set_implicit_attach(GpteJvm* self, gboolean implicit_attach);
+
+/**
+ * gpte_jvm_set_executor_limits:
+ * @self: the JVM wrapper
+ * @n_threads: number of worker threads, or 0 for the default
+ * @max_queued: maximum number of pending requests, or 0 for the default
+ *
+ * Configures the pool of JVM-attached worker threads the `_async`
+ * methods run on. Requests beyond @max_queued fail with
+ * %GPTE_JAVA_ERROR_JVM_THREADING.
+ */
+void gpte_jvm_set_executor_limits(GpteJvm* self, guint n_threads, guint max_queued);
+
+/**
+ * gpte_jvm_set_request_timeout:
+ * @self: the JVM wrapper
+ * @timeout: milliseconds a query may take, or 0 for no limit
+ *
+ * Sets how long a provider query may take in total, including all
+ * network requests it makes. Queries exceeding it are aborted and fail
+ * with %GPTE_JAVA_ERROR_IO_EXCEPTION. Separate connect and read
+ * deadlines aren't available, providers build their HTTP client
+ * internally.
+ *
+ * The timeout is shared by every provider of @self, but each query is
+ * timed on its own. A single query can be given a tighter deadline by
+ * cancelling its [class@Gio.Cancellable] from a timeout source.
+ */
+void gpte_jvm_set_request_timeout(GpteJvm* self, guint timeout);
+
+/**
+ * gpte_jvm_get_release_stats:
+ * @self: the JVM wrapper
+ * @pending: (out) (optional): number of references waiting to be released
+ * @freed: (out) (optional): number of references released so far
+ *
+ * References held by GPTE objects are not released on the thread that
+ * frees them, but in batches on a dedicated thread. This reports the
+ * state of that queue.
+ */
+void gpte_jvm_get_release_stats(GpteJvm* self, gsize* pending, gsize* freed);
+
 /**
  * gpte_vm_error:
  * @self: the JVM wrapper
@@ -0,0 +1,62 @@
+/*
+ * gpte - GObject bindings for public-transport-enabler
+ * Copyright (C) 2024  Florian "sp1rit" <sp1rit@disroot.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef __GPTELIMITER_PRIV_H__
+#define __GPTELIMITER_PRIV_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Token bucket plus in-flight limit shared by all providers of the same
+ * identifier. Waiters are granted a slot in order of priority once both
+ * limits allow another request. Nothing blocks while waiting: a missing
+ * token is waited for with a timeout source on a limiter-owned thread,
+ * a missing in-flight slot is handed on when released.
+ */
+typedef struct _GpteLimiter GpteLimiter;
+// a granted request, to be handed back to gpte_limiter_release()
+typedef GpteLimiter GpteLimiterSlot;
+
+// never freed, lives as long as the process
+GpteLimiter* gpte_limiter_get(const gchar* id);
+
+// @rate requests per second (0 for unlimited) with bursts of up to
+// @burst requests, and at most @max_in_flight (0 for unlimited) at once
+void gpte_limiter_configure(GpteLimiter* self, gdouble rate, guint burst, guint max_in_flight);
+
+// receives the granted slot, or NULL if the wait was cancelled
+typedef void (*GpteLimiterFunc)(GpteLimiterSlot* slot, gpointer data);
+
+// Lower @priority values are served first. @func is called once, either
+// right away or later from any thread that frees up a slot or refills
+// a token, or on @context (the thread default one if %NULL) once
+// @cancellable is cancelled.
+void gpte_limiter_acquire_async(GpteLimiter* self, gint priority, GCancellable* cancellable, GMainContext* context, GpteLimiterFunc func, gpointer data);
+// for synchronous callers, iterates a private context until a slot is
+// granted, returns NULL once @cancellable is cancelled
+GpteLimiterSlot* gpte_limiter_acquire(GpteLimiter* self, gint priority, GCancellable* cancellable);
+void gpte_limiter_release(GpteLimiterSlot* slot);
+
+void gpte_limiter_get_stats(GpteLimiter* self, guint* queued, guint* in_flight, gint64* mean_wait, gint64* max_wait);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(GpteLimiterSlot, gpte_limiter_release)
+
+G_END_DECLS
+
+#endif // __GPTELIMITER_PRIV_H__
@@ -0,0 +1,294 @@
+/*
+ * gpte - GObject bindings for public-transport-enabler
+ * Copyright (C) 2024  Florian "sp1rit" <sp1rit@disroot.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "gptelimiter-priv.h"
+
+struct _GpteLimiter {
+	GMutex lock;
+
+	gdouble rate;
+	gdouble burst;
+	guint max_in_flight;
+
+	gdouble tokens;
+	gint64 refilled;
+	guint in_flight;
+
+	// GpteLimiterWaiter, ordered by priority and arrival
+	GQueue waiters;
+	guint64 seq;
+	// grants the head waiter once its token is ready, on the context of
+	// gpte_limiter_timer_context()
+	GSource* timer;
+
+	guint64 granted;
+	gint64 total_wait;
+	gint64 max_wait;
+};
+
+typedef struct {
+	gatomicrefcount rc;
+	gint priority;
+	guint64 seq;
+	gint64 start;
+	GMainContext* context;
+	GSource* cancel_source;
+	GpteLimiterFunc func;
+	gpointer data;
+	GpteLimiter* limiter;
+} GpteLimiterWaiter;
+
+static GpteLimiterWaiter* gpte_limiter_waiter_ref(GpteLimiterWaiter* self) {
+	g_atomic_ref_count_inc(&self->rc);
+	return self;
+}
+static void gpte_limiter_waiter_unref(GpteLimiterWaiter* self) {
+	if (!g_atomic_ref_count_dec(&self->rc))
+		return;
+	if (self->context)
+		g_main_context_unref(self->context);
+	if (self->cancel_source)
+		g_source_unref(self->cancel_source);
+	g_free(self);
+}
+
+static gpointer gpte_limiter_timer_thread(GMainContext* context) {
+	g_main_context_push_thread_default(context);
+	while (TRUE)
+		g_main_context_iteration(context, TRUE);
+	return NULL;
+}
+
+// Refill timers of all limiters run on a thread of their own. Granting
+// must not depend on a caller iterating its context: that context may
+// belong to a thread that is itself blocked in gpte_limiter_acquire().
+static GMainContext* gpte_limiter_timer_context(void) {
+	static gsize context = 0;
+	if (g_once_init_enter(&context)) {
+		GMainContext* new = g_main_context_new();
+		g_thread_unref(g_thread_new("gpte-limiter", (GThreadFunc)gpte_limiter_timer_thread, g_main_context_ref(new)));
+		g_once_init_leave(&context, (gsize)new);
+	}
+	return (GMainContext*)context;
+}
+
+G_LOCK_DEFINE_STATIC(gpte_limiters);
+static GHashTable* gpte_limiters = NULL;
+
+GpteLimiter* gpte_limiter_get(const gchar* id) {
+	G_LOCK(gpte_limiters);
+	if (!gpte_limiters)
+		gpte_limiters = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	GpteLimiter* self = g_hash_table_lookup(gpte_limiters, id);
+	if (!self) {
+		self = g_new0(GpteLimiter, 1);
+		g_mutex_init(&self->lock);
+		g_queue_init(&self->waiters);
+		self->refilled = g_get_monotonic_time();
+		g_hash_table_insert(gpte_limiters, g_strdup(id), self);
+	}
+	G_UNLOCK(gpte_limiters);
+	return self;
+}
+
+// must be called with self->lock held
+static void gpte_limiter_refill(GpteLimiter* self, gint64 now) {
+	if (self->rate > 0)
+		self->tokens = MIN(self->burst, self->tokens + (now - self->refilled) * self->rate / G_USEC_PER_SEC);
+	self->refilled = now;
+}
+
+static gboolean gpte_limiter_timer_fired(GpteLimiter* self);
+
+// Must be called with self->lock held. Grants tokens to the waiters at
+// the head of the queue and returns them, their callbacks are to be run
+// with gpte_limiter_complete() once the lock is released.
+static GSList* gpte_limiter_dispatch(GpteLimiter* self) {
+	GSList* granted = NULL;
+	gint64 now = g_get_monotonic_time();
+	gpte_limiter_refill(self, now);
+
+	GpteLimiterWaiter* head;
+	while ((head = g_queue_peek_head(&self->waiters))) {
+		if (self->max_in_flight && self->in_flight >= self->max_in_flight)
+			break;
+		if (self->rate > 0 && self->tokens < 1)
+			break;
+
+		g_queue_pop_head(&self->waiters);
+		if (self->rate > 0)
+			self->tokens -= 1;
+		self->in_flight++;
+
+		gint64 waited = now - head->start;
+		self->granted++;
+		self->total_wait += waited;
+		self->max_wait = MAX(self->max_wait, waited);
+		granted = g_slist_prepend(granted, head);
+	}
+
+	// Only a missing token needs a timer, a missing in-flight slot is
+	// handed on by gpte_limiter_release().
+	gboolean needs_timer = head && self->rate > 0 && self->tokens < 1 && !(self->max_in_flight && self->in_flight >= self->max_in_flight);
+	if (self->timer && (!needs_timer || g_source_is_destroyed(self->timer))) {
+		g_source_destroy(self->timer);
+		g_clear_pointer(&self->timer, g_source_unref);
+	}
+	if (needs_timer && !self->timer) {
+		gint64 ready = (1 - self->tokens) * G_USEC_PER_SEC / self->rate + 1;
+		self->timer = g_timeout_source_new((ready + 999) / 1000);
+		g_source_set_callback(self->timer, (GSourceFunc)gpte_limiter_timer_fired, self, NULL);
+		g_source_attach(self->timer, gpte_limiter_timer_context());
+	}
+	return g_slist_reverse(granted);
+}
+
+static void gpte_limiter_complete(GSList* granted) {
+	for (GSList* l = granted; l; l = l->next) {
+		GpteLimiterWaiter* waiter = l->data;
+		if (waiter->cancel_source)
+			g_source_destroy(waiter->cancel_source);
+		waiter->func(waiter->limiter, waiter->data);
+		gpte_limiter_waiter_unref(waiter);
+	}
+	g_slist_free(granted);
+}
+
+static gboolean gpte_limiter_timer_fired(GpteLimiter* self) {
+	g_mutex_lock(&self->lock);
+	if (self->timer == g_main_current_source())
+		g_clear_pointer(&self->timer, g_source_unref);
+	GSList* granted = gpte_limiter_dispatch(self);
+	g_mutex_unlock(&self->lock);
+	gpte_limiter_complete(granted);
+	return G_SOURCE_REMOVE;
+}
+
+void gpte_limiter_configure(GpteLimiter* self, gdouble rate, guint burst, guint max_in_flight) {
+	g_mutex_lock(&self->lock);
+	gpte_limiter_refill(self, g_get_monotonic_time());
+	// a freshly limited provider starts with a full bucket
+	gboolean was_unlimited = self->rate <= 0;
+	self->rate = MAX(rate, 0);
+	self->burst = MAX(burst, 1);
+	self->tokens = was_unlimited ? self->burst : MIN(self->tokens, self->burst);
+	self->max_in_flight = max_in_flight;
+	GSList* granted = gpte_limiter_dispatch(self);
+	g_mutex_unlock(&self->lock);
+	gpte_limiter_complete(granted);
+}
+
+static gint gpte_limiter_waiter_compare(const GpteLimiterWaiter* a, const GpteLimiterWaiter* b, gpointer) {
+	if (a->priority != b->priority)
+		return a->priority < b->priority ? -1 : 1;
+	return a->seq < b->seq ? -1 : (a->seq > b->seq);
+}
+
+static gboolean gpte_limiter_cancelled(GCancellable*, GpteLimiterWaiter* waiter) {
+	GpteLimiter* self = waiter->limiter;
+	g_mutex_lock(&self->lock);
+	// may have been granted concurrently
+	gboolean removed = g_queue_remove(&self->waiters, waiter);
+	GSList* granted = removed ? gpte_limiter_dispatch(self) : NULL;
+	g_mutex_unlock(&self->lock);
+
+	if (removed) {
+		waiter->func(NULL, waiter->data);
+		// drops the reference of the queue
+		gpte_limiter_waiter_unref(waiter);
+	}
+	gpte_limiter_complete(granted);
+	return G_SOURCE_REMOVE;
+}
+
+void gpte_limiter_acquire_async(GpteLimiter* self, gint priority, GCancellable* cancellable, GMainContext* context, GpteLimiterFunc func, gpointer data) {
+	GpteLimiterWaiter* waiter = g_new(GpteLimiterWaiter, 1);
+	g_atomic_ref_count_init(&waiter->rc);
+	waiter->priority = priority;
+	waiter->start = g_get_monotonic_time();
+	waiter->context = context ? g_main_context_ref(context) : g_main_context_ref_thread_default();
+	waiter->func = func;
+	waiter->data = data;
+	waiter->limiter = self;
+
+	// unlike a ::cancelled handler, a source can be removed from any
+	// thread and at any time without waiting for its callback
+	waiter->cancel_source = NULL;
+	if (cancellable) {
+		waiter->cancel_source = g_cancellable_source_new(cancellable);
+		g_source_set_priority(waiter->cancel_source, priority);
+		g_source_set_callback(waiter->cancel_source, (GSourceFunc)gpte_limiter_cancelled, gpte_limiter_waiter_ref(waiter), (GDestroyNotify)gpte_limiter_waiter_unref);
+		g_source_attach(waiter->cancel_source, waiter->context);
+	}
+
+	g_mutex_lock(&self->lock);
+	waiter->seq = self->seq++;
+	g_queue_insert_sorted(&self->waiters, waiter, (GCompareDataFunc)gpte_limiter_waiter_compare, NULL);
+	GSList* granted = gpte_limiter_dispatch(self);
+	g_mutex_unlock(&self->lock);
+	gpte_limiter_complete(granted);
+}
+
+typedef struct {
+	GMainContext* context;
+	GpteLimiterSlot* slot;
+	gint done;
+} GpteLimiterSync;
+
+static void gpte_limiter_sync_done(GpteLimiterSlot* slot, GpteLimiterSync* sync) {
+	sync->slot = slot;
+	g_atomic_int_set(&sync->done, TRUE);
+	g_main_context_wakeup(sync->context);
+}
+
+GpteLimiterSlot* gpte_limiter_acquire(GpteLimiter* self, gint priority, GCancellable* cancellable) {
+	GpteLimiterSync sync = {
+		.context = g_main_context_new(),
+		.slot = NULL,
+		.done = FALSE
+	};
+	gpte_limiter_acquire_async(self, priority, cancellable, sync.context, (GpteLimiterFunc)gpte_limiter_sync_done, &sync);
+	while (!g_atomic_int_get(&sync.done))
+		g_main_context_iteration(sync.context, TRUE);
+	g_main_context_unref(sync.context);
+	return sync.slot;
+}
+
+void gpte_limiter_release(GpteLimiterSlot* slot) {
+	GpteLimiter* self = slot;
+	g_mutex_lock(&self->lock);
+	self->in_flight--;
+	GSList* granted = gpte_limiter_dispatch(self);
+	g_mutex_unlock(&self->lock);
+	gpte_limiter_complete(granted);
+}
+
+void gpte_limiter_get_stats(GpteLimiter* self, guint* queued, guint* in_flight, gint64* mean_wait, gint64* max_wait) {
+	g_mutex_lock(&self->lock);
+	if (queued)
+		*queued = self->waiters.length;
+	if (in_flight)
+		*in_flight = self->in_flight;
+	if (mean_wait)
+		*mean_wait = self->granted ? self->total_wait / (gint64)self->granted : 0;
+	if (max_wait)
+		*max_wait = self->max_wait;
+	g_mutex_unlock(&self->lock);
+}
@@ -57,36 +57,50 @@ struct _GpteLine {
 	GpteCachedString label;
 	GpteCachedString name;
 	GpteStyle* style;
+	// FALSE if style is interned by the style cache of the provider
+	gboolean owns_style;
 	GpteLineAttrs attrs;
 	GpteCachedString message;
 };
 
 G_DEFINE_TYPE (GpteLine, gpte_line, GPTE_TYPE_JAVA_OBJECT)
 
-#define GPTE_LINE_FREE_CACHED_STRING(env,fn,ce) \
-	if ((self->cached & (ce)) && self->fn.string) { \
-		(*(env))->ReleaseStringUTFChars((env), self->fn.string, self->fn.utf8); \
-		(*(env))->DeleteGlobalRef((env), self->fn.string); \
+// detached lines own a copy of the string instead
+#define GPTE_LINE_FREE_CACHED_STRING(vm,fn,ce) \
+	if ((self->cached & (ce)) && self->fn.string) \
+		gpte_jvm_release_string((vm), self->fn.string, self->fn.utf8); \
+	else if (self->cached & (ce)) \
+		g_free((gchar*)self->fn.utf8);
+#define GPTE_LINE_DETACH_CACHED_STRING(vm,fn) \
+	if (self->fn.string) { \
+		gchar* copy = g_strdup(self->fn.utf8); \
+		gpte_jvm_release_string((vm), self->fn.string, self->fn.utf8); \
+		self->fn = (GpteCachedString){ .string = NULL, .utf8 = copy }; \
 	}
 
+static void gpte_line_hydrate(GpteJavaObject* object);
+
 static void gpte_location_finalize(GObject* object) {
 	GpteLine* self = GPTE_LINE(object);
-	JNIEnv* env = gpte_java_object_env(GPTE_JAVA_OBJECT(self));
-	GPTE_LINE_FREE_CACHED_STRING(env, id, GPTE_LINE_CACHED_ID)
-	GPTE_LINE_FREE_CACHED_STRING(env, network, GPTE_LINE_CACHED_NETWORK)
-	GPTE_LINE_FREE_CACHED_STRING(env, label, GPTE_LINE_CACHED_LABEL)
-	GPTE_LINE_FREE_CACHED_STRING(env, name, GPTE_LINE_CACHED_NAME)
-	//GpteStyle* gpte_line_get_style(GpteLine* self);
-	GPTE_LINE_FREE_CACHED_STRING(env, message, GPTE_LINE_CACHED_MESSAGE)
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	GPTE_LINE_FREE_CACHED_STRING(vm, id, GPTE_LINE_CACHED_ID)
+	GPTE_LINE_FREE_CACHED_STRING(vm, network, GPTE_LINE_CACHED_NETWORK)
+	GPTE_LINE_FREE_CACHED_STRING(vm, label, GPTE_LINE_CACHED_LABEL)
+	GPTE_LINE_FREE_CACHED_STRING(vm, name, GPTE_LINE_CACHED_NAME)
+	if ((self->cached & GPTE_LINE_CACHED_STYLE) && self->owns_style)
+		gpte_style_free(self->style);
+	GPTE_LINE_FREE_CACHED_STRING(vm, message, GPTE_LINE_CACHED_MESSAGE)
 	G_OBJECT_CLASS(gpte_line_parent_class)->finalize(object);
 }
 
 static void gpte_line_class_init(GpteLineClass* class) {
 	G_OBJECT_CLASS(class)->finalize = gpte_location_finalize;
+	GPTE_JAVA_OBJECT_CLASS(class)->hydrate = gpte_line_hydrate;
 }
 
 static void gpte_line_init(GpteLine* self) {
 	self->cached = 0;
+	self->owns_style = FALSE;
 }
 
 #define GPTE_LINE_STRING_GETTER(fn,ce) \
@@ -95,12 +109,9 @@ static void gpte_line_init(GpteLine* self) {
 		if (self->cached & (ce)) \
 			return self->fn.utf8; \
 		GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self)); \
-		g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3); \
+		g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1); \
 		jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self)); \
-		jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Line"); \
-		jfieldID field_id = (*env)->GetFieldID(env, class, #fn, "Ljava/lang/String;"); \
-		g_return_val_if_fail(field_id, NULL); \
-		self->fn.string = (*env)->GetObjectField(env, this, field_id); \
+		self->fn.string = (*env)->GetObjectField(env, this, vm->jni.line.fn); \
 		if (!self->fn.string) { \
 			self->fn.utf8 = NULL; \
 			self->cached |= (ce); \
@@ -121,11 +132,9 @@ GpteProductCode gpte_line_get_product(GpteLine* self) {
 	if (self->cached & GPTE_LINE_CACHED_PRODUCT)
 		return self->product;
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Line");
-	jfieldID field_id = (*env)->GetFieldID(env, class, "product", "Lde/schildbach/pte/dto/Product;");
-	jobject jproduct = (*env)->GetObjectField(env, this, field_id);
+	jobject jproduct = (*env)->GetObjectField(env, this, vm->jni.line.product);
 	if (!jproduct) {
 		self->product = GPTE_PRODUCT_CODE_NULL;
 		self->cached |= GPTE_LINE_CACHED_PRODUCT;
@@ -137,22 +146,35 @@ GpteProductCode gpte_line_get_product(GpteLine* self) {
 }
 GPTE_LINE_STRING_GETTER(label, GPTE_LINE_CACHED_LABEL)
 GPTE_LINE_STRING_GETTER(name, GPTE_LINE_CACHED_NAME)
+static GpteStyle* gpte_line_style_from_java(GpteLine* self) {
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
+	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
+	jobject jstyle = (*env)->GetObjectField(env, this, vm->jni.line.style);
+	return jstyle ? gpte_style_from_java(vm, jstyle) : NULL;
+}
 GpteStyle* gpte_line_get_style(GpteLine* self) {
 	g_return_val_if_fail(GPTE_IS_LINE(self), NULL);
 	if (self->cached & GPTE_LINE_CACHED_STYLE)
 		return self->style;
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
-	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Line");
-	jfieldID field_id = (*env)->GetFieldID(env, class, "style", "Lde/schildbach/pte/dto/Style;");
-	jobject jstyle = (*env)->GetObjectField(env, this, field_id);
-	if (!jstyle) {
-		self->style = NULL;
+
+	GpteStyleCache* cache = gpte_style_cache_get_for(self);
+	if (!cache) {
+		self->style = gpte_line_style_from_java(self);
+		self->owns_style = TRUE;
 		self->cached |= GPTE_LINE_CACHED_STYLE;
-		return NULL;
+		return self->style;
 	}
-	self->style = gpte_style_from_java(vm, jstyle);
+
+	// lines of the same provider with the same identity share their style
+	const gchar* network = gpte_line_get_network(self);
+	GpteProductCode product = gpte_line_get_product(self);
+	const gchar* label = gpte_line_get_label(self);
+	gboolean found;
+	const GpteStyle* style = gpte_style_cache_lookup(cache, network, product, label, &found);
+	if (!found)
+		style = gpte_style_cache_insert(cache, network, product, label, gpte_line_style_from_java(self));
+	self->style = (GpteStyle*)style;
 	self->cached |= GPTE_LINE_CACHED_STYLE;
 	return self->style;
 }
@@ -160,11 +182,10 @@ GpteLineAttrs gpte_line_get_attrs(GpteLine* self) {
 	g_return_val_if_fail(GPTE_IS_LINE(self), 0);
 	if (self->cached & GPTE_LINE_CACHED_ATTRS)
 		return self->attrs;
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self)), 13);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Line");
-	jfieldID field_id = (*env)->GetFieldID(env, class, "attrs", "Ljava/util/Set;");
-	jobject jattrs = (*env)->GetObjectField(env, this, field_id);
+	jobject jattrs = (*env)->GetObjectField(env, this, vm->jni.line.attrs);
 	if (!jattrs) {
 		self->attrs = 0;
 		self->cached |= GPTE_LINE_CACHED_ATTRS;
@@ -172,45 +193,14 @@ GpteLineAttrs gpte_line_get_attrs(GpteLine* self) {
 	}
 
 	self->attrs = 0;
-	jclass set_class = (*env)->FindClass(env, "java/util/Set");
-	jmethodID set_to_array = (*env)->GetMethodID(env, set_class, "toArray", "()[Ljava/lang/Object;");
-	jobjectArray elems = (*env)->CallObjectMethod(env, jattrs, set_to_array);
+	jobjectArray elems = (*env)->CallObjectMethod(env, jattrs, vm->jni.set.to_array);
 	jsize len = (*env)->GetArrayLength(env, elems);
 
-	jclass attrs_class = (*env)->FindClass(env, "de/schildbach/pte/dto/Line$Attr");
-	jobject clockwise = (*env)->GetStaticObjectField(
-		env, attrs_class,
-		(*env)->GetStaticFieldID(env, attrs_class, "CIRCLE_CLOCKWISE", "Lde/schildbach/pte/dto/Line$Attr;")
-	);
-	jobject anticlockwise = (*env)->GetStaticObjectField(
-		env, attrs_class,
-		(*env)->GetStaticFieldID(env, attrs_class, "CIRCLE_ANTICLOCKWISE", "Lde/schildbach/pte/dto/Line$Attr;")
-	);
-	jobject replacement = (*env)->GetStaticObjectField(
-		env, attrs_class,
-		(*env)->GetStaticFieldID(env, attrs_class, "SERVICE_REPLACEMENT", "Lde/schildbach/pte/dto/Line$Attr;")
-	);
-	jobject airport = (*env)->GetStaticObjectField(
-		env, attrs_class,
-		(*env)->GetStaticFieldID(env, attrs_class, "LINE_AIRPORT", "Lde/schildbach/pte/dto/Line$Attr;")
-	);
-	jobject bicylces = (*env)->GetStaticObjectField(
-		env, attrs_class,
-		(*env)->GetStaticFieldID(env, attrs_class, "BICYCLE_CARRIAGE", "Lde/schildbach/pte/dto/Line$Attr;")
-	);
-
 	for (jsize i = 0; i < len; i++) {
 		jobject entry = (*env)->GetObjectArrayElement(env, elems, i);
-		if ((*env)->IsSameObject(env, entry, clockwise))
-			self->attrs |= GPTE_LINE_ATTR_CIRCLE_CLOCKWISE;
-		else if ((*env)->IsSameObject(env, entry, anticlockwise))
-			self->attrs |= GPTE_LINE_ATTR_CIRCLE_ANTICLOCKWISE;
-		else if ((*env)->IsSameObject(env, entry, replacement))
-			self->attrs |= GPTE_LINE_ATTR_SERVICE_REPLACEMENT;
-		else if ((*env)->IsSameObject(env, entry, airport))
-			self->attrs |= GPTE_LINE_ATTR_LINE_AIRPORT;
-		else if ((*env)->IsSameObject(env, entry, bicylces))
-			self->attrs |= GPTE_LINE_ATTR_BICYCLE_CARRIAGE;
+		gint attr = gpte_jni_enum_decode(&vm->jni, env, &vm->jni.line_attr, entry);
+		if (attr >= 0)
+			self->attrs |= 1 << attr;
 		else
 			g_critical("Unknown line attribute: %p", entry);
 		(*env)->DeleteLocalRef(env, entry);
@@ -220,3 +210,26 @@ GpteLineAttrs gpte_line_get_attrs(GpteLine* self) {
 	return self->attrs;
 }
 GPTE_LINE_STRING_GETTER(message, GPTE_LINE_CACHED_MESSAGE)
+
+static void gpte_line_hydrate(GpteJavaObject* object) {
+	GpteLine* self = GPTE_LINE(object);
+	GpteJvm* vm = gpte_java_object_get_vm(object);
+	gpte_line_get_id(self);
+	gpte_line_get_network(self);
+	gpte_line_get_product(self);
+	gpte_line_get_label(self);
+	gpte_line_get_name(self);
+	gpte_line_get_style(self);
+	gpte_line_get_attrs(self);
+	gpte_line_get_message(self);
+	GPTE_LINE_DETACH_CACHED_STRING(vm, id)
+	GPTE_LINE_DETACH_CACHED_STRING(vm, network)
+	GPTE_LINE_DETACH_CACHED_STRING(vm, label)
+	GPTE_LINE_DETACH_CACHED_STRING(vm, name)
+	GPTE_LINE_DETACH_CACHED_STRING(vm, message)
+}
+
+GpteLine* gpte_line_snapshot(GpteLine* self) {
+	g_return_val_if_fail(GPTE_IS_LINE(self), NULL);
+	return GPTE_LINE(gpte_java_object_snapshot(GPTE_JAVA_OBJECT(self)));
+}
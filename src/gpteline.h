@@ -119,6 +119,9 @@ const gchar* gpte_line_get_name(GpteLine* self);
  *
  * Gets the visual style parameters for displaying the line.
  *
+ * Lines returned by a [class@Gpte.Provider] share the style of lines with
+ * the same network, product and label, which must not be modified.
+ *
  * Returns: (transfer none) (nullable): visual style
  */
 GpteStyle* gpte_line_get_style(GpteLine* self);
@@ -144,6 +147,17 @@ GpteLineAttrs gpte_line_get_attrs(GpteLine* self);
  */
 const gchar* gpte_line_get_message(GpteLine* self);
 
+/**
+ * gpte_line_snapshot:
+ * @self: the line
+ *
+ * Copies @self into native memory, see
+ * [method@Gpte.JavaObject.snapshot].
+ *
+ * Returns: (transfer full): a detached copy of @self
+ */
+GpteLine* gpte_line_snapshot(GpteLine* self);
+
 G_END_DECLS
 
 #endif // __GPTELINE_H__
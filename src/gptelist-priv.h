@@ -25,10 +25,27 @@
 G_BEGIN_DECLS
 
 GListModel* gpte_list_new(GpteJvm* vm, GType type, jobject list);
+// a new wrapper of the Java list of @self with caches of its own, for
+// handing the same result to another thread
+GListModel* gpte_list_copy(GpteList* self);
+
+// Reads the fields of a window of newly wrapped items in bulk. @items is
+// the Java array of the window and @wrapped holds its wrappers, entries
+// may be %NULL if they were evicted again.
+typedef void (*GpteListPackFunc)(GpteJvm* vm, jobjectArray items, GObject** wrapped, guint n_items);
+// makes @self eager: the whole list is wrapped on first access (as far
+// as the cache limit allows) and @func fills in the wrappers
+void gpte_list_set_pack_func(GpteList* self, GpteListPackFunc func);
 
 void gpte_list_prepend(GpteList* self, jobject list);
 void gpte_list_append(GpteList* self, jobject list);
 
+// Snapshots every item of @list. Unlike a GListStore, the returned array
+// can be read from several threads at once, so detached lists that are
+// shared keep their items in one and hand out a fresh store per caller.
+GPtrArray* gpte_list_detach_items(GListModel* list);
+GListModel* gpte_list_store_new_from_items(GType type, GPtrArray* items);
+
 G_END_DECLS
 
 #endif // __GPTELIST_PRIV_H__
@@ -19,10 +19,128 @@
 #include "gptelist.h"
 #include "gptelist-priv.h"
 #include <gptejavaobject-priv.h>
+#include "gptestyle-priv.h"
 
-static void gpte_list_g_object_unref_with_null_guard(GObject* object) {
-	if (object)
-		g_object_unref(object);
+// number of items wrapped per call into the JVM, and slots per chunk
+#define GPTE_LIST_WINDOW 32
+
+typedef struct {
+	GObject* item;
+	// position in the LRU queue while item is set
+	GList* link;
+} GpteListSlot;
+
+/*
+ * Two-ended cache of item wrappers. Slots are allocated in chunks,
+ * referenced by a ring buffer so chunks can be added in front of or
+ * after the existing ones without moving any slot. Chunks are only
+ * allocated once a slot within them is used.
+ */
+typedef struct {
+	GpteListSlot** chunks;
+	guint head;
+	guint n_chunks;
+	guint capacity;
+	// unused slots before the first item in the first chunk
+	guint front;
+
+	// live wrappers, most recently used first
+	GQueue lru;
+	guint max_live;
+} GpteListCache;
+
+static void gpte_list_cache_init(GpteListCache* self) {
+	self->chunks = NULL;
+	self->head = 0;
+	self->n_chunks = 0;
+	self->capacity = 0;
+	self->front = 0;
+	g_queue_init(&self->lru);
+	self->max_live = 0;
+}
+
+static void gpte_list_cache_clear(GpteListCache* self) {
+	for (GList* link = self->lru.head; link; link = link->next)
+		g_object_unref(((GpteListSlot*)link->data)->item);
+	g_queue_clear(&self->lru);
+	for (guint i = 0; i < self->n_chunks; i++)
+		g_free(self->chunks[(self->head + i) % self->capacity]);
+	g_clear_pointer(&self->chunks, g_free);
+	self->head = 0;
+	self->n_chunks = 0;
+	self->capacity = 0;
+	self->front = 0;
+}
+
+static void gpte_list_cache_reserve(GpteListCache* self) {
+	if (self->n_chunks < self->capacity)
+		return;
+	guint capacity = MAX(self->capacity * 2, 4);
+	GpteListSlot** chunks = g_new0(GpteListSlot*, capacity);
+	for (guint i = 0; i < self->n_chunks; i++)
+		chunks[i] = self->chunks[(self->head + i) % self->capacity];
+	g_free(self->chunks);
+	self->chunks = chunks;
+	self->head = 0;
+	self->capacity = capacity;
+}
+
+// makes room for @n items before the current first one
+static void gpte_list_cache_prepend(GpteListCache* self, guint n) {
+	while (self->front < n) {
+		gpte_list_cache_reserve(self);
+		self->head = (self->head + self->capacity - 1) % self->capacity;
+		self->chunks[self->head] = NULL;
+		self->n_chunks++;
+		self->front += GPTE_LIST_WINDOW;
+	}
+	self->front -= n;
+}
+
+// returns NULL if the slot wasn't allocated and @create is FALSE
+static GpteListSlot* gpte_list_cache_slot(GpteListCache* self, guint idx, gboolean create) {
+	guint pos = self->front + idx;
+	guint chunk = pos / GPTE_LIST_WINDOW;
+	if (chunk >= self->n_chunks) {
+		if (!create)
+			return NULL;
+		while (self->n_chunks <= chunk) {
+			gpte_list_cache_reserve(self);
+			self->chunks[(self->head + self->n_chunks) % self->capacity] = NULL;
+			self->n_chunks++;
+		}
+	}
+
+	GpteListSlot** slots = &self->chunks[(self->head + chunk) % self->capacity];
+	if (!*slots) {
+		if (!create)
+			return NULL;
+		*slots = g_new0(GpteListSlot, GPTE_LIST_WINDOW);
+	}
+	return &(*slots)[pos % GPTE_LIST_WINDOW];
+}
+
+static void gpte_list_cache_evict(GpteListCache* self) {
+	while (self->max_live && self->lru.length > self->max_live) {
+		GList* link = g_queue_pop_tail_link(&self->lru);
+		GpteListSlot* slot = link->data;
+		g_clear_object(&slot->item);
+		slot->link = NULL;
+		g_list_free_1(link);
+	}
+}
+
+// takes ownership of @item
+static void gpte_list_cache_store(GpteListCache* self, GpteListSlot* slot, GObject* item) {
+	slot->item = item;
+	g_queue_push_head(&self->lru, slot);
+	slot->link = self->lru.head;
+	gpte_list_cache_evict(self);
+}
+
+static void gpte_list_cache_touch(GpteListCache* self, GpteListSlot* slot) {
+	g_queue_unlink(&self->lru, slot->link);
+	g_queue_push_head_link(&self->lru, slot->link);
 }
 
 struct _GpteList {
@@ -30,8 +148,13 @@ struct _GpteList {
 
 	GTypeClass* child_kind;
 
+	// models may be shared between threads (e.g. by the departures cache)
+	GMutex lock;
 	gint length;
-	GPtrArray* cache;
+	GpteListCache cache;
+	// index of the previous cache miss, to guess the scroll direction
+	gint last_miss;
+	GpteListPackFunc pack;
 };
 
 static void gpte_list_iface_init(GListModelInterface* iface);
@@ -48,11 +171,14 @@ static GParamSpec* obj_properties[N_PROPERTIES] = { 0, };
 static void gpte_list_finalize(GObject* object) {
 	GpteList* self = GPTE_LIST(object);
 	g_type_class_unref(self->child_kind);
+	g_mutex_clear(&self->lock);
 	G_OBJECT_CLASS(gpte_list_parent_class)->finalize(object);
 }
 static void gpte_list_dispose(GObject* object) {
 	GpteList* self = GPTE_LIST(object);
-	g_ptr_array_unref(self->cache);
+	g_mutex_lock(&self->lock);
+	gpte_list_cache_clear(&self->cache);
+	g_mutex_unlock(&self->lock);
 	G_OBJECT_CLASS(gpte_list_parent_class)->dispose(object);
 }
 
@@ -96,48 +222,119 @@ static void gpte_list_class_init(GpteListClass* class) {
 
 static void gpte_list_init(GpteList* self) {
 	self->child_kind = NULL;
+	g_mutex_init(&self->lock);
 	self->length = -1;
-	self->cache = g_ptr_array_new_with_free_func((GDestroyNotify)gpte_list_g_object_unref_with_null_guard);
+	self->last_miss = -1;
+	self->pack = NULL;
+	gpte_list_cache_init(&self->cache);
 }
 
 static GType gpte_list_model_get_type(GListModel* model) {
 	GpteList* self = GPTE_LIST(model);
 	return G_TYPE_FROM_CLASS(self->child_kind);
 }
-static guint gpte_list_model_get_n_items(GListModel* model) {
-	GpteList* self = GPTE_LIST(model);
+// must be called with self->lock held
+static guint gpte_list_get_length(GpteList* self) {
 	if (self->length >= 0)
 		return self->length;
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self)), 2);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	JNIEnv* env = gpte_jvm_get_env(vm);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "java/util/List");
-	jmethodID mid = (*env)->GetMethodID(env, class, "size", "()I");
-	self->length = (*env)->CallIntMethod(env, this, mid);
+	self->length = (*env)->CallIntMethod(env, this, vm->jni.list.size);
 	return self->length;
 }
-static gpointer gpte_list_model_get_item(GListModel* model, guint idx) {
+static guint gpte_list_model_get_n_items(GListModel* model) {
 	GpteList* self = GPTE_LIST(model);
-	guint length = gpte_list_model_get_n_items(model);
-	if (idx >= length)
-		return NULL;
-	if (idx < self->cache->len) {
-		gpointer c = g_ptr_array_index(self->cache, idx);
-		if (c)
-			return g_object_ref(c);
-	}
+	g_mutex_lock(&self->lock);
+	guint length = gpte_list_get_length(self);
+	g_mutex_unlock(&self->lock);
+	return length;
+}
+static GObject* gpte_list_wrap(GpteList* self, GValue values[2], jobject item) {
+	static const gchar* names[] = { "vm", "object" };
+	g_value_set_pointer(&values[1], item);
+	GObject* ret = g_object_new_with_properties(G_TYPE_FROM_CLASS(self->child_kind), G_N_ELEMENTS(names), names, values);
+	gpte_style_cache_inherit(ret, self);
+	return ret;
+}
+// wraps the items [start, end) that aren't cached yet, fetching them
+// with a single subList().toArray() call. @idx is stored last so it's
+// the most recently used one.
+// must be called with self->lock held
+static void gpte_list_fill_window(GpteList* self, guint start, guint end, guint idx) {
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
 	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "java/util/List");
-	jmethodID mid = (*env)->GetMethodID(env, class, "get", "(I)Ljava/lang/Object;");
-	jobject item = (*env)->CallObjectMethod(env, this, mid, idx);
-	gpointer ret = g_object_new(G_TYPE_FROM_CLASS(self->child_kind), "vm", vm, "object", item, NULL);
-	if (idx >= self->cache->len)
-		g_ptr_array_insert(self->cache, idx, g_object_ref(ret));
-	else
-		g_ptr_array_index(self->cache, idx) = g_object_ref(ret);
+	jobject window = (*env)->CallObjectMethod(env, this, vm->jni.list.sub_list, start, end);
+	jobjectArray items = (*env)->CallObjectMethod(env, window, vm->jni.list.to_array);
+
+	GValue values[2] = { G_VALUE_INIT, G_VALUE_INIT };
+	g_value_init(&values[0], GPTE_TYPE_JVM);
+	g_value_set_boxed(&values[0], vm);
+	g_value_init(&values[1], G_TYPE_POINTER);
+
+	for (guint i = start; i < end; i++) {
+		GpteListSlot* slot = gpte_list_cache_slot(&self->cache, i, TRUE);
+		if (i == idx || slot->item)
+			continue;
+		jobject item = (*env)->GetObjectArrayElement(env, items, i - start);
+		gpte_list_cache_store(&self->cache, slot, gpte_list_wrap(self, values, item));
+		(*env)->DeleteLocalRef(env, item);
+	}
+
+	jobject item = (*env)->GetObjectArrayElement(env, items, idx - start);
+	gpte_list_cache_store(&self->cache, gpte_list_cache_slot(&self->cache, idx, TRUE), gpte_list_wrap(self, values, item));
+	(*env)->DeleteLocalRef(env, item);
+
+	if (self->pack) {
+		g_autofree GObject** wrapped = g_new(GObject*, end - start);
+		for (guint i = start; i < end; i++)
+			wrapped[i - start] = gpte_list_cache_slot(&self->cache, i, TRUE)->item;
+		self->pack(vm, items, wrapped, end - start);
+	}
+
+	g_value_unset(&values[0]);
+	g_value_unset(&values[1]);
+}
+// must be called with self->lock held
+static gpointer gpte_list_get_item(GpteList* self, guint idx) {
+	guint length = gpte_list_get_length(self);
+	if (idx >= length)
+		return NULL;
+	GpteListSlot* slot = gpte_list_cache_slot(&self->cache, idx, FALSE);
+	if (slot && slot->item) {
+		gpte_list_cache_touch(&self->cache, slot);
+		return g_object_ref(slot->item);
+	}
+
+	// prefetch in the direction the list is walked in, without evicting
+	// the prefetched items right away. Eager lists are read in one go.
+	guint window = self->pack ? length : GPTE_LIST_WINDOW;
+	if (self->cache.max_live)
+		window = CLAMP(self->cache.max_live / 2, 1, window);
+	guint start, end;
+	if (window >= length) {
+		start = 0;
+		end = length;
+	} else if (self->last_miss >= 0 && idx < (guint)self->last_miss) {
+		start = idx >= window - 1 ? idx - (window - 1) : 0;
+		end = idx + 1;
+	} else {
+		start = idx;
+		end = MIN(idx + window, length);
+	}
+	self->last_miss = idx;
+
+	gpte_list_fill_window(self, start, end, idx);
+	return g_object_ref(gpte_list_cache_slot(&self->cache, idx, FALSE)->item);
+}
+static gpointer gpte_list_model_get_item(GListModel* model, guint idx) {
+	GpteList* self = GPTE_LIST(model);
+	g_mutex_lock(&self->lock);
+	gpointer ret = gpte_list_get_item(self, idx);
+	g_mutex_unlock(&self->lock);
 	return ret;
 }
 static void gpte_list_iface_init(GListModelInterface* iface) {
@@ -150,26 +347,36 @@ GListModel* gpte_list_new(GpteJvm* vm, GType type, jobject list) {
 	return g_object_new(GPTE_TYPE_LIST, "vm", vm, "object", list, "type", type, NULL);
 }
 
+GListModel* gpte_list_copy(GpteList* self) {
+	g_return_val_if_fail(GPTE_IS_LIST(self), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	GpteList* copy = GPTE_LIST(gpte_list_new(vm, G_TYPE_FROM_CLASS(self->child_kind), gpte_java_object_get(GPTE_JAVA_OBJECT(self))));
+	g_mutex_lock(&self->lock);
+	copy->pack = self->pack;
+	copy->cache.max_live = self->cache.max_live;
+	g_mutex_unlock(&self->lock);
+	gpte_style_cache_inherit(copy, self);
+	return G_LIST_MODEL(copy);
+}
+
 void gpte_list_prepend(GpteList* self, jobject list) {
 	g_return_if_fail(GPTE_IS_LIST(self));
 
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self)), 3);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	JNIEnv* env = gpte_jvm_get_env(vm);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "java/util/List");
-	jmethodID mid = (*env)->GetMethodID(env, class, "size", "()I");
-	jint length = (*env)->CallIntMethod(env, list, mid);
+	jint length = (*env)->CallIntMethod(env, list, vm->jni.list.size);
 
-	jmethodID prepend = (*env)->GetMethodID(env, class, "addAll", "(ILjava/util/Collection;)Z");
-	jboolean res = (*env)->CallBooleanMethod(env, this, prepend, 0, list);
+	jboolean res = (*env)->CallBooleanMethod(env, this, vm->jni.list.add_all_at, 0, list);
 	if (!res)
 		return;
 
-	GPtrArray* new_cache = g_ptr_array_new_with_free_func((GDestroyNotify)gpte_list_g_object_unref_with_null_guard);
-	g_ptr_array_set_size(new_cache, self->length);
-	g_ptr_array_extend_and_steal(new_cache, self->cache);
-	self->cache = new_cache;
-	self->length += length;
+	g_mutex_lock(&self->lock);
+	gpte_list_cache_prepend(&self->cache, length);
+	self->last_miss = -1;
+	self->length = (*env)->CallIntMethod(env, this, vm->jni.list.size);
+	g_mutex_unlock(&self->lock);
 
 	g_list_model_items_changed(G_LIST_MODEL(self), 0, 0, length);
 }
@@ -177,19 +384,61 @@ void gpte_list_prepend(GpteList* self, jobject list) {
 void gpte_list_append(GpteList* self, jobject list) {
 	g_return_if_fail(GPTE_IS_LIST(self));
 
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self)), 3);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	JNIEnv* env = gpte_jvm_get_env(vm);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "java/util/List");
-	jmethodID mid = (*env)->GetMethodID(env, class, "size", "()I");
-	jint length = (*env)->CallIntMethod(env, list, mid);
+	jint length = (*env)->CallIntMethod(env, list, vm->jni.list.size);
 
-	jmethodID append = (*env)->GetMethodID(env, class, "addAll", "(Ljava/util/Collection;)Z");
-	jboolean res = (*env)->CallBooleanMethod(env, this, append, list);
+	jboolean res = (*env)->CallBooleanMethod(env, this, vm->jni.list.add_all, list);
 	if (!res)
 		return;
 
-	guint old_length = self->length;
-	self->length += length;
+	g_mutex_lock(&self->lock);
+	// the java list already contains the new items at this point
+	guint new_length = (*env)->CallIntMethod(env, this, vm->jni.list.size);
+	guint old_length = new_length - length;
+	self->length = new_length;
+	g_mutex_unlock(&self->lock);
 	g_list_model_items_changed(G_LIST_MODEL(self), old_length, 0, length);
 }
+
+void gpte_list_set_max_cached(GpteList* self, guint max_items) {
+	g_return_if_fail(GPTE_IS_LIST(self));
+	g_mutex_lock(&self->lock);
+	self->cache.max_live = max_items;
+	gpte_list_cache_evict(&self->cache);
+	g_mutex_unlock(&self->lock);
+}
+
+void gpte_list_set_pack_func(GpteList* self, GpteListPackFunc func) {
+	g_return_if_fail(GPTE_IS_LIST(self));
+	g_mutex_lock(&self->lock);
+	self->pack = func;
+	g_mutex_unlock(&self->lock);
+}
+
+GPtrArray* gpte_list_detach_items(GListModel* list) {
+	guint n_items = g_list_model_get_n_items(list);
+	GPtrArray* items = g_ptr_array_new_full(n_items, g_object_unref);
+	for (guint i = 0; i < n_items; i++) {
+		g_autoptr(GpteJavaObject) item = g_list_model_get_item(list, i);
+		g_ptr_array_add(items, gpte_java_object_snapshot(item));
+	}
+	return items;
+}
+
+GListModel* gpte_list_store_new_from_items(GType type, GPtrArray* items) {
+	GListStore* store = g_list_store_new(type);
+	g_list_store_splice(store, 0, 0, items->pdata, items->len);
+	return G_LIST_MODEL(store);
+}
+
+GListModel* gpte_list_snapshot(GListModel* list) {
+	g_return_val_if_fail(G_IS_LIST_MODEL(list), NULL);
+	GType type = g_list_model_get_item_type(list);
+	g_return_val_if_fail(g_type_is_a(type, GPTE_TYPE_JAVA_OBJECT), NULL);
+
+	g_autoptr(GPtrArray) items = gpte_list_detach_items(list);
+	return gpte_list_store_new_from_items(type, items);
+}
@@ -35,6 +35,31 @@ G_BEGIN_DECLS
 #define GPTE_TYPE_LIST (gpte_list_get_type())
 G_DECLARE_FINAL_TYPE (GpteList, gpte_list, GPTE, LIST, GpteJavaObject)
 
+/**
+ * gpte_list_set_max_cached:
+ * @self: the list
+ * @max_items: maximum number of items kept alive, or 0 for no limit
+ *
+ * Limits the number of item wrappers @self keeps around. Once the limit
+ * is exceeded the least recently accessed items are dropped, and
+ * created again from the wrapped list when they are accessed the next
+ * time. Items may therefore not be the same instance on every access.
+ *
+ * There is no limit by default.
+ */
+void gpte_list_set_max_cached(GpteList* self, guint max_items);
+
+/**
+ * gpte_list_snapshot:
+ * @list: a list model of [class@Gpte.JavaObject]
+ *
+ * Copies every item of @list with [method@Gpte.JavaObject.snapshot]. Items
+ * of a [class@Gpte.List] are read from Java in bulk.
+ *
+ * Returns: (transfer full): a [class@Gio.ListStore] of detached items
+ */
+GListModel* gpte_list_snapshot(GListModel* list);
+
 G_END_DECLS
 
 #endif // __GPTELIST_H__
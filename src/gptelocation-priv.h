@@ -25,6 +25,9 @@
 G_BEGIN_DECLS
 
 jobject gpte_locations_to_java(GpteJvm* vm, GpteLocations locations);
+// a local reference to the Java object of @self, snapshots are
+// re-created from their native fields
+jobject gpte_location_to_java(GpteJvm* vm, GpteLocation* self);
 
 G_END_DECLS
 
@@ -41,36 +41,13 @@ G_DEFINE_FLAGS_TYPE(GpteLocations, gpte_locations,
 
 
 jobject gpte_locations_to_java(GpteJvm* vm, GpteLocations locations) {
-	GpteScopeGuard env = gpte_jvm_enter_scope(vm, 15);
+	JNIEnv* env = gpte_jvm_get_env(vm);
 
-	jclass set_class = (*env)->FindClass(env, "java/util/HashSet");
-	jmethodID set_constructor = (*env)->GetMethodID(env, set_class, "<init>", "()V");
-	jmethodID add_to_set = (*env)->GetMethodID(env, set_class, "add", "(Ljava/lang/Object;)Z");
-
-	jobject flags = (*env)->NewObject(env, set_class, set_constructor);
-	jclass flags_enum = (*env)->FindClass(env, "de/schildbach/pte/dto/LocationType");
-	if (locations & GPTE_LOCATIONS_ANY) {
-		jobject any = (*env)->GetStaticObjectField(env, flags_enum, (*env)->GetStaticFieldID(env, flags_enum, "ANY", "Lde/schildbach/pte/dto/LocationType;"));
-		(*env)->CallBooleanMethod(env, flags, add_to_set, any);
-	}
-	if (locations & GPTE_LOCATIONS_STATION) {
-		jobject station = (*env)->GetStaticObjectField(env, flags_enum, (*env)->GetStaticFieldID(env, flags_enum, "STATION", "Lde/schildbach/pte/dto/LocationType;"));
-		(*env)->CallBooleanMethod(env, flags, add_to_set, station);
-	}
-	if (locations & GPTE_LOCATIONS_POI) {
-		jobject poi = (*env)->GetStaticObjectField(env, flags_enum, (*env)->GetStaticFieldID(env, flags_enum, "POI", "Lde/schildbach/pte/dto/LocationType;"));
-		(*env)->CallBooleanMethod(env, flags, add_to_set, poi);
-	}
-	if (locations & GPTE_LOCATIONS_ADDRESS) {
-		jobject address = (*env)->GetStaticObjectField(env, flags_enum, (*env)->GetStaticFieldID(env, flags_enum, "ADDRESS", "Lde/schildbach/pte/dto/LocationType;"));
-		(*env)->CallBooleanMethod(env, flags, add_to_set, address);
-	}
-	if (locations & GPTE_LOCATIONS_COORD) {
-		jobject coord = (*env)->GetStaticObjectField(env, flags_enum, (*env)->GetStaticFieldID(env, flags_enum, "COORD", "Lde/schildbach/pte/dto/LocationType;"));
-		(*env)->CallBooleanMethod(env, flags, add_to_set, coord);
-	}
-
-	return gpte_scope_guard_leave_with_ref(&env, flags);
+	jobject flags = (*env)->NewObject(env, vm->jni.hash_set.class, vm->jni.hash_set.init);
+	for (gsize i = 0; i < vm->jni.location_type.n_constants; i++)
+		if (locations & (1 << i))
+			(*env)->CallBooleanMethod(env, flags, vm->jni.hash_set.add, vm->jni.location_type.constants[i]);
+	return flags;
 }
 
 typedef struct {
@@ -101,25 +78,35 @@ struct _GpteLocation {
 
 G_DEFINE_TYPE (GpteLocation, gpte_location, GPTE_TYPE_JAVA_OBJECT)
 
-#define GPTE_LOCATION_FREE_CACHED_STRING(env,fn,ce) \
-	if ((self->cached & (ce)) && self->fn.string) { \
-		(*(env))->ReleaseStringUTFChars((env), self->fn.string, self->fn.utf8); \
-		(*(env))->DeleteGlobalRef((env), self->fn.string); \
+// detached locations own a copy of the string instead
+#define GPTE_LOCATION_FREE_CACHED_STRING(vm,fn,ce) \
+	if ((self->cached & (ce)) && self->fn.string) \
+		gpte_jvm_release_string((vm), self->fn.string, self->fn.utf8); \
+	else if (self->cached & (ce)) \
+		g_free((gchar*)self->fn.utf8);
+#define GPTE_LOCATION_DETACH_CACHED_STRING(vm,fn) \
+	if (self->fn.string) { \
+		gchar* copy = g_strdup(self->fn.utf8); \
+		gpte_jvm_release_string((vm), self->fn.string, self->fn.utf8); \
+		self->fn = (GpteCachedString){ .string = NULL, .utf8 = copy }; \
 	}
 
+static void gpte_location_hydrate(GpteJavaObject* object);
+
 static void gpte_location_finalize(GObject* object) {
 	GpteLocation* self = GPTE_LOCATION(object);
-	JNIEnv* env = gpte_java_object_env(GPTE_JAVA_OBJECT(self));
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
 	if ((self->cached & GPTE_LOCATION_CACHED_COORDS) && self->coords)
 		gpte_geo_point_free(self->coords);
-	GPTE_LOCATION_FREE_CACHED_STRING(env, id, GPTE_LOCATION_CACHED_ID)
-	GPTE_LOCATION_FREE_CACHED_STRING(env, name, GPTE_LOCATION_CACHED_NAME)
-	GPTE_LOCATION_FREE_CACHED_STRING(env, place, GPTE_LOCATION_CACHED_PLACE)
+	GPTE_LOCATION_FREE_CACHED_STRING(vm, id, GPTE_LOCATION_CACHED_ID)
+	GPTE_LOCATION_FREE_CACHED_STRING(vm, name, GPTE_LOCATION_CACHED_NAME)
+	GPTE_LOCATION_FREE_CACHED_STRING(vm, place, GPTE_LOCATION_CACHED_PLACE)
 	G_OBJECT_CLASS(gpte_location_parent_class)->finalize(object);
 }
 
 static void gpte_location_class_init(GpteLocationClass* class) {
 	G_OBJECT_CLASS(class)->finalize = gpte_location_finalize;
+	GPTE_JAVA_OBJECT_CLASS(class)->hydrate = gpte_location_hydrate;
 }
 
 static void gpte_location_init(GpteLocation* self) {
@@ -130,15 +117,10 @@ GpteLocation* gpte_location_from_coords(GpteJvm* vm, const GpteGeoPoint* point)
 	g_return_val_if_fail(vm != NULL, NULL);
 	g_return_val_if_fail(point != NULL, NULL);
 
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 2);
 
-	jclass point_class = (*env)->FindClass(env, "de/schildbach/pte/dto/Point");
-	jmethodID create_point = (*env)->GetStaticMethodID(env, point_class, "fromDouble", "(DD)Lde/schildbach/pte/dto/Point;");
-	jobject jpoint = (*env)->CallStaticObjectMethod(env, point_class, create_point, point->lat, point->lon);
-
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Location");
-	jmethodID mid = (*env)->GetStaticMethodID(env, class, "coord", "(Lde/schildbach/pte/dto/Point;)Lde/schildbach/pte/dto/Location;");
-	jobject created = (*env)->CallStaticObjectMethod(env, class, mid, jpoint);
+	jobject jpoint = (*env)->CallStaticObjectMethod(env, vm->jni.point.class, vm->jni.point.from_double, point->lat, point->lon);
+	jobject created = (*env)->CallStaticObjectMethod(env, vm->jni.location.class, vm->jni.location.new_coord, jpoint);
 
 	return g_object_new(GPTE_TYPE_LOCATION, "vm", vm, "object", created, NULL);
 }
@@ -148,12 +130,9 @@ const GpteGeoPoint* gpte_location_get_coords(GpteLocation* self) {
 	if (self->cached & GPTE_LOCATION_CACHED_COORDS)
 		return self->coords;
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Location");
-	jfieldID field_id = (*env)->GetFieldID(env, class, "coord", "Lde/schildbach/pte/dto/Point;");
-	g_return_val_if_fail(field_id, NULL);
-	jstring point = (*env)->GetObjectField(env, this, field_id);
+	jobject point = (*env)->GetObjectField(env, this, vm->jni.location.coord);
 	if (!point) {
 		self->coords = NULL;
 		self->cached |= GPTE_LOCATION_CACHED_COORDS;
@@ -170,12 +149,10 @@ const GpteGeoPoint* gpte_location_get_coords(GpteLocation* self) {
 		g_return_val_if_fail(GPTE_IS_LOCATION(self), NULL); \
 		if (self->cached & (ce)) \
 			return self->fn.utf8; \
-		g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self)), 3); \
+		GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self)); \
+		g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1); \
 		jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self)); \
-		jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Location"); \
-		jfieldID field_id = (*env)->GetFieldID(env, class, #fn, "Ljava/lang/String;"); \
-		g_return_val_if_fail(field_id, NULL); \
-		self->fn.string = (*env)->GetObjectField(env, this, field_id); \
+		self->fn.string = (*env)->GetObjectField(env, this, vm->jni.location.fn); \
 		if (!self->fn.string) { \
 			self->fn.utf8 = NULL; \
 			self->cached |= (ce); \
@@ -198,18 +175,16 @@ GpteProducts gpte_location_get_products(GpteLocation* self) {
 	if (self->cached & GPTE_LOCATION_CACHED_PRODUCTS)
 		return self->products;
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Location");
-	jfieldID field_id = (*env)->GetFieldID(env, class, "products", "Ljava/util/Set;");
-	g_return_val_if_fail(field_id, 0);
-	jobject jproducts = (*env)->GetObjectField(env, this, field_id);
+	jobject jproducts = (*env)->GetObjectField(env, this, vm->jni.location.products);
 	if (!jproducts) {
 		self->products = 0;
 		self->cached |= GPTE_LOCATION_CACHED_PRODUCTS;
 		return 0;
 	}
 	self->products = gpte_products_from_set(vm, jproducts);
+	self->cached |= GPTE_LOCATION_CACHED_PRODUCTS;
 	return self->products;
 }
 
@@ -217,42 +192,54 @@ GpteLocationType gpte_location_get_location_type(GpteLocation* self) {
 	g_return_val_if_fail(GPTE_IS_LOCATION(self), GPTE_LOCATION_ANY);
 	if (self->cached & GPTE_LOCATION_CACHED_LOCATION_TYPE)
 		return self->type;
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self)), 9);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Location");
-	jfieldID field_id = (*env)->GetFieldID(env, class, "type", "Lde/schildbach/pte/dto/LocationType;");
-	g_return_val_if_fail(field_id, GPTE_LOCATION_ANY);
-	jobject jtype = (*env)->GetObjectField(env, this, field_id);
-	jclass type_class = (*env)->FindClass(env, "de/schildbach/pte/dto/LocationType");
+	jobject jtype = (*env)->GetObjectField(env, this, vm->jni.location.type);
 
-	if ((*env)->IsSameObject(env, jtype, (*env)->GetStaticObjectField(
-		env, type_class,
-		(*env)->GetStaticFieldID(env, type_class , "ANY", "Lde/schildbach/pte/dto/LocationType;")
-	)))
-		self->type = GPTE_LOCATION_ANY;
-	else if ((*env)->IsSameObject(env, jtype, (*env)->GetStaticObjectField(
-		env, type_class,
-		(*env)->GetStaticFieldID(env, type_class , "STATION", "Lde/schildbach/pte/dto/LocationType;")
-	)))
-		self->type = GPTE_LOCATION_STATION;
-	else if ((*env)->IsSameObject(env, jtype, (*env)->GetStaticObjectField(
-		env, type_class,
-		(*env)->GetStaticFieldID(env, type_class , "POI", "Lde/schildbach/pte/dto/LocationType;")
-	)))
-		self->type = GPTE_LOCATION_POI;
-	else if ((*env)->IsSameObject(env, jtype, (*env)->GetStaticObjectField(
-		env, type_class,
-		(*env)->GetStaticFieldID(env, type_class , "ADDRESS", "Lde/schildbach/pte/dto/LocationType;")
-	)))
-		self->type = GPTE_LOCATION_ADDRESS;
-	else if ((*env)->IsSameObject(env, jtype, (*env)->GetStaticObjectField(
-		env, type_class,
-		(*env)->GetStaticFieldID(env, type_class , "COORD", "Lde/schildbach/pte/dto/LocationType;")
-	)))
-		self->type = GPTE_LOCATION_COORD;
-	else {
+	gint type = gpte_jni_enum_decode(&vm->jni, env, &vm->jni.location_type, jtype);
+	if (type < 0) {
 		g_critical("Unknown location type: %p", jtype);
 		self->type = GPTE_LOCATION_ANY;
+	} else {
+		self->type = type;
 	}
+	self->cached |= GPTE_LOCATION_CACHED_LOCATION_TYPE;
 	return self->type;
 }
+
+static void gpte_location_hydrate(GpteJavaObject* object) {
+	GpteLocation* self = GPTE_LOCATION(object);
+	GpteJvm* vm = gpte_java_object_get_vm(object);
+	gpte_location_get_coords(self);
+	gpte_location_get_id(self);
+	gpte_location_get_name(self);
+	gpte_location_get_place(self);
+	gpte_location_get_products(self);
+	gpte_location_get_location_type(self);
+	GPTE_LOCATION_DETACH_CACHED_STRING(vm, id)
+	GPTE_LOCATION_DETACH_CACHED_STRING(vm, name)
+	GPTE_LOCATION_DETACH_CACHED_STRING(vm, place)
+}
+
+jobject gpte_location_to_java(GpteJvm* vm, GpteLocation* self) {
+	JNIEnv* env = gpte_jvm_get_env(vm);
+	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
+	if (this)
+		return (*env)->NewLocalRef(env, this);
+
+	// a snapshot has every field cached
+	const GpteGeoPoint* coords = gpte_location_get_coords(self);
+	jobject jcoord = coords ? (*env)->CallStaticObjectMethod(env, vm->jni.point.class, vm->jni.point.from_double, coords->lat, coords->lon) : NULL;
+	jstring jid = self->id.utf8 ? (*env)->NewStringUTF(env, self->id.utf8) : NULL;
+	jstring jplace = self->place.utf8 ? (*env)->NewStringUTF(env, self->place.utf8) : NULL;
+	jstring jname = self->name.utf8 ? (*env)->NewStringUTF(env, self->name.utf8) : NULL;
+	jobject jproducts = self->products ? gpte_products_to_java(vm, self->products) : NULL;
+	return (*env)->NewObject(env, vm->jni.location.class, vm->jni.location.init,
+		vm->jni.location_type.constants[self->type], jid, jcoord, jplace, jname, jproducts);
+}
+
+GpteLocation* gpte_location_snapshot(GpteLocation* self) {
+	g_return_val_if_fail(GPTE_IS_LOCATION(self), NULL);
+	return GPTE_LOCATION(gpte_java_object_snapshot(GPTE_JAVA_OBJECT(self)));
+}
@@ -157,6 +157,17 @@ GpteProducts gpte_location_get_products(GpteLocation* self);
  */
 GpteLocationType gpte_location_get_location_type(GpteLocation* self);
 
+/**
+ * gpte_location_snapshot:
+ * @self: the location
+ *
+ * Copies @self into native memory, see
+ * [method@Gpte.JavaObject.snapshot].
+ *
+ * Returns: (transfer full): a detached copy of @self
+ */
+GpteLocation* gpte_location_snapshot(GpteLocation* self);
+
 G_END_DECLS
 
 #endif // __GPTELOCATION_H__
@@ -25,7 +25,10 @@
 G_BEGIN_DECLS
 
 GpteProductCode gpte_product_code_from_java(GpteJvm* vm, jobject product);
+jobject gpte_product_code_to_java(GpteJvm* vm, GpteProductCode code);
 GpteProducts gpte_products_from_set(GpteJvm* vm, jobject set);
+// @ordinals has a bit set per Product.ordinal()
+GpteProducts gpte_products_from_ordinals(GpteJvm* vm, jlong ordinals);
 
 jobject gpte_products_to_java(GpteJvm* vm, GpteProducts products);
 
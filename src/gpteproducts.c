@@ -46,14 +46,33 @@ G_DEFINE_FLAGS_TYPE(GpteProducts, gpte_products,
 
 
 GpteProductCode gpte_product_code_from_java(GpteJvm* vm, jobject product) {
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 2);
+	JNIEnv* env = gpte_jvm_get_env(vm);
 
-	jclass product_class = (*env)->FindClass(env, "de/schildbach/pte/dto/Product");
-	jfieldID product_code = (*env)->GetFieldID(env, product_class, "code", "C");
-	jchar code = (*env)->GetCharField(env, product, product_code);
+	jchar code = (*env)->GetCharField(env, product, vm->jni.product.code);
 	return (GpteProductCode)code;
 }
 
+#define GPTE_PRODUCT_CODE_CONST(kw) \
+	case GPTE_PRODUCT_CODE_##kw: \
+		return vm->jni.products.constants[g_bit_nth_lsf(GPTE_PRODUCT_##kw, -1)];
+
+jobject gpte_product_code_to_java(GpteJvm* vm, GpteProductCode code) {
+	switch (code) {
+		GPTE_PRODUCT_CODE_CONST(HIGH_SPEED_TRAIN)
+		GPTE_PRODUCT_CODE_CONST(REGIONAL_TRAIN)
+		GPTE_PRODUCT_CODE_CONST(SUBURBAN_TRAIN)
+		GPTE_PRODUCT_CODE_CONST(SUBWAY)
+		GPTE_PRODUCT_CODE_CONST(TRAM)
+		GPTE_PRODUCT_CODE_CONST(BUS)
+		GPTE_PRODUCT_CODE_CONST(FERRY)
+		GPTE_PRODUCT_CODE_CONST(CABLECAR)
+		GPTE_PRODUCT_CODE_CONST(ON_DEMAND)
+		case GPTE_PRODUCT_CODE_NULL:
+		default:
+			return NULL;
+	}
+}
+
 gint gpte_product_code_to_priority(GpteProductCode code) {
 	switch (code) {
 		case GPTE_PRODUCT_CODE_HIGH_SPEED_TRAIN:
@@ -86,20 +105,15 @@ gint gpte_product_code_to_priority(GpteProductCode code) {
 		break;
 
 GpteProducts gpte_products_from_set(GpteJvm* vm, jobject set) {
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 6);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 2);
 
-	jclass set_class = (*env)->FindClass(env, "java/util/Set");
-	jmethodID set_to_array = (*env)->GetMethodID(env, set_class, "toArray", "()[Ljava/lang/Object;");
-	jobjectArray elems = (*env)->CallObjectMethod(env, set, set_to_array);
+	jobjectArray elems = (*env)->CallObjectMethod(env, set, vm->jni.set.to_array);
 	gint len = (*env)->GetArrayLength(env, elems);
 
-	jclass product_class = (*env)->FindClass(env, "de/schildbach/pte/dto/Product");
-	jfieldID product_code = (*env)->GetFieldID(env, product_class, "code", "C");
-
 	GpteProducts ret = 0;
 	for (gint i = 0; i < len; i++) {
 		jobject obj = (*env)->GetObjectArrayElement(env, elems, i);
-		jchar code = (*env)->GetCharField(env, obj, product_code);
+		jchar code = (*env)->GetCharField(env, obj, vm->jni.product.code);
 		switch (code) {
 			GPTE_PRODUCT_SWITCH(HIGH_SPEED_TRAIN)
 			GPTE_PRODUCT_SWITCH(REGIONAL_TRAIN)
@@ -118,30 +132,20 @@ GpteProducts gpte_products_from_set(GpteJvm* vm, jobject set) {
 	return ret;
 }
 
-#define GPTE_PRODUCT_CONV(kw) \
-	if (products & GPTE_PRODUCT_##kw) { \
-		jobject itrain = (*env)->GetStaticObjectField(env, products_enum, (*env)->GetStaticFieldID(env, products_enum, #kw, "Lde/schildbach/pte/dto/Product;")); \
-		(*env)->CallBooleanMethod(env, jproducts, add_to_set, itrain); \
-	}
+GpteProducts gpte_products_from_ordinals(GpteJvm* vm, jlong ordinals) {
+	GpteProducts ret = 0;
+	for (gsize i = 0; i < vm->jni.products.n_ordinals; i++)
+		if ((ordinals & (G_GINT64_CONSTANT(1) << i)) && vm->jni.products.ordinals[i] >= 0)
+			ret |= 1 << vm->jni.products.ordinals[i];
+	return ret;
+}
 
 jobject gpte_products_to_java(GpteJvm* vm, GpteProducts products) {
-	GpteScopeGuard env = gpte_jvm_enter_scope(vm, 14);
-
-	jclass set_class = (*env)->FindClass(env, "java/util/HashSet");
-	jmethodID constructor = (*env)->GetMethodID(env, set_class, "<init>", "()V");
-	jmethodID add_to_set = (*env)->GetMethodID(env, set_class, "add", "(Ljava/lang/Object;)Z");
-
-	jclass products_enum = (*env)->FindClass(env, "de/schildbach/pte/dto/Product");
-	jobject jproducts = (*env)->NewObject(env, set_class, constructor);
-	GPTE_PRODUCT_CONV(HIGH_SPEED_TRAIN)
-	GPTE_PRODUCT_CONV(REGIONAL_TRAIN)
-	GPTE_PRODUCT_CONV(SUBURBAN_TRAIN)
-	GPTE_PRODUCT_CONV(SUBWAY)
-	GPTE_PRODUCT_CONV(TRAM)
-	GPTE_PRODUCT_CONV(BUS)
-	GPTE_PRODUCT_CONV(FERRY)
-	GPTE_PRODUCT_CONV(CABLECAR)
-	GPTE_PRODUCT_CONV(ON_DEMAND)
-	return gpte_scope_guard_leave_with_ref(&env, jproducts);
-}
+	JNIEnv* env = gpte_jvm_get_env(vm);
 
+	jobject jproducts = (*env)->NewObject(env, vm->jni.hash_set.class, vm->jni.hash_set.init);
+	for (gsize i = 0; i < vm->jni.products.n_constants; i++)
+		if (products & (1 << i))
+			(*env)->CallBooleanMethod(env, jproducts, vm->jni.hash_set.add, vm->jni.products.constants[i]);
+	return jproducts;
+}
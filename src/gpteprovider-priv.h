@@ -21,11 +21,35 @@
 
 #include <gpteprovider.h>
 #include <gptejvm-priv.h>
+#include <gptelimiter-priv.h>
+#include <gptestyle-priv.h>
 
 G_BEGIN_DECLS
 
 GpteProvider* gpte_provider_new(const gchar* identifier, GpteJvm* vm, jobject provider);
 
+// JNI name of the Java class implementing the provider @id, or NULL
+const gchar* gpte_provider_class_name(const gchar* id);
+// area of the provider @id as generated at build time, or NULL
+const GpteGeoPoint* gpte_provider_static_area(const gchar* id, gsize* len);
+
+// Takes the slot of the running job on an executor worker. Synchronous
+// callers block until the rate limit of the provider admits another
+// request, which fails once the current GCancellable is cancelled.
+GpteLimiterSlot* gpte_provider_acquire_slot(GpteProvider* self, GError** err);
+// runs @func on the executor once the rate limit of @self grants it a slot
+void gpte_provider_run_task(GpteProvider* self, GTask* task, GTaskThreadFunc func);
+
+// fails with GPTE_PTE_ERROR_SERVICE_DOWN while the provider is down
+gboolean gpte_provider_breaker_admit(GpteProvider* self, GError** err);
+// Feeds the outcome of an admitted request back into the health state.
+// Unless @reached, the request failed before calling the provider (e.g.
+// it got no slot) and only gives up a probe.
+void gpte_provider_breaker_report(GpteProvider* self, gboolean reached, const GError* error);
+
+// line styles resolved for this provider
+GpteStyleCache* gpte_provider_get_style_cache(GpteProvider* self);
+
 G_END_DECLS
 
 #endif // __GPTEPROVIDER_PRIV_H__
@@ -16,7 +16,7 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include "gpteprovider.h"
+#include "gpteprovider-priv.h"
 #include "gptejavaobject-priv.h"
 #include "gpteutils-priv.h"
 #include "gptelocation-priv.h"
@@ -25,6 +25,7 @@
 #include "gptestyle-priv.h"
 #include "gptelist-priv.h"
 #include "gptetrips-priv.h"
+#include "gptestationdepartures-priv.h"
 #include "gpteerrors.h"
 
 G_DEFINE_FLAGS_TYPE(GpteProviderCapabilities, gpte_provider_capabilities,
@@ -36,7 +37,8 @@ G_DEFINE_FLAGS_TYPE(GpteProviderCapabilities, gpte_provider_capabilities,
 )
 
 G_DEFINE_FLAGS_TYPE(GpteQueryDeparturesFlags, gpte_query_departures_flags,
-	G_DEFINE_ENUM_VALUE(GPTE_QUERY_DEPARTURES_QUERY_EQUIVS, "query-equivs")
+	G_DEFINE_ENUM_VALUE(GPTE_QUERY_DEPARTURES_QUERY_EQUIVS, "query-equivs"),
+	G_DEFINE_ENUM_VALUE(GPTE_QUERY_DEPARTURES_EAGER, "eager")
 )
 
 G_DEFINE_ENUM_TYPE(GpteTripsQueryRequest, gpte_trips_query_request,
@@ -45,16 +47,134 @@ G_DEFINE_ENUM_TYPE(GpteTripsQueryRequest, gpte_trips_query_request,
 )
 
 
+// departures queried for a specific time are cached per minute
+#define GPTE_PROVIDER_CACHE_TIME_BUCKET 60
+// once reached, the oldest entry is dropped for a new one
+#define GPTE_PROVIDER_CACHE_MAX_ENTRIES 64
+
+typedef struct {
+	// detached GpteStationDepartures shared between all callers, every
+	// hit gets its own GListStore of them
+	GPtrArray* items;
+	gint64 fetched;
+	gboolean refreshing;
+} GpteDeparturesCacheEntry;
+
+static void gpte_departures_cache_entry_free(GpteDeparturesCacheEntry* self) {
+	g_ptr_array_unref(self->items);
+	g_free(self);
+}
+
+/*
+ * Identical async requests share one upstream request. Every caller
+ * is a waiter on the in-flight request and receives its own copy of the
+ * result, the upstream request is only cancelled once no one is waiting
+ * for it anymore.
+ */
+typedef struct {
+	gatomicrefcount rc;
+	gchar* key;
+	// protected by the inflight_lock of the provider
+	GPtrArray* waiters;
+	GCancellable* upstream;
+	GBoxedCopyFunc copy;
+	GDestroyNotify free;
+} GpteInflight;
+
+typedef struct {
+	gatomicrefcount rc;
+	// owned, the provider must outlive callbacks of its waiters
+	GpteProvider* provider;
+	GTask* task;
+	GCancellable* cancellable;
+	gulong handler;
+	GpteInflight* inflight;
+	gboolean cancelled;
+} GpteInflightWaiter;
+
+static GpteInflight* gpte_inflight_ref(GpteInflight* self) {
+	g_atomic_ref_count_inc(&self->rc);
+	return self;
+}
+static void gpte_inflight_unref(GpteInflight* self) {
+	if (!g_atomic_ref_count_dec(&self->rc))
+		return;
+	g_free(self->key);
+	g_ptr_array_unref(self->waiters);
+	g_object_unref(self->upstream);
+	g_free(self);
+}
+
+static GpteInflightWaiter* gpte_inflight_waiter_ref(GpteInflightWaiter* self) {
+	g_atomic_ref_count_inc(&self->rc);
+	return self;
+}
+static void gpte_inflight_waiter_unref(GpteInflightWaiter* self) {
+	if (!g_atomic_ref_count_dec(&self->rc))
+		return;
+	g_clear_object(&self->task);
+	g_clear_object(&self->cancellable);
+	g_clear_pointer(&self->inflight, gpte_inflight_unref);
+	g_object_unref(self->provider);
+	g_free(self);
+}
+
 struct _GpteProvider {
 	GpteJavaObject parent_instance;
 
 	gchar* id;
+	// shared by all providers with the same id
+	GpteLimiter* limiter;
+
+	GMutex cache_lock;
+	// NULL while caching is disabled
+	GHashTable* departures_cache;
+	gint64 cache_ttl;
+	gint64 cache_stale;
+	guint cache_hits;
+	guint cache_misses;
+
+	GMutex inflight_lock;
+	// request key → GpteInflight
+	GHashTable* inflight;
+
+	GMutex batch_lock;
+	// concurrent queries of all departures batches
+	guint batch_parallelism;
+	guint batch_running;
+	// batch GTasks waiting for a query slot
+	GQueue batch_waiting;
+
+	GMainContext* context;
+	GMutex breaker_lock;
+	GpteProviderHealth health;
+	guint failures;
+	guint failure_threshold;
+	gint64 cooldown;
+	gint64 opened;
+	gboolean probing;
+
+	GpteStyleCache* styles;
+
+	// read once on first access, they never change for an instance
+	gsize info_loaded;
+	GpteProviderCapabilities capabilities;
+	GpteProducts default_products;
+	GpteGeoPoint* area;
+	gsize area_len;
 };
 
 G_DEFINE_TYPE (GpteProvider, gpte_provider, GPTE_TYPE_JAVA_OBJECT)
 
+G_DEFINE_ENUM_TYPE(GpteProviderHealth, gpte_provider_health,
+	G_DEFINE_ENUM_VALUE(GPTE_PROVIDER_HEALTH_HEALTHY, "healthy"),
+	G_DEFINE_ENUM_VALUE(GPTE_PROVIDER_HEALTH_DOWN, "down"),
+	G_DEFINE_ENUM_VALUE(GPTE_PROVIDER_HEALTH_PROBING, "probing")
+)
+
 enum {
 	PROP_ID = 1,
+	PROP_HEALTH,
 	N_PROPERTIES
 };
 static GParamSpec* obj_properties[N_PROPERTIES] = { 0, };
@@ -62,6 +182,15 @@ static GParamSpec* obj_properties[N_PROPERTIES] = { 0, };
 static void gpte_provider_finalize(GObject* object) {
 	GpteProvider* self = GPTE_PROVIDER(object);
 	g_free(self->id);
+	g_clear_pointer(&self->departures_cache, g_hash_table_unref);
+	g_mutex_clear(&self->cache_lock);
+	g_hash_table_unref(self->inflight);
+	g_mutex_clear(&self->inflight_lock);
+	g_mutex_clear(&self->batch_lock);
+	g_main_context_unref(self->context);
+	g_mutex_clear(&self->breaker_lock);
+	gpte_style_cache_unref(self->styles);
+	g_free(self->area);
 	G_OBJECT_CLASS(gpte_provider_parent_class)->finalize(object);
 }
 
@@ -71,6 +200,9 @@ static void gpte_provider_get_property(GObject* object, guint prop_id, GValue* v
 		case PROP_ID:
 			g_value_set_string(val, gpte_provider_get_id(self));
 			break;
+		case PROP_HEALTH:
+			g_value_set_enum(val, gpte_provider_get_health(self));
+			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
 	}
@@ -81,6 +213,7 @@ static void gpte_provider_set_property(GObject* object, guint prop_id, const GVa
 		case PROP_ID:
 			g_return_if_fail(self->id == NULL);
 			self->id = g_value_dup_string(val);
+			self->limiter = gpte_limiter_get(self->id ? self->id : "");
 			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
@@ -94,11 +227,39 @@ static void gpte_provider_class_init(GpteProviderClass* class) {
 	object_class->set_property = gpte_provider_set_property;
 
 	obj_properties[PROP_ID] = g_param_spec_string("identifier", NULL, NULL, NULL, G_PARAM_STATIC_STRINGS | G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+	obj_properties[PROP_HEALTH] = g_param_spec_enum("health", NULL, NULL, GPTE_TYPE_PROVIDER_HEALTH, GPTE_PROVIDER_HEALTH_HEALTHY, G_PARAM_STATIC_STRINGS | G_PARAM_READABLE | G_PARAM_EXPLICIT_NOTIFY);
 	g_object_class_install_properties(object_class, N_PROPERTIES, obj_properties);
 }
 
 static void gpte_provider_init(GpteProvider* self) {
 	self->id = NULL;
+	self->limiter = NULL;
+	g_mutex_init(&self->cache_lock);
+	self->departures_cache = NULL;
+	self->cache_ttl = 0;
+	self->cache_stale = 0;
+	self->cache_hits = 0;
+	self->cache_misses = 0;
+	g_mutex_init(&self->inflight_lock);
+	self->inflight = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)gpte_inflight_unref);
+	g_mutex_init(&self->batch_lock);
+	self->batch_parallelism = 4;
+	self->batch_running = 0;
+	g_queue_init(&self->batch_waiting);
+	self->context = g_main_context_ref_thread_default();
+	g_mutex_init(&self->breaker_lock);
+	self->health = GPTE_PROVIDER_HEALTH_HEALTHY;
+	self->failures = 0;
+	self->failure_threshold = 5;
+	self->cooldown = 30 * G_USEC_PER_SEC;
+	self->opened = 0;
+	self->probing = FALSE;
+	self->styles = gpte_style_cache_new();
+	self->info_loaded = 0;
+	self->capabilities = 0;
+	self->default_products = 0;
+	self->area = NULL;
+	self->area_len = 0;
 }
 
 GpteProvider* gpte_provider_new(const gchar* identifier, GpteJvm* vm, jobject provider) {
@@ -110,58 +271,172 @@ const gchar* gpte_provider_get_id(GpteProvider* self) {
 	return self->id;
 }
 
-GpteProducts gpte_provider_default_products(GpteProvider* self) {
-	g_return_val_if_fail(GPTE_IS_PROVIDER(self), 0);
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
-	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
+GpteLimiterSlot* gpte_provider_acquire_slot(GpteProvider* self, GError** err) {
+	// workers never wait, their jobs are only queued once they hold a slot
+	if (gpte_executor_in_job()) {
+		GpteLimiterSlot* slot = gpte_executor_steal_slot();
+		if (slot == self->limiter)
+			return slot;
+		if (slot)
+			gpte_limiter_release(slot);
+		g_set_error(err, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_THREADING, "Job was not started with gpte_provider_run_task()");
+		return NULL;
+	}
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/NetworkProvider");
-	jmethodID products_mid = (*env)->GetMethodID(env, class, "defaultProducts", "()Ljava/util/Set;");
-	jobject default_products = (*env)->CallObjectMethod(env, this, products_mid);
+	GCancellable* cancellable = g_cancellable_get_current();
+	GpteLimiterSlot* slot = gpte_limiter_acquire(self->limiter, G_PRIORITY_DEFAULT, cancellable);
+	if (!slot)
+		g_cancellable_set_error_if_cancelled(cancellable, err);
+	return slot;
+}
 
-	return gpte_products_from_set(vm, default_products);
+typedef struct {
+	GpteProvider* provider;
+	GTask* task;
+	GTaskThreadFunc func;
+} GpteProviderPendingJob;
+
+static void gpte_provider_slot_granted(GpteLimiterSlot* slot, GpteProviderPendingJob* job) {
+	if (slot)
+		gpte_executor_run_task_with_slot(gpte_jvm_get_executor(gpte_java_object_get_vm(GPTE_JAVA_OBJECT(job->provider))), job->task, job->func, slot);
+	else
+		g_task_return_error_if_cancelled(job->task);
+	g_object_unref(job->task);
+	g_object_unref(job->provider);
+	g_free(job);
 }
 
-gboolean gpte_provider_has_capabilities(GpteProvider* self, GpteProviderCapabilities capabilities) {
-	g_return_val_if_fail(GPTE_IS_PROVIDER(self), 0);
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
-	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
+void gpte_provider_run_task(GpteProvider* self, GTask* task, GTaskThreadFunc func) {
+	GpteProviderPendingJob* job = g_new(GpteProviderPendingJob, 1);
+	job->provider = g_object_ref(self);
+	job->task = g_object_ref(task);
+	job->func = func;
+	gpte_limiter_acquire_async(self->limiter, g_task_get_priority(task), g_task_get_cancellable(task), g_task_get_context(task), (GpteLimiterFunc)gpte_provider_slot_granted, job);
+}
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/NetworkProvider");
-	jmethodID caps_mid = (*env)->GetMethodID(env, class, "hasCapabilities", "([Lde/schildbach/pte/NetworkProvider$Capability;)Z");
+void gpte_provider_set_rate_limit(GpteProvider* self, gdouble rate, guint burst, guint max_in_flight) {
+	g_return_if_fail(GPTE_IS_PROVIDER(self));
+	g_return_if_fail(rate >= 0);
+	gpte_limiter_configure(self->limiter, rate, burst, max_in_flight);
+}
 
-	jclass enum_class = (*env)->FindClass(env, "de/schildbach/pte/NetworkProvider$Capability");
-	g_autoptr(GPtrArray) args = g_ptr_array_new();
-	if (capabilities & GPTE_PROVIDER_CAPABILITY_DEPARTURES)
-		g_ptr_array_add(args, (*env)->GetStaticObjectField(env, enum_class, (*env)->GetStaticFieldID(env, enum_class, "DEPARTURES", "Lde/schildbach/pte/NetworkProvider$Capability;")));
-	if (capabilities & GPTE_PROVIDER_CAPABILITY_NEARBY_LOCATIONS)
-		g_ptr_array_add(args, (*env)->GetStaticObjectField(env, enum_class, (*env)->GetStaticFieldID(env, enum_class, "NEARBY_LOCATIONS", "Lde/schildbach/pte/NetworkProvider$Capability;")));
-	if (capabilities & GPTE_PROVIDER_CAPABILITY_SUGGEST_LOCATIONS)
-		g_ptr_array_add(args, (*env)->GetStaticObjectField(env, enum_class, (*env)->GetStaticFieldID(env, enum_class, "SUGGEST_LOCATIONS", "Lde/schildbach/pte/NetworkProvider$Capability;")));
-	if (capabilities & GPTE_PROVIDER_CAPABILITY_TRIPS)
-		g_ptr_array_add(args, (*env)->GetStaticObjectField(env, enum_class, (*env)->GetStaticFieldID(env, enum_class, "TRIPS", "Lde/schildbach/pte/NetworkProvider$Capability;")));
-	if (capabilities & GPTE_PROVIDER_CAPABILITY_TRIPS_VIA)
-		g_ptr_array_add(args, (*env)->GetStaticObjectField(env, enum_class, (*env)->GetStaticFieldID(env, enum_class, "TRIPS_VIA", "Lde/schildbach/pte/NetworkProvider$Capability;")));
+static gboolean gpte_provider_notify_health(GpteProvider* self) {
+	g_object_notify_by_pspec(G_OBJECT(self), obj_properties[PROP_HEALTH]);
+	return G_SOURCE_REMOVE;
+}
 
-	jobjectArray jargs = (*env)->NewObjectArray(env, args->len, enum_class, NULL);
-	for (guint i = 0; i < args->len; i++)
-		(*env)->SetObjectArrayElement(env, jargs, i, g_ptr_array_index(args, i));
+// must be called with self->breaker_lock held
+static void gpte_provider_set_health(GpteProvider* self, GpteProviderHealth health) {
+	if (self->health == health)
+		return;
+	self->health = health;
+	// Queries run on worker threads, but UIs expect to be notified on the
+	// context the provider was created on. Always deferred, even on that
+	// context, as handlers would otherwise run with breaker_lock held.
+	GSource* source = g_idle_source_new();
+	g_source_set_priority(source, G_PRIORITY_DEFAULT);
+	g_source_set_callback(source, (GSourceFunc)gpte_provider_notify_health, g_object_ref(self), g_object_unref);
+	g_source_attach(source, self->context);
+	g_source_unref(source);
+}
 
-	return (*env)->CallBooleanMethod(env, this, caps_mid, jargs);
+GpteProviderHealth gpte_provider_get_health(GpteProvider* self) {
+	g_return_val_if_fail(GPTE_IS_PROVIDER(self), GPTE_PROVIDER_HEALTH_HEALTHY);
+	g_mutex_lock(&self->breaker_lock);
+	GpteProviderHealth health = self->health;
+	g_mutex_unlock(&self->breaker_lock);
+	return health;
 }
 
-GpteGeoPoint* gpte_provider_get_area(GpteProvider* self, gsize* len) {
-	g_return_val_if_fail(GPTE_IS_PROVIDER(self), NULL);
-	g_return_val_if_fail(len != NULL, NULL);
+void gpte_provider_set_circuit_breaker(GpteProvider* self, guint threshold, guint cooldown) {
+	g_return_if_fail(GPTE_IS_PROVIDER(self));
+	g_mutex_lock(&self->breaker_lock);
+	self->failure_threshold = threshold;
+	self->cooldown = (gint64)cooldown * G_USEC_PER_SEC;
+	if (!threshold) {
+		self->failures = 0;
+		self->probing = FALSE;
+		gpte_provider_set_health(self, GPTE_PROVIDER_HEALTH_HEALTHY);
+	}
+	g_mutex_unlock(&self->breaker_lock);
+}
+
+gboolean gpte_provider_breaker_admit(GpteProvider* self, GError** err) {
+	g_mutex_lock(&self->breaker_lock);
+	gboolean admit = TRUE;
+	switch (self->health) {
+		case GPTE_PROVIDER_HEALTH_HEALTHY:
+			break;
+		case GPTE_PROVIDER_HEALTH_DOWN:
+			if (g_get_monotonic_time() - self->opened < self->cooldown) {
+				admit = FALSE;
+				break;
+			}
+			// this caller becomes the probe
+			gpte_provider_set_health(self, GPTE_PROVIDER_HEALTH_PROBING);
+			self->probing = TRUE;
+			break;
+		case GPTE_PROVIDER_HEALTH_PROBING:
+			admit = !self->probing;
+			self->probing = TRUE;
+			break;
+	}
+	g_mutex_unlock(&self->breaker_lock);
+
+	if (!admit)
+		g_set_error(err, GPTE_PTE_ERROR, GPTE_PTE_ERROR_SERVICE_DOWN, "Service Down (not retrying yet)");
+	return admit;
+}
+
+void gpte_provider_breaker_report(GpteProvider* self, gboolean reached, const GError* error) {
+	// anything else proves the endpoint answered
+	gboolean failed = g_error_matches(error, GPTE_PTE_ERROR, GPTE_PTE_ERROR_SERVICE_DOWN) ||
+		g_error_matches(error, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_IO_EXCEPTION);
+
+	g_mutex_lock(&self->breaker_lock);
+	if (!reached || g_cancellable_is_cancelled(g_cancellable_get_current())) {
+		// failed locally or aborted by the caller, which says nothing
+		// about the provider, but such a probe has to make room for the
+		// next one
+		self->probing = FALSE;
+	} else if (!failed) {
+		self->failures = 0;
+		self->probing = FALSE;
+		gpte_provider_set_health(self, GPTE_PROVIDER_HEALTH_HEALTHY);
+	} else if (self->health == GPTE_PROVIDER_HEALTH_PROBING || (self->failure_threshold && ++self->failures >= self->failure_threshold)) {
+		self->opened = g_get_monotonic_time();
+		self->probing = FALSE;
+		gpte_provider_set_health(self, GPTE_PROVIDER_HEALTH_DOWN);
+	}
+	g_mutex_unlock(&self->breaker_lock);
+}
+
+void gpte_provider_get_queue_stats(GpteProvider* self, guint* queued, guint* in_flight, gint64* mean_wait, gint64* max_wait) {
+	g_return_if_fail(GPTE_IS_PROVIDER(self));
+	gpte_limiter_get_stats(self->limiter, queued, in_flight, mean_wait, max_wait);
+}
+
+void gpte_provider_get_style_stats(GpteProvider* self, guint* hits, guint* misses, guint* n_styles) {
+	g_return_if_fail(GPTE_IS_PROVIDER(self));
+	gpte_style_cache_get_stats(self->styles, hits, misses, n_styles);
+}
+
+GpteStyleCache* gpte_provider_get_style_cache(GpteProvider* self) {
+	return self->styles;
+}
+
+static GpteGeoPoint* gpte_provider_area_from_java(GpteProvider* self, JNIEnv* env, gsize* len) {
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 4);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/NetworkProvider");
-	jmethodID area_mid = (*env)->GetMethodID(env, class, "getArea", "()[Lde/schildbach/pte/dto/Point;");
-	jobjectArray jarea = (*env)->CallObjectMethod(env, this, area_mid);
+	g_autoptr(GError) err = NULL;
+	jobjectArray jarea = (*env)->CallObjectMethod(env, this, vm->jni.network_provider.get_area);
+	if (gpte_jvm_error(vm, &err))
+		g_warning("Gpte.Provider %s failed to report its area: %s", self->id, err->message);
+	if (!jarea) {
+		*len = 0;
+		return NULL;
+	}
 
 	jsize jlen = (*env)->GetArrayLength(env, jarea);
 	*len = jlen;
@@ -171,90 +446,502 @@ GpteGeoPoint* gpte_provider_get_area(GpteProvider* self, gsize* len) {
 		ret[i] = gpte_geo_point_from_java(vm, point);
 		(*env)->DeleteLocalRef(env, point);
 	}
+	(*env)->DeleteLocalRef(env, jarea);
 	return ret;
 }
 
+// reads capabilities, default products and area in a single JVM scope
+static void gpte_provider_load_info(GpteProvider* self) {
+	if (!g_once_init_enter(&self->info_loaded))
+		return;
+
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 8);
+	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
+
+	// a provider failing to answer is treated as lacking the capability
+	// or default products, the exception must not leak into later calls
+	g_autoptr(GError) err = NULL;
+	jobjectArray jargs = (*env)->NewObjectArray(env, 1, vm->jni.capability.class, NULL);
+	for (gsize i = 0; i < vm->jni.capability.n_constants; i++) {
+		(*env)->SetObjectArrayElement(env, jargs, 0, vm->jni.capability.constants[i]);
+		jboolean has = (*env)->CallBooleanMethod(env, this, vm->jni.network_provider.has_capabilities, jargs);
+		if (gpte_jvm_error(vm, &err)) {
+			g_warning("Gpte.Provider %s failed to report its capabilities: %s", self->id, err->message);
+			g_clear_error(&err);
+		} else if (has) {
+			self->capabilities |= 1u << i;
+		}
+	}
+	(*env)->DeleteLocalRef(env, jargs);
+
+	jobject default_products = (*env)->CallObjectMethod(env, this, vm->jni.network_provider.default_products);
+	if (gpte_jvm_error(vm, &err)) {
+		g_warning("Gpte.Provider %s failed to report its default products: %s", self->id, err->message);
+		g_clear_error(&err);
+	} else if (default_products) {
+		self->default_products = gpte_products_from_set(vm, default_products);
+		(*env)->DeleteLocalRef(env, default_products);
+	}
+
+	// areas known at build time are served by gpte_provider_get_area()
+	gsize static_len;
+	if (!self->id || !gpte_provider_static_area(self->id, &static_len))
+		self->area = gpte_provider_area_from_java(self, env, &self->area_len);
+
+	g_once_init_leave(&self->info_loaded, 1);
+}
+
+GpteProducts gpte_provider_default_products(GpteProvider* self) {
+	g_return_val_if_fail(GPTE_IS_PROVIDER(self), 0);
+	gpte_provider_load_info(self);
+	return self->default_products;
+}
+
+gboolean gpte_provider_has_capabilities(GpteProvider* self, GpteProviderCapabilities capabilities) {
+	g_return_val_if_fail(GPTE_IS_PROVIDER(self), 0);
+	gpte_provider_load_info(self);
+
+	// capabilities unknown to the Java side are ignored
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	capabilities &= (1u << vm->jni.capability.n_constants) - 1;
+	return (self->capabilities & capabilities) == capabilities;
+}
+
+GpteGeoPoint* gpte_provider_get_area(GpteProvider* self, gsize* len) {
+	g_return_val_if_fail(GPTE_IS_PROVIDER(self), NULL);
+	g_return_val_if_fail(len != NULL, NULL);
+
+	const GpteGeoPoint* area = self->id ? gpte_provider_static_area(self->id, len) : NULL;
+	if (area)
+		return g_memdup2(area, *len * sizeof(GpteGeoPoint));
+
+	gpte_provider_load_info(self);
+	*len = self->area_len;
+	return self->area ? g_memdup2(self->area, self->area_len * sizeof(GpteGeoPoint)) : NULL;
+}
+
 GpteStyle* gpte_provider_line_style(GpteProvider* self, const gchar* network, GpteProductCode product, const gchar* label) {
 	g_return_val_if_fail(GPTE_IS_PROVIDER(self), NULL);
+
+	gboolean found;
+	const GpteStyle* style = gpte_style_cache_lookup(self->styles, network, product, label, &found);
+	if (found)
+		return style ? gpte_style_copy(style) : NULL;
+
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
 	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 8);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/NetworkProvider");
-	jmethodID style_mid = (*env)->GetMethodID(env, class, "lineStyle", "(Ljava/lang/String;Lde/schildbach/pte/dto/Product;Ljava/lang/String;)Lde/schildbach/pte/dto/Style;");
 	jstring network_str = network ? (*env)->NewStringUTF(env, network) : NULL;
 	jstring label_str = label ? (*env)->NewStringUTF(env, label) : NULL;
 
-	jclass product_class = (*env)->FindClass(env, "de/schildbach/pte/dto/Product");
-	jmethodID from_code = (*env)->GetStaticMethodID(env, product_class, "fromCode", "(C)Lde/schildbach/pte/dto/Product;");
-	jobject jproduct = product != GPTE_PRODUCT_CODE_NULL ? (*env)->CallStaticObjectMethod(env, product_class, from_code, (jchar)product) : NULL;
+	jobject jproduct = gpte_product_code_to_java(vm, product);
 
-	jobject jstyle = (*env)->CallObjectMethod(env, this, style_mid, network_str, jproduct, label_str);
-	if (!jstyle)
-		return NULL;
-	return gpte_style_from_java(vm, jstyle);
+	jobject jstyle = (*env)->CallObjectMethod(env, this, vm->jni.network_provider.line_style, network_str, jproduct, label_str);
+	style = gpte_style_cache_insert(self->styles, network, product, label, jstyle ? gpte_style_from_java(vm, jstyle) : NULL);
+	return style ? gpte_style_copy(style) : NULL;
 }
 
-#define GPTE_PROVIDER_RESULT_STATUS_ENUM_ENTRY(f,cn) \
-	(*env)->GetStaticObjectField(env, status_class, (*env)->GetStaticFieldID(env, status_class, (#f), "Lde/schildbach/pte/dto/" cn "$Status;"))
-#define GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(dom,f,cn,ret,msgf,...) \
-	if ((*env)->IsSameObject(env, status, GPTE_PROVIDER_RESULT_STATUS_ENUM_ENTRY(f, cn))) { \
+#define GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(dom,res,f,ret,msgf,...) \
+	case GPTE_JNI_##res##_STATUS_##f: \
 		g_set_error(err, dom, dom##_##f, msgf __VA_OPT__(,) __VA_ARGS__); \
-		return (ret); \
-	}
+		return (ret);
 
-GListModel* gpte_provider_query_departures(GpteProvider* self, const gchar* id, GDateTime* time, gint max, GpteQueryDeparturesFlags flags, GError** err) {
-	g_return_val_if_fail(GPTE_IS_PROVIDER(self), NULL);
+static GListModel* gpte_provider_fetch_departures_upstream(GpteProvider* self, const gchar* id, GDateTime* time, gint max, GpteQueryDeparturesFlags flags, gboolean* reached, GError** err) {
+	g_autoptr(GpteLimiterSlot) slot = gpte_provider_acquire_slot(self, err);
+	if (!slot)
+		return NULL;
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
 	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 10);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/NetworkProvider");
-	jmethodID query_mid = (*env)->GetMethodID(env, class, "queryDepartures", "(Ljava/lang/String;Ljava/util/Date;IZ)Lde/schildbach/pte/dto/QueryDeparturesResult;");
-
 	jstring id_str = (*env)->NewStringUTF(env, id);
 	jobject jtime = time ? gpte_date_to_java(vm, time) : NULL;
-	jobject res = (*env)->CallObjectMethod(env, this, query_mid, id_str, jtime, (jint)max, (jboolean)((flags & GPTE_QUERY_DEPARTURES_QUERY_EQUIVS) != 0));
+	*reached = TRUE;
+	jobject res = gpte_jvm_call_provider(vm, this, vm->jni.network_provider.query_departures, 4, (jobject[]){
+		id_str, jtime, gpte_jvm_box_int(vm, max), gpte_jvm_box_boolean(vm, flags & GPTE_QUERY_DEPARTURES_QUERY_EQUIVS)
+	});
 
+	gpte_jvm_timing_query_done(vm);
 	if (gpte_jvm_error(vm, err))
 		return NULL;
 
-	jclass result_class = (*env)->FindClass(env, "de/schildbach/pte/dto/QueryDeparturesResult");
-
-	jfieldID status_id = (*env)->GetFieldID(env, result_class, "status", "Lde/schildbach/pte/dto/QueryDeparturesResult$Status;");
-	jobject status = (*env)->GetObjectField(env, res, status_id);
+	jobject status = (*env)->GetObjectField(env, res, vm->jni.query_departures_result.status);
 
-	jclass status_class = (*env)->FindClass(env, "de/schildbach/pte/dto/QueryDeparturesResult$Status");
-	if (!(*env)->IsSameObject(env, status, GPTE_PROVIDER_RESULT_STATUS_ENUM_ENTRY(OK, "QueryDeparturesResult"))) {
-		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_ERROR, SERVICE_DOWN, "QueryDeparturesResult", NULL, "Service Down")
-		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_ERROR, INVALID_STATION, "QueryDeparturesResult", NULL, "Invalid Station")
+	switch (gpte_jni_enum_decode(&vm->jni, env, &vm->jni.query_departures_status, status)) {
+		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_ERROR, DEPARTURES, SERVICE_DOWN, NULL, "Service Down")
+		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_ERROR, DEPARTURES, INVALID_STATION, NULL, "Invalid Station")
+		default:
+			break;
 	}
 
-	jfieldID depas_id = (*env)->GetFieldID(env, result_class, "stationDepartures", "Ljava/util/List;");
-	jobject depas = (*env)->GetObjectField(env, res, depas_id);
+	jobject depas = (*env)->GetObjectField(env, res, vm->jni.query_departures_result.station_departures);
 	GListModel* ret = gpte_list_new(vm, GPTE_TYPE_STATION_DEPARTURES, depas);
+	gpte_style_cache_attach(ret, self->styles);
+	if (flags & GPTE_QUERY_DEPARTURES_EAGER)
+		gpte_list_set_pack_func(GPTE_LIST(ret), gpte_station_departures_unpack_window);
 	return ret;
 }
+static GListModel* gpte_provider_fetch_departures(GpteProvider* self, const gchar* id, GDateTime* time, gint max, GpteQueryDeparturesFlags flags, GError** err) {
+	if (!gpte_provider_breaker_admit(self, err))
+		return NULL;
+	GError* error = NULL;
+	gboolean reached = FALSE;
+	GListModel* ret = gpte_provider_fetch_departures_upstream(self, id, time, max, flags, &reached, &error);
+	gpte_provider_breaker_report(self, reached, error);
+	if (error)
+		g_propagate_error(err, error);
+	return ret;
+}
+
+static gchar* gpte_provider_departures_cache_key(const gchar* id, GDateTime* time, gint max, GpteQueryDeparturesFlags flags) {
+	// without a time the provider uses the current one, which the TTL covers
+	gint64 bucket = time ? g_date_time_to_unix(time) / GPTE_PROVIDER_CACHE_TIME_BUCKET : -1;
+	return g_strdup_printf("%s\x1f%" G_GINT64_FORMAT "\x1f%d\x1f%u", id, bucket, max, flags);
+}
+
+static gboolean gpte_provider_departures_cache_expired(gpointer, GpteDeparturesCacheEntry* entry, GpteProvider* self) {
+	return !entry->refreshing && g_get_monotonic_time() - entry->fetched >= self->cache_ttl + self->cache_stale;
+}
+
+// must be called with cache_lock held
+static void gpte_provider_departures_cache_evict_oldest(GpteProvider* self) {
+	GHashTableIter iter;
+	gpointer key, value;
+	gpointer oldest = NULL;
+	gint64 oldest_fetched = G_MAXINT64;
+	g_hash_table_iter_init(&iter, self->departures_cache);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		GpteDeparturesCacheEntry* entry = value;
+		// a refreshing entry is looked up again once its refresh ends
+		if (!entry->refreshing && entry->fetched < oldest_fetched) {
+			oldest = key;
+			oldest_fetched = entry->fetched;
+		}
+	}
+	if (oldest)
+		g_hash_table_remove(self->departures_cache, oldest);
+}
+
+// must be called with cache_lock held, takes ownership of @key and @items
+static void gpte_provider_departures_cache_store(GpteProvider* self, gchar* key, GPtrArray* items) {
+	if (!self->departures_cache) {
+		g_free(key);
+		g_ptr_array_unref(items);
+		return;
+	}
+	g_hash_table_foreach_remove(self->departures_cache, (GHRFunc)gpte_provider_departures_cache_expired, self);
+	if (!g_hash_table_contains(self->departures_cache, key) && g_hash_table_size(self->departures_cache) >= GPTE_PROVIDER_CACHE_MAX_ENTRIES)
+		gpte_provider_departures_cache_evict_oldest(self);
+
+	GpteDeparturesCacheEntry* entry = g_new(GpteDeparturesCacheEntry, 1);
+	entry->items = items;
+	entry->fetched = g_get_monotonic_time();
+	entry->refreshing = FALSE;
+	g_hash_table_replace(self->departures_cache, key, entry);
+}
 
 typedef struct {
+	GpteProvider* provider;
+	gchar* key;
 	gchar* id;
 	GDateTime* time;
 	gint max;
 	GpteQueryDeparturesFlags flags;
-} GpteQueryDeparturesData;
-static void gpte_provider_query_depatures_data_free(GpteQueryDeparturesData* self) {
+} GpteDeparturesRefreshData;
+static void gpte_provider_departures_refresh_data_free(GpteDeparturesRefreshData* self) {
+	// also reached if the refresh never ran, e.g. because the executor was full
+	g_mutex_lock(&self->provider->cache_lock);
+	GpteDeparturesCacheEntry* entry = self->provider->departures_cache ? g_hash_table_lookup(self->provider->departures_cache, self->key) : NULL;
+	if (entry)
+		entry->refreshing = FALSE;
+	g_mutex_unlock(&self->provider->cache_lock);
+
+	g_free(self->key);
 	g_free(self->id);
-	g_date_time_unref(self->time);
+	if (self->time)
+		g_date_time_unref(self->time);
 	g_free(self);
 }
-static void gpte_provider_query_depatures_thread(GTask* task, GpteProvider* self, GpteQueryDeparturesData* data, GCancellable*) {
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_autoptr(GpteThreadGuard) guard = gpte_jvm_attach_thread(vm, "gpte-query-depatures-async");
-	if (!guard) {
-		g_task_return_error(task, g_error_new(GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_THREADING, "Unable to attach thread"));
+static void gpte_provider_departures_refresh_thread(GTask* task, GpteProvider* self, GpteDeparturesRefreshData* data, GCancellable*) {
+	GError* err = NULL;
+	g_autoptr(GListModel) model = gpte_provider_fetch_departures(self, data->id, data->time, data->max, data->flags, &err);
+	if (!model) {
+		g_task_return_error(task, err);
+		return;
+	}
+	// read from Java before taking the lock
+	GPtrArray* items = gpte_list_detach_items(model);
+	g_mutex_lock(&self->cache_lock);
+	gpte_provider_departures_cache_store(self, g_strdup(data->key), items);
+	g_mutex_unlock(&self->cache_lock);
+	g_task_return_boolean(task, TRUE);
+}
+
+// the entry must already be marked as refreshing
+static void gpte_provider_departures_refresh(GpteProvider* self, const gchar* key, const gchar* id, GDateTime* time, gint max, GpteQueryDeparturesFlags flags) {
+	GpteDeparturesRefreshData* data = g_new(GpteDeparturesRefreshData, 1);
+	data->provider = self;
+	data->key = g_strdup(key);
+	data->id = g_strdup(id);
+	data->time = time ? g_date_time_ref(time) : NULL;
+	data->max = max;
+	data->flags = flags;
+
+	// the task holds a reference to the provider, so data->provider stays valid
+	g_autoptr(GTask) task = g_task_new(self, NULL, NULL, NULL);
+	g_task_set_priority(task, G_PRIORITY_LOW);
+	g_task_set_task_data(task, data, (GDestroyNotify)gpte_provider_departures_refresh_data_free);
+	gpte_provider_run_task(self, task, (GTaskThreadFunc)gpte_provider_departures_refresh_thread);
+}
+
+// Returns a new store of the cached items, or NULL on a miss. Stale
+// entries are returned as well, while a refresh is started in the
+// background.
+static GListModel* gpte_provider_departures_cache_lookup(GpteProvider* self, const gchar* key, const gchar* id, GDateTime* time, gint max, GpteQueryDeparturesFlags flags, gboolean count_miss) {
+	g_autoptr(GPtrArray) items = NULL;
+	gboolean refresh = FALSE;
+	g_mutex_lock(&self->cache_lock);
+	GpteDeparturesCacheEntry* entry = self->departures_cache ? g_hash_table_lookup(self->departures_cache, key) : NULL;
+	gint64 age = entry ? g_get_monotonic_time() - entry->fetched : 0;
+	if (entry && age < self->cache_ttl + self->cache_stale) {
+		items = g_ptr_array_ref(entry->items);
+		if (age >= self->cache_ttl && !entry->refreshing)
+			refresh = entry->refreshing = TRUE;
+	}
+	g_mutex_unlock(&self->cache_lock);
+
+	if (refresh)
+		gpte_provider_departures_refresh(self, key, id, time, max, flags);
+	if (items)
+		g_atomic_int_inc(&self->cache_hits);
+	else if (count_miss)
+		g_atomic_int_inc(&self->cache_misses);
+	return items ? gpte_list_store_new_from_items(GPTE_TYPE_STATION_DEPARTURES, items) : NULL;
+}
+
+static gboolean gpte_provider_departures_cache_enabled(GpteProvider* self) {
+	g_mutex_lock(&self->cache_lock);
+	gboolean enabled = self->departures_cache != NULL;
+	g_mutex_unlock(&self->cache_lock);
+	return enabled;
+}
+
+GListModel* gpte_provider_query_departures(GpteProvider* self, const gchar* id, GDateTime* time, gint max, GpteQueryDeparturesFlags flags, GError** err) {
+	g_return_val_if_fail(GPTE_IS_PROVIDER(self), NULL);
+
+	if (!gpte_provider_departures_cache_enabled(self))
+		return gpte_provider_fetch_departures(self, id, time, max, flags, err);
+
+	g_autofree gchar* key = gpte_provider_departures_cache_key(id, time, max, flags);
+	GListModel* ret = gpte_provider_departures_cache_lookup(self, key, id, time, max, flags, TRUE);
+	if (ret)
+		return ret;
+
+	g_autoptr(GListModel) model = gpte_provider_fetch_departures(self, id, time, max, flags, err);
+	if (!model)
+		return NULL;
+
+	// hits are detached, so misses are as well
+	GPtrArray* items = gpte_list_detach_items(model);
+	ret = gpte_list_store_new_from_items(GPTE_TYPE_STATION_DEPARTURES, items);
+	g_mutex_lock(&self->cache_lock);
+	gpte_provider_departures_cache_store(self, g_steal_pointer(&key), items);
+	g_mutex_unlock(&self->cache_lock);
+	return ret;
+}
+
+void gpte_provider_set_departures_cache(GpteProvider* self, guint ttl, guint stale) {
+	g_return_if_fail(GPTE_IS_PROVIDER(self));
+	g_mutex_lock(&self->cache_lock);
+	if (ttl == 0) {
+		g_clear_pointer(&self->departures_cache, g_hash_table_unref);
+	} else if (!self->departures_cache) {
+		self->departures_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)gpte_departures_cache_entry_free);
+	}
+	self->cache_ttl = (gint64)ttl * G_USEC_PER_SEC;
+	self->cache_stale = (gint64)stale * G_USEC_PER_SEC;
+	g_mutex_unlock(&self->cache_lock);
+}
+
+void gpte_provider_get_departures_cache_stats(GpteProvider* self, guint* hits, guint* misses) {
+	g_return_if_fail(GPTE_IS_PROVIDER(self));
+	if (hits)
+		*hits = g_atomic_int_get(&self->cache_hits);
+	if (misses)
+		*misses = g_atomic_int_get(&self->cache_misses);
+}
+
+static void gpte_provider_inflight_cancelled(GCancellable*, GpteInflightWaiter* waiter) {
+	// the waiter was already served
+	if (!waiter->task)
+		return;
+	GpteProvider* self = waiter->provider;
+
+	g_mutex_lock(&self->inflight_lock);
+	GpteInflight* inflight = waiter->inflight;
+	if (!inflight) {
+		// not joined yet, gpte_provider_run_deduplicated() handles it
+		waiter->cancelled = TRUE;
+		g_mutex_unlock(&self->inflight_lock);
+		return;
+	}
+	gboolean removed = g_ptr_array_remove(inflight->waiters, waiter);
+	gboolean abandoned = removed && inflight->waiters->len == 0;
+	// later callers must not join a request that is about to be cancelled
+	if (abandoned && g_hash_table_lookup(self->inflight, inflight->key) == inflight)
+		g_hash_table_remove(self->inflight, inflight->key);
+	g_mutex_unlock(&self->inflight_lock);
+
+	if (!removed)
 		return;
+	// g_cancellable_disconnect() would wait for this very handler, the
+	// handler reference of the waiter is dropped with it
+	g_signal_handler_disconnect(waiter->cancellable, waiter->handler);
+	waiter->handler = 0;
+	g_task_return_error_if_cancelled(waiter->task);
+	g_clear_object(&waiter->task);
+	if (abandoned)
+		g_cancellable_cancel(inflight->upstream);
+	// drops the reference of the waiters array
+	gpte_inflight_waiter_unref(waiter);
+}
+
+static void gpte_provider_inflight_done(GpteProvider* self, GAsyncResult* res, GpteInflight* inflight) {
+	GError* err = NULL;
+	gpointer result = g_task_propagate_pointer(G_TASK(res), &err);
+
+	g_mutex_lock(&self->inflight_lock);
+	if (g_hash_table_lookup(self->inflight, inflight->key) == inflight)
+		g_hash_table_remove(self->inflight, inflight->key);
+	GPtrArray* waiters = g_steal_pointer(&inflight->waiters);
+	inflight->waiters = g_ptr_array_new();
+	g_mutex_unlock(&self->inflight_lock);
+
+	for (guint i = 0; i < waiters->len; i++) {
+		GpteInflightWaiter* waiter = g_ptr_array_index(waiters, i);
+		// waits for a concurrently running cancellation handler
+		if (waiter->cancellable)
+			g_cancellable_disconnect(waiter->cancellable, waiter->handler);
+		if (err)
+			g_task_return_error(waiter->task, g_error_copy(err));
+		else
+			g_task_return_pointer(waiter->task, inflight->copy(result), inflight->free);
+		gpte_inflight_waiter_unref(waiter);
+	}
+	g_ptr_array_unref(waiters);
+
+	if (result)
+		inflight->free(result);
+	g_clear_error(&err);
+	gpte_inflight_unref(inflight);
+}
+
+// Coalesced waiters may live on different threads, so each of them gets
+// a model of its own: wrappers have unsynchronised caches and a
+// GListStore isn't thread-safe either. Items of stores are snapshots,
+// which may be shared.
+static GListModel* gpte_provider_result_list_copy(GListModel* list) {
+	if (GPTE_IS_LIST(list))
+		return gpte_list_copy(GPTE_LIST(list));
+	guint n_items = g_list_model_get_n_items(list);
+	g_autoptr(GPtrArray) items = g_ptr_array_new_full(n_items, g_object_unref);
+	for (guint i = 0; i < n_items; i++)
+		g_ptr_array_add(items, g_list_model_get_item(list, i));
+	return gpte_list_store_new_from_items(g_list_model_get_item_type(list), items);
+}
+
+/*
+ * Runs @func with @data on the executor and returns its result of
+ * @copy/@free-able type to @task, unless a request with the same @key is
+ * already in flight, in which case @task receives a copy of its result.
+ */
+static void gpte_provider_run_deduplicated(GpteProvider* self, GTask* task, const gchar* key, gpointer data, GDestroyNotify data_free, GTaskThreadFunc func, GBoxedCopyFunc copy, GDestroyNotify free) {
+	GpteInflightWaiter* waiter = g_new(GpteInflightWaiter, 1);
+	g_atomic_ref_count_init(&waiter->rc);
+	waiter->provider = g_object_ref(self);
+	waiter->task = g_object_ref(task);
+	waiter->cancellable = NULL;
+	waiter->handler = 0;
+	waiter->inflight = NULL;
+	waiter->cancelled = FALSE;
+
+	GCancellable* cancellable = g_task_get_cancellable(task);
+	if (cancellable) {
+		waiter->cancellable = g_object_ref(cancellable);
+		waiter->handler = g_cancellable_connect(cancellable, G_CALLBACK(gpte_provider_inflight_cancelled), gpte_inflight_waiter_ref(waiter), (GDestroyNotify)gpte_inflight_waiter_unref);
+	}
+
+	g_mutex_lock(&self->inflight_lock);
+	if (waiter->cancelled || (cancellable && !waiter->handler)) {
+		g_mutex_unlock(&self->inflight_lock);
+		g_cancellable_disconnect(cancellable, waiter->handler);
+		g_task_return_error_if_cancelled(task);
+		goto joined;
+	}
+
+	GpteInflight* inflight = g_hash_table_lookup(self->inflight, key);
+	if (inflight) {
+		waiter->inflight = gpte_inflight_ref(inflight);
+		g_ptr_array_add(inflight->waiters, waiter);
+		g_mutex_unlock(&self->inflight_lock);
+		// the waiter is now owned by the in-flight request
+		waiter = NULL;
+		goto joined;
 	}
 
+	inflight = g_new(GpteInflight, 1);
+	g_atomic_ref_count_init(&inflight->rc);
+	inflight->key = g_strdup(key);
+	inflight->waiters = g_ptr_array_new();
+	inflight->upstream = g_cancellable_new();
+	inflight->copy = copy;
+	inflight->free = free;
+	g_hash_table_insert(self->inflight, inflight->key, inflight);
+
+	waiter->inflight = gpte_inflight_ref(inflight);
+	g_ptr_array_add(inflight->waiters, waiter);
+	g_mutex_unlock(&self->inflight_lock);
+
+	GTask* upstream = g_task_new(self, inflight->upstream, (GAsyncReadyCallback)gpte_provider_inflight_done, gpte_inflight_ref(inflight));
+	g_task_set_priority(upstream, g_task_get_priority(task));
+	g_task_set_task_data(upstream, data, data_free);
+	gpte_provider_run_task(self, upstream, func);
+	g_object_unref(upstream);
+	return;
+
+joined:
+	if (waiter)
+		gpte_inflight_waiter_unref(waiter);
+	data_free(data);
+}
+
+static gchar* gpte_provider_location_key(GpteLocation* location) {
+	if (!location)
+		return g_strdup("");
+	const gchar* id = gpte_location_get_id(location);
+	if (id)
+		return g_strdup(id);
+	const GpteGeoPoint* coords = gpte_location_get_coords(location);
+	if (coords)
+		return g_strdup_printf("%.6f,%.6f", coords->lat, coords->lon);
+	return g_strdup(gpte_location_get_name(location));
+}
+
+typedef struct {
+	gchar* id;
+	GDateTime* time;
+	gint max;
+	GpteQueryDeparturesFlags flags;
+} GpteQueryDeparturesData;
+static void gpte_provider_query_depatures_data_free(GpteQueryDeparturesData* self) {
+	g_free(self->id);
+	if (self->time)
+		g_date_time_unref(self->time);
+	g_free(self);
+}
+static void gpte_provider_query_depatures_thread(GTask* task, GpteProvider* self, GpteQueryDeparturesData* data, GCancellable*) {
 	GError* err = NULL;
 	GListModel* model = gpte_provider_query_departures(self, data->id, data->time, data->max, data->flags, &err);
 	if (model)
@@ -273,13 +960,27 @@ void gpte_provider_query_departures_async(
 ) {
 	g_return_if_fail(GPTE_IS_PROVIDER(self));
 	g_autoptr(GTask) task = g_task_new(self, cancellable, callback, user_data);
+
+	// cache hits don't need to go through the executor
+	if (gpte_provider_departures_cache_enabled(self)) {
+		g_autofree gchar* key = gpte_provider_departures_cache_key(id, time, max, flags);
+		GListModel* cached = gpte_provider_departures_cache_lookup(self, key, id, time, max, flags, FALSE);
+		if (cached) {
+			g_task_return_pointer(task, cached, g_object_unref);
+			return;
+		}
+	}
+
 	GpteQueryDeparturesData* data = g_new(GpteQueryDeparturesData, 1);
 	data->id = id ? g_strdup(id) : NULL;
-	data->time = g_date_time_ref(time);
+	data->time = time ? g_date_time_ref(time) : NULL;
 	data->max = max;
 	data->flags = flags;
-	g_task_set_task_data(task, data, (GDestroyNotify)gpte_provider_query_depatures_data_free);
-	g_task_run_in_thread(task, (GTaskThreadFunc)gpte_provider_query_depatures_thread);
+
+	g_autofree gchar* cache_key = gpte_provider_departures_cache_key(id, time, max, flags);
+	g_autofree gchar* key = g_strconcat("departures\x1e", cache_key, NULL);
+	gpte_provider_run_deduplicated(self, task, key, data, (GDestroyNotify)gpte_provider_query_depatures_data_free,
+		(GTaskThreadFunc)gpte_provider_query_depatures_thread, (GBoxedCopyFunc)gpte_provider_result_list_copy, g_object_unref);
 }
 
 GListModel* gpte_provider_query_departures_finish(GpteProvider* self, GAsyncResult* result, GError** error) {
@@ -287,54 +988,283 @@ GListModel* gpte_provider_query_departures_finish(GpteProvider* self, GAsyncResu
 	return g_task_propagate_pointer(G_TASK(result), error);
 }
 
+typedef struct {
+	GStrv ids;
+	guint next;
+	guint running;
+	gboolean finished;
+	// protected by the batch_lock of the provider
+	gboolean waiting;
+	// query slots handed over by other batches
+	guint granted;
+	gulong cancelled_handler;
+	GDateTime* time;
+	gint max;
+	GpteQueryDeparturesFlags flags;
+	GpteDeparturesFunc func;
+	gpointer func_data;
+	GDestroyNotify func_destroy;
+} GpteDeparturesBatch;
+static void gpte_departures_batch_free(GpteDeparturesBatch* self) {
+	g_strfreev(self->ids);
+	if (self->time)
+		g_date_time_unref(self->time);
+	if (self->func_destroy)
+		self->func_destroy(self->func_data);
+	g_free(self);
+}
 
-GpteTripsResult* gpte_provider_query_trips(GpteProvider* self, GpteLocation* from, GpteLocation* via, GpteLocation* to, GDateTime* date, GpteTripsQueryRequest request, const GpteTripOptions* options, GError** err) {
-	g_return_val_if_fail(GPTE_IS_PROVIDER(self), NULL);
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 10);
-	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
+typedef struct {
+	GTask* task;
+	guint index;
+} GpteDeparturesBatchQuery;
+
+static void gpte_provider_departures_batch_pump(GTask* task);
+
+static gboolean gpte_provider_departures_batch_resume(GTask* task) {
+	gpte_provider_departures_batch_pump(task);
+	return G_SOURCE_REMOVE;
+}
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/NetworkProvider");
-	jmethodID query_mid = (*env)->GetMethodID(env, class, "queryTrips", "("
-		"Lde/schildbach/pte/dto/Location;"
-		"Lde/schildbach/pte/dto/Location;"
-		"Lde/schildbach/pte/dto/Location;"
-		"Ljava/util/Date;"
-		"Z"
-		"Lde/schildbach/pte/dto/TripOptions;"
-	")Lde/schildbach/pte/dto/QueryTripsResult;");
+// must be called with batch_lock held, returns the batches to resume
+static GPtrArray* gpte_provider_batch_dispatch(GpteProvider* self) {
+	GPtrArray* woken = g_ptr_array_new();
+	while (self->batch_running < self->batch_parallelism && !g_queue_is_empty(&self->batch_waiting)) {
+		GTask* task = g_queue_pop_head(&self->batch_waiting);
+		GpteDeparturesBatch* batch = g_task_get_task_data(task);
+		batch->waiting = FALSE;
+		batch->granted++;
+		self->batch_running++;
+		g_ptr_array_add(woken, task);
+	}
+	return woken;
+}
+// takes ownership of @task
+static void gpte_provider_departures_batch_schedule(GTask* task) {
+	// batches may belong to other threads, and the current one may still
+	// be inside the pump of a batch
+	GSource* source = g_idle_source_new();
+	g_source_set_priority(source, g_task_get_priority(task));
+	g_source_set_callback(source, (GSourceFunc)gpte_provider_departures_batch_resume, task, g_object_unref);
+	g_source_attach(source, g_task_get_context(task));
+	g_source_unref(source);
+}
+static void gpte_provider_batch_resume_all(GPtrArray* woken) {
+	for (guint i = 0; i < woken->len; i++)
+		gpte_provider_departures_batch_schedule(g_ptr_array_index(woken, i));
+	g_ptr_array_unref(woken);
+}
 
+// a queued batch has no query that would resume it
+static void gpte_provider_departures_batch_cancelled(GCancellable*, GTask* task) {
+	gpte_provider_departures_batch_schedule(g_object_ref(task));
+}
 
-	jobject jfrom = gpte_java_object_get(GPTE_JAVA_OBJECT(from));
-	jobject jvia = via ? gpte_java_object_get(GPTE_JAVA_OBJECT(via)) : NULL;
-	jobject jto = gpte_java_object_get(GPTE_JAVA_OBJECT(to));
+// Takes a query slot of the provider for @task. If there is none, @task
+// is queued and resumed once another batch hands one over.
+static gboolean gpte_provider_batch_acquire(GpteProvider* self, GTask* task) {
+	GpteDeparturesBatch* batch = g_task_get_task_data(task);
+	gboolean acquired = TRUE;
+	g_mutex_lock(&self->batch_lock);
+	if (batch->granted > 0) {
+		batch->granted--;
+	} else if (self->batch_running < self->batch_parallelism && g_queue_is_empty(&self->batch_waiting)) {
+		self->batch_running++;
+	} else {
+		acquired = FALSE;
+		if (!batch->waiting) {
+			batch->waiting = TRUE;
+			g_queue_push_tail(&self->batch_waiting, g_object_ref(task));
+		}
+	}
+	g_mutex_unlock(&self->batch_lock);
+	return acquired;
+}
+
+static void gpte_provider_batch_release(GpteProvider* self, guint n_slots) {
+	g_mutex_lock(&self->batch_lock);
+	self->batch_running -= n_slots;
+	GPtrArray* woken = gpte_provider_batch_dispatch(self);
+	g_mutex_unlock(&self->batch_lock);
+	gpte_provider_batch_resume_all(woken);
+}
+
+// passes on the slots @task was handed but doesn't need anymore
+static void gpte_provider_batch_leave(GpteProvider* self, GTask* task) {
+	GpteDeparturesBatch* batch = g_task_get_task_data(task);
+	gboolean dequeued = FALSE;
+	g_mutex_lock(&self->batch_lock);
+	guint granted = batch->granted;
+	batch->granted = 0;
+	if (batch->waiting) {
+		dequeued = g_queue_remove(&self->batch_waiting, task);
+		batch->waiting = FALSE;
+	}
+	g_mutex_unlock(&self->batch_lock);
+
+	if (dequeued)
+		g_object_unref(task);
+	if (granted > 0)
+		gpte_provider_batch_release(self, granted);
+}
+
+static void gpte_provider_departures_batch_done(GpteProvider* self, GAsyncResult* res, GpteDeparturesBatchQuery* query) {
+	GTask* task = query->task;
+	GpteDeparturesBatch* batch = g_task_get_task_data(task);
+	GError* err = NULL;
+	g_autoptr(GListModel) model = gpte_provider_query_departures_finish(self, res, &err);
+
+	// a cancelled batch doesn't report the stations it gave up on
+	if (!g_cancellable_is_cancelled(g_task_get_cancellable(task)))
+		batch->func(self, batch->ids[query->index], model, err, batch->func_data);
+	g_clear_error(&err);
+
+	batch->running--;
+	gpte_provider_batch_release(self, 1);
+	gpte_provider_departures_batch_pump(task);
+
+	g_object_unref(task);
+	g_free(query);
+}
+
+static void gpte_provider_departures_batch_pump(GTask* task) {
+	GpteProvider* self = g_task_get_source_object(task);
+	GpteDeparturesBatch* batch = g_task_get_task_data(task);
+	GCancellable* cancellable = g_task_get_cancellable(task);
+	// a resume may still be pending when the batch finishes
+	if (batch->finished)
+		return;
+
+	gboolean cancelled = g_cancellable_is_cancelled(cancellable);
+	while (!cancelled && batch->ids[batch->next] && gpte_provider_batch_acquire(self, task)) {
+		GpteDeparturesBatchQuery* query = g_new(GpteDeparturesBatchQuery, 1);
+		query->task = g_object_ref(task);
+		query->index = batch->next++;
+		batch->running++;
+		gpte_provider_query_departures_async(self, batch->ids[query->index], batch->time, batch->max, batch->flags, cancellable,
+			(GAsyncReadyCallback)gpte_provider_departures_batch_done, query);
+	}
+	if (cancelled || !batch->ids[batch->next])
+		gpte_provider_batch_leave(self, task);
+
+	if (batch->running > 0)
+		return;
+	batch->finished = TRUE;
+	g_cancellable_disconnect(cancellable, batch->cancelled_handler);
+	if (cancelled)
+		g_task_return_error_if_cancelled(task);
+	else
+		g_task_return_boolean(task, TRUE);
+}
+
+void gpte_provider_query_departures_many_async(
+	GpteProvider* self,
+	const gchar* const* ids,
+	GDateTime* time,
+	gint max,
+	GpteQueryDeparturesFlags flags,
+	GCancellable* cancellable,
+	GpteDeparturesFunc func, gpointer func_data, GDestroyNotify func_destroy,
+	GAsyncReadyCallback callback, gpointer user_data
+) {
+	g_return_if_fail(GPTE_IS_PROVIDER(self));
+	g_return_if_fail(ids != NULL);
+	g_return_if_fail(func != NULL);
+	g_autoptr(GTask) task = g_task_new(self, cancellable, callback, user_data);
+	g_task_set_source_tag(task, gpte_provider_query_departures_many_async);
+
+	GpteDeparturesBatch* batch = g_new(GpteDeparturesBatch, 1);
+	batch->ids = g_strdupv((gchar**)ids);
+	batch->next = 0;
+	batch->running = 0;
+	batch->finished = FALSE;
+	batch->waiting = FALSE;
+	batch->granted = 0;
+	batch->cancelled_handler = 0;
+	batch->time = time ? g_date_time_ref(time) : NULL;
+	batch->max = max;
+	batch->flags = flags;
+	batch->func = func;
+	batch->func_data = func_data;
+	batch->func_destroy = func_destroy;
+	g_task_set_task_data(task, batch, (GDestroyNotify)gpte_departures_batch_free);
+
+	// disconnected once the batch finishes, which outlives the handler
+	if (cancellable)
+		batch->cancelled_handler = g_cancellable_connect(cancellable, G_CALLBACK(gpte_provider_departures_batch_cancelled), task, NULL);
+	gpte_provider_departures_batch_pump(task);
+}
+
+gboolean gpte_provider_query_departures_many_finish(GpteProvider* self, GAsyncResult* result, GError** error) {
+	g_return_val_if_fail(g_task_is_valid(result, self), FALSE);
+	return g_task_propagate_boolean(G_TASK(result), error);
+}
+
+void gpte_provider_set_batch_parallelism(GpteProvider* self, guint parallelism) {
+	g_return_if_fail(GPTE_IS_PROVIDER(self));
+	g_return_if_fail(parallelism > 0);
+	g_mutex_lock(&self->batch_lock);
+	self->batch_parallelism = parallelism;
+	GPtrArray* woken = gpte_provider_batch_dispatch(self);
+	g_mutex_unlock(&self->batch_lock);
+	gpte_provider_batch_resume_all(woken);
+}
+
+
+static GpteTripsResult* gpte_provider_query_trips_upstream(GpteProvider* self, GpteLocation* from, GpteLocation* via, GpteLocation* to, GDateTime* date, GpteTripsQueryRequest request, const GpteTripOptions* options, gboolean* reached, GError** err) {
+	g_autoptr(GpteLimiterSlot) slot = gpte_provider_acquire_slot(self, err);
+	if (!slot)
+		return NULL;
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 32);
+	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
+
+	jobject jfrom = gpte_location_to_java(vm, from);
+	jobject jvia = via ? gpte_location_to_java(vm, via) : NULL;
+	jobject jto = gpte_location_to_java(vm, to);
+	if (gpte_jvm_error(vm, err))
+		return NULL;
 	jobject jdate = gpte_date_to_java(vm, date);
 	jobject joptions = gpte_trip_options_to_java(vm, options);
 
-	jobject res = (*env)->CallObjectMethod(env, this, query_mid, jfrom, jvia, jto, jdate, (jboolean)(request == GPTE_TRIPS_QUERY_DEPARTURE), joptions);
+	*reached = TRUE;
+	jobject res = gpte_jvm_call_provider(vm, this, vm->jni.network_provider.query_trips, 6, (jobject[]){
+		jfrom, jvia, jto, jdate, gpte_jvm_box_boolean(vm, request == GPTE_TRIPS_QUERY_DEPARTURE), joptions
+	});
 
+	gpte_jvm_timing_query_done(vm);
 	if (gpte_jvm_error(vm, err))
 		return NULL;
 
-	jclass result_class = (*env)->FindClass(env, "de/schildbach/pte/dto/QueryTripsResult");
-	jfieldID status_id = (*env)->GetFieldID(env, result_class, "status", "Lde/schildbach/pte/dto/QueryTripsResult$Status;");
-	jobject status = (*env)->GetObjectField(env, res, status_id);
-
-	jclass status_class = (*env)->FindClass(env, "de/schildbach/pte/dto/QueryTripsResult$Status");
-	if (!(*env)->IsSameObject(env, status, GPTE_PROVIDER_RESULT_STATUS_ENUM_ENTRY(OK, "QueryTripsResult"))) {
-		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_ERROR, SERVICE_DOWN, "QueryTripsResult", NULL, "Service Down")
-		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_ERROR, INVALID_DATE, "QueryTripsResult", NULL, "Invalid Date")
-		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_TRIPS_ERROR, NO_TRIPS, "QueryTripsResult", NULL, "No available trips")
-		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_TRIPS_ERROR, TOO_CLOSE, "QueryTripsResult", NULL, "Locations too close by eachother")
-		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_TRIPS_ERROR, UNKNOWN_FROM, "QueryTripsResult", NULL, "Departure location unknown")
-		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_TRIPS_ERROR, UNKNOWN_LOCATION, "QueryTripsResult", NULL, "Unknown location")
-		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_TRIPS_ERROR, UNKNOWN_TO, "QueryTripsResult", NULL, "Destination location unknown")
-		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_TRIPS_ERROR, UNKNOWN_VIA, "QueryTripsResult", NULL, "Via location unknown")
-		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_TRIPS_ERROR, UNRESOLVABLE_ADDRESS, "QueryTripsResult", NULL, "Address unresolvable")
-
+	jobject status = (*env)->GetObjectField(env, res, vm->jni.query_trips_result.status);
+
+	switch (gpte_jni_enum_decode(&vm->jni, env, &vm->jni.query_trips_status, status)) {
+		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_ERROR, TRIPS, SERVICE_DOWN, NULL, "Service Down")
+		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_ERROR, TRIPS, INVALID_DATE, NULL, "Invalid Date")
+		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_TRIPS_ERROR, TRIPS, NO_TRIPS, NULL, "No available trips")
+		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_TRIPS_ERROR, TRIPS, TOO_CLOSE, NULL, "Locations too close by eachother")
+		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_TRIPS_ERROR, TRIPS, UNKNOWN_FROM, NULL, "Departure location unknown")
+		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_TRIPS_ERROR, TRIPS, UNKNOWN_LOCATION, NULL, "Unknown location")
+		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_TRIPS_ERROR, TRIPS, UNKNOWN_TO, NULL, "Destination location unknown")
+		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_TRIPS_ERROR, TRIPS, UNKNOWN_VIA, NULL, "Via location unknown")
+		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_TRIPS_ERROR, TRIPS, UNRESOLVABLE_ADDRESS, NULL, "Address unresolvable")
+		default:
+			break;
 	}
 
-	return gpte_trips_result_new(vm, res, self);
+	return gpte_trips_result_new(vm, res, self, options ? options->flags : 0);
+}
+GpteTripsResult* gpte_provider_query_trips(GpteProvider* self, GpteLocation* from, GpteLocation* via, GpteLocation* to, GDateTime* date, GpteTripsQueryRequest request, const GpteTripOptions* options, GError** err) {
+	g_return_val_if_fail(GPTE_IS_PROVIDER(self), NULL);
+	if (!gpte_provider_breaker_admit(self, err))
+		return NULL;
+	GError* error = NULL;
+	gboolean reached = FALSE;
+	GpteTripsResult* ret = gpte_provider_query_trips_upstream(self, from, via, to, date, request, options, &reached, &error);
+	gpte_provider_breaker_report(self, reached, error);
+	if (error)
+		g_propagate_error(err, error);
+	return ret;
 }
 
 typedef struct {
@@ -355,13 +1285,6 @@ static void gpte_provider_query_trips_data_free(GpteProviderQueryTripsData* self
 	g_free(self);
 }
 static void gpte_provider_query_trips_thread(GTask* task, GpteProvider* self, GpteProviderQueryTripsData* data, GCancellable*) {
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_autoptr(GpteThreadGuard) guard = gpte_jvm_attach_thread(vm, "gpte-suggest-locations-async");
-	if (!guard) {
-		g_task_return_error(task, g_error_new(GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_THREADING, "Unable to attach thread"));
-		return;
-	}
-
 	GError* err = NULL;
 	GpteTripsResult* res = gpte_provider_query_trips(self, data->from, data->via, data->to, data->date, data->request, data->has_options ? &data->options : NULL, &err);
 	if (res)
@@ -384,7 +1307,6 @@ void gpte_provider_query_trips_async(
 	g_autoptr(GTask) task = g_task_new(self, cancellable, callback, user_data);
 	GpteProviderQueryTripsData* data = g_new(GpteProviderQueryTripsData, 1);
 	data->from = g_object_ref(from);
-	data->from = g_object_ref(from);
 	data->via = via ? g_object_ref(via) : NULL;
 	data->to = g_object_ref(to);
 	data->date = g_date_time_ref(date);
@@ -395,8 +1317,17 @@ void gpte_provider_query_trips_async(
 	} else {
 		data->has_options = FALSE;
 	}
-	g_task_set_task_data(task, data, (GDestroyNotify)gpte_provider_query_trips_data_free);
-	g_task_run_in_thread(task, (GTaskThreadFunc)gpte_provider_query_trips_thread);
+
+	g_autofree gchar* from_key = gpte_provider_location_key(from);
+	g_autofree gchar* via_key = gpte_provider_location_key(via);
+	g_autofree gchar* to_key = gpte_provider_location_key(to);
+	g_autofree gchar* key = g_strdup_printf("trips\x1e%s\x1f%s\x1f%s\x1f%" G_GINT64_FORMAT "\x1f%d\x1f%d\x1f%d\x1f%d\x1f%d\x1f%d",
+		from_key, via_key, to_key, g_date_time_to_unix(date), request, data->has_options,
+		options ? (gint)options->accessibility : 0, options ? (gint)options->flags : 0,
+		options ? (gint)options->optimize : 0, options ? (gint)options->products : 0,
+		options ? (gint)options->walk_speed : 0);
+	gpte_provider_run_deduplicated(self, task, key, data, (GDestroyNotify)gpte_provider_query_trips_data_free,
+		(GTaskThreadFunc)gpte_provider_query_trips_thread, (GBoxedCopyFunc)gpte_trips_result_copy, (GDestroyNotify)gpte_trips_result_free);
 }
 GpteTripsResult* gpte_provider_query_trips_finish(GpteProvider* self, GAsyncResult* result, GError** error) {
 	g_return_val_if_fail(g_task_is_valid(result, self), NULL);
@@ -404,37 +1335,51 @@ GpteTripsResult* gpte_provider_query_trips_finish(GpteProvider* self, GAsyncResu
 }
 
 
-GListModel* gpte_provider_query_nearby(GpteProvider* self, GpteLocations locations, GpteLocation* location, gint max_dist, gint max, GError** err) {
-	g_return_val_if_fail(GPTE_IS_PROVIDER(self), NULL);
+static GListModel* gpte_provider_query_nearby_upstream(GpteProvider* self, GpteLocations locations, GpteLocation* location, gint max_dist, gint max, gboolean* reached, GError** err) {
+	g_autoptr(GpteLimiterSlot) slot = gpte_provider_acquire_slot(self, err);
+	if (!slot)
+		return NULL;
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 10);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 16);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/NetworkProvider");
-	jmethodID nearby_mid = (*env)->GetMethodID(env, class, "queryNearbyLocations", "(Ljava/util/Set;Lde/schildbach/pte/dto/Location;II)Lde/schildbach/pte/dto/NearbyLocationsResult;");
-
 	jobject jlocations = gpte_locations_to_java(vm, locations);
-	jobject jlocation = gpte_java_object_get(GPTE_JAVA_OBJECT(location));
-	jobject res = (*env)->CallObjectMethod(env, this, nearby_mid, jlocations, jlocation, (jint)max_dist, (jint)max);
-
+	jobject jlocation = gpte_location_to_java(vm, location);
 	if (gpte_jvm_error(vm, err))
 		return NULL;
+	*reached = TRUE;
+	jobject res = gpte_jvm_call_provider(vm, this, vm->jni.network_provider.query_nearby_locations, 4, (jobject[]){
+		jlocations, jlocation, gpte_jvm_box_int(vm, max_dist), gpte_jvm_box_int(vm, max)
+	});
 
-	jclass result_class = (*env)->FindClass(env, "de/schildbach/pte/dto/NearbyLocationsResult");
+	gpte_jvm_timing_query_done(vm);
+	if (gpte_jvm_error(vm, err))
+		return NULL;
 
-	jfieldID status_id = (*env)->GetFieldID(env, result_class, "status", "Lde/schildbach/pte/dto/NearbyLocationsResult$Status;");
-	jobject status = (*env)->GetObjectField(env, res, status_id);
+	jobject status = (*env)->GetObjectField(env, res, vm->jni.nearby_locations_result.status);
 
-	jclass status_class = (*env)->FindClass(env, "de/schildbach/pte/dto/NearbyLocationsResult$Status");
-	if (!(*env)->IsSameObject(env, status, GPTE_PROVIDER_RESULT_STATUS_ENUM_ENTRY(OK, "NearbyLocationsResult"))) {
-		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_ERROR, SERVICE_DOWN, "NearbyLocationsResult", NULL, "Service Down")
-		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_ERROR, INVALID_ID, "NearbyLocationsResult", NULL, "Invalid station identifier")
+	switch (gpte_jni_enum_decode(&vm->jni, env, &vm->jni.nearby_locations_status, status)) {
+		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_ERROR, NEARBY, SERVICE_DOWN, NULL, "Service Down")
+		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_ERROR, NEARBY, INVALID_ID, NULL, "Invalid station identifier")
+		default:
+			break;
 	}
 
-	jfieldID locations_id = (*env)->GetFieldID(env, result_class, "locations", "Ljava/util/List;");
-	jobject locations_list = (*env)->GetObjectField(env, res, locations_id);
+	jobject locations_list = (*env)->GetObjectField(env, res, vm->jni.nearby_locations_result.locations);
 	return gpte_list_new(vm, GPTE_TYPE_LOCATION, locations_list);
 }
+GListModel* gpte_provider_query_nearby(GpteProvider* self, GpteLocations locations, GpteLocation* location, gint max_dist, gint max, GError** err) {
+	g_return_val_if_fail(GPTE_IS_PROVIDER(self), NULL);
+	if (!gpte_provider_breaker_admit(self, err))
+		return NULL;
+	GError* error = NULL;
+	gboolean reached = FALSE;
+	GListModel* ret = gpte_provider_query_nearby_upstream(self, locations, location, max_dist, max, &reached, &error);
+	gpte_provider_breaker_report(self, reached, error);
+	if (error)
+		g_propagate_error(err, error);
+	return ret;
+}
 
 typedef struct {
 	GpteLocations locations;
@@ -447,13 +1392,6 @@ static void gpte_provider_query_nearby_data_free(GpteProviderQueryNearbyData* se
 	g_free(self);
 }
 static void gpte_provider_query_nearby_thread(GTask* task, GpteProvider* self, GpteProviderQueryNearbyData* data, GCancellable*) {
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_autoptr(GpteThreadGuard) guard = gpte_jvm_attach_thread(vm, "gpte-suggest-locations-async");
-	if (!guard) {
-		g_task_return_error(task, g_error_new(GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_THREADING, "Unable to attach thread"));
-		return;
-	}
-
 	GError* err = NULL;
 	GListModel* model = gpte_provider_query_nearby(self, data->locations, data->location, data->max_dist, data->max, &err);
 	if (model)
@@ -477,8 +1415,11 @@ void gpte_provider_query_nearby_async(
 	data->location = g_object_ref(location);
 	data->max_dist = max_dist;
 	data->max = max;
-	g_task_set_task_data(task, data, (GDestroyNotify)gpte_provider_query_nearby_data_free);
-	g_task_run_in_thread(task, (GTaskThreadFunc)gpte_provider_query_nearby_thread);
+
+	g_autofree gchar* location_key = gpte_provider_location_key(location);
+	g_autofree gchar* key = g_strdup_printf("nearby\x1e%d\x1f%s\x1f%d\x1f%d", (gint)locations, location_key, max_dist, max);
+	gpte_provider_run_deduplicated(self, task, key, data, (GDestroyNotify)gpte_provider_query_nearby_data_free,
+		(GTaskThreadFunc)gpte_provider_query_nearby_thread, (GBoxedCopyFunc)gpte_provider_result_list_copy, g_object_unref);
 }
 
 GListModel* gpte_provider_query_nearby_finish(GpteProvider* self, GAsyncResult* result, GError** error) {
@@ -487,35 +1428,48 @@ GListModel* gpte_provider_query_nearby_finish(GpteProvider* self, GAsyncResult*
 }
 
 
-GListModel* gpte_provider_suggest_locations(GpteProvider* self, const gchar* constraint, GpteLocations locations, gint max, GError** err) {
-	g_return_val_if_fail(GPTE_IS_PROVIDER(self), NULL);
+static GListModel* gpte_provider_suggest_locations_upstream(GpteProvider* self, const gchar* constraint, GpteLocations locations, gint max, gboolean* reached, GError** err) {
+	g_autoptr(GpteLimiterSlot) slot = gpte_provider_acquire_slot(self, err);
+	if (!slot)
+		return NULL;
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
 	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 7);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/NetworkProvider");
-	jmethodID suggest_mid = (*env)->GetMethodID(env, class, "suggestLocations", "(Ljava/lang/CharSequence;Ljava/util/Set;I)Lde/schildbach/pte/dto/SuggestLocationsResult;");
 	jstring jconstraint = (*env)->NewStringUTF(env, constraint);
 	jobject types = gpte_locations_to_java(vm, locations);
-	jobject result = (*env)->CallObjectMethod(env, this, suggest_mid, jconstraint, types, max);
+	*reached = TRUE;
+	jobject result = gpte_jvm_call_provider(vm, this, vm->jni.network_provider.suggest_locations, 3, (jobject[]){
+		jconstraint, types, gpte_jvm_box_int(vm, max)
+	});
 
+	gpte_jvm_timing_query_done(vm);
 	if (gpte_jvm_error(vm, err))
 		return NULL;
 
-	jclass result_class = (*env)->FindClass(env, "de/schildbach/pte/dto/SuggestLocationsResult");
-
-	jfieldID status_id = (*env)->GetFieldID(env, result_class, "status", "Lde/schildbach/pte/dto/SuggestLocationsResult$Status;");
-	jobject status = (*env)->GetObjectField(env, result, status_id);
+	jobject status = (*env)->GetObjectField(env, result, vm->jni.suggest_locations_result.status);
 
-	jclass status_class = (*env)->FindClass(env, "de/schildbach/pte/dto/SuggestLocationsResult$Status");
-	if (!(*env)->IsSameObject(env, status, GPTE_PROVIDER_RESULT_STATUS_ENUM_ENTRY(OK, "SuggestLocationsResult"))) {
-		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_ERROR, SERVICE_DOWN, "SuggestLocationsResult", NULL, "Service Down")
+	switch (gpte_jni_enum_decode(&vm->jni, env, &vm->jni.suggest_locations_status, status)) {
+		GPTE_PROVIDER_RESULT_STATUS_PROPAGTE_ERROR(GPTE_PTE_ERROR, SUGGEST, SERVICE_DOWN, NULL, "Service Down")
+		default:
+			break;
 	}
 
-	jmethodID loc_mid = (*env)->GetMethodID(env, result_class, "getLocations", "()Ljava/util/List;");
-	jobject locations_list = (*env)->CallObjectMethod(env, result, loc_mid);
+	jobject locations_list = (*env)->CallObjectMethod(env, result, vm->jni.suggest_locations_result.get_locations);
 	return gpte_list_new(vm, GPTE_TYPE_LOCATION, locations_list);
 }
+GListModel* gpte_provider_suggest_locations(GpteProvider* self, const gchar* constraint, GpteLocations locations, gint max, GError** err) {
+	g_return_val_if_fail(GPTE_IS_PROVIDER(self), NULL);
+	if (!gpte_provider_breaker_admit(self, err))
+		return NULL;
+	GError* error = NULL;
+	gboolean reached = FALSE;
+	GListModel* ret = gpte_provider_suggest_locations_upstream(self, constraint, locations, max, &reached, &error);
+	gpte_provider_breaker_report(self, reached, error);
+	if (error)
+		g_propagate_error(err, error);
+	return ret;
+}
 
 typedef struct {
 	gchar* constraint;
@@ -527,13 +1481,6 @@ static void gpte_provider_suggest_locations_data_free(GpteProviderSuggestLocatio
 	g_free(self);
 }
 static void gpte_provider_suggest_locations_thread(GTask* task, GpteProvider* self, GpteProviderSuggestLocationsData* data, GCancellable*) {
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_autoptr(GpteThreadGuard) guard = gpte_jvm_attach_thread(vm, "gpte-suggest-locations-async");
-	if (!guard) {
-		g_task_return_error(task, g_error_new(GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_THREADING, "Unable to attach thread"));
-		return;
-	}
-
 	GError* err = NULL;
 	GListModel* model = gpte_provider_suggest_locations(self, data->constraint, data->locations, data->max, &err);
 	if (model)
@@ -555,8 +1502,11 @@ void gpte_provider_suggest_locations_async(
 	data->constraint = constraint ? g_strdup(constraint) : NULL;
 	data->locations = locations;
 	data->max = max;
-	g_task_set_task_data(task, data, (GDestroyNotify)gpte_provider_suggest_locations_data_free);
-	g_task_run_in_thread(task, (GTaskThreadFunc)gpte_provider_suggest_locations_thread);
+	g_task_set_priority(task, G_PRIORITY_HIGH);
+
+	g_autofree gchar* key = g_strdup_printf("suggest\x1e%d\x1f%d\x1f%c%s", (gint)locations, max, constraint ? '=' : '!', constraint ? constraint : "");
+	gpte_provider_run_deduplicated(self, task, key, data, (GDestroyNotify)gpte_provider_suggest_locations_data_free,
+		(GTaskThreadFunc)gpte_provider_suggest_locations_thread, (GBoxedCopyFunc)gpte_provider_result_list_copy, g_object_unref);
 }
 
 GListModel* gpte_provider_suggest_locations_finish(GpteProvider* self, GAsyncResult* result, GError** error) {
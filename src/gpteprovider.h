@@ -58,6 +58,10 @@ typedef enum {
 /**
  * GpteQueryDeparturesFlags:
  * @GPTE_QUERY_DEPARTURES_QUERY_EQUIVS: also query equivalent stations
+ * @GPTE_QUERY_DEPARTURES_EAGER: Read the times, lines, destinations,
+ *   positions and messages of all departures of a station with a single
+ *   call when they are first accessed, instead of one call per getter.
+ *   Not passed to the provider.
  *
  * Additional query parameters for [method@Gpte.Provider.query_departures].
  */
@@ -67,7 +71,8 @@ GType gpte_query_departures_flags_get_type(void);
 
 typedef enum {
 	GPTE_QUERY_DEPARTURES_NONE = 0,
-	GPTE_QUERY_DEPARTURES_QUERY_EQUIVS = 1 << 0
+	GPTE_QUERY_DEPARTURES_QUERY_EQUIVS = 1 << 0,
+	GPTE_QUERY_DEPARTURES_EAGER = 1 << 1
 } GpteQueryDeparturesFlags;
 
 
@@ -101,6 +106,26 @@ typedef enum {
 #define GPTE_TYPE_PROVIDER (gpte_provider_get_type())
 G_DECLARE_FINAL_TYPE (GpteProvider, gpte_provider, GPTE, PROVIDER, GpteJavaObject)
 
+/**
+ * GpteProviderHealth:
+ * @GPTE_PROVIDER_HEALTH_HEALTHY: queries are sent to the provider
+ * @GPTE_PROVIDER_HEALTH_DOWN: the provider failed repeatedly, queries
+ *   fail immediately with %GPTE_PTE_ERROR_SERVICE_DOWN
+ * @GPTE_PROVIDER_HEALTH_PROBING: the provider was down, a single query
+ *   is let through to check whether it recovered
+ *
+ * Health of a provider, as tracked by its circuit breaker.
+ */
+
+#define GPTE_TYPE_PROVIDER_HEALTH (gpte_provider_health_get_type())
+GType gpte_provider_health_get_type(void);
+
+typedef enum {
+	GPTE_PROVIDER_HEALTH_HEALTHY,
+	GPTE_PROVIDER_HEALTH_DOWN,
+	GPTE_PROVIDER_HEALTH_PROBING
+} GpteProviderHealth;
+
 /**
  * gpte_provider_get_id:
  * @self: the transportation network
@@ -111,6 +136,86 @@ G_DECLARE_FINAL_TYPE (GpteProvider, gpte_provider, GPTE, PROVIDER, GpteJavaObjec
  */
 const gchar* gpte_provider_get_id(GpteProvider* self);
 
+/**
+ * gpte_provider_get_health:
+ * @self: the transportation network
+ *
+ * Gets the current health of @self.
+ *
+ * Changes are notified through [property@Gpte.Provider:health] on
+ * the thread-default main context @self was created on.
+ *
+ * Returns: the health of the provider
+ */
+GpteProviderHealth gpte_provider_get_health(GpteProvider* self);
+
+/**
+ * gpte_provider_set_circuit_breaker:
+ * @self: the transportation network
+ * @threshold: consecutive failures after which the provider is
+ *   considered down, or 0 to disable the circuit breaker
+ * @cooldown: seconds to fail queries immediately before probing the
+ *   provider again
+ *
+ * Configures the circuit breaker of @self. Only %GPTE_PTE_ERROR_SERVICE_DOWN
+ * and %GPTE_JAVA_ERROR_IO_EXCEPTION count as failures, any other result
+ * proves the provider is reachable.
+ *
+ * Defaults to 5 failures and a cooldown of 30 seconds.
+ */
+void gpte_provider_set_circuit_breaker(GpteProvider* self, guint threshold, guint cooldown);
+
+/**
+ * gpte_provider_set_rate_limit:
+ * @self: the transportation network
+ * @rate: requests per second, or 0 for no rate limit
+ * @burst: number of requests that may be issued at once after being idle
+ * @max_in_flight: maximum number of concurrent requests, or 0 for no limit
+ *
+ * Limits the requests sent to the endpoint of @self. The limit applies
+ * to every provider with the same identifier, regardless of the thread
+ * or [class@Gpte.Jvm] they are used from.
+ *
+ * Asynchronous queries exceeding the limit are only handed to a worker
+ * thread once they are admitted, they don't occupy one while waiting.
+ * Synchronous queries block the calling thread until they are admitted.
+ * Queued queries are admitted by the priority of their [class@Gio.Task]
+ * (and in order within the same priority), synchronous ones count as
+ * %G_PRIORITY_DEFAULT.
+ *
+ * There is no limit by default.
+ */
+void gpte_provider_set_rate_limit(GpteProvider* self, gdouble rate, guint burst, guint max_in_flight);
+
+/**
+ * gpte_provider_get_queue_stats:
+ * @self: the transportation network
+ * @queued: (out) (optional): number of queries waiting to be admitted
+ * @in_flight: (out) (optional): number of queries currently running
+ * @mean_wait: (out) (optional): mean time in microseconds queries had
+ *  to wait before being admitted
+ * @max_wait: (out) (optional): longest time in microseconds a query had
+ *  to wait before being admitted
+ *
+ * Reports the state of the rate limit shared by all providers with the
+ * same identifier as @self.
+ */
+void gpte_provider_get_queue_stats(GpteProvider* self, guint* queued, guint* in_flight, gint64* mean_wait, gint64* max_wait);
+
+/**
+ * gpte_provider_get_style_stats:
+ * @self: the transportation network
+ * @hits: (out) (optional): number of line styles served from the cache
+ * @misses: (out) (optional): number of line styles that had to be
+ *  resolved through the JVM
+ * @n_styles: (out) (optional): number of distinct styles in the cache
+ *
+ * Reports the use of the line style cache of @self. Styles are cached
+ * by network, product and label for [method@Gpte.Provider.line_style]
+ * and for the lines of results returned by @self.
+ */
+void gpte_provider_get_style_stats(GpteProvider* self, guint* hits, guint* misses, guint* n_styles);
+
 /**
  * gpte_provider_default_products:
  * @self: the transportation network
@@ -127,6 +232,9 @@ GpteProducts gpte_provider_default_products(GpteProvider* self);
  *
  * Check if the specific transporation network provider supports a
  * particular set of capabilities.
+ *
+ * Capabilities, default products and area are read from the JVM once,
+ * on the first call to any of these functions.
  * Returns: %TRUE if the network supports all the capabilites, %FALSE if not
  */
 gboolean gpte_provider_has_capabilities(GpteProvider* self, GpteProviderCapabilities capabilities);
@@ -138,8 +246,11 @@ gboolean gpte_provider_has_capabilities(GpteProvider* self, GpteProviderCapabili
  *
  * Gets the primary covered area of the particular transportation
  * network.
- * Returns: (transfer full) (array length=len):
- * 	array containing points of a polygon (special case: just one coordinate defines just a center point)
+ *
+ * Areas known at build time are returned without calling into the JVM.
+ * Returns: (transfer full) (array length=len) (nullable):
+ * 	array containing points of a polygon (special case: just one coordinate defines just a center point),
+ * 	or %NULL if the network doesn't declare its area
  */
 GpteGeoPoint* gpte_provider_get_area(GpteProvider* self, gsize* len);
 
@@ -150,7 +261,8 @@ GpteGeoPoint* gpte_provider_get_area(GpteProvider* self, gsize* len);
  * @product: (nullable): line product to get style of,
  * @label: (nullable): line label to get style of
  *
- * Get style of line
+ * Get style of line. Styles are cached per provider, so only the first
+ * lookup of a line calls into the JVM.
  * Returns: (transfer full): style containing background, foreground and optional border colors
  */
 GpteStyle* gpte_provider_line_style(GpteProvider* self, const gchar* network, GpteProductCode product, const gchar* label);
@@ -214,6 +326,110 @@ void gpte_provider_query_departures_async(
  */
 GListModel* gpte_provider_query_departures_finish(GpteProvider* self, GAsyncResult* result, GError** error);
 
+/**
+ * GpteDeparturesFunc:
+ * @self: the transportation network
+ * @id: identifier of the station
+ * @departures: (nullable): list of departures as a #GListModel of
+ *  [class@Gpte.StationDepartures], or %NULL on error
+ * @error: (nullable): the error querying @id, or %NULL on success
+ * @user_data: user data passed to
+ *  gpte_provider_query_departures_many_async()
+ *
+ * Receives the departures of a single station of a batch query.
+ */
+typedef void (*GpteDeparturesFunc)(GpteProvider* self, const gchar* id, GListModel* departures, const GError* error, gpointer user_data);
+
+/**
+ * gpte_provider_query_departures_many_async:
+ * @self: the transportation network
+ * @ids: (array zero-terminated=1): identifiers of the stations
+ * @time: (nullable): desired time for departing, or %NULL for the
+ *  provider default
+ * @max: maximum number of departures to get per station or 0,
+ * @flags: additional parameters for the query
+ * @cancellable: (nullable): optional #GCancellable object, %NULL to
+ *  ignore
+ * @func: (scope notified) (closure func_data): a #GpteDeparturesFunc to
+ *  call for every station as soon as its departures arrive
+ * @func_data: the data to pass to @func
+ * @func_destroy: (destroy func_data): destroy notify for @func_data
+ * @callback: (scope async) (closure user_data): a #GAsyncReadyCallback
+ *  to call when all stations have been queried
+ * @user_data: the data to pass to callback function
+ *
+ * Asynchronously gets departures at many stations.
+ *
+ * All batches of @self together query at most as many stations at once
+ * as set with [method@Gpte.Provider.set_batch_parallelism], taking
+ * turns once the limit is reached.
+ * Failing stations are reported to @func with their error and do not
+ * abort the remaining ones.
+ */
+void gpte_provider_query_departures_many_async(
+	GpteProvider* self,
+	const gchar* const* ids,
+	GDateTime* time,
+	gint max,
+	GpteQueryDeparturesFlags flags,
+	GCancellable* cancellable,
+	GpteDeparturesFunc func, gpointer func_data, GDestroyNotify func_destroy,
+	GAsyncReadyCallback callback, gpointer user_data
+);
+/**
+ * gpte_provider_query_departures_many_finish:
+ * @self: the transportation network
+ * @result: a #GAsyncResult
+ * @error: a #GError, or %NULL
+ *
+ * Finishes an asynchronous departure query started with
+ * gpte_provider_query_departures_many_async().
+ *
+ * Returns: %TRUE once every station was reported, %FALSE if the batch
+ *  was cancelled
+ */
+gboolean gpte_provider_query_departures_many_finish(GpteProvider* self, GAsyncResult* result, GError** error);
+
+/**
+ * gpte_provider_set_batch_parallelism:
+ * @self: the transportation network
+ * @parallelism: maximum number of concurrent batch queries
+ *
+ * Limits how many stations all running
+ * gpte_provider_query_departures_many_async() batches of @self query at
+ * once. Defaults to 4.
+ */
+void gpte_provider_set_batch_parallelism(GpteProvider* self, guint parallelism);
+
+/**
+ * gpte_provider_set_departures_cache:
+ * @self: the transportation network
+ * @ttl: seconds results stay fresh, or 0 to disable the cache
+ * @stale: seconds expired results are still served while they are
+ *   refreshed in the background
+ *
+ * Enables caching of [method@Gpte.Provider.query_departures] results,
+ * keyed by station, time (per minute), maximum and flags.
+ *
+ * While the cache is enabled, results are [class@Gio.ListStore]s of
+ * detached items (see [method@Gpte.JavaObject.snapshot]). Every call
+ * returns its own store, the items in it are shared between callers.
+ * At most 64 results are kept, the oldest one is dropped for a new one.
+ *
+ * The cache is disabled by default.
+ */
+void gpte_provider_set_departures_cache(GpteProvider* self, guint ttl, guint stale);
+
+/**
+ * gpte_provider_get_departures_cache_stats:
+ * @self: the transportation network
+ * @hits: (out) (optional): number of queries answered from the cache
+ * @misses: (out) (optional): number of queries that went upstream
+ *
+ * Reports the effectiveness of the departures cache.
+ */
+void gpte_provider_get_departures_cache_stats(GpteProvider* self, guint* hits, guint* misses);
+
 /**
  * gpte_provider_query_trips:
  * @self: the transportation network
@@ -228,6 +444,10 @@ GListModel* gpte_provider_query_departures_finish(GpteProvider* self, GAsyncResu
  *
  * Query trips, asking for any ambiguousnesses.
  *
+ * Any of the locations may be a snapshot (see
+ * [method@Gpte.JavaObject.snapshot]), it is turned back into a Java
+ * object from its fields for the query.
+ *
  * Ought to throw exceptions from the [error@Gpte.PteError],
  * [error@Gpte.PteTripsError] or [error@Gpte.JavaError] domain.
  *
@@ -292,6 +512,8 @@ GpteTripsResult* gpte_provider_query_trips_finish(GpteProvider* self, GAsyncResu
  * Find locations near to given location.
  *
  * At least one of lat/lon pair or station id must be present in that location.
+ * A snapshot (see [method@Gpte.JavaObject.snapshot]) is turned back into
+ * a Java object from its fields for the query.
  *
  * Ought to throw exceptions from the [error@Gpte.PteError] or
  * [error@Gpte.JavaError] domain.
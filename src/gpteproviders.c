@@ -19,153 +19,466 @@
 #include "gpteproviders.h"
 #include "gpteprovider-priv.h"
 
-#define GPTE_CREATE_NAVITIA_PROVIDER_FUN(name, class) \
+#include <math.h>
+#include <string.h>
+
+// BEGIN GPTE PROVIDERS SECTION
+
+// kind of the gpte_create function, id, Java class and whether gpte-gtk
+// ships an icon; the registry and the gpte_create functions are both
+// expanded from this list, providersgen.sh generates the header from it
+#define GPTE_PROVIDERS(X) \
+	X(NAVITIA, australia, "AustraliaProvider", NO_ICON) \
+	X(HAFAS, avv_aachen, "AvvAachenProvider", ICON) \
+	X(HAFAS, avv_augsburg, "AvvAugsburgProvider", ICON) \
+	X(HAFAS, bart, "BartProvider", ICON) \
+	X(EFA, bayern, "BayernProvider", ICON) \
+	X(NAVITIA, brazil, "BrazilProvider", NO_ICON) \
+	X(NAVITIA, british_columbia, "BritishColumbiaProvider", NO_ICON) \
+	X(EFA, bsvag, "BsvagProvider", ICON) \
+	X(HAFAS, bvg, "BvgProvider", ICON) \
+	X(HAFAS, cmta, "CmtaProvider", ICON) \
+	X(NAVITIA, czech_republic, "CzechRepublicProvider", NO_ICON) \
+	X(HAFAS_COMPLEX, db, "DbProvider", ICON) \
+	X(EFA, ding, "DingProvider", ICON) \
+	X(HAFAS, dsb, "DsbProvider", ICON) \
+	X(EFA, dub, "DubProvider", NO_ICON) \
+	X(HAFAS_LEGACY, eireann, "EireannProvider", NO_ICON) \
+	X(NAVITIA, finland, "FinlandProvider", NO_ICON) \
+	X(NAVITIA, france_ne, "FranceNorthEastProvider", ICON) \
+	X(NAVITIA, france_nw, "FranceNorthWestProvider", ICON) \
+	X(NAVITIA, france_se, "FranceSouthEastProvider", ICON) \
+	X(NAVITIA, france_sw, "FranceSouthWestProvider", ICON) \
+	X(NAVITIA, ghana, "GhanaProvider", NO_ICON) \
+	X(EFA, gvh, "GvhProvider", ICON) \
+	X(HAFAS_COMPLEX, invg, "InvgProvider", ICON) \
+	X(NAVITIA, italy, "ItalyProvider", ICON) \
+	X(EFA, kvv, "KvvProvider", ICON) \
+	X(EFA, linz, "LinzProvider", NO_ICON) \
+	X(HAFAS, lu, "LuProvider", NO_ICON) \
+	X(NAVITIA, massachusetts, "MassachusettsProvider", NO_ICON) \
+	X(EFA, mersey, "MerseyProvider", NO_ICON) \
+	X(EFA, mvg, "MvgProvider", ICON) \
+	X(EFA, mvv, "MvvProvider", ICON) \
+	X(HAFAS, nasa, "NasaProvider", ICON) \
+	X(LANGUAGE, negentwee, "NegentweeProvider", ICON) \
+	X(NAVITIA, nicaragua, "NicaraguaProvider", NO_ICON) \
+	X(HAFAS_LEGACY, ns, "NsProvider", NO_ICON) \
+	X(EFA, nvbw, "NvbwProvider", ICON) \
+	X(HAFAS, nvv, "NvvProvider", ICON) \
+	X(NAVITIA, nz, "NzProvider", NO_ICON) \
+	X(HAFAS, oebb, "OebbProvider", ICON) \
+	X(NAVITIA, ontario, "OntarioProvider", NO_ICON) \
+	X(HAFAS, ooevv, "OoevvProvider", ICON) \
+	X(NAVITIA, oregon, "OregonProvider", NO_ICON) \
+	X(NAVITIA, paris, "ParisProvider", NO_ICON) \
+	X(HAFAS, pl, "PlProvider", NO_ICON) \
+	X(NAVITIA, pl_navitia, "PlNavitiaProvider", NO_ICON) \
+	X(NAVITIA, quebec, "QuebecProvider", ICON) \
+	X(HAFAS_LEGACY, rt, "RtProvider", NO_ICON) \
+	X(EFA, rta_chicago, "RtaChicagoProvider", NO_ICON) \
+	X(HAFAS, se, "SeProvider", NO_ICON) \
+	X(HAFAS, sh, "ShProvider", ICON) \
+	X(NAVITIA, spain, "SpainProvider", ICON) \
+	X(EFA, stv, "StvProvider", ICON) \
+	X(HAFAS, svv, "SvvProvider", NO_ICON) \
+	X(EFA, sydney, "SydneyProvider", ICON) \
+	X(EFA, tlem, "TlemProvider", NO_ICON) \
+	X(HAFAS, vao, "VaoProvider", NO_ICON) \
+	X(HAFAS_COMPLEX, vbb, "VbbProvider", ICON) \
+	X(EFA, vbl, "VblProvider", ICON) \
+	X(HAFAS_COMPLEX, vbn, "VbnProvider", ICON) \
+	X(EFA, vgn, "VgnProvider", ICON) \
+	X(HAFAS_COMPLEX, vgs, "VgsProvider", ICON) \
+	X(HAFAS, vmobil, "VmobilProvider", ICON) \
+	X(HAFAS, vmt, "VmtProvider", NO_ICON) \
+	X(EFA, vmv, "VmvProvider", ICON) \
+	X(HAFAS, vor, "VorProvider", ICON) \
+	X(EFA, vrn, "VrnProvider", ICON) \
+	X(EFA, vrr, "VrrProvider", ICON) \
+	X(CLIENT_CERTIFICATE, vrs, "VrsProvider", ICON) \
+	X(EFA, vvm, "VvmProvider", ICON) \
+	X(EFA, vvo, "VvoProvider", ICON) \
+	X(EFA, vvs, "VvsProvider", ICON) \
+	X(HAFAS, vvt, "VvtProvider", ICON) \
+	X(EFA, vvv, "VvvProvider", ICON) \
+	X(EFA, wien, "WienProvider", ICON) \
+	X(HAFAS, zvv, "ZvvProvider", ICON)
+
+// END GPTE PROVIDERS SECTION
+
+#define GPTE_PROVIDER_KIND_NAVITIA GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION
+#define GPTE_PROVIDER_KIND_HAFAS GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION
+#define GPTE_PROVIDER_KIND_HAFAS_COMPLEX GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION_SALT
+#define GPTE_PROVIDER_KIND_HAFAS_LEGACY GPTE_PROVIDER_CONSTRUCTOR_PLAIN
+#define GPTE_PROVIDER_KIND_EFA GPTE_PROVIDER_CONSTRUCTOR_PLAIN
+#define GPTE_PROVIDER_KIND_CLIENT_CERTIFICATE GPTE_PROVIDER_CONSTRUCTOR_CLIENT_CERTIFICATE
+#define GPTE_PROVIDER_KIND_LANGUAGE GPTE_PROVIDER_CONSTRUCTOR_LANGUAGE
+
+// resource path, only available when linking gpte-gtk
+#define GPTE_PROVIDER_ICON_ICON(id) "/arpa/sp1rit/gpte/gtk/networks/" #id ".svg"
+#define GPTE_PROVIDER_ICON_NO_ICON(id) NULL
+
+#define GPTE_PROVIDER_REGISTRY_ENTRY(kind, id, class, icon) \
+	{ #id, "de/schildbach/pte/" class, GPTE_PROVIDER_KIND_##kind, GPTE_PROVIDER_ICON_##icon(id) },
+
+static const struct {
+	const gchar* id;
+	const gchar* class_name;
+	GpteProviderConstructor constructor;
+	const gchar* icon;
+} gpte_provider_registry[] = {
+	GPTE_PROVIDERS(GPTE_PROVIDER_REGISTRY_ENTRY)
+};
+
+#define GPTE_PROVIDER_REGISTRY_INDEX(kind, id, class, icon) GPTE_PROVIDER_INDEX_##id,
+
+enum {
+	GPTE_PROVIDERS(GPTE_PROVIDER_REGISTRY_INDEX)
+};
+
+static gssize gpte_provider_registry_index(const gchar* id) {
+	for (gsize i = 0; i < G_N_ELEMENTS(gpte_provider_registry); i++)
+		if (g_strcmp0(gpte_provider_registry[i].id, id) == 0)
+			return i;
+	return -1;
+}
+
+const gchar* gpte_provider_class_name(const gchar* id) {
+	gssize index = gpte_provider_registry_index(id);
+	return index < 0 ? NULL : gpte_provider_registry[index].class_name;
+}
+
+static const gchar* gpte_provider_constructor_signatures[] = {
+	[GPTE_PROVIDER_CONSTRUCTOR_PLAIN] = "()V",
+	[GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION] = "(Ljava/lang/String;)V",
+	[GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION_SALT] = "(Ljava/lang/String;[B)V",
+	[GPTE_PROVIDER_CONSTRUCTOR_CLIENT_CERTIFICATE] = "([B)V",
+	[GPTE_PROVIDER_CONSTRUCTOR_LANGUAGE] = "(Lde/schildbach/pte/NegentweeProvider$Language;)V"
+};
+
+// resolves the class and constructor of a provider once per JVM
+static const GpteJvmProviderClass* gpte_provider_registry_resolve(GpteJvm* vm, JNIEnv* env, gsize index, GError** err) {
+	g_mutex_lock(&vm->registry_lock);
+	GpteJvmProviderClass* cached = g_hash_table_lookup(vm->provider_classes, gpte_provider_registry[index].id);
+	if (cached) {
+		g_mutex_unlock(&vm->registry_lock);
+		return cached;
+	}
+
+	const gchar* class_name = gpte_provider_registry[index].class_name;
+	jclass local = (*env)->FindClass(env, class_name);
+	jmethodID constructor = local ? (*env)->GetMethodID(env, local, "<init>", gpte_provider_constructor_signatures[gpte_provider_registry[index].constructor]) : NULL;
+	if (!constructor) {
+		(*env)->ExceptionClear(env);
+		g_mutex_unlock(&vm->registry_lock);
+		g_set_error(err, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_UNHANLED_EXCEPTION, "Unable to resolve the constructor of %s", class_name);
+		return NULL;
+	}
+
+	cached = g_new(GpteJvmProviderClass, 1);
+	cached->class = (*env)->NewGlobalRef(env, local);
+	cached->constructor = constructor;
+	(*env)->DeleteLocalRef(env, local);
+	// released together with the rest of the JNI registry
+	g_ptr_array_add(vm->jni.global_refs, cached->class);
+	g_hash_table_insert(vm->provider_classes, (gpointer)gpte_provider_registry[index].id, cached);
+	g_mutex_unlock(&vm->registry_lock);
+	return cached;
+}
+
+static jobject gpte_provider_negentwee_language(JNIEnv* env, GpteNegentweeLanguage language) {
+	jclass language_class = (*env)->FindClass(env, "de/schildbach/pte/NegentweeProvider$Language");
+	const gchar* name = language == GPTE_NEGENTWEE_LANG_NL_NL ? "NL_NL" : "EN_GB";
+	return (*env)->GetStaticObjectField(env, language_class, (*env)->GetStaticFieldID(env, language_class, name, "Lde/schildbach/pte/NegentweeProvider$Language;"));
+}
+
+static GpteProvider* gpte_provider_registry_construct(GpteJvm* vm, gsize index, const GpteProviderCredentials* credentials, GError** err) {
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 6);
+	const GpteJvmProviderClass* cls = gpte_provider_registry_resolve(vm, env, index, err);
+	if (!cls)
+		return NULL;
+
+	static const GpteProviderCredentials none = { 0 };
+	if (!credentials)
+		credentials = &none;
+
+	jobject object = NULL;
+	switch (gpte_provider_registry[index].constructor) {
+		case GPTE_PROVIDER_CONSTRUCTOR_PLAIN:
+			object = (*env)->NewObject(env, cls->class, cls->constructor);
+			break;
+		case GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION: {
+			jstring authorization = credentials->authorization ? (*env)->NewStringUTF(env, credentials->authorization) : NULL;
+			object = (*env)->NewObject(env, cls->class, cls->constructor, authorization);
+			break;
+		}
+		case GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION_SALT: {
+			jstring authorization = credentials->authorization ? (*env)->NewStringUTF(env, credentials->authorization) : NULL;
+			jbyteArray salt = (*env)->NewByteArray(env, credentials->data_len);
+			(*env)->SetByteArrayRegion(env, salt, 0, credentials->data_len, (const jbyte*)credentials->data);
+			object = (*env)->NewObject(env, cls->class, cls->constructor, authorization, salt);
+			break;
+		}
+		case GPTE_PROVIDER_CONSTRUCTOR_CLIENT_CERTIFICATE: {
+			jbyteArray cert = (*env)->NewByteArray(env, credentials->data_len);
+			(*env)->SetByteArrayRegion(env, cert, 0, credentials->data_len, (const jbyte*)credentials->data);
+			object = (*env)->NewObject(env, cls->class, cls->constructor, cert);
+			break;
+		}
+		case GPTE_PROVIDER_CONSTRUCTOR_LANGUAGE:
+			object = (*env)->NewObject(env, cls->class, cls->constructor, gpte_provider_negentwee_language(env, credentials->language));
+			break;
+	}
+
+	if (gpte_jvm_error(vm, err))
+		return NULL;
+	return gpte_provider_new(gpte_provider_registry[index].id, vm, object);
+}
+
+static GpteProvider* gpte_provider_registry_construct_or_warn(GpteJvm* vm, gsize index, const GpteProviderCredentials* credentials) {
+	g_autoptr(GError) err = NULL;
+	GpteProvider* provider = gpte_provider_registry_construct(vm, index, credentials, &err);
+	if (!provider)
+		g_critical("Unable to create provider %s: %s", gpte_provider_registry[index].id, err->message);
+	return provider;
+}
+
+#define GPTE_CREATE_NAVITIA_PROVIDER_FUN(name) \
 	GpteProvider* gpte_create_##name##_provider(GpteJvm* vm, const gchar* authorization) { \
-		g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 4); \
-		jclass provider_class = (*env)->FindClass(env, "de/schildbach/pte/" class); \
-		jmethodID constructor = (*env)->GetMethodID(env, provider_class, "<init>", "(Ljava/lang/String;)V"); \
-		jstring authorization_str = (*env)->NewStringUTF(env, authorization); \
-		jobject object = (*env)->NewObject(env, provider_class, constructor, authorization_str); \
-		return gpte_provider_new(#name, vm, object); \
-	}
-#define GPTE_CREATE_HAFAS_PROVIDER_FUN(name, class) \
+		return gpte_provider_registry_construct_or_warn(vm, GPTE_PROVIDER_INDEX_##name, &(GpteProviderCredentials){ .authorization = authorization }); \
+	}
+#define GPTE_CREATE_HAFAS_PROVIDER_FUN(name) \
 	GpteProvider* gpte_create_##name##_provider(GpteJvm* vm, const gchar* api_authorization) { \
-		g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 4); \
-		jclass provider_class = (*env)->FindClass(env, "de/schildbach/pte/" class); \
-		jmethodID constructor = (*env)->GetMethodID(env, provider_class, "<init>", "(Ljava/lang/String;)V"); \
-		jstring authorization_str = (*env)->NewStringUTF(env, api_authorization); \
-		jobject object = (*env)->NewObject(env, provider_class, constructor, authorization_str); \
-		return gpte_provider_new(#name, vm, object); \
-	}
-#define GPTE_CREATE_EFA_PROVIDER_FUN(name, class) \
+		return gpte_provider_registry_construct_or_warn(vm, GPTE_PROVIDER_INDEX_##name, &(GpteProviderCredentials){ .authorization = api_authorization }); \
+	}
+#define GPTE_CREATE_EFA_PROVIDER_FUN(name) \
 	GpteProvider* gpte_create_##name##_provider(GpteJvm* vm) { \
-		g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3); \
-		jclass provider_class = (*env)->FindClass(env, "de/schildbach/pte/" class); \
-		jmethodID constructor = (*env)->GetMethodID(env, provider_class, "<init>", "()V"); \
-		jobject object = (*env)->NewObject(env, provider_class, constructor); \
-		return gpte_provider_new(#name, vm, object); \
+		return gpte_provider_registry_construct_or_warn(vm, GPTE_PROVIDER_INDEX_##name, NULL); \
 	}
-#define GPTE_CREATE_HAFAS_COMPLEX_PROVIDER_FUN(name, class) \
+#define GPTE_CREATE_HAFAS_COMPLEX_PROVIDER_FUN(name) \
 	GpteProvider* gpte_create_##name##_provider(GpteJvm* vm, const gchar* api_authorization, const guchar* salt, gsize salt_len) { \
-		g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 5); \
-		jclass provider_class = (*env)->FindClass(env, "de/schildbach/pte/" class); \
-		jmethodID constructor = (*env)->GetMethodID(env, provider_class, "<init>", "(Ljava/lang/String;[B)V"); \
-		jstring authorization_str = (*env)->NewStringUTF(env, api_authorization); \
-		jbyteArray jsalt = (*env)->NewByteArray(env, salt_len); \
-		(*env)->SetByteArrayRegion(env, jsalt, 0, salt_len, (const jbyte*)salt); \
-		jobject object = (*env)->NewObject(env, provider_class, constructor, authorization_str, jsalt); \
-		return gpte_provider_new(#name, vm, object); \
-	}
-#define GPTE_CREATE_HAFAS_LEGACY_PROVIDER_FUN(name, class) \
-	GpteProvider* gpte_create_##name##_provider(GpteJvm* vm) { \
-		g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3); \
-		jclass provider_class = (*env)->FindClass(env, "de/schildbach/pte/" class); \
-		jmethodID constructor = (*env)->GetMethodID(env, provider_class, "<init>", "()V"); \
-		jobject object = (*env)->NewObject(env, provider_class, constructor); \
-		return gpte_provider_new(#name, vm, object); \
+		return gpte_provider_registry_construct_or_warn(vm, GPTE_PROVIDER_INDEX_##name, &(GpteProviderCredentials){ .authorization = api_authorization, .data = salt, .data_len = salt_len }); \
+	}
+#define GPTE_CREATE_HAFAS_LEGACY_PROVIDER_FUN(name) GPTE_CREATE_EFA_PROVIDER_FUN(name)
+#define GPTE_CREATE_CLIENT_CERTIFICATE_PROVIDER_FUN(name) \
+	GpteProvider* gpte_create_##name##_provider(GpteJvm* vm, const guchar* client_cert, gsize client_cert_len) { \
+		return gpte_provider_registry_construct_or_warn(vm, GPTE_PROVIDER_INDEX_##name, &(GpteProviderCredentials){ .data = client_cert, .data_len = client_cert_len }); \
+	}
+#define GPTE_CREATE_LANGUAGE_PROVIDER_FUN(name) \
+	GpteProvider* gpte_create_##name##_provider(GpteJvm* vm, GpteNegentweeLanguage language) { \
+		return gpte_provider_registry_construct_or_warn(vm, GPTE_PROVIDER_INDEX_##name, &(GpteProviderCredentials){ .language = language }); \
 	}
 
-// BEGIN GPTE PROVIDERS SECTION
+#define GPTE_CREATE_PROVIDER_FUN(kind, id, class, icon) GPTE_CREATE_##kind##_PROVIDER_FUN(id)
 
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(australia, "AustraliaProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(avv_aachen, "AvvAachenProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(avv_augsburg, "AvvAugsburgProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(bart, "BartProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(bayern, "BayernProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(brazil, "BrazilProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(british_columbia, "BritishColumbiaProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(bsvag, "BsvagProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(bvg, "BvgProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(cmta, "CmtaProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(czech_republic, "CzechRepublicProvider")
-GPTE_CREATE_HAFAS_COMPLEX_PROVIDER_FUN(db, "DbProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(ding, "DingProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(dsb, "DsbProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(dub, "DubProvider")
-GPTE_CREATE_HAFAS_LEGACY_PROVIDER_FUN(eireann, "EireannProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(finland, "FinlandProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(france_ne, "FranceNorthEastProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(france_nw, "FranceNorthWestProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(france_se, "FranceSouthEastProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(france_sw, "FranceSouthWestProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(ghana, "GhanaProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(gvh, "GvhProvider")
-GPTE_CREATE_HAFAS_COMPLEX_PROVIDER_FUN(invg, "InvgProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(italy, "ItalyProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(kvv, "KvvProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(linz, "LinzProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(lu, "LuProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(massachusetts, "MassachusettsProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(mersey, "MerseyProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(mvg, "MvgProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(mvv, "MvvProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(nasa, "NasaProvider")
-
-GpteProvider* gpte_create_negentwee_provider(GpteJvm* vm, GpteNegentweeLanguage language) {
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 7);
-	jclass provider_class = (*env)->FindClass(env, "de/schildbach/pte/NegentweeProvider");
-	jmethodID constructor = (*env)->GetMethodID(env, provider_class, "<init>", "(Lde/schildbach/pte/NegentweeProvider$Language;)V");
+GPTE_PROVIDERS(GPTE_CREATE_PROVIDER_FUN)
 
-	jclass language_class = (*env)->FindClass(env, "de/schildbach/pte/NegentweeProvider$Language");
-	jobject jlanguage = language == GPTE_NEGENTWEE_LANG_NL_NL ?
-		(*env)->GetStaticObjectField(env, language_class, (*env)->GetStaticFieldID(env, language_class, "NL_NL", "Lde/schildbach/pte/NegentweeProvider$Language;")) :
-		(*env)->GetStaticObjectField(env, language_class, (*env)->GetStaticFieldID(env, language_class, "EN_GB", "Lde/schildbach/pte/NegentweeProvider$Language;"));
-
-	jobject object = (*env)->NewObject(env, provider_class, constructor, jlanguage);
-	return gpte_provider_new("negentwee", vm, object);
-}
-
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(nicaragua, "NicaraguaProvider")
-GPTE_CREATE_HAFAS_LEGACY_PROVIDER_FUN(ns, "NsProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(nvbw, "NvbwProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(nvv, "NvvProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(nz, "NzProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(oebb, "OebbProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(ontario, "OntarioProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(ooevv, "OoevvProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(oregon, "OregonProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(paris, "ParisProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(pl_navitia, "PlNavitiaProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(pl, "PlProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(quebec, "QuebecProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(rta_chicago, "RtaChicagoProvider")
-GPTE_CREATE_HAFAS_LEGACY_PROVIDER_FUN(rt, "RtProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(se, "SeProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(sh, "ShProvider")
-GPTE_CREATE_NAVITIA_PROVIDER_FUN(spain, "SpainProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(stv, "StvProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(svv, "SvvProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(sydney, "SydneyProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(tlem, "TlemProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(vao, "VaoProvider")
-GPTE_CREATE_HAFAS_COMPLEX_PROVIDER_FUN(vbb, "VbbProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(vbl, "VblProvider")
-GPTE_CREATE_HAFAS_COMPLEX_PROVIDER_FUN(vbn, "VbnProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(vgn, "VgnProvider")
-GPTE_CREATE_HAFAS_COMPLEX_PROVIDER_FUN(vgs, "VgsProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(vmobil, "VmobilProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(vmt, "VmtProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(vmv, "VmvProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(vor, "VorProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(vrn, "VrnProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(vrr, "VrrProvider")
-
-GpteProvider* gpte_create_vrs_provider(GpteJvm* vm, const guchar* client_cert, gsize client_cert_len) {
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 4);
-	jclass provider_class = (*env)->FindClass(env, "de/schildbach/pte/VrsProvider");
-	jmethodID constructor = (*env)->GetMethodID(env, provider_class, "<init>", "([B)V");
-	jbyteArray jccert = (*env)->NewByteArray(env, client_cert_len);
-	(*env)->SetByteArrayRegion(env, jccert, 0, client_cert_len, (const jbyte*)client_cert);
-	jobject object = (*env)->NewObject(env, provider_class, constructor, jccert);
-	return gpte_provider_new("vrs", vm, object);
-}
-
-GPTE_CREATE_EFA_PROVIDER_FUN(vvm, "VvmProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(vvo, "VvoProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(vvs, "VvsProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(vvt, "VvtProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(vvv, "VvvProvider")
-GPTE_CREATE_EFA_PROVIDER_FUN(wien, "WienProvider")
-GPTE_CREATE_HAFAS_PROVIDER_FUN(zvv, "ZvvProvider")
 
-// END GPTE PROVIDERS SECTION
+typedef struct {
+	const gchar* class_name;
+	const GpteGeoPoint* points;
+	gsize n_points;
+	GpteGeoPoint min;
+	GpteGeoPoint max;
+} GpteProviderArea;
+
+// grid cell of GPTE_PROVIDER_AREA_CELL degrees touched by the bounding
+// box of an area
+typedef struct {
+	gint lat;
+	gint lon;
+	guint area;
+} GpteProviderAreaCell;
+
+// both arrays end with a sentinel entry, use the generated counts
+#include "gpteproviderareas.h"
+
+static const GpteProviderArea* gpte_provider_area_find(const gchar* id) {
+	const gchar* class_name = gpte_provider_class_name(id);
+	if (!class_name)
+		return NULL;
+	for (gsize i = 0; i < GPTE_PROVIDER_N_AREAS; i++)
+		if (g_str_equal(gpte_provider_areas[i].class_name, class_name))
+			return &gpte_provider_areas[i];
+	return NULL;
+}
+
+const GpteGeoPoint* gpte_provider_static_area(const gchar* id, gsize* len) {
+	const GpteProviderArea* area = gpte_provider_area_find(id);
+	if (!area)
+		return NULL;
+	*len = area->n_points;
+	return area->points;
+}
+
+static gboolean gpte_provider_area_contains(const GpteProviderArea* area, gdouble lat, gdouble lon) {
+	if (lat < area->min.lat || lat > area->max.lat || lon < area->min.lon || lon > area->max.lon)
+		return FALSE;
+
+	// even-odd rule
+	gboolean inside = FALSE;
+	for (gsize i = 0, j = area->n_points - 1; i < area->n_points; j = i++) {
+		const GpteGeoPoint* a = &area->points[i];
+		const GpteGeoPoint* b = &area->points[j];
+		if ((a->lat > lat) != (b->lat > lat) && lon < (b->lon - a->lon) * (lat - a->lat) / (b->lat - a->lat) + a->lon)
+			inside = !inside;
+	}
+	return inside;
+}
+
+static const gchar* gpte_provider_class_id(const gchar* class_name) {
+	for (gsize i = 0; i < G_N_ELEMENTS(gpte_provider_registry); i++)
+		if (g_str_equal(gpte_provider_registry[i].class_name, class_name))
+			return gpte_provider_registry[i].id;
+	return NULL;
+}
+
+gchar** gpte_providers_for_point(gdouble lat, gdouble lon) {
+	gint cell_lat = (gint)floor(lat / GPTE_PROVIDER_AREA_CELL);
+	gint cell_lon = (gint)floor(lon / GPTE_PROVIDER_AREA_CELL);
+
+	// first entry of the cell
+	gsize lo = 0, hi = GPTE_PROVIDER_N_AREA_CELLS;
+	while (lo < hi) {
+		gsize mid = lo + (hi - lo) / 2;
+		const GpteProviderAreaCell* cell = &gpte_provider_area_cells[mid];
+		if (cell->lat < cell_lat || (cell->lat == cell_lat && cell->lon < cell_lon))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	GStrvBuilder* builder = g_strv_builder_new();
+	for (gsize i = lo; i < GPTE_PROVIDER_N_AREA_CELLS; i++) {
+		const GpteProviderAreaCell* cell = &gpte_provider_area_cells[i];
+		if (cell->lat != cell_lat || cell->lon != cell_lon)
+			break;
+		const GpteProviderArea* area = &gpte_provider_areas[cell->area];
+		const gchar* id = gpte_provider_class_id(area->class_name);
+		if (id && gpte_provider_area_contains(area, lat, lon))
+			g_strv_builder_add(builder, id);
+	}
+	return g_strv_builder_unref_to_strv(builder);
+}
+
+G_DEFINE_ENUM_TYPE(GpteProviderConstructor, gpte_provider_constructor,
+	G_DEFINE_ENUM_VALUE(GPTE_PROVIDER_CONSTRUCTOR_PLAIN, "plain"),
+	G_DEFINE_ENUM_VALUE(GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION, "authorization"),
+	G_DEFINE_ENUM_VALUE(GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION_SALT, "authorization-salt"),
+	G_DEFINE_ENUM_VALUE(GPTE_PROVIDER_CONSTRUCTOR_CLIENT_CERTIFICATE, "client-certificate"),
+	G_DEFINE_ENUM_VALUE(GPTE_PROVIDER_CONSTRUCTOR_LANGUAGE, "language")
+)
+
+const gchar* const* gpte_provider_registry_list(void) {
+	static const gchar* ids[G_N_ELEMENTS(gpte_provider_registry) + 1];
+	static gsize initialized = 0;
+	if (g_once_init_enter(&initialized)) {
+		for (gsize i = 0; i < G_N_ELEMENTS(gpte_provider_registry); i++)
+			ids[i] = gpte_provider_registry[i].id;
+		ids[G_N_ELEMENTS(gpte_provider_registry)] = NULL;
+		g_once_init_leave(&initialized, 1);
+	}
+	return ids;
+}
+
+gboolean gpte_provider_registry_lookup(const gchar* id, GpteProviderConstructor* constructor, const gchar** icon) {
+	gssize index = gpte_provider_registry_index(id);
+	if (index < 0)
+		return FALSE;
+	if (constructor)
+		*constructor = gpte_provider_registry[index].constructor;
+	if (icon)
+		*icon = gpte_provider_registry[index].icon;
+	return TRUE;
+}
+
+// identifies an instance by provider and the credentials its constructor
+// uses, ignored fields must not lead to a second instance
+static gchar* gpte_provider_registry_key(gsize index, const GpteProviderCredentials* credentials) {
+	g_autoptr(GChecksum) checksum = g_checksum_new(G_CHECKSUM_SHA256);
+	// gpte_provider_registry_construct() treats NULL the same way
+	static const GpteProviderCredentials none = { 0 };
+	if (!credentials)
+		credentials = &none;
+
+	GpteProviderConstructor constructor = gpte_provider_registry[index].constructor;
+	gboolean authorization = constructor == GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION || constructor == GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION_SALT;
+	gboolean data = constructor == GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION_SALT || constructor == GPTE_PROVIDER_CONSTRUCTOR_CLIENT_CERTIFICATE;
+	// the terminator keeps NULL and "" apart
+	if (authorization && credentials->authorization)
+		g_checksum_update(checksum, (const guchar*)credentials->authorization, strlen(credentials->authorization) + 1);
+	if (data && credentials->data)
+		g_checksum_update(checksum, credentials->data, credentials->data_len);
+	if (constructor == GPTE_PROVIDER_CONSTRUCTOR_LANGUAGE)
+		g_checksum_update(checksum, (const guchar*)&credentials->language, sizeof(credentials->language));
+	return g_strconcat(gpte_provider_registry[index].id, ":", g_checksum_get_string(checksum), NULL);
+}
+
+typedef struct {
+	GpteJvm* vm;
+	gchar* key;
+} GpteProviderRegistryEntry;
+
+// drops the entry of a dead instance, unless it was replaced meanwhile
+static void gpte_provider_registry_instance_died(GpteProviderRegistryEntry* entry, GObject*) {
+	GpteJvm* vm = entry->vm;
+	g_mutex_lock(&vm->registry_lock);
+	GWeakRef* ref = g_hash_table_lookup(vm->provider_instances, entry->key);
+	GObject* alive = ref ? g_weak_ref_get(ref) : NULL;
+	if (ref && !alive)
+		g_hash_table_remove(vm->provider_instances, entry->key);
+	g_mutex_unlock(&vm->registry_lock);
+	// unref outside the lock, the replacement might be the last reference
+	g_clear_object(&alive);
+
+	g_free(entry->key);
+	g_free(entry);
+}
+
+GpteProvider* gpte_provider_registry_create(GpteJvm* vm, const gchar* id, const GpteProviderCredentials* credentials, GError** err) {
+	g_return_val_if_fail(vm != NULL, NULL);
+	g_return_val_if_fail(id != NULL, NULL);
+
+	gssize index = gpte_provider_registry_index(id);
+	if (index < 0) {
+		g_set_error(err, GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_UNKNOWN_PROVIDER, "Unknown provider %s", id);
+		return NULL;
+	}
+
+	g_autofree gchar* key = gpte_provider_registry_key(index, credentials);
+	g_mutex_lock(&vm->registry_lock);
+	GWeakRef* ref = g_hash_table_lookup(vm->provider_instances, key);
+	GpteProvider* provider = ref ? g_weak_ref_get(ref) : NULL;
+	g_mutex_unlock(&vm->registry_lock);
+	if (provider)
+		return provider;
+
+	provider = gpte_provider_registry_construct(vm, index, credentials, err);
+	if (!provider)
+		return NULL;
+
+	g_mutex_lock(&vm->registry_lock);
+	// somebody else might have been faster
+	ref = g_hash_table_lookup(vm->provider_instances, key);
+	GpteProvider* existing = ref ? g_weak_ref_get(ref) : NULL;
+	if (existing) {
+		g_mutex_unlock(&vm->registry_lock);
+		g_object_unref(provider);
+		return existing;
+	}
+	if (!ref) {
+		ref = g_new(GWeakRef, 1);
+		g_weak_ref_init(ref, NULL);
+		g_hash_table_insert(vm->provider_instances, g_strdup(key), ref);
+	}
+	g_weak_ref_set(ref, provider);
+	g_mutex_unlock(&vm->registry_lock);
+
+	// the vm is only released on finalize, after weak notifies ran
+	GpteProviderRegistryEntry* entry = g_new(GpteProviderRegistryEntry, 1);
+	entry->vm = vm;
+	entry->key = g_steal_pointer(&key);
+	g_object_weak_ref(G_OBJECT(provider), (GWeakNotify)gpte_provider_registry_instance_died, entry);
+	return provider;
+}
@@ -28,6 +28,50 @@ typedef enum {
 	GPTE_NEGENTWEE_LANG_NL_NL
 } GpteNegentweeLanguage;
 
+/**
+ * GpteProviderConstructor:
+ * @GPTE_PROVIDER_CONSTRUCTOR_PLAIN: no credentials are needed
+ * @GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION: an api authorization is
+ *   passed in [field@Gpte.ProviderCredentials.authorization]
+ * @GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION_SALT: an api authorization and
+ *   a request salt in [field@Gpte.ProviderCredentials.data]
+ * @GPTE_PROVIDER_CONSTRUCTOR_CLIENT_CERTIFICATE: a client certificate in
+ *   [field@Gpte.ProviderCredentials.data]
+ * @GPTE_PROVIDER_CONSTRUCTOR_LANGUAGE: a language in
+ *   [field@Gpte.ProviderCredentials.language]
+ *
+ * Credentials a provider needs to be constructed.
+ */
+
+#define GPTE_TYPE_PROVIDER_CONSTRUCTOR (gpte_provider_constructor_get_type())
+GType gpte_provider_constructor_get_type(void);
+
+typedef enum {
+	GPTE_PROVIDER_CONSTRUCTOR_PLAIN,
+	GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION,
+	GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION_SALT,
+	GPTE_PROVIDER_CONSTRUCTOR_CLIENT_CERTIFICATE,
+	GPTE_PROVIDER_CONSTRUCTOR_LANGUAGE
+} GpteProviderConstructor;
+
+/**
+ * GpteProviderCredentials:
+ * @authorization: (nullable): api authorization
+ * @data: (array length=data_len) (nullable): salt or client certificate
+ * @data_len: length of @data
+ * @language: language of the provider
+ *
+ * Credentials passed to [func@Gpte.provider_registry_create]. Which
+ * fields are used depends on the [enum@Gpte.ProviderConstructor] of
+ * the provider, the others are ignored.
+ */
+typedef struct {
+	const gchar* authorization;
+	const guchar* data;
+	gsize data_len;
+	GpteNegentweeLanguage language;
+} GpteProviderCredentials;
+
 // BEGIN GPTE PROVIDERS SECTION
 
 
@@ -354,7 +398,6 @@ GpteProvider* gpte_create_mvv_provider(GpteJvm* vm);
  */
 GpteProvider* gpte_create_nasa_provider(GpteJvm* vm, const gchar* api_authorization);
 
-
 /**
  * gpte_create_negentwee_provider:
  * @vm: the Java VM to create this provider in
@@ -365,7 +408,6 @@ GpteProvider* gpte_create_nasa_provider(GpteJvm* vm, const gchar* api_authorizat
  */
 GpteProvider* gpte_create_negentwee_provider(GpteJvm* vm, GpteNegentweeLanguage language);
 
-
 /**
  * gpte_create_nicaragua_provider:
  * @vm: the Java VM to create this provider in
@@ -464,16 +506,6 @@ GpteProvider* gpte_create_oregon_provider(GpteJvm* vm, const gchar* authorizatio
  */
 GpteProvider* gpte_create_paris_provider(GpteJvm* vm, const gchar* authorization);
 
-/**
- * gpte_create_pl_navitia_provider:
- * @vm: the Java VM to create this provider in
- * @authorization: The Navitia authorization token
- *
- * Creates the pl_navitia provider from [Navitia](https://navitia.io/).
- * Returns: (transfer full): the pl_navitia provider
- */
-GpteProvider* gpte_create_pl_navitia_provider(GpteJvm* vm, const gchar* authorization);
-
 /**
  * gpte_create_pl_provider:
  * @vm: the Java VM to create this provider in
@@ -485,23 +517,24 @@ GpteProvider* gpte_create_pl_navitia_provider(GpteJvm* vm, const gchar* authoriz
 GpteProvider* gpte_create_pl_provider(GpteJvm* vm, const gchar* api_authorization);
 
 /**
- * gpte_create_quebec_provider:
+ * gpte_create_pl_navitia_provider:
  * @vm: the Java VM to create this provider in
  * @authorization: The Navitia authorization token
  *
- * Creates the quebec provider from [Navitia](https://navitia.io/).
- * Returns: (transfer full): the quebec provider
+ * Creates the pl_navitia provider from [Navitia](https://navitia.io/).
+ * Returns: (transfer full): the pl_navitia provider
  */
-GpteProvider* gpte_create_quebec_provider(GpteJvm* vm, const gchar* authorization);
+GpteProvider* gpte_create_pl_navitia_provider(GpteJvm* vm, const gchar* authorization);
 
 /**
- * gpte_create_rta_chicago_provider:
+ * gpte_create_quebec_provider:
  * @vm: the Java VM to create this provider in
+ * @authorization: The Navitia authorization token
  *
- * Creates the rta_chicago provider.
- * Returns: (transfer full): the rta_chicago provider
+ * Creates the quebec provider from [Navitia](https://navitia.io/).
+ * Returns: (transfer full): the quebec provider
  */
-GpteProvider* gpte_create_rta_chicago_provider(GpteJvm* vm);
+GpteProvider* gpte_create_quebec_provider(GpteJvm* vm, const gchar* authorization);
 
 /**
  * gpte_create_rt_provider:
@@ -512,6 +545,15 @@ GpteProvider* gpte_create_rta_chicago_provider(GpteJvm* vm);
  */
 GpteProvider* gpte_create_rt_provider(GpteJvm* vm);
 
+/**
+ * gpte_create_rta_chicago_provider:
+ * @vm: the Java VM to create this provider in
+ *
+ * Creates the rta_chicago provider.
+ * Returns: (transfer full): the rta_chicago provider
+ */
+GpteProvider* gpte_create_rta_chicago_provider(GpteJvm* vm);
+
 /**
  * gpte_create_se_provider:
  * @vm: the Java VM to create this provider in
@@ -700,19 +742,17 @@ GpteProvider* gpte_create_vrn_provider(GpteJvm* vm);
  */
 GpteProvider* gpte_create_vrr_provider(GpteJvm* vm);
 
-
 /**
  * gpte_create_vrs_provider:
  * @vm: the Java VM to create this provider in
  * @client_cert: (array length=client_cert_len): client certificate blob
- * @client_cert_len: length of  in bytes
+ * @client_cert_len: length of @client_cert in bytes
  *
  * Creates the vrs provider.
  * Returns: (transfer full): the vrs provider
  */
 GpteProvider* gpte_create_vrs_provider(GpteJvm* vm, const guchar* client_cert, gsize client_cert_len);
 
-
 /**
  * gpte_create_vvm_provider:
  * @vm: the Java VM to create this provider in
@@ -780,6 +820,63 @@ GpteProvider* gpte_create_zvv_provider(GpteJvm* vm, const gchar* api_authorizati
 
 // END GPTE PROVIDERS SECTION
 
+/**
+ * gpte_providers_for_point:
+ * @lat: latitude in degrees
+ * @lon: longitude in degrees
+ *
+ * Looks up the providers whose area covers the given coordinate. This
+ * uses an index generated at build time and doesn't need a
+ * [class@Gpte.Jvm]. Providers that don't declare an area (or fetch it
+ * from the network, like the Navitia based ones) are never returned.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): identifiers of the
+ *   matching providers, as used by the `gpte_create` family of functions
+ */
+gchar** gpte_providers_for_point(gdouble lat, gdouble lon);
+
+/**
+ * gpte_provider_registry_list:
+ *
+ * Lists the identifiers of all providers known to the registry.
+ *
+ * Returns: (transfer none) (array zero-terminated=1): the identifiers
+ */
+const gchar* const* gpte_provider_registry_list(void);
+
+/**
+ * gpte_provider_registry_lookup:
+ * @id: identifier of the provider
+ * @constructor: (out) (optional): credentials the provider needs
+ * @icon: (out) (optional) (transfer none) (nullable): resource path of
+ *   the icon of the provider, if there is one
+ *
+ * Looks up a provider in the registry without creating it.
+ *
+ * Returns: %TRUE if the provider is known
+ */
+gboolean gpte_provider_registry_lookup(const gchar* id, GpteProviderConstructor* constructor, const gchar** icon);
+
+/**
+ * gpte_provider_registry_create:
+ * @vm: the JVM instance
+ * @id: identifier of the provider
+ * @credentials: (nullable): credentials of the provider
+ * @err: return location for a #GError
+ *
+ * Creates the provider @id. The Java class and constructor are only
+ * looked up the first time a provider is created on @vm.
+ *
+ * Creating the same provider with the same credentials again returns
+ * the existing instance for as long as it is alive.
+ *
+ * Fails with %GPTE_JAVA_ERROR_UNKNOWN_PROVIDER if there is no provider
+ * @id.
+ *
+ * Returns: (transfer full): the provider or %NULL on error
+ */
+GpteProvider* gpte_provider_registry_create(GpteJvm* vm, const gchar* id, const GpteProviderCredentials* credentials, GError** err);
+
 G_END_DECLS
 
 #endif // __GPTEPROVIDERS_H__
@@ -0,0 +1,44 @@
+/*
+ * gpte - GObject bindings for public-transport-enabler
+ * Copyright (C) 2024  Florian "sp1rit" <sp1rit@disroot.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef __GPTEREAPER_PRIV_H__
+#define __GPTEREAPER_PRIV_H__
+
+#include <glib.h>
+#include <jni.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Attached thread that releases global references (and the UTF-8
+ * buffers of cached strings) in batches, so finalizers don't have to
+ * transition into the JVM or even be attached to it.
+ */
+typedef struct _GpteReaper GpteReaper;
+
+GpteReaper* gpte_reaper_new(JavaVM* vm);
+// releases everything still pending before returning
+void gpte_reaper_free(GpteReaper* self);
+
+void gpte_reaper_release(GpteReaper* self, jobject ref);
+void gpte_reaper_release_string(GpteReaper* self, jstring string, const char* utf8);
+
+void gpte_reaper_get_stats(GpteReaper* self, gsize* pending, gsize* freed);
+
+G_END_DECLS
+
+#endif // __GPTEREAPER_PRIV_H__
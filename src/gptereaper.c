@@ -0,0 +1,195 @@
+/*
+ * gpte - GObject bindings for public-transport-enabler
+ * Copyright (C) 2024  Florian "sp1rit" <sp1rit@disroot.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "gptereaper-priv.h"
+
+typedef struct _GpteReaperNode GpteReaperNode;
+struct _GpteReaperNode {
+	GpteReaperNode* next;
+	jobject ref;
+	// only set for strings
+	const char* utf8;
+};
+
+struct _GpteReaper {
+	JavaVM* vm;
+	GThread* thread;
+
+	// lock-free stack the finalizers push onto, drained as a whole
+	GpteReaperNode* head;
+
+	// only used to put the reaper to sleep while head is empty
+	GMutex lock;
+	GCond cond;
+	gboolean stop;
+
+	gsize pending;
+	gsize freed;
+};
+
+static GpteReaperNode* gpte_reaper_take(GpteReaper* self) {
+	GpteReaperNode* batch = g_atomic_pointer_exchange(&self->head, NULL);
+
+	// restore the order the references were released in
+	GpteReaperNode* reversed = NULL;
+	while (batch) {
+		GpteReaperNode* next = batch->next;
+		batch->next = reversed;
+		reversed = batch;
+		batch = next;
+	}
+	return reversed;
+}
+
+static void gpte_reaper_drain(GpteReaper* self, JNIEnv* env) {
+	GpteReaperNode* batch = gpte_reaper_take(self);
+	if (!batch)
+		return;
+
+	gsize n = 0;
+	(*env)->PushLocalFrame(env, 0);
+	while (batch) {
+		GpteReaperNode* next = batch->next;
+		if (batch->utf8)
+			(*env)->ReleaseStringUTFChars(env, batch->ref, batch->utf8);
+		(*env)->DeleteGlobalRef(env, batch->ref);
+		g_free(batch);
+		batch = next;
+		n++;
+	}
+	(*env)->PopLocalFrame(env, NULL);
+
+	g_atomic_pointer_add(&self->pending, -(gssize)n);
+	g_atomic_pointer_add(&self->freed, n);
+}
+
+static gpointer gpte_reaper_thread(GpteReaper* self) {
+	JNIEnv* env;
+	gint rc = (*self->vm)->AttachCurrentThreadAsDaemon(self->vm, (void**)&env, &(JavaVMAttachArgs){
+		.version = JNI_VERSION_21,
+		.name = "gpte-reaper",
+		.group = NULL
+	});
+	if (rc != JNI_OK) {
+		g_critical("Gpte.Reaper was unable to attach thread (error %d)", rc);
+		return NULL;
+	}
+
+	gboolean stop = FALSE;
+	while (!stop) {
+		g_mutex_lock(&self->lock);
+		while (!g_atomic_pointer_get(&self->head) && !self->stop)
+			g_cond_wait(&self->cond, &self->lock);
+		stop = self->stop;
+		g_mutex_unlock(&self->lock);
+
+		gpte_reaper_drain(self, env);
+	}
+
+	(*self->vm)->DetachCurrentThread(self->vm);
+	return NULL;
+}
+
+GpteReaper* gpte_reaper_new(JavaVM* vm) {
+	GpteReaper* self = g_new(GpteReaper, 1);
+	self->vm = vm;
+	self->head = NULL;
+	g_mutex_init(&self->lock);
+	g_cond_init(&self->cond);
+	self->stop = FALSE;
+	self->pending = 0;
+	self->freed = 0;
+	self->thread = g_thread_new("gpte-reaper", (GThreadFunc)gpte_reaper_thread, self);
+	return self;
+}
+
+void gpte_reaper_free(GpteReaper* self) {
+	if (!self)
+		return;
+
+	g_mutex_lock(&self->lock);
+	self->stop = TRUE;
+	g_cond_signal(&self->cond);
+	g_mutex_unlock(&self->lock);
+	g_thread_join(self->thread);
+
+	// left over if the reaper failed to attach, so release them from here
+	if (g_atomic_pointer_get(&self->head)) {
+		JNIEnv* env;
+		gint rc = (*self->vm)->GetEnv(self->vm, (void**)&env, JNI_VERSION_21);
+		gboolean attached = rc == JNI_EDETACHED && (*self->vm)->AttachCurrentThread(self->vm, (void**)&env, NULL) == JNI_OK;
+		if (rc == JNI_OK || attached)
+			gpte_reaper_drain(self, env);
+		else
+			g_critical("Gpte.Reaper was unable to release %" G_GSIZE_FORMAT " references", (gsize)g_atomic_pointer_get(&self->pending));
+		if (attached)
+			(*self->vm)->DetachCurrentThread(self->vm);
+	}
+
+	// only nodes that could not be released are left
+	GpteReaperNode* batch = gpte_reaper_take(self);
+	while (batch) {
+		GpteReaperNode* next = batch->next;
+		g_free(batch);
+		batch = next;
+	}
+
+	g_cond_clear(&self->cond);
+	g_mutex_clear(&self->lock);
+	g_free(self);
+}
+
+static void gpte_reaper_push(GpteReaper* self, jobject ref, const char* utf8) {
+	GpteReaperNode* node = g_new(GpteReaperNode, 1);
+	node->ref = ref;
+	node->utf8 = utf8;
+
+	g_atomic_pointer_add(&self->pending, 1);
+
+	GpteReaperNode* head;
+	do {
+		head = g_atomic_pointer_get(&self->head);
+		node->next = head;
+	} while (!g_atomic_pointer_compare_and_exchange(&self->head, head, node));
+
+	// only the push onto an empty stack needs to wake the reaper, later
+	// ones end up in the same batch
+	if (!head) {
+		g_mutex_lock(&self->lock);
+		g_cond_signal(&self->cond);
+		g_mutex_unlock(&self->lock);
+	}
+}
+
+void gpte_reaper_release(GpteReaper* self, jobject ref) {
+	if (ref)
+		gpte_reaper_push(self, ref, NULL);
+}
+
+void gpte_reaper_release_string(GpteReaper* self, jstring string, const char* utf8) {
+	if (string)
+		gpte_reaper_push(self, string, utf8);
+}
+
+void gpte_reaper_get_stats(GpteReaper* self, gsize* pending, gsize* freed) {
+	if (pending)
+		*pending = g_atomic_pointer_get(&self->pending);
+	if (freed)
+		*freed = g_atomic_pointer_get(&self->freed);
+}
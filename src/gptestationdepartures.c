@@ -16,10 +16,12 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include "gptestationdepartures.h"
+#include "gptestationdepartures-priv.h"
 #include "gptejavaobject-priv.h"
 
+#include "gptedeparture-priv.h"
 #include "gptelist-priv.h"
+#include "gptestyle-priv.h"
 
 G_DEFINE_BOXED_TYPE(GpteLineDest, gpte_line_dest, gpte_line_dest_copy, gpte_line_dest_free)
 
@@ -32,80 +34,165 @@ GpteLineDest* gpte_line_dest_copy(const GpteLineDest* self) {
 void gpte_line_dest_free(GpteLineDest* self) {
 	if (!self)
 		return;
-	g_object_unref(self->destination);
+	if (self->destination)
+		g_object_unref(self->destination);
 	g_object_unref(self->line);
 	g_free(self);
 }
 
+typedef enum {
+	GPTE_STATION_DEPARTURES_CACHED_LOCATION = 1 << 0,
+	GPTE_STATION_DEPARTURES_CACHED_DEPARTURES = 1 << 1,
+	GPTE_STATION_DEPARTURES_CACHED_LINES = 1 << 2
+} GpteStationDeparturesCachedValues;
+
 struct _GpteStationDepartures {
 	GpteJavaObject parent_instance;
+
+	GpteStationDeparturesCachedValues cached;
+	GpteLocation* cached_location;
+	GListModel* cached_departures;
+	GPtrArray* cached_lines;
+	// set once detached, every caller gets its own store of these
+	GPtrArray* detached_departures;
 };
 
 G_DEFINE_TYPE (GpteStationDepartures, gpte_station_departures, GPTE_TYPE_JAVA_OBJECT)
 
-static void gpte_station_departures_class_init(GpteStationDeparturesClass*) {}
-static void gpte_station_departures_init(GpteStationDepartures*) {}
+static void gpte_station_departures_dispose(GObject* object) {
+	GpteStationDepartures* self = GPTE_STATION_DEPARTURES(object);
+	if (self->cached & GPTE_STATION_DEPARTURES_CACHED_LOCATION)
+		g_clear_object(&self->cached_location);
+	if (self->cached & GPTE_STATION_DEPARTURES_CACHED_DEPARTURES)
+		g_clear_object(&self->cached_departures);
+	if (self->cached & GPTE_STATION_DEPARTURES_CACHED_LINES)
+		g_clear_pointer(&self->cached_lines, g_ptr_array_unref);
+	g_clear_pointer(&self->detached_departures, g_ptr_array_unref);
+	self->cached = 0;
+	G_OBJECT_CLASS(gpte_station_departures_parent_class)->dispose(object);
+}
 
-GpteLocation* gpte_station_departures_get_location(GpteStationDepartures* self) {
-	g_return_val_if_fail(GPTE_IS_STATION_DEPARTURES(self), NULL);
+static void gpte_station_departures_hydrate(GpteJavaObject* object);
+
+static void gpte_station_departures_class_init(GpteStationDeparturesClass* class) {
+	G_OBJECT_CLASS(class)->dispose = gpte_station_departures_dispose;
+	GPTE_JAVA_OBJECT_CLASS(class)->hydrate = gpte_station_departures_hydrate;
+}
+static void gpte_station_departures_init(GpteStationDepartures* self) {
+	self->cached = 0;
+	self->detached_departures = NULL;
+}
+
+static GpteLocation* gpte_station_departures_location(GpteStationDepartures* self) {
+	if (self->cached & GPTE_STATION_DEPARTURES_CACHED_LOCATION)
+		return self->cached_location;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/StationDepartures");
-
-	jfieldID location_id = (*env)->GetFieldID(env, class, "location", "Lde/schildbach/pte/dto/Location;");
-	jobject jlocation = (*env)->GetObjectField(env, this, location_id);
+	jobject jlocation = (*env)->GetObjectField(env, this, vm->jni.station_departures.location);
 
-	return g_object_new(GPTE_TYPE_LOCATION, "vm", vm, "object", jlocation, NULL);
+	self->cached_location = g_object_new(GPTE_TYPE_LOCATION, "vm", vm, "object", jlocation, NULL);
+	self->cached |= GPTE_STATION_DEPARTURES_CACHED_LOCATION;
+	return self->cached_location;
 }
-
-GListModel* gpte_station_departures_get_departures(GpteStationDepartures* self) {
+GpteLocation* gpte_station_departures_get_location(GpteStationDepartures* self) {
 	g_return_val_if_fail(GPTE_IS_STATION_DEPARTURES(self), NULL);
+	return g_object_ref(gpte_station_departures_location(self));
+}
+
+static GListModel* gpte_station_departures_departures(GpteStationDepartures* self) {
+	if (self->cached & GPTE_STATION_DEPARTURES_CACHED_DEPARTURES)
+		return self->cached_departures;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/StationDepartures");
+	jobject jdepas = (*env)->GetObjectField(env, this, vm->jni.station_departures.departures);
 
-	jfieldID depas_id = (*env)->GetFieldID(env, class, "departures", "Ljava/util/List;");
-	jobject jdepas = (*env)->GetObjectField(env, this, depas_id);
+	self->cached_departures = gpte_list_new(vm, GPTE_TYPE_DEPARTURE, jdepas);
+	gpte_style_cache_inherit(self->cached_departures, self);
+	self->cached |= GPTE_STATION_DEPARTURES_CACHED_DEPARTURES;
+	return self->cached_departures;
+}
+GListModel* gpte_station_departures_get_departures(GpteStationDepartures* self) {
+	g_return_val_if_fail(GPTE_IS_STATION_DEPARTURES(self), NULL);
+	if (self->detached_departures)
+		return gpte_list_store_new_from_items(GPTE_TYPE_DEPARTURE, self->detached_departures);
+	return g_object_ref(gpte_station_departures_departures(self));
+}
 
-	return gpte_list_new(vm, GPTE_TYPE_DEPARTURE, jdepas);
+void gpte_station_departures_unpack_window(GpteJvm* vm, jobjectArray items, GObject** wrapped, guint n_items) {
+	for (guint i = 0; i < n_items; i++)
+		if (wrapped[i])
+			gpte_list_set_pack_func(GPTE_LIST(gpte_station_departures_departures(GPTE_STATION_DEPARTURES(wrapped[i]))), gpte_departure_unpack_window);
 }
 
-GPtrArray* gpte_station_departures_get_lines(GpteStationDepartures* self) {
-	g_return_val_if_fail(GPTE_IS_STATION_DEPARTURES(self), NULL);
+static GPtrArray* gpte_station_departures_lines(GpteStationDepartures* self) {
+	if (self->cached & GPTE_STATION_DEPARTURES_CACHED_LINES)
+		return self->cached_lines;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 11);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 5);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/StationDepartures");
 
-	jfieldID lines_id = (*env)->GetFieldID(env, class, "lines", "Ljava/util/List;");
-	jobject lines = (*env)->GetObjectField(env, this, lines_id);
-	if (!lines)
+	jobject lines = (*env)->GetObjectField(env, this, vm->jni.station_departures.lines);
+	if (!lines) {
+		self->cached_lines = NULL;
+		self->cached |= GPTE_STATION_DEPARTURES_CACHED_LINES;
 		return NULL;
+	}
 
-	jclass list_class = (*env)->FindClass(env, "java/util/List");
-	jmethodID to_arr = (*env)->GetMethodID(env, list_class, "toArray", "()[Ljava/lang/Object;");
-	jobjectArray lines_arr = (*env)->CallObjectMethod(env, lines, to_arr);
-
-	jclass line_dest_class = (*env)->FindClass(env, "de/schildbach/pte/dto/LineDestination");
-	jfieldID line_id = (*env)->GetFieldID(env, line_dest_class, "line", "Lde/schildbach/pte/dto/Line;");
-	jfieldID dest_id = (*env)->GetFieldID(env, line_dest_class, "line", "Lde/schildbach/pte/dto/Location;");
+	jobjectArray lines_arr = (*env)->CallObjectMethod(env, lines, vm->jni.list.to_array);
 
 	jsize len = (*env)->GetArrayLength(env, lines_arr);
 	GPtrArray* ret = g_ptr_array_new_full(len, (GDestroyNotify)gpte_line_dest_free);
 	for (jsize i = 0; i < len; i++) {
 		jobject line_dest = (*env)->GetObjectArrayElement(env, lines_arr, i);
 		GpteLineDest* ld = g_new(GpteLineDest, 1);
-		ld->line = g_object_new(GPTE_TYPE_LINE, "vm", vm, "object", (*env)->GetObjectField(env, line_dest, line_id), NULL);
-		jobject dest = (*env)->GetObjectField(env, line_dest, dest_id);
-		ld->destination = dest ? g_object_new(GPTE_TYPE_LINE, "vm", vm, "object", dest, NULL) : NULL;
+		jobject line = (*env)->GetObjectField(env, line_dest, vm->jni.line_destination.line);
+		ld->line = g_object_new(GPTE_TYPE_LINE, "vm", vm, "object", line, NULL);
+		gpte_style_cache_inherit(ld->line, self);
+		jobject dest = (*env)->GetObjectField(env, line_dest, vm->jni.line_destination.destination);
+		ld->destination = dest ? g_object_new(GPTE_TYPE_LOCATION, "vm", vm, "object", dest, NULL) : NULL;
 		g_ptr_array_add(ret, ld);
 		(*env)->DeleteLocalRef(env, line_dest);
+		(*env)->DeleteLocalRef(env, line);
 		(*env)->DeleteLocalRef(env, dest);
 	}
+
+	self->cached_lines = ret;
+	self->cached |= GPTE_STATION_DEPARTURES_CACHED_LINES;
+	return self->cached_lines;
+}
+GPtrArray* gpte_station_departures_get_lines(GpteStationDepartures* self) {
+	g_return_val_if_fail(GPTE_IS_STATION_DEPARTURES(self), NULL);
+	GPtrArray* lines = gpte_station_departures_lines(self);
+	if (!lines)
+		return NULL;
+	// the line/destination wrappers are shared, the array is not
+	GPtrArray* ret = g_ptr_array_copy(lines, (GCopyFunc)gpte_line_dest_copy, NULL);
+	g_ptr_array_set_free_func(ret, (GDestroyNotify)gpte_line_dest_free);
 	return ret;
 }
+
+static void gpte_station_departures_hydrate(GpteJavaObject* object) {
+	GpteStationDepartures* self = GPTE_STATION_DEPARTURES(object);
+	gpte_java_object_detach(gpte_station_departures_location(self));
+
+	self->detached_departures = gpte_list_detach_items(gpte_station_departures_departures(self));
+	g_clear_object(&self->cached_departures);
+	self->cached &= ~GPTE_STATION_DEPARTURES_CACHED_DEPARTURES;
+
+	GPtrArray* lines = gpte_station_departures_lines(self);
+	for (guint i = 0; lines && i < lines->len; i++) {
+		GpteLineDest* ld = g_ptr_array_index(lines, i);
+		gpte_java_object_detach(ld->line);
+		gpte_java_object_detach(ld->destination);
+	}
+}
+
+GpteStationDepartures* gpte_station_departures_snapshot(GpteStationDepartures* self) {
+	g_return_val_if_fail(GPTE_IS_STATION_DEPARTURES(self), NULL);
+	return GPTE_STATION_DEPARTURES(gpte_java_object_snapshot(GPTE_JAVA_OBJECT(self)));
+}
@@ -92,6 +92,17 @@ GListModel* gpte_station_departures_get_departures(GpteStationDepartures* self);
  */
 GPtrArray* gpte_station_departures_get_lines(GpteStationDepartures* self);
 
+/**
+ * gpte_station_departures_snapshot:
+ * @self: the station departures
+ *
+ * Copies @self into native memory, see
+ * [method@Gpte.JavaObject.snapshot].
+ *
+ * Returns: (transfer full): a detached copy of @self
+ */
+GpteStationDepartures* gpte_station_departures_snapshot(GpteStationDepartures* self);
+
 G_END_DECLS
 
 #endif // __GPTESTATIONDEPARTURES_H__
@@ -0,0 +1,37 @@
+/*
+ * gpte - GObject bindings for public-transport-enabler
+ * Copyright (C) 2024  Florian "sp1rit" <sp1rit@disroot.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GPTESTOP_PRIV_H__
+#define __GPTESTOP_PRIV_H__
+
+#include <gptestop.h>
+#include <gptejvm-priv.h>
+
+G_BEGIN_DECLS
+
+GptePosition* gpte_position_from_java(GpteJvm* vm, jobject position);
+
+// number of values gpte_stop_unpack() reads
+#define GPTE_STOP_PACKED_SIZE 6
+// fills the cached times and delays of @self from values packed by
+// GpteBulk.packStop()
+void gpte_stop_unpack(GpteStop* self, const jlong* packed);
+
+G_END_DECLS
+
+#endif // __GPTESTOP_PRIV_H__
@@ -17,6 +17,7 @@
  */
 
 #include "gptestop.h"
+#include "gptestop-priv.h"
 
 #include "gptejavaobject-priv.h"
 #include "gpteutils-priv.h"
@@ -40,6 +41,23 @@ void gpte_position_free(GptePosition* self) {
 	g_free(self);
 }
 
+GptePosition* gpte_position_from_java(GpteJvm* vm, jobject position) {
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 2);
+	jstring jname = (*env)->GetObjectField(env, position, vm->jni.position.name);
+	jstring jsection = (*env)->GetObjectField(env, position, vm->jni.position.section);
+
+	GptePosition* self = g_new0(GptePosition, 1);
+	const char* jname_str = (*env)->GetStringUTFChars(env, jname, NULL);
+	self->name = g_strdup(jname_str);
+	(*env)->ReleaseStringUTFChars(env, jname, jname_str);
+	if (jsection) {
+		const char* jsection_str = (*env)->GetStringUTFChars(env, jsection, NULL);
+		self->section = g_strdup(jsection_str);
+		(*env)->ReleaseStringUTFChars(env, jsection, jsection_str);
+	}
+	return self;
+}
+
 const gchar* gpte_position_get_name(const GptePosition* self) {
 	g_return_val_if_fail(self != NULL, NULL);
 	return self->name;
@@ -92,15 +110,18 @@ static void gpte_stop_dispose(GObject* object) {
 		g_date_time_unref(self->cached_arrival);
 	if ((self->cached & GPTE_STOP_CACHED_DEPARTURE) && self->cached_departure)
 		g_date_time_unref(self->cached_departure);
-	if (self->cached & GPTE_STOP_CACHED_LOCATION)
+	if ((self->cached & GPTE_STOP_CACHED_LOCATION) && self->cached_location)
 		g_object_unref(self->cached_location);
 	self->cached = 0;
 	G_OBJECT_CLASS(gpte_stop_parent_class)->dispose(object);
 }
 
+static void gpte_stop_hydrate(GpteJavaObject* object);
+
 static void gpte_stop_class_init(GpteStopClass* class) {
 	GObjectClass* object_class = G_OBJECT_CLASS(class);
 	object_class->dispose = gpte_stop_dispose;
+	GPTE_JAVA_OBJECT_CLASS(class)->hydrate = gpte_stop_hydrate;
 }
 
 static void gpte_stop_init(GpteStop* self) {
@@ -113,19 +134,17 @@ GpteLocation* gpte_stop_get_location(GpteStop* self) {
 		return self->cached_location;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Stop");
-	jfieldID id = (*env)->GetFieldID(env, class, "location", "Lde/schildbach/pte/dto/Location;");
-	jobject location = (*env)->GetObjectField(env, this, id);
+	jobject location = (*env)->GetObjectField(env, this, vm->jni.stop.location);
 
 	self->cached_location = g_object_new(GPTE_TYPE_LOCATION, "vm", vm, "object", location, NULL);
 	self->cached |= GPTE_STOP_CACHED_LOCATION;
 	return self->cached_location;
 }
 
-static GDateTime* gpte_stop_call_date_and_pred_meth(GpteStop* self, gboolean* is_predicted, const gchar* method, const gchar* predicted, GDateTime** cache, gboolean* predicted_cache, GpteStopCachedValues cache_value) {
+static GDateTime* gpte_stop_call_date_and_pred_meth(GpteStop* self, gboolean* is_predicted, jmethodID method, jmethodID predicted, GDateTime** cache, gboolean* predicted_cache, GpteStopCachedValues cache_value) {
 	if (self->cached & cache_value) {
 		if (is_predicted)
 			*is_predicted = *predicted_cache;
@@ -133,15 +152,11 @@ static GDateTime* gpte_stop_call_date_and_pred_meth(GpteStop* self, gboolean* is
 	}
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Stop");
-	jmethodID method_id = (*env)->GetMethodID(env, class, method, "()Ljava/util/Date;");
-	jobject date = (*env)->CallObjectMethod(env, this, method_id);
-
-	jmethodID get_is_predicted = (*env)->GetMethodID(env, class, predicted, "()Z");
-	*predicted_cache = (*env)->CallBooleanMethod(env, this, get_is_predicted);
+	jobject date = (*env)->CallObjectMethod(env, this, method);
+	*predicted_cache = (*env)->CallBooleanMethod(env, this, predicted);
 
 	*cache = date ? gpte_date_from_java(vm, date) : NULL;
 	self->cached |= cache_value;
@@ -151,14 +166,16 @@ static GDateTime* gpte_stop_call_date_and_pred_meth(GpteStop* self, gboolean* is
 }
 GDateTime* gpte_stop_get_arrival_time(GpteStop* self, gboolean* is_predicted) {
 	g_return_val_if_fail(GPTE_IS_STOP(self), NULL);
-	return gpte_stop_call_date_and_pred_meth(self, is_predicted, "getArrivalTime", "isArrivalTimePredicted", &self->cached_arrival, &self->cached_arrival_time_predicted, GPTE_STOP_CACHED_ARRIVAL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_stop_call_date_and_pred_meth(self, is_predicted, vm->jni.stop.get_arrival_time, vm->jni.stop.is_arrival_time_predicted, &self->cached_arrival, &self->cached_arrival_time_predicted, GPTE_STOP_CACHED_ARRIVAL);
 }
 GDateTime* gpte_stop_get_departure_time(GpteStop* self, gboolean* is_predicted) {
 	g_return_val_if_fail(GPTE_IS_STOP(self), NULL);
-	return gpte_stop_call_date_and_pred_meth(self, is_predicted, "getDepartureTime", "isDepartureTimePredicted", &self->cached_departure, &self->cached_departure_time_predicted, GPTE_STOP_CACHED_DEPARTURE);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_stop_call_date_and_pred_meth(self, is_predicted, vm->jni.stop.get_departure_time, vm->jni.stop.is_departure_time_predicted, &self->cached_departure, &self->cached_departure_time_predicted, GPTE_STOP_CACHED_DEPARTURE);
 }
 
-static const glong* gpte_stop_call_boxed_long_meth(GpteStop* self, const gchar* method, glong* value_cache, gboolean* has_value_cache, GpteStopCachedValues cache_value) {
+static const glong* gpte_stop_call_boxed_long_meth(GpteStop* self, jmethodID method, glong* value_cache, gboolean* has_value_cache, GpteStopCachedValues cache_value) {
 	if (self->cached & cache_value) {
 		if (*has_value_cache)
 			return value_cache;
@@ -166,35 +183,33 @@ static const glong* gpte_stop_call_boxed_long_meth(GpteStop* self, const gchar*
 	}
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 5);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Stop");
-	jmethodID get_box = (*env)->GetMethodID(env, class, method, "()Ljava/lang/Long;");
-	jobject boxed = (*env)->CallObjectMethod(env, this, get_box);
+	jobject boxed = (*env)->CallObjectMethod(env, this, method);
 	if (!boxed) {
 		*has_value_cache = FALSE;
 		self->cached |= cache_value;
 		return NULL;
 	}
 
-	jclass long_class = (*env)->FindClass(env, "java/lang/Long");
-	jmethodID get_value = (*env)->GetMethodID(env, long_class, "longValue", "()J");
-	*value_cache = (*env)->CallLongMethod(env, boxed, get_value);
+	*value_cache = (*env)->CallLongMethod(env, boxed, vm->jni.long_.long_value);
 	*has_value_cache = TRUE;
 	self->cached |= cache_value;
 	return value_cache;
 }
 const glong* gpte_stop_get_arrival_delay(GpteStop* self) {
 	g_return_val_if_fail(GPTE_IS_STOP(self), NULL);
-	return gpte_stop_call_boxed_long_meth(self, "getArrivalDelay", &self->cached_arrival_delay, &self->cached_has_arrival_delay, GPTE_STOP_CACHED_ARRIVAL_DELAY);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_stop_call_boxed_long_meth(self, vm->jni.stop.get_arrival_delay, &self->cached_arrival_delay, &self->cached_has_arrival_delay, GPTE_STOP_CACHED_ARRIVAL_DELAY);
 }
 const glong* gpte_stop_get_departure_delay(GpteStop* self) {
 	g_return_val_if_fail(GPTE_IS_STOP(self), NULL);
-	return gpte_stop_call_boxed_long_meth(self, "getDepartureDelay", &self->cached_departure_delay, &self->cached_has_departure_delay, GPTE_STOP_CACHED_DEPARTURE_DELAY);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_stop_call_boxed_long_meth(self, vm->jni.stop.get_departure_delay, &self->cached_departure_delay, &self->cached_has_departure_delay, GPTE_STOP_CACHED_DEPARTURE_DELAY);
 }
 
-static const GptePosition* gpte_stop_call_position_and_pred_meth(GpteStop* self, gboolean* is_predicted, const gchar* position, const gchar* predicted, GptePosition** position_cache, gboolean* predicted_cache, GpteStopCachedValues cache_value) {
+static const GptePosition* gpte_stop_call_position_and_pred_meth(GpteStop* self, gboolean* is_predicted, jmethodID position, jmethodID predicted, GptePosition** position_cache, gboolean* predicted_cache, GpteStopCachedValues cache_value) {
 	if (self->cached & cache_value) {
 		if (is_predicted)
 			*is_predicted = *predicted_cache;
@@ -202,34 +217,22 @@ static const GptePosition* gpte_stop_call_position_and_pred_meth(GpteStop* self,
 	}
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 11);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Stop");
-	jmethodID get_position = (*env)->GetMethodID(env, class, position, "()Lde/schildbach/pte/dto/Position;");
-	jobject jposition = (*env)->CallObjectMethod(env, this, get_position);
-	if (!jposition)
+	jobject jposition = (*env)->CallObjectMethod(env, this, position);
+	if (!jposition) {
+		*predicted_cache = FALSE;
+		*position_cache = NULL;
+		self->cached |= cache_value;
+		if (is_predicted)
+			*is_predicted = FALSE;
 		return NULL;
-
-	jmethodID get_is_predicted = (*env)->GetMethodID(env, class, predicted, "()Z");
-	*predicted_cache = (*env)->CallBooleanMethod(env, this, get_is_predicted);
-
-	jclass position_class = (*env)->FindClass(env, "de/schildbach/pte/dto/Position");
-	jfieldID name_id = (*env)->GetFieldID(env, position_class, "name", "Ljava/lang/String;");
-	jfieldID section_id = (*env)->GetFieldID(env, position_class, "section", "Ljava/lang/String;");
-	jstring jname = (*env)->GetObjectField(env, jposition, name_id);
-	jstring jsection = (*env)->GetObjectField(env, jposition, section_id);
-
-	*position_cache = g_new0(GptePosition, 1);
-	const char* jname_str = (*env)->GetStringUTFChars(env, jname, NULL);
-	(*position_cache)->name = g_strdup(jname_str);
-	(*env)->ReleaseStringUTFChars(env, jname, jname_str);
-	if (jsection) {
-		const char* jsection_str = (*env)->GetStringUTFChars(env, jsection, NULL);
-		(*position_cache)->section = g_strdup(jsection_str);
-		(*env)->ReleaseStringUTFChars(env, jsection, jsection_str);
 	}
 
+	*predicted_cache = (*env)->CallBooleanMethod(env, this, predicted);
+	*position_cache = gpte_position_from_java(vm, jposition);
+
 	self->cached |= cache_value;
 	if (is_predicted)
 		*is_predicted = *predicted_cache;
@@ -237,9 +240,49 @@ static const GptePosition* gpte_stop_call_position_and_pred_meth(GpteStop* self,
 }
 const GptePosition* gpte_stop_get_arrival_position(GpteStop* self, gboolean* is_predicted) {
 	g_return_val_if_fail(GPTE_IS_STOP(self), NULL);
-	return gpte_stop_call_position_and_pred_meth(self, is_predicted, "getArrivalPosition", "isArrivalPositionPredicted", &self->cached_true_arrival, &self->cached_arrival_predicted, GPTE_STOP_CACHED_TRUE_ARRIVAL_POS);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_stop_call_position_and_pred_meth(self, is_predicted, vm->jni.stop.get_arrival_position, vm->jni.stop.is_arrival_position_predicted, &self->cached_true_arrival, &self->cached_arrival_predicted, GPTE_STOP_CACHED_TRUE_ARRIVAL_POS);
 }
 const GptePosition* gpte_stop_get_departure_position(GpteStop* self, gboolean* is_predicted) {
 	g_return_val_if_fail(GPTE_IS_STOP(self), NULL);
-	return gpte_stop_call_position_and_pred_meth(self, is_predicted, "getDeparturePosition", "isDeparturePositionPredicted", &self->cached_true_departure, &self->cached_departure_predicted, GPTE_STOP_CACHED_TRUE_DEPARTURE_POS);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_stop_call_position_and_pred_meth(self, is_predicted, vm->jni.stop.get_departure_position, vm->jni.stop.is_departure_position_predicted, &self->cached_true_departure, &self->cached_departure_predicted, GPTE_STOP_CACHED_TRUE_DEPARTURE_POS);
+}
+
+static void gpte_stop_unpack_delay(GpteStop* self, jlong packed, glong* value_cache, gboolean* has_value_cache, GpteStopCachedValues cache_value) {
+	if (self->cached & cache_value)
+		return;
+	*has_value_cache = packed != GPTE_PACKED_NULL;
+	*value_cache = *has_value_cache ? packed : 0;
+	self->cached |= cache_value;
+}
+void gpte_stop_unpack(GpteStop* self, const jlong* packed) {
+	if (!(self->cached & GPTE_STOP_CACHED_ARRIVAL)) {
+		self->cached_arrival = gpte_date_from_packed(packed[0]);
+		self->cached_arrival_time_predicted = packed[1];
+		self->cached |= GPTE_STOP_CACHED_ARRIVAL;
+	}
+	if (!(self->cached & GPTE_STOP_CACHED_DEPARTURE)) {
+		self->cached_departure = gpte_date_from_packed(packed[2]);
+		self->cached_departure_time_predicted = packed[3];
+		self->cached |= GPTE_STOP_CACHED_DEPARTURE;
+	}
+	gpte_stop_unpack_delay(self, packed[4], &self->cached_arrival_delay, &self->cached_has_arrival_delay, GPTE_STOP_CACHED_ARRIVAL_DELAY);
+	gpte_stop_unpack_delay(self, packed[5], &self->cached_departure_delay, &self->cached_has_departure_delay, GPTE_STOP_CACHED_DEPARTURE_DELAY);
+}
+
+static void gpte_stop_hydrate(GpteJavaObject* object) {
+	GpteStop* self = GPTE_STOP(object);
+	gpte_java_object_detach(gpte_stop_get_location(self));
+	gpte_stop_get_arrival_time(self, NULL);
+	gpte_stop_get_departure_time(self, NULL);
+	gpte_stop_get_arrival_delay(self);
+	gpte_stop_get_departure_delay(self);
+	gpte_stop_get_arrival_position(self, NULL);
+	gpte_stop_get_departure_position(self, NULL);
+}
+
+GpteStop* gpte_stop_snapshot(GpteStop* self) {
+	g_return_val_if_fail(GPTE_IS_STOP(self), NULL);
+	return GPTE_STOP(gpte_java_object_snapshot(GPTE_JAVA_OBJECT(self)));
 }
@@ -164,6 +164,17 @@ const GptePosition* gpte_stop_get_arrival_position(GpteStop* self, gboolean* is_
  */
 const GptePosition* gpte_stop_get_departure_position(GpteStop* self, gboolean* is_predicted);
 
+/**
+ * gpte_stop_snapshot:
+ * @self: the stop
+ *
+ * Copies @self into native memory, see
+ * [method@Gpte.JavaObject.snapshot].
+ *
+ * Returns: (transfer full): a detached copy of @self
+ */
+GpteStop* gpte_stop_snapshot(GpteStop* self);
+
 G_END_DECLS
 
 #endif // __GPTESTOP_H__
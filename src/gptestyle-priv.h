@@ -20,12 +20,41 @@
 #define __GPTESTYLE_PRIV_H__
 
 #include <gptestyle.h>
+#include <gpteproducts.h>
 #include <gptejvm-priv.h>
 
 G_BEGIN_DECLS
 
 GpteStyle* gpte_style_from_java(GpteJvm* vm, jobject jstyle);
 
+/*
+ * Per-provider map from (network, product, label) to an interned style.
+ * Styles handed out by the cache are immutable and stay valid for as
+ * long as the cache is alive. Safe to use from multiple threads.
+ */
+typedef struct _GpteStyleCache GpteStyleCache;
+
+GpteStyleCache* gpte_style_cache_new(void);
+GpteStyleCache* gpte_style_cache_ref(GpteStyleCache* self);
+void gpte_style_cache_unref(GpteStyleCache* self);
+
+// returns NULL (and counts a miss) if there is no entry yet
+const GpteStyle* gpte_style_cache_lookup(GpteStyleCache* self, const gchar* network, GpteProductCode product, const gchar* label, gboolean* found);
+// takes ownership of @style and returns the interned instance
+const GpteStyle* gpte_style_cache_insert(GpteStyleCache* self, const gchar* network, GpteProductCode product, const gchar* label, GpteStyle* style);
+void gpte_style_cache_get_stats(GpteStyleCache* self, guint* hits, guint* misses, guint* size);
+
+/*
+ * The cache of the provider an object was returned by is attached to it
+ * and passed on to the objects derived from it, so lines can resolve
+ * their style without calling into the JVM.
+ */
+GpteStyleCache* gpte_style_cache_get_for(gpointer object);
+void gpte_style_cache_attach(gpointer object, GpteStyleCache* cache);
+void gpte_style_cache_inherit(gpointer child, gpointer parent);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(GpteStyleCache, gpte_style_cache_unref)
+
 G_END_DECLS
 
 #endif // __GPTESTYLE_PRIV_H__
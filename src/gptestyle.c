@@ -45,28 +45,14 @@ void gpte_style_free(GpteStyle* self) {
 }
 
 static GpteStyleShape gpte_style_shape_from_java(GpteJvm* vm, jobject shape) {
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 7);
-	jclass type_class = (*env)->FindClass(env, "de/schildbach/pte/dto/Style$Shape");
-
-	if ((*env)->IsSameObject(env, shape, (*env)->GetStaticObjectField(
-		env, type_class,
-		(*env)->GetStaticFieldID(env, type_class , "RECT", "Lde/schildbach/pte/dto/Style$Shape;")
-	)))
-		return GPTE_STYLE_SHAPE_RECT;
-	else if ((*env)->IsSameObject(env, shape, (*env)->GetStaticObjectField(
-		env, type_class,
-		(*env)->GetStaticFieldID(env, type_class , "ROUNDED", "Lde/schildbach/pte/dto/Style$Shape;")
-	)))
-		return GPTE_STYLE_SHAPE_ROUNDED;
-	else if ((*env)->IsSameObject(env, shape, (*env)->GetStaticObjectField(
-		env, type_class,
-		(*env)->GetStaticFieldID(env, type_class , "CIRCLE", "Lde/schildbach/pte/dto/Style$Shape;")
-	)))
-		return GPTE_STYLE_SHAPE_CIRCLE;
-	else {
+	JNIEnv* env = gpte_jvm_get_env(vm);
+
+	gint type = gpte_jni_enum_decode(&vm->jni, env, &vm->jni.style_shape, shape);
+	if (type < 0) {
 		g_critical("Unknown shape type: %p", shape);
 		return 0;
 	}
+	return type;
 }
 
 typedef union {
@@ -86,20 +72,114 @@ static GpteColor gpte_style_color_from_jcolor(jint color) {
 }
 
 GpteStyle* gpte_style_from_java(GpteJvm* vm, jobject jstyle) {
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 11);
-
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Style");
-	jfieldID shape_id = (*env)->GetFieldID(env, class, "shape", "Lde/schildbach/pte/dto/Style$Shape;");
-	jfieldID bg_id = (*env)->GetFieldID(env, class, "backgroundColor", "I");
-	jfieldID bg2_id = (*env)->GetFieldID(env, class, "backgroundColor2", "I");
-	jfieldID fg_id = (*env)->GetFieldID(env, class, "foregroundColor", "I");
-	jfieldID border_id = (*env)->GetFieldID(env, class, "borderColor", "I");
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 
 	GpteStyle* self = g_new0(GpteStyle, 1);
-	self->shape = gpte_style_shape_from_java(vm, (*env)->GetObjectField(env, jstyle, shape_id));
-	self->background = gpte_style_color_from_jcolor((*env)->GetIntField(env, jstyle, bg_id));
-	self->background2 = gpte_style_color_from_jcolor((*env)->GetIntField(env, jstyle, bg2_id));
-	self->foreground = gpte_style_color_from_jcolor((*env)->GetIntField(env, jstyle, fg_id));
-	self->border = gpte_style_color_from_jcolor((*env)->GetIntField(env, jstyle, border_id));
+	self->shape = gpte_style_shape_from_java(vm, (*env)->GetObjectField(env, jstyle, vm->jni.style.shape));
+	self->background = gpte_style_color_from_jcolor((*env)->GetIntField(env, jstyle, vm->jni.style.background_color));
+	self->background2 = gpte_style_color_from_jcolor((*env)->GetIntField(env, jstyle, vm->jni.style.background_color2));
+	self->foreground = gpte_style_color_from_jcolor((*env)->GetIntField(env, jstyle, vm->jni.style.foreground_color));
+	self->border = gpte_style_color_from_jcolor((*env)->GetIntField(env, jstyle, vm->jni.style.border_color));
+	return self;
+}
+
+struct _GpteStyleCache {
+	gatomicrefcount rc;
+
+	GMutex lock;
+	// "network\x1fproduct\x1flabel" → GpteStyle* (NULL if the line has no style)
+	GHashTable* styles;
+	guint hits;
+	guint misses;
+};
+
+GpteStyleCache* gpte_style_cache_new(void) {
+	GpteStyleCache* self = g_new(GpteStyleCache, 1);
+	g_atomic_ref_count_init(&self->rc);
+	g_mutex_init(&self->lock);
+	self->styles = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	self->hits = 0;
+	self->misses = 0;
+	return self;
+}
+
+GpteStyleCache* gpte_style_cache_ref(GpteStyleCache* self) {
+	g_atomic_ref_count_inc(&self->rc);
 	return self;
 }
+
+void gpte_style_cache_unref(GpteStyleCache* self) {
+	if (g_atomic_ref_count_dec(&self->rc)) {
+		g_hash_table_destroy(self->styles);
+		g_mutex_clear(&self->lock);
+		g_free(self);
+	}
+}
+
+// \x1e marks a missing value, so NULL and "" don't collide
+static gchar* gpte_style_cache_key(const gchar* network, GpteProductCode product, const gchar* label) {
+	return g_strdup_printf("%s\x1f%d\x1f%s", network ? network : "\x1e", product, label ? label : "\x1e");
+}
+
+const GpteStyle* gpte_style_cache_lookup(GpteStyleCache* self, const gchar* network, GpteProductCode product, const gchar* label, gboolean* found) {
+	g_autofree gchar* key = gpte_style_cache_key(network, product, label);
+	gpointer style = NULL;
+
+	g_mutex_lock(&self->lock);
+	*found = g_hash_table_lookup_extended(self->styles, key, NULL, &style);
+	if (*found)
+		self->hits++;
+	else
+		self->misses++;
+	g_mutex_unlock(&self->lock);
+	return style;
+}
+
+const GpteStyle* gpte_style_cache_insert(GpteStyleCache* self, const gchar* network, GpteProductCode product, const gchar* label, GpteStyle* style) {
+	gchar* key = gpte_style_cache_key(network, product, label);
+	gpointer existing = NULL;
+
+	g_mutex_lock(&self->lock);
+	// another thread might have resolved the same line in the meantime
+	if (g_hash_table_lookup_extended(self->styles, key, NULL, &existing)) {
+		g_mutex_unlock(&self->lock);
+		g_free(key);
+		g_free(style);
+		return existing;
+	}
+	g_hash_table_insert(self->styles, key, style);
+	g_mutex_unlock(&self->lock);
+	return style;
+}
+
+void gpte_style_cache_get_stats(GpteStyleCache* self, guint* hits, guint* misses, guint* size) {
+	g_mutex_lock(&self->lock);
+	if (hits)
+		*hits = self->hits;
+	if (misses)
+		*misses = self->misses;
+	if (size)
+		*size = g_hash_table_size(self->styles);
+	g_mutex_unlock(&self->lock);
+}
+
+static GQuark gpte_style_cache_quark(void) {
+	static GQuark quark = 0;
+	if (G_UNLIKELY(!quark))
+		quark = g_quark_from_static_string("gpte-style-cache");
+	return quark;
+}
+
+GpteStyleCache* gpte_style_cache_get_for(gpointer object) {
+	return g_object_get_qdata(object, gpte_style_cache_quark());
+}
+
+void gpte_style_cache_attach(gpointer object, GpteStyleCache* cache) {
+	if (cache)
+		g_object_set_qdata_full(object, gpte_style_cache_quark(), gpte_style_cache_ref(cache), (GDestroyNotify)gpte_style_cache_unref);
+}
+
+void gpte_style_cache_inherit(gpointer child, gpointer parent) {
+	if (child && parent)
+		gpte_style_cache_attach(child, gpte_style_cache_get_for(parent));
+}
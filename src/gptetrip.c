@@ -17,11 +17,14 @@
  */
 
 #include "gptetrip.h"
+#include "gptetrip-priv.h"
 #include "gptejavaobject-priv.h"
 
 #include "gpteutils-priv.h"
 #include "gptelist-priv.h"
 #include "gpteproducts-priv.h"
+#include "gptestyle-priv.h"
+#include "gptetripleg-priv.h"
 
 typedef enum {
 	GPTE_TRIP_CACHED_FROM_LOC = 1 << 0,
@@ -88,35 +91,38 @@ static void gpte_trip_dispose(GObject* object) {
 	G_OBJECT_CLASS(gpte_trip_parent_class)->dispose(object);
 }
 
+static void gpte_trip_hydrate(GpteJavaObject* object);
+
 static void gpte_trip_class_init(GpteTripClass* class) {
 	GObjectClass* object_class = G_OBJECT_CLASS(class);
 	object_class->dispose = gpte_trip_dispose;
+	GPTE_JAVA_OBJECT_CLASS(class)->hydrate = gpte_trip_hydrate;
 }
 
 static void gpte_trip_init(GpteTrip*) {}
 
-static GpteLocation* gpte_trip_location_field(GpteTrip* self, const gchar* field, GpteLocation** location_cache, GpteTripCachedValues cache_value) {
-	g_return_val_if_fail(GPTE_IS_TRIP(self), NULL);
+static GpteLocation* gpte_trip_location_field(GpteTrip* self, GpteJvm* vm, jfieldID field, GpteLocation** location_cache, GpteTripCachedValues cache_value) {
 	if (self->cached & cache_value)
 		return *location_cache;
 
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip");
-	jfieldID id = (*env)->GetFieldID(env, class, field, "Lde/schildbach/pte/dto/Location;");
-	jobject location = (*env)->GetObjectField(env, this, id);
+	jobject location = (*env)->GetObjectField(env, this, field);
 
 	*location_cache = location ? g_object_new(GPTE_TYPE_LOCATION, "vm", vm, "object", location, NULL) : NULL;
 	self->cached |= cache_value;
 	return *location_cache;
 }
 GpteLocation* gpte_trip_from(GpteTrip* self) {
-	return gpte_trip_location_field(self, "from", &self->cached_from, GPTE_TRIP_CACHED_FROM_LOC);
+	g_return_val_if_fail(GPTE_IS_TRIP(self), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trip_location_field(self, vm, vm->jni.trip.from, &self->cached_from, GPTE_TRIP_CACHED_FROM_LOC);
 }
 GpteLocation* gpte_trip_to(GpteTrip* self) {
-	return gpte_trip_location_field(self, "to", &self->cached_to, GPTE_TRIP_CACHED_TO_LOC);
+	g_return_val_if_fail(GPTE_IS_TRIP(self), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trip_location_field(self, vm, vm->jni.trip.to, &self->cached_to, GPTE_TRIP_CACHED_TO_LOC);
 }
 
 GListModel* gpte_trip_get_legs(GpteTrip* self) {
@@ -125,14 +131,13 @@ GListModel* gpte_trip_get_legs(GpteTrip* self) {
 		return self->cached_legs;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip");
-	jfieldID legs_id = (*env)->GetFieldID(env, class, "legs", "Ljava/util/List;");
-	jobject jlegs = (*env)->GetObjectField(env, this, legs_id);
+	jobject jlegs = (*env)->GetObjectField(env, this, vm->jni.trip.legs);
 
 	self->cached_legs = jlegs ? gpte_list_new(vm, GPTE_TYPE_TRIP_LEG, jlegs) : NULL;
+	gpte_style_cache_inherit(self->cached_legs, self);
 	self->cached |= GPTE_TRIP_CACHED_LEGS;
 	return self->cached_legs;
 }
@@ -142,21 +147,18 @@ gint gpte_trip_get_num_changes(GpteTrip* self) {
 	if (self->cached & GPTE_TRIP_CACHED_CHANGES)
 		return self->cached_changes;
 
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self)), 5);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip");
-	jmethodID get_changes = (*env)->GetMethodID(env, class, "getNumChanges", "()Ljava/lang/Integer;");
-	jobject jchanges = (*env)->CallObjectMethod(env, this, get_changes);
+	jobject jchanges = (*env)->CallObjectMethod(env, this, vm->jni.trip.get_num_changes);
 	if (!jchanges) {
 		self->cached_changes = -1;
 		self->cached |= GPTE_TRIP_CACHED_CHANGES;
 		return -1;
 	}
 
-	jclass integer = (*env)->FindClass(env, "java/lang/Integer");
-	jmethodID to_int = (*env)->GetMethodID(env, integer, "intValue", "()I");
-	self->cached_changes = (*env)->CallIntMethod(env, jchanges, to_int);
+	self->cached_changes = (*env)->CallIntMethod(env, jchanges, vm->jni.integer.int_value);
 	self->cached |= GPTE_TRIP_CACHED_CHANGES;
 	return self->cached_changes;
 }
@@ -166,28 +168,23 @@ glong gpte_trip_get_duration(GpteTrip* self) {
 	if (self->cached & GPTE_TRIP_CACHED_DURATION)
 		return self->cached_duration;
 
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self)), 2);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	JNIEnv* env = gpte_jvm_get_env(vm);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip");
-	jmethodID duration_mid = (*env)->GetMethodID(env, class, "getDuration", "()J");
-	self->cached_duration = (*env)->CallLongMethod(env, this, duration_mid);
+	self->cached_duration = (*env)->CallLongMethod(env, this, vm->jni.trip.get_duration);
 	self->cached |= GPTE_TRIP_CACHED_DURATION;
 	return self->cached_duration;
 }
 
-static GpteTripPublic* gpte_trip_call_public_leg_meth(GpteTrip* self, const gchar* meth, GpteTripPublic** cached_leg, GpteTripCachedValues cache_value) {
-	g_return_val_if_fail(GPTE_IS_TRIP(self), NULL);
+static GpteTripPublic* gpte_trip_call_public_leg_meth(GpteTrip* self, GpteJvm* vm, jmethodID meth, GpteTripPublic** cached_leg, GpteTripCachedValues cache_value) {
 	if (self->cached & cache_value)
 		return *cached_leg;
 
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 2);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip");
-	jmethodID duration_mid = (*env)->GetMethodID(env, class, meth, "()Lde/schildbach/pte/dto/Trip$Public;");
-	jobject leg = (*env)->CallObjectMethod(env, this, duration_mid);
+	jobject leg = (*env)->CallObjectMethod(env, this, meth);
 
 	*cached_leg = leg ? g_object_new(GPTE_TYPE_TRIP_PUBLIC, "vm", vm, "object", leg, NULL) : NULL;
 	self->cached |= cache_value;
@@ -195,40 +192,48 @@ static GpteTripPublic* gpte_trip_call_public_leg_meth(GpteTrip* self, const gcha
 }
 
 GpteTripPublic* gpte_trip_get_first_public_leg(GpteTrip* self) {
-	return gpte_trip_call_public_leg_meth(self, "getFirstPublicLeg", &self->cached_first_public_leg, GPTE_TRIP_CACHED_FIRST_PUBLIC_LEG);
+	g_return_val_if_fail(GPTE_IS_TRIP(self), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trip_call_public_leg_meth(self, vm, vm->jni.trip.get_first_public_leg, &self->cached_first_public_leg, GPTE_TRIP_CACHED_FIRST_PUBLIC_LEG);
 }
 GpteTripPublic* gpte_trip_get_last_public_leg(GpteTrip* self) {
-	return gpte_trip_call_public_leg_meth(self, "getLastPublicLeg", &self->cached_last_public_leg, GPTE_TRIP_CACHED_LAST_PUBLIC_LEG);
+	g_return_val_if_fail(GPTE_IS_TRIP(self), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trip_call_public_leg_meth(self, vm, vm->jni.trip.get_last_public_leg, &self->cached_last_public_leg, GPTE_TRIP_CACHED_LAST_PUBLIC_LEG);
 }
 
-static GDateTime* gpte_trip_call_date_meth(GpteTrip* self, const gchar* meth, GDateTime** cached_date, GpteTripCachedValues cache_value) {
-	g_return_val_if_fail(GPTE_IS_TRIP(self), NULL);
+static GDateTime* gpte_trip_call_date_meth(GpteTrip* self, GpteJvm* vm, jmethodID meth, GDateTime** cached_date, GpteTripCachedValues cache_value) {
 	if (self->cached & cache_value)
 		return *cached_date;
 
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 2);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip");
-	jmethodID duration_mid = (*env)->GetMethodID(env, class, meth, "()Ljava/util/Date;");
-	jobject jdate = (*env)->CallObjectMethod(env, this, duration_mid);
+	jobject jdate = (*env)->CallObjectMethod(env, this, meth);
 
-	*cached_date = gpte_date_from_java(vm, jdate);
+	*cached_date = jdate ? gpte_date_from_java(vm, jdate) : NULL;
 	self->cached |= cache_value;
 	return *cached_date;
 }
 GDateTime* gpte_trip_get_first_departure_time(GpteTrip* self) {
-	return gpte_trip_call_date_meth(self, "getFirstDepartureTime", &self->cached_first_departure, GPTE_TRIP_CACHED_FIRST_DEPARTURE);
+	g_return_val_if_fail(GPTE_IS_TRIP(self), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trip_call_date_meth(self, vm, vm->jni.trip.get_first_departure_time, &self->cached_first_departure, GPTE_TRIP_CACHED_FIRST_DEPARTURE);
 }
 GDateTime* gpte_trip_get_last_arrival_time(GpteTrip* self) {
-	return gpte_trip_call_date_meth(self, "getLastArrivalTime", &self->cached_last_arrival, GPTE_TRIP_CACHED_LAST_ARRIVAL);
+	g_return_val_if_fail(GPTE_IS_TRIP(self), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trip_call_date_meth(self, vm, vm->jni.trip.get_last_arrival_time, &self->cached_last_arrival, GPTE_TRIP_CACHED_LAST_ARRIVAL);
 }
 GDateTime* gpte_trip_get_min_time(GpteTrip* self) {
-	return gpte_trip_call_date_meth(self, "getMinTime", &self->cached_min_time, GPTE_TRIP_CACHED_MIN_TIME);
+	g_return_val_if_fail(GPTE_IS_TRIP(self), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trip_call_date_meth(self, vm, vm->jni.trip.get_min_time, &self->cached_min_time, GPTE_TRIP_CACHED_MIN_TIME);
 }
 GDateTime* gpte_trip_get_max_time(GpteTrip* self) {
-	return gpte_trip_call_date_meth(self, "getMaxTime", &self->cached_max_time, GPTE_TRIP_CACHED_MAX_TIME);
+	g_return_val_if_fail(GPTE_IS_TRIP(self), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trip_call_date_meth(self, vm, vm->jni.trip.get_max_time, &self->cached_max_time, GPTE_TRIP_CACHED_MAX_TIME);
 }
 
 gboolean gpte_trip_is_travelable(GpteTrip* self) {
@@ -236,13 +241,11 @@ gboolean gpte_trip_is_travelable(GpteTrip* self) {
 	if (self->cached & GPTE_TRIP_CACHED_TRAVELABLE)
 		return self->cached_travelable;
 
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self)), 2);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	JNIEnv* env = gpte_jvm_get_env(vm);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip");
-	jmethodID trabelable_mid = (*env)->GetMethodID(env, class, "isTravelable", "()Z");
-
-	self->cached_travelable = (*env)->CallBooleanMethod(env, this, trabelable_mid);
+	self->cached_travelable = (*env)->CallBooleanMethod(env, this, vm->jni.trip.is_travelable);
 	self->cached |= GPTE_TRIP_CACHED_TRAVELABLE;
 	return self->cached_travelable;
 }
@@ -253,12 +256,10 @@ GpteProducts gpte_trip_get_products(GpteTrip* self) {
 		return self->cached_products;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip");
-	jmethodID products_mid = (*env)->GetMethodID(env, class, "products", "()Ljava/util/Set;");
-	jobject jproducts = (*env)->CallObjectMethod(env, this, products_mid);
+	jobject jproducts = (*env)->CallObjectMethod(env, this, vm->jni.trip.products);
 
 	self->cached_products = jproducts ? gpte_products_from_set(vm, jproducts) : 0;
 	self->cached |= GPTE_TRIP_CACHED_PRODUCTS;
@@ -271,14 +272,97 @@ GListModel* gpte_trip_get_fares(GpteTrip* self) {
 		return self->cached_fares;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip");
-	jfieldID fares_id = (*env)->GetFieldID(env, class, "fares", "Ljava/util/List;");
-	jobject jfares = (*env)->GetObjectField(env, this, fares_id);
+	jobject jfares = (*env)->GetObjectField(env, this, vm->jni.trip.fares);
 
 	self->cached_fares = jfares ? gpte_list_new(vm, GPTE_TYPE_FARE, jfares) : NULL;
 	self->cached |= GPTE_TRIP_CACHED_FARES;
 	return self->cached_fares;
 }
+
+static void gpte_trip_unpack_date(GpteTrip* self, jlong packed, GDateTime** cache, GpteTripCachedValues cache_value) {
+	if (self->cached & cache_value)
+		return;
+	*cache = gpte_date_from_packed(packed);
+	self->cached |= cache_value;
+}
+// fills the cached values of @self and its legs from the record
+// GpteBulk.packTrips() wrote at @packed
+static void gpte_trip_unpack(GpteTrip* self, GpteJvm* vm, const jlong* packed) {
+	if (!(self->cached & GPTE_TRIP_CACHED_CHANGES)) {
+		self->cached_changes = packed[1];
+		self->cached |= GPTE_TRIP_CACHED_CHANGES;
+	}
+	if (!(self->cached & GPTE_TRIP_CACHED_DURATION)) {
+		self->cached_duration = packed[2];
+		self->cached |= GPTE_TRIP_CACHED_DURATION;
+	}
+	gpte_trip_unpack_date(self, packed[3], &self->cached_first_departure, GPTE_TRIP_CACHED_FIRST_DEPARTURE);
+	gpte_trip_unpack_date(self, packed[4], &self->cached_last_arrival, GPTE_TRIP_CACHED_LAST_ARRIVAL);
+	gpte_trip_unpack_date(self, packed[5], &self->cached_min_time, GPTE_TRIP_CACHED_MIN_TIME);
+	gpte_trip_unpack_date(self, packed[6], &self->cached_max_time, GPTE_TRIP_CACHED_MAX_TIME);
+	if (!(self->cached & GPTE_TRIP_CACHED_TRAVELABLE)) {
+		self->cached_travelable = packed[7];
+		self->cached |= GPTE_TRIP_CACHED_TRAVELABLE;
+	}
+	if (!(self->cached & GPTE_TRIP_CACHED_PRODUCTS)) {
+		self->cached_products = gpte_products_from_ordinals(vm, packed[8]);
+		self->cached |= GPTE_TRIP_CACHED_PRODUCTS;
+	}
+
+	GListModel* legs = gpte_trip_get_legs(self);
+	if (!legs)
+		return;
+	const jlong* leg = packed + 10;
+	for (jlong i = 0; i < packed[9]; i++) {
+		g_autoptr(GpteTripLeg) item = g_list_model_get_item(legs, i);
+		leg = gpte_trip_leg_unpack(item, leg);
+	}
+}
+
+void gpte_trip_unpack_window(GpteJvm* vm, jobjectArray items, GObject** wrapped, guint n_items) {
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
+	jlongArray jpacked = (*env)->CallStaticObjectMethod(env, vm->jni.bulk.class, vm->jni.bulk.pack_trips, items);
+	g_autoptr(GError) err = NULL;
+	if (gpte_jvm_error(vm, &err)) {
+		// the getters still read the fields one by one
+		g_warning("Failed packing trips: %s", err->message);
+		return;
+	}
+
+	jlong* packed = (*env)->GetLongArrayElements(env, jpacked, NULL);
+	const jlong* record = packed;
+	for (guint i = 0; i < n_items; i++) {
+		if (wrapped[i])
+			gpte_trip_unpack(GPTE_TRIP(wrapped[i]), vm, record);
+		record += record[0];
+	}
+	(*env)->ReleaseLongArrayElements(env, jpacked, packed, JNI_ABORT);
+}
+
+static void gpte_trip_hydrate(GpteJavaObject* object) {
+	GpteTrip* self = GPTE_TRIP(object);
+	gpte_java_object_detach(gpte_trip_from(self));
+	gpte_java_object_detach(gpte_trip_to(self));
+	gpte_trip_get_legs(self);
+	gpte_java_object_detach_list(&self->cached_legs);
+	gpte_trip_get_num_changes(self);
+	gpte_trip_get_duration(self);
+	gpte_java_object_detach(gpte_trip_get_first_public_leg(self));
+	gpte_java_object_detach(gpte_trip_get_last_public_leg(self));
+	gpte_trip_get_first_departure_time(self);
+	gpte_trip_get_last_arrival_time(self);
+	gpte_trip_get_min_time(self);
+	gpte_trip_get_max_time(self);
+	gpte_trip_is_travelable(self);
+	gpte_trip_get_products(self);
+	gpte_trip_get_fares(self);
+	gpte_java_object_detach_list(&self->cached_fares);
+}
+
+GpteTrip* gpte_trip_snapshot(GpteTrip* self) {
+	g_return_val_if_fail(GPTE_IS_TRIP(self), NULL);
+	return GPTE_TRIP(gpte_java_object_snapshot(GPTE_JAVA_OBJECT(self)));
+}
@@ -181,6 +181,17 @@ GpteProducts gpte_trip_get_products(GpteTrip* self);
  */
 GListModel* gpte_trip_get_fares(GpteTrip* self);
 
+/**
+ * gpte_trip_snapshot:
+ * @self: the trip
+ *
+ * Copies @self into native memory, see
+ * [method@Gpte.JavaObject.snapshot].
+ *
+ * Returns: (transfer full): a detached copy of @self
+ */
+GpteTrip* gpte_trip_snapshot(GpteTrip* self);
+
 G_END_DECLS
 
 #endif // __GPTETRIP_H__
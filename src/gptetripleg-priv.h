@@ -0,0 +1,34 @@
+/*
+ * gpte - GObject bindings for public-transport-enabler
+ * Copyright (C) 2024  Florian "sp1rit" <sp1rit@disroot.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GPTETRIPLEG_PRIV_H__
+#define __GPTETRIPLEG_PRIV_H__
+
+#include <gptetripleg.h>
+#include <gptejvm-priv.h>
+
+G_BEGIN_DECLS
+
+// fills the cached values of @self, including the times of the departure
+// and arrival stop of public legs, from the record GpteBulk.packLeg()
+// wrote at @packed. Returns the start of the next record.
+const jlong* gpte_trip_leg_unpack(GpteTripLeg* self, const jlong* packed);
+
+G_END_DECLS
+
+#endif // __GPTETRIPLEG_PRIV_H__
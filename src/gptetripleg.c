@@ -17,11 +17,14 @@
  */
 
 #include "gptetripleg.h"
+#include "gptetripleg-priv.h"
 #include "gptejavaobject-priv.h"
 
 #include "gpteutils-priv.h"
 #include "gptelist-priv.h"
 #include "gptegeo-priv.h"
+#include "gptestyle-priv.h"
+#include "gptestop-priv.h"
 
 G_DEFINE_ENUM_TYPE(GpteTripIndividualType, gpte_trip_individual_type,
 	G_DEFINE_ENUM_VALUE(GPTE_TRIP_INDIVIDUAL_NULL, "null"),
@@ -62,19 +65,19 @@ G_DEFINE_TYPE_WITH_PRIVATE (GpteTripLeg, gpte_trip_leg, GPTE_TYPE_JAVA_OBJECT)
 
 static void gpte_trip_leg_dispose(GObject* object) {
 	GpteTripLegPrivate* priv = gpte_trip_leg_get_instance_private(GPTE_TRIP_LEG(object));
-	if (priv->cached & GPTE_TRIP_LEG_CACHED_DEPARTURE)
+	if ((priv->cached & GPTE_TRIP_LEG_CACHED_DEPARTURE) && priv->cached_departure)
 		g_object_unref(priv->cached_departure);
-	if (priv->cached & GPTE_TRIP_LEG_CACHED_ARRIVAL)
+	if ((priv->cached & GPTE_TRIP_LEG_CACHED_ARRIVAL) && priv->cached_arrival)
 		g_object_unref(priv->cached_arrival);
-	if (priv->cached & GPTE_TRIP_LEG_CACHED_PATH)
+	if ((priv->cached & GPTE_TRIP_LEG_CACHED_PATH) && priv->cached_path)
 		g_array_unref(priv->cached_path);
-	if (priv->cached & GPTE_TRIP_LEG_CACHED_DEPARTURE_TIME)
+	if ((priv->cached & GPTE_TRIP_LEG_CACHED_DEPARTURE_TIME) && priv->cached_depature_time)
 		g_date_time_unref(priv->cached_depature_time);
-	if (priv->cached & GPTE_TRIP_LEG_CACHED_ARRIVAL_TIME)
+	if ((priv->cached & GPTE_TRIP_LEG_CACHED_ARRIVAL_TIME) && priv->cached_arrival_time)
 		g_date_time_unref(priv->cached_arrival_time);
-	if (priv->cached & GPTE_TRIP_LEG_CACHED_MIN_TIME)
+	if ((priv->cached & GPTE_TRIP_LEG_CACHED_MIN_TIME) && priv->cached_min_time)
 		g_date_time_unref(priv->cached_min_time);
-	if (priv->cached & GPTE_TRIP_LEG_CACHED_MAX_TIME)
+	if ((priv->cached & GPTE_TRIP_LEG_CACHED_MAX_TIME) && priv->cached_max_time)
 		g_date_time_unref(priv->cached_max_time);
 	priv->cached = 0;
 	G_OBJECT_CLASS(gpte_trip_leg_parent_class)->dispose(object);
@@ -92,12 +95,10 @@ static GObject* gpte_trip_leg_constructor(GType type, guint n_construct_props, G
 		}
 
 		if (vm && this) {
-			g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 2);
-			jclass individual = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip$Individual");
-			jclass public = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip$Public");
-			if ((*env)->IsInstanceOf(env, this, individual))
+			JNIEnv* env = gpte_jvm_get_env(vm);
+			if ((*env)->IsInstanceOf(env, this, vm->jni.trip_individual.class))
 				type = GPTE_TYPE_TRIP_INDIVIDUAL;
-			else if ((*env)->IsInstanceOf(env, this, public))
+			else if ((*env)->IsInstanceOf(env, this, vm->jni.trip_public.class))
 				type = GPTE_TYPE_TRIP_PUBLIC;
 		}
 	}
@@ -105,30 +106,30 @@ static GObject* gpte_trip_leg_constructor(GType type, guint n_construct_props, G
 	return G_OBJECT_CLASS(gpte_trip_leg_parent_class)->constructor(type, n_construct_props, construct_props);
 }
 
+static void gpte_trip_leg_hydrate(GpteJavaObject* object);
+
 static void gpte_trip_leg_class_init(GpteTripLegClass* class) {
 	GObjectClass* object_class = G_OBJECT_CLASS(class);
 	object_class->dispose = gpte_trip_leg_dispose;
 	object_class->constructor = gpte_trip_leg_constructor;
+	GPTE_JAVA_OBJECT_CLASS(class)->hydrate = gpte_trip_leg_hydrate;
 }
 static void gpte_trip_leg_init(GpteTripLeg* self) {
 	GpteTripLegPrivate* priv = gpte_trip_leg_get_instance_private(self);
 	priv->cached = 0;
 }
 
-static GpteLocation* gpte_trip_leg_get_location_field(GpteTripLeg* self, const gchar* field, GpteLocation** cache, GpteTripLegCachedValues cache_field) {
+static GpteLocation* gpte_trip_leg_get_location_field(GpteTripLeg* self, GpteJvm* vm, jfieldID field, GpteLocation** cache, GpteTripLegCachedValues cache_field) {
 	GpteTripLegPrivate* priv = gpte_trip_leg_get_instance_private(self);
 	if (priv->cached & cache_field)
 		return *cache;
 
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip$Leg");
-	jfieldID id = (*env)->GetFieldID(env, class, field, "Lde/schildbach/pte/dto/Location;");
-	jobject location = (*env)->GetObjectField(env, this, id);
+	jobject location = (*env)->GetObjectField(env, this, field);
 
-	*cache = g_object_new(GPTE_TYPE_LOCATION, "vm", vm, "object", location, NULL);
+	*cache = location ? g_object_new(GPTE_TYPE_LOCATION, "vm", vm, "object", location, NULL) : NULL;
 	priv->cached |= cache_field;
 	return *cache;
 }
@@ -136,13 +137,15 @@ static GpteLocation* gpte_trip_leg_get_location_field(GpteTripLeg* self, const g
 GpteLocation* gpte_trip_leg_get_departure(GpteTripLeg* self) {
 	g_return_val_if_fail(GPTE_IS_TRIP_LEG(self), NULL);
 	GpteTripLegPrivate* priv = gpte_trip_leg_get_instance_private(self);
-	return gpte_trip_leg_get_location_field(self, "departure", &priv->cached_departure, GPTE_TRIP_LEG_CACHED_DEPARTURE);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trip_leg_get_location_field(self, vm, vm->jni.trip_leg.departure, &priv->cached_departure, GPTE_TRIP_LEG_CACHED_DEPARTURE);
 }
 
 GpteLocation* gpte_trip_leg_get_arrival(GpteTripLeg* self) {
 	g_return_val_if_fail(GPTE_IS_TRIP_LEG(self), NULL);
 	GpteTripLegPrivate* priv = gpte_trip_leg_get_instance_private(self);
-	return gpte_trip_leg_get_location_field(self, "arrival", &priv->cached_arrival, GPTE_TRIP_LEG_CACHED_ARRIVAL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trip_leg_get_location_field(self, vm, vm->jni.trip_leg.arrival, &priv->cached_arrival, GPTE_TRIP_LEG_CACHED_ARRIVAL);
 }
 
 GArray* gpte_trip_leg_get_path(GpteTripLeg* self) {
@@ -152,18 +155,17 @@ GArray* gpte_trip_leg_get_path(GpteTripLeg* self) {
 		return priv->cached_path;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 7);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip$Leg");
-	jfieldID id = (*env)->GetFieldID(env, class, "path", "Ljava/util/List;");
-	jobject path_list = (*env)->GetObjectField(env, this, id);
-	if (!path_list)
+	jobject path_list = (*env)->GetObjectField(env, this, vm->jni.trip_leg.path);
+	if (!path_list) {
+		priv->cached_path = NULL;
+		priv->cached |= GPTE_TRIP_LEG_CACHED_PATH;
 		return NULL;
+	}
 
-	jclass list = (*env)->FindClass(env, "java/util/List");
-	jmethodID to_array = (*env)->GetMethodID(env, list, "toArray", "()[Ljava/lang/Object;");
-	jobjectArray path_arr = (*env)->CallObjectMethod(env, path_list, to_array);
+	jobjectArray path_arr = (*env)->CallObjectMethod(env, path_list, vm->jni.list.to_array);
 	jsize len = (*env)->GetArrayLength(env, path_arr);
 
 	priv->cached_path = g_array_sized_new(FALSE, TRUE, sizeof(GpteGeoPoint), len);
@@ -178,20 +180,17 @@ GArray* gpte_trip_leg_get_path(GpteTripLeg* self) {
 	return priv->cached_path;
 }
 
-static GDateTime* gpte_trip_leg_call_date_getter(GpteTripLeg* self, const gchar* method, GDateTime** cache, GpteTripLegCachedValues cache_field) {
+static GDateTime* gpte_trip_leg_call_date_getter(GpteTripLeg* self, GpteJvm* vm, jmethodID method, GDateTime** cache, GpteTripLegCachedValues cache_field) {
 	GpteTripLegPrivate* priv = gpte_trip_leg_get_instance_private(self);
 	if (priv->cached & cache_field)
 		return *cache;
 
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip$Leg");
-	jmethodID mid = (*env)->GetMethodID(env, class, method, "()Ljava/util/Date;");
-	jobject jdate = (*env)->CallObjectMethod(env, this, mid);
+	jobject jdate = (*env)->CallObjectMethod(env, this, method);
 
-	*cache = gpte_date_from_java(vm, jdate);
+	*cache = jdate ? gpte_date_from_java(vm, jdate) : NULL;
 	priv->cached |= cache_field;
 	return *cache;
 }
@@ -199,25 +198,29 @@ static GDateTime* gpte_trip_leg_call_date_getter(GpteTripLeg* self, const gchar*
 GDateTime* gpte_trip_leg_get_departure_time(GpteTripLeg* self) {
 	g_return_val_if_fail(GPTE_IS_TRIP_LEG(self), NULL);
 	GpteTripLegPrivate* priv = gpte_trip_leg_get_instance_private(self);
-	return gpte_trip_leg_call_date_getter(self, "getDepartureTime", &priv->cached_depature_time, GPTE_TRIP_LEG_CACHED_DEPARTURE_TIME);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trip_leg_call_date_getter(self, vm, vm->jni.trip_leg.get_departure_time, &priv->cached_depature_time, GPTE_TRIP_LEG_CACHED_DEPARTURE_TIME);
 }
 
 GDateTime* gpte_trip_leg_get_arrival_time(GpteTripLeg* self) {
 	g_return_val_if_fail(GPTE_IS_TRIP_LEG(self), NULL);
 	GpteTripLegPrivate* priv = gpte_trip_leg_get_instance_private(self);
-	return gpte_trip_leg_call_date_getter(self, "getArrivalTime", &priv->cached_arrival_time, GPTE_TRIP_LEG_CACHED_ARRIVAL_TIME);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trip_leg_call_date_getter(self, vm, vm->jni.trip_leg.get_arrival_time, &priv->cached_arrival_time, GPTE_TRIP_LEG_CACHED_ARRIVAL_TIME);
 }
 
 GDateTime* gpte_trip_leg_get_min_time(GpteTripLeg* self) {
 	g_return_val_if_fail(GPTE_IS_TRIP_LEG(self), NULL);
 	GpteTripLegPrivate* priv = gpte_trip_leg_get_instance_private(self);
-	return gpte_trip_leg_call_date_getter(self, "getMinTime", &priv->cached_min_time, GPTE_TRIP_LEG_CACHED_MIN_TIME);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trip_leg_call_date_getter(self, vm, vm->jni.trip_leg.get_min_time, &priv->cached_min_time, GPTE_TRIP_LEG_CACHED_MIN_TIME);
 }
 
 GDateTime* gpte_trip_leg_get_max_time(GpteTripLeg* self) {
 	g_return_val_if_fail(GPTE_IS_TRIP_LEG(self), NULL);
 	GpteTripLegPrivate* priv = gpte_trip_leg_get_instance_private(self);
-	return gpte_trip_leg_call_date_getter(self, "getMaxTime", &priv->cached_max_time, GPTE_TRIP_LEG_CACHED_MAX_TIME);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trip_leg_call_date_getter(self, vm, vm->jni.trip_leg.get_max_time, &priv->cached_max_time, GPTE_TRIP_LEG_CACHED_MAX_TIME);
 }
 
 // BEGIN Trip.Individual
@@ -237,7 +240,11 @@ struct _GpteTripIndividual {
 };
 G_DEFINE_FINAL_TYPE (GpteTripIndividual, gpte_trip_individual, GPTE_TYPE_TRIP_LEG)
 
-static void gpte_trip_individual_class_init(GpteTripIndividualClass*) {}
+static void gpte_trip_individual_hydrate(GpteJavaObject* object);
+
+static void gpte_trip_individual_class_init(GpteTripIndividualClass* class) {
+	GPTE_JAVA_OBJECT_CLASS(class)->hydrate = gpte_trip_individual_hydrate;
+}
 static void gpte_trip_individual_init(GpteTripIndividual* self) {
 	self->cached = 0;
 }
@@ -248,48 +255,16 @@ GpteTripIndividualType gpte_trip_individual_type(GpteTripIndividual* self) {
 		return self->cached_type;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 16);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip$Individual");
-
-	jfieldID field_id = (*env)->GetFieldID(env, class, "type", "Lde/schildbach/pte/dto/Trip$Individual$Type;");
-	jobject jtype = (*env)->GetObjectField(env, this, field_id);
-	jclass type_class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip$Individual$Type");
-
-	if ((*env)->IsSameObject(env, jtype, (*env)->GetStaticObjectField(
-		env, type_class,
-		(*env)->GetStaticFieldID(env, type_class , "BIKE", "Lde/schildbach/pte/dto/Trip$Individual$Type;")
-	)))
-		self->cached_type = GPTE_TRIP_INDIVIDUAL_BIKE;
-	else if ((*env)->IsSameObject(env, jtype, (*env)->GetStaticObjectField(
-		env, type_class,
-		(*env)->GetStaticFieldID(env, type_class , "CAR", "Lde/schildbach/pte/dto/Trip$Individual$Type;")
-	)))
-		self->cached_type = GPTE_TRIP_INDIVIDUAL_CAR;
-	else if ((*env)->IsSameObject(env, jtype, (*env)->GetStaticObjectField(
-		env, type_class,
-		(*env)->GetStaticFieldID(env, type_class , "CHECK_IN", "Lde/schildbach/pte/dto/Trip$Individual$Type;")
-	)))
-		self->cached_type = GPTE_TRIP_INDIVIDUAL_CHECK_IN;
-	else if ((*env)->IsSameObject(env, jtype, (*env)->GetStaticObjectField(
-		env, type_class,
-		(*env)->GetStaticFieldID(env, type_class , "CHECK_OUT", "Lde/schildbach/pte/dto/Trip$Individual$Type;")
-	)))
-		self->cached_type = GPTE_TRIP_INDIVIDUAL_CHECK_OUT;
-	else if ((*env)->IsSameObject(env, jtype, (*env)->GetStaticObjectField(
-		env, type_class,
-		(*env)->GetStaticFieldID(env, type_class , "TRANSFER", "Lde/schildbach/pte/dto/Trip$Individual$Type;")
-	)))
-		self->cached_type = GPTE_TRIP_INDIVIDUAL_TRANSFER;
-	else if ((*env)->IsSameObject(env, jtype, (*env)->GetStaticObjectField(
-		env, type_class,
-		(*env)->GetStaticFieldID(env, type_class , "WALK", "Lde/schildbach/pte/dto/Trip$Individual$Type;")
-	)))
-		self->cached_type = GPTE_TRIP_INDIVIDUAL_WALK;
-	else {
+
+	jobject jtype = (*env)->GetObjectField(env, this, vm->jni.trip_individual.type);
+	gint type = gpte_jni_enum_decode(&vm->jni, env, &vm->jni.trip_individual_type, jtype);
+	if (type <= GPTE_TRIP_INDIVIDUAL_NULL) {
 		g_critical("Unknown ind. trip type: %p", jtype);
-		return GPTE_TRIP_INDIVIDUAL_NULL;
+		type = GPTE_TRIP_INDIVIDUAL_NULL;
 	}
+	self->cached_type = type;
 	self->cached |= GPTE_TRIP_INDIVIDUAL_CACHED_TYPE;
 	return self->cached_type;
 }
@@ -297,15 +272,13 @@ GpteTripIndividualType gpte_trip_individual_type(GpteTripIndividual* self) {
 gint gpte_trip_individual_get_distance(GpteTripIndividual* self) {
 	g_return_val_if_fail(GPTE_IS_TRIP_INDIVIDUAL(self), GPTE_TRIP_INDIVIDUAL_NULL);
 	if (self->cached & GPTE_TRIP_INDIVIDUAL_CACHED_DISTANCE)
-			return self->cached_type;
+		return self->cached_distance;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 2);
+	JNIEnv* env = gpte_jvm_get_env(vm);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip$Individual");
 
-	jfieldID field_id = (*env)->GetFieldID(env, class, "distance", "I");
-	self->cached_distance = (*env)->GetIntField(env, this, field_id);
+	self->cached_distance = (*env)->GetIntField(env, this, vm->jni.trip_individual.distance);
 
 	self->cached |= GPTE_TRIP_INDIVIDUAL_CACHED_DISTANCE;
 	return self->cached_distance;
@@ -341,48 +314,50 @@ static void gpte_trip_public_dispose(GObject* object) {
 		g_object_unref(self->cached_departure);
 	if (self->cached & GPTE_TRIP_PUBLIC_CACHED_ARRIVAL)
 		g_object_unref(self->cached_arrival);
-	if (self->cached & GPTE_TRIP_PUBLIC_CACHED_INTERMEDIATE)
+	if ((self->cached & GPTE_TRIP_PUBLIC_CACHED_INTERMEDIATE) && self->cached_intermediate)
 		g_object_unref(self->cached_intermediate);
-	if (self->cached & GPTE_TRIP_PUBLIC_CACHED_DESTINATION)
+	if ((self->cached & GPTE_TRIP_PUBLIC_CACHED_DESTINATION) && self->cached_destination)
 		g_object_unref(self->cached_destination);
 	if (self->cached & GPTE_TRIP_PUBLIC_CACHED_LINE)
 		g_object_unref(self->cached_line);
 	if (self->cached & GPTE_TRIP_PUBLIC_CACHED_MESSAGE)
 		g_free(self->cached_message);
 	self->cached = 0;
-	G_OBJECT_CLASS(gpte_trip_leg_parent_class)->dispose(object);
+	G_OBJECT_CLASS(gpte_trip_public_parent_class)->dispose(object);
 }
 
+static void gpte_trip_public_hydrate(GpteJavaObject* object);
+
 static void gpte_trip_public_class_init(GpteTripPublicClass* class) {
 	GObjectClass* object_class = G_OBJECT_CLASS(class);
 	object_class->dispose = gpte_trip_public_dispose;
+	GPTE_JAVA_OBJECT_CLASS(class)->hydrate = gpte_trip_public_hydrate;
 }
 
 static void gpte_trip_public_init(GpteTripPublic* self) {
 	self->cached = 0;
 }
 
-static GpteStop* gpte_trip_public_get_stop_field(GpteTripPublic* self, const gchar* field, GpteStop** cache, GpteTripPublicCachedValues cache_field) {
+static GpteStop* gpte_trip_public_get_stop_field(GpteTripPublic* self, GpteJvm* vm, jfieldID field, GpteStop** cache, GpteTripPublicCachedValues cache_field) {
 	if (self->cached & cache_field)
 		return *cache;
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip$Public");
-	jfieldID id = (*env)->GetFieldID(env, class, field, "Lde/schildbach/pte/dto/Stop;");
-	jobject stop = (*env)->GetObjectField(env, this, id);
+	jobject stop = (*env)->GetObjectField(env, this, field);
 	*cache = g_object_new(GPTE_TYPE_STOP, "vm", vm, "object", stop, NULL);
 	self->cached |= cache_field;
 	return *cache;
 }
 GpteStop* gpte_trip_public_get_departure(GpteTripPublic* self) {
 	g_return_val_if_fail(GPTE_IS_TRIP_PUBLIC(self), NULL);
-	return gpte_trip_public_get_stop_field(self, "departureStop", &self->cached_departure, GPTE_TRIP_PUBLIC_CACHED_DEPARTURE);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trip_public_get_stop_field(self, vm, vm->jni.trip_public.departure_stop, &self->cached_departure, GPTE_TRIP_PUBLIC_CACHED_DEPARTURE);
 }
 GpteStop* gpte_trip_public_get_arrival(GpteTripPublic* self) {
 	g_return_val_if_fail(GPTE_IS_TRIP_PUBLIC(self), NULL);
-	return gpte_trip_public_get_stop_field(self, "arrivalStop", &self->cached_arrival, GPTE_TRIP_PUBLIC_CACHED_ARRIVAL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trip_public_get_stop_field(self, vm, vm->jni.trip_public.arrival_stop, &self->cached_arrival, GPTE_TRIP_PUBLIC_CACHED_ARRIVAL);
 }
 GListModel* gpte_trip_public_get_intermediate(GpteTripPublic* self) {
 	g_return_val_if_fail(GPTE_IS_TRIP_PUBLIC(self), NULL);
@@ -390,12 +365,10 @@ GListModel* gpte_trip_public_get_intermediate(GpteTripPublic* self) {
 		return self->cached_intermediate;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip$Public");
-	jfieldID id = (*env)->GetFieldID(env, class, "intermediateStops", "Ljava/util/List;");
-	jobject list = (*env)->GetObjectField(env, this, id);
+	jobject list = (*env)->GetObjectField(env, this, vm->jni.trip_public.intermediate_stops);
 	self->cached_intermediate = list ? gpte_list_new(vm, GPTE_TYPE_STOP, list) : NULL;
 	self->cached |= GPTE_TRIP_PUBLIC_CACHED_INTERMEDIATE;
 	return self->cached_intermediate;
@@ -407,12 +380,10 @@ GpteLocation* gpte_trip_public_get_destination(GpteTripPublic* self) {
 		return self->cached_destination;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip$Public");
-	jfieldID id = (*env)->GetFieldID(env, class, "destination", "Lde/schildbach/pte/dto/Location;");
-	jobject location = (*env)->GetObjectField(env, this, id);
+	jobject location = (*env)->GetObjectField(env, this, vm->jni.trip_public.destination);
 	self->cached_destination = location ? g_object_new(GPTE_TYPE_LOCATION, "vm", vm, "object", location, NULL) : NULL;
 	self->cached |= GPTE_TRIP_PUBLIC_CACHED_DESTINATION;
 	return self->cached_destination;
@@ -424,13 +395,12 @@ GpteLine* gpte_trip_public_get_line(GpteTripPublic* self) {
 		return self->cached_line;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip$Public");
-	jfieldID id = (*env)->GetFieldID(env, class, "line", "Lde/schildbach/pte/dto/Line;");
-	jobject location = (*env)->GetObjectField(env, this, id);
+	jobject location = (*env)->GetObjectField(env, this, vm->jni.trip_public.line);
 	self->cached_line = g_object_new(GPTE_TYPE_LINE, "vm", vm, "object", location, NULL);
+	gpte_style_cache_inherit(self->cached_line, self);
 	self->cached |= GPTE_TRIP_PUBLIC_CACHED_LINE;
 	return self->cached_line;
 }
@@ -441,12 +411,10 @@ const gchar* gpte_trip_public_get_message(GpteTripPublic* self) {
 		return self->cached_message;
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/Trip$Public");
-	jfieldID id = (*env)->GetFieldID(env, class, "message", "Ljava/lang/String;");
-	jstring msg = (*env)->GetObjectField(env, this, id);
+	jstring msg = (*env)->GetObjectField(env, this, vm->jni.trip_public.message);
 	if (!msg) {
 		self->cached_message = NULL;
 		self->cached |= GPTE_TRIP_PUBLIC_CACHED_MESSAGE;
@@ -459,3 +427,88 @@ const gchar* gpte_trip_public_get_message(GpteTripPublic* self) {
 	(*env)->ReleaseStringUTFChars(env, msg, utf);
 	return self->cached_message;
 }
+
+static void gpte_trip_leg_hydrate(GpteJavaObject* object) {
+	GpteTripLeg* self = GPTE_TRIP_LEG(object);
+	gpte_java_object_detach(gpte_trip_leg_get_departure(self));
+	gpte_java_object_detach(gpte_trip_leg_get_arrival(self));
+	gpte_trip_leg_get_path(self);
+	gpte_trip_leg_get_departure_time(self);
+	gpte_trip_leg_get_arrival_time(self);
+	gpte_trip_leg_get_min_time(self);
+	gpte_trip_leg_get_max_time(self);
+}
+
+static void gpte_trip_individual_hydrate(GpteJavaObject* object) {
+	GpteTripIndividual* self = GPTE_TRIP_INDIVIDUAL(object);
+	gpte_trip_leg_hydrate(object);
+	gpte_trip_individual_type(self);
+	gpte_trip_individual_get_distance(self);
+}
+
+static void gpte_trip_public_hydrate(GpteJavaObject* object) {
+	GpteTripPublic* self = GPTE_TRIP_PUBLIC(object);
+	gpte_trip_leg_hydrate(object);
+	gpte_java_object_detach(gpte_trip_public_get_departure(self));
+	gpte_java_object_detach(gpte_trip_public_get_arrival(self));
+	gpte_trip_public_get_intermediate(self);
+	gpte_java_object_detach_list(&self->cached_intermediate);
+	gpte_java_object_detach(gpte_trip_public_get_destination(self));
+	gpte_java_object_detach(gpte_trip_public_get_line(self));
+	gpte_trip_public_get_message(self);
+}
+
+// kinds of legs in the records of GpteBulk.packLeg()
+#define GPTE_TRIP_LEG_PACKED_INDIVIDUAL 0
+#define GPTE_TRIP_LEG_PACKED_PUBLIC 1
+
+static void gpte_trip_leg_unpack_date(GpteTripLegPrivate* priv, jlong packed, GDateTime** cache, GpteTripLegCachedValues cache_field) {
+	if (priv->cached & cache_field)
+		return;
+	*cache = gpte_date_from_packed(packed);
+	priv->cached |= cache_field;
+}
+
+static void gpte_trip_individual_unpack(GpteTripIndividual* self, const jlong* packed) {
+	if (!(self->cached & GPTE_TRIP_INDIVIDUAL_CACHED_TYPE)) {
+		GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+		const GpteJniEnum* types = &vm->jni.trip_individual_type;
+		gint type = packed[0] >= 0 && (guint64)packed[0] < types->n_ordinals ? types->ordinals[packed[0]] : -1;
+		self->cached_type = MAX(type, GPTE_TRIP_INDIVIDUAL_NULL);
+		self->cached |= GPTE_TRIP_INDIVIDUAL_CACHED_TYPE;
+	}
+	if (!(self->cached & GPTE_TRIP_INDIVIDUAL_CACHED_DISTANCE)) {
+		self->cached_distance = packed[1];
+		self->cached |= GPTE_TRIP_INDIVIDUAL_CACHED_DISTANCE;
+	}
+}
+
+const jlong* gpte_trip_leg_unpack(GpteTripLeg* self, const jlong* packed) {
+	GpteTripLegPrivate* priv = gpte_trip_leg_get_instance_private(self);
+	jlong kind = packed[0];
+	gpte_trip_leg_unpack_date(priv, packed[1], &priv->cached_depature_time, GPTE_TRIP_LEG_CACHED_DEPARTURE_TIME);
+	gpte_trip_leg_unpack_date(priv, packed[2], &priv->cached_arrival_time, GPTE_TRIP_LEG_CACHED_ARRIVAL_TIME);
+	gpte_trip_leg_unpack_date(priv, packed[3], &priv->cached_min_time, GPTE_TRIP_LEG_CACHED_MIN_TIME);
+	gpte_trip_leg_unpack_date(priv, packed[4], &priv->cached_max_time, GPTE_TRIP_LEG_CACHED_MAX_TIME);
+	packed += 5;
+
+	switch (kind) {
+		case GPTE_TRIP_LEG_PACKED_INDIVIDUAL:
+			if (GPTE_IS_TRIP_INDIVIDUAL(self))
+				gpte_trip_individual_unpack(GPTE_TRIP_INDIVIDUAL(self), packed);
+			return packed + 2;
+		case GPTE_TRIP_LEG_PACKED_PUBLIC:
+			if (GPTE_IS_TRIP_PUBLIC(self)) {
+				gpte_stop_unpack(gpte_trip_public_get_departure(GPTE_TRIP_PUBLIC(self)), packed);
+				gpte_stop_unpack(gpte_trip_public_get_arrival(GPTE_TRIP_PUBLIC(self)), packed + GPTE_STOP_PACKED_SIZE);
+			}
+			return packed + 2 * GPTE_STOP_PACKED_SIZE;
+		default:
+			return packed;
+	}
+}
+
+GpteTripLeg* gpte_trip_leg_snapshot(GpteTripLeg* self) {
+	g_return_val_if_fail(GPTE_IS_TRIP_LEG(self), NULL);
+	return GPTE_TRIP_LEG(gpte_java_object_snapshot(GPTE_JAVA_OBJECT(self)));
+}
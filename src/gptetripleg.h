@@ -150,6 +150,18 @@ GDateTime* gpte_trip_leg_get_min_time(GpteTripLeg* self);
 
 GDateTime* gpte_trip_leg_get_max_time(GpteTripLeg* self);
 
+/**
+ * gpte_trip_leg_snapshot:
+ * @self: the trip leg
+ *
+ * Copies @self into native memory, see
+ * [method@Gpte.JavaObject.snapshot].
+ *
+ * Returns: (transfer full): a detached copy of @self, of the same
+ *   type as @self
+ */
+GpteTripLeg* gpte_trip_leg_snapshot(GpteTripLeg* self);
+
 
 /**
  * GpteTripIndividual:
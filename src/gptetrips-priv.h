@@ -26,7 +26,7 @@ G_BEGIN_DECLS
 
 jobject gpte_trip_options_to_java(GpteJvm* vm, const GpteTripOptions* options);
 
-GpteTripsResult* gpte_trips_result_new(GpteJvm* vm, jobject obj, GpteProvider* provider);
+GpteTripsResult* gpte_trips_result_new(GpteJvm* vm, jobject obj, GpteProvider* provider, GpteTripFlags flags);
 
 G_END_DECLS
 
@@ -22,8 +22,9 @@
 #include "gptejavaobject-priv.h"
 #include "gptelist-priv.h"
 #include "gpteproducts-priv.h"
+#include "gptetrip-priv.h"
 
-#include "gpteprovider.h"
+#include "gpteprovider-priv.h"
 #include "gpteerrors.h"
 
 G_DEFINE_ENUM_TYPE(GpteTripAccessibility, gpte_trip_accessibility,
@@ -33,7 +34,8 @@ G_DEFINE_ENUM_TYPE(GpteTripAccessibility, gpte_trip_accessibility,
 )
 
 G_DEFINE_FLAGS_TYPE(GpteTripFlags, gpte_trip_flags,
-	G_DEFINE_ENUM_VALUE(GPTE_TRIP_FLAG_BIKE, "bike")
+	G_DEFINE_ENUM_VALUE(GPTE_TRIP_FLAG_BIKE, "bike"),
+	G_DEFINE_ENUM_VALUE(GPTE_TRIP_FLAG_EAGER, "eager")
 )
 
 G_DEFINE_ENUM_TYPE(GpteTripOptimization, gpte_trip_optimization,
@@ -60,72 +62,23 @@ jobject gpte_trip_options_to_java(GpteJvm* vm, const GpteTripOptions* options) {
 	if (!options)
 		return NULL;
 
-	GpteScopeGuard env = gpte_jvm_enter_scope(vm, 18);
-
-	jclass accessibility_enum = (*env)->FindClass(env, "de/schildbach/pte/NetworkProvider$Accessibility");
-	jobject accessibility = NULL;
-	switch (options->accessibility) {
-		case GPTE_ACCESSIBILITY_NEUTRAL:
-			accessibility = (*env)->GetStaticObjectField(env, accessibility_enum, (*env)->GetStaticFieldID(env, accessibility_enum, "NEUTRAL", "Lde/schildbach/pte/NetworkProvider$Accessibility;"));
-			break;
-		case GPTE_ACCESSIBILITY_LIMITED:
-			accessibility = (*env)->GetStaticObjectField(env, accessibility_enum, (*env)->GetStaticFieldID(env, accessibility_enum, "LIMITED", "Lde/schildbach/pte/NetworkProvider$Accessibility;"));
-			break;
-		case GPTE_ACCESSIBILITY_BARRIER_FREE:
-			accessibility = (*env)->GetStaticObjectField(env, accessibility_enum, (*env)->GetStaticFieldID(env, accessibility_enum, "BARRIER_FREE", "Lde/schildbach/pte/NetworkProvider$Accessibility;"));
-			break;
-	}
-
-	jclass set_class = (*env)->FindClass(env, "java/util/HashSet");
-	jmethodID set_constructor = (*env)->GetMethodID(env, set_class, "<init>", "()V");
-	jmethodID add_to_set = (*env)->GetMethodID(env, set_class, "add", "(Ljava/lang/Object;)Z");
-
-	jobject flags = (*env)->NewObject(env, set_class, set_constructor);
-	jclass flags_enum = (*env)->FindClass(env, "de/schildbach/pte/NetworkProvider$TripFlag");
-	if (options->flags & GPTE_TRIP_FLAG_BIKE) {
-		jobject bike = (*env)->GetStaticObjectField(env, flags_enum, (*env)->GetStaticFieldID(env, flags_enum, "BIKE", "Lde/schildbach/pte/NetworkProvider$TripFlag;"));
-		(*env)->CallBooleanMethod(env, flags, add_to_set, bike);
-	}
+	GpteScopeGuard env = gpte_jvm_enter_scope(vm, 3);
 
-	jclass optimize_enum = (*env)->FindClass(env, "de/schildbach/pte/NetworkProvider$Optimize");
-	jobject optimize = NULL;
-	switch (options->optimize) {
-		case GPTE_OPTIMIZE_LEAST_DURATION:
-			optimize = (*env)->GetStaticObjectField(env, optimize_enum, (*env)->GetStaticFieldID(env, optimize_enum, "LEAST_DURATION", "Lde/schildbach/pte/NetworkProvider$Optimize;"));
-			break;
-		case GPTE_OPTIMIZE_LEAST_CHANGES:
-			optimize = (*env)->GetStaticObjectField(env, optimize_enum, (*env)->GetStaticFieldID(env, optimize_enum, "LEAST_CHANGES", "Lde/schildbach/pte/NetworkProvider$Optimize;"));
-			break;
-		case GPTE_OPTIMIZE_LEAST_WALKING:
-			optimize = (*env)->GetStaticObjectField(env, optimize_enum, (*env)->GetStaticFieldID(env, optimize_enum, "LEAST_WALKING", "Lde/schildbach/pte/NetworkProvider$Optimize;"));
-			break;
-	}
+	jobject flags = (*env)->NewObject(env, vm->jni.hash_set.class, vm->jni.hash_set.init);
+	// flags past the TripFlag constants (GPTE_TRIP_FLAG_EAGER) are gpte's own
+	for (gsize i = 0; i < vm->jni.trip_flag.n_constants; i++)
+		if (options->flags & (1 << i))
+			(*env)->CallBooleanMethod(env, flags, vm->jni.hash_set.add, vm->jni.trip_flag.constants[i]);
 
 	jobject products = gpte_products_to_java(vm, options->products);
 
-	jclass walk_speed_enum = (*env)->FindClass(env, "de/schildbach/pte/NetworkProvider$WalkSpeed");
-	jobject walk_speed = NULL;
-	switch (options->walk_speed) {
-		case GPTE_WALK_SLOW:
-			walk_speed = (*env)->GetStaticObjectField(env, walk_speed_enum, (*env)->GetStaticFieldID(env, walk_speed_enum, "SLOW", "Lde/schildbach/pte/NetworkProvider$WalkSpeed;"));
-			break;
-		case GPTE_WALK_NORMAL:
-			walk_speed = (*env)->GetStaticObjectField(env, walk_speed_enum, (*env)->GetStaticFieldID(env, walk_speed_enum, "NORMAL", "Lde/schildbach/pte/NetworkProvider$WalkSpeed;"));
-			break;
-		case GPTE_WALK_FAST:
-			walk_speed = (*env)->GetStaticObjectField(env, walk_speed_enum, (*env)->GetStaticFieldID(env, walk_speed_enum, "FAST", "Lde/schildbach/pte/NetworkProvider$WalkSpeed;"));
-			break;
-	}
-
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/TripOptions");
-	jmethodID constructor = (*env)->GetMethodID(env, class, "<init>", "("
-		"Ljava/util/Set;"
-		"Lde/schildbach/pte/NetworkProvider$Optimize;"
-		"Lde/schildbach/pte/NetworkProvider$WalkSpeed;"
-		"Lde/schildbach/pte/NetworkProvider$Accessibility;"
-		"Ljava/util/Set;"
-	")V");
-	return gpte_scope_guard_leave_with_ref(&env, (*env)->NewObject(env, class, constructor, products, optimize, walk_speed, accessibility, flags));
+	return gpte_scope_guard_leave_with_ref(&env, (*env)->NewObject(env, vm->jni.trip_options.class, vm->jni.trip_options.init,
+		products,
+		GPTE_JNI_ENUM_CONSTANT(vm->jni.optimize, options->optimize),
+		GPTE_JNI_ENUM_CONSTANT(vm->jni.walk_speed, options->walk_speed),
+		GPTE_JNI_ENUM_CONSTANT(vm->jni.accessibility, options->accessibility),
+		flags
+	));
 }
 
 
@@ -158,41 +111,42 @@ GpteTripsResultType gpte_trips_result_get(GpteTripsResult* self) {
 	g_return_val_if_fail(self && GPTE_IS_TRIPS(self->inner), GPTE_TRIPS_RESULT_ERR);
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self->inner));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 8);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self->inner));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/QueryTripsResult");
-	jfieldID status_id = (*env)->GetFieldID(env, class, "status", "Lde/schildbach/pte/dto/QueryTripsResult$Status;");
-	jobject status = (*env)->GetObjectField(env, this, status_id);
+	jobject status = (*env)->GetObjectField(env, this, vm->jni.query_trips_result.status);
 
-	jclass enum_class = (*env)->FindClass(env, "de/schildbach/pte/dto/QueryTripsResult$Status");
-	if ((*env)->IsSameObject(env, status, (*env)->GetStaticObjectField(env, enum_class, (*env)->GetStaticFieldID(env, enum_class, "OK", "Lde/schildbach/pte/dto/QueryTripsResult$Status;"))))
-		return GPTE_TRIPS_RESULT_OK;
-	if ((*env)->IsSameObject(env, status, (*env)->GetStaticObjectField(env, enum_class, (*env)->GetStaticFieldID(env, enum_class, "AMBIGUOUS", "Lde/schildbach/pte/dto/QueryTripsResult$Status;"))))
-		return GPTE_TRIPS_RESULT_AMBIGUOUS;
-	return GPTE_TRIPS_RESULT_ERR;
+	switch (gpte_jni_enum_decode(&vm->jni, env, &vm->jni.query_trips_status, status)) {
+		case GPTE_JNI_TRIPS_STATUS_OK:
+			return GPTE_TRIPS_RESULT_OK;
+		case GPTE_JNI_TRIPS_STATUS_AMBIGUOUS:
+			return GPTE_TRIPS_RESULT_AMBIGUOUS;
+		default:
+			return GPTE_TRIPS_RESULT_ERR;
+	}
 }
 
-static GListModel* gpte_trips_result_get_location_list_field(GpteTripsResult* self, const gchar* field) {
-	g_return_val_if_fail(self && GPTE_IS_TRIPS(self->inner), NULL);
-
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self->inner));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 3);
+static GListModel* gpte_trips_result_get_location_list_field(GpteTripsResult* self, GpteJvm* vm, jfieldID field) {
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self->inner));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/QueryTripsResult");
-	jfieldID field_id = (*env)->GetFieldID(env, class, field, "Ljava/util/List;");
-	jobject list = (*env)->GetObjectField(env, this, field_id);
+	jobject list = (*env)->GetObjectField(env, this, field);
 	return list ? gpte_list_new(vm, GPTE_TYPE_LOCATION, list) : NULL;
 }
 GListModel* gpte_trips_result_get_ambiguous_from(GpteTripsResult* self) {
-	return gpte_trips_result_get_location_list_field(self, "ambiguousFrom");
+	g_return_val_if_fail(self && GPTE_IS_TRIPS(self->inner), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self->inner));
+	return gpte_trips_result_get_location_list_field(self, vm, vm->jni.query_trips_result.ambiguous_from);
 }
 GListModel* gpte_trips_result_get_ambiguous_via(GpteTripsResult* self) {
-	return gpte_trips_result_get_location_list_field(self, "ambiguousVia");
+	g_return_val_if_fail(self && GPTE_IS_TRIPS(self->inner), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self->inner));
+	return gpte_trips_result_get_location_list_field(self, vm, vm->jni.query_trips_result.ambiguous_via);
 }
 GListModel* gpte_trips_result_get_ambiguous_to(GpteTripsResult* self) {
-	return gpte_trips_result_get_location_list_field(self, "ambiguousTo");
+	g_return_val_if_fail(self && GPTE_IS_TRIPS(self->inner), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self->inner));
+	return gpte_trips_result_get_location_list_field(self, vm, vm->jni.query_trips_result.ambiguous_to);
 }
 
 GpteTrips* gpte_trips_result_get_trips(GpteTripsResult* self) {
@@ -228,9 +182,9 @@ static GParamSpec* obj_properties[N_PROPERTIES] = { 0, };
 static void gpte_trips_finalize(GObject* object) {
 	GpteTrips* self = GPTE_TRIPS(object);
 
-	JNIEnv* env = gpte_java_object_env(GPTE_JAVA_OBJECT(self));
-	(*env)->DeleteGlobalRef(env, self->earlier_ctx);
-	(*env)->DeleteGlobalRef(env, self->later_ctx);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	gpte_jvm_release_global(vm, self->earlier_ctx);
+	gpte_jvm_release_global(vm, self->later_ctx);
 
 	g_object_unref(self->trips);
 
@@ -255,17 +209,16 @@ static void gpte_trips_constructed(GObject* object) {
 	GpteTrips* self = GPTE_TRIPS(object);
 
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 5);
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 2);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/QueryTripsResult");
 
-	jfieldID trips_id = (*env)->GetFieldID(env, class, "trips", "Ljava/util/List;");
-	jobject trips = (*env)->GetObjectField(env, this, trips_id);
+	jobject trips = (*env)->GetObjectField(env, this, vm->jni.query_trips_result.trips);
 	self->trips = gpte_list_new(vm, GPTE_TYPE_TRIP, trips);
+	if (self->provider)
+		gpte_style_cache_attach(self->trips, gpte_provider_get_style_cache(self->provider));
 	g_signal_connect(self->trips, "items-changed", G_CALLBACK(gpte_trips_list_changed), self);
 
-	jfieldID ctx_id = (*env)->GetFieldID(env, class, "context", "Lde/schildbach/pte/dto/QueryTripsContext;");
-	jobject ctx = (*env)->GetObjectField(env, this, ctx_id);
+	jobject ctx = (*env)->GetObjectField(env, this, vm->jni.query_trips_result.context);
 	self->earlier_ctx = (*env)->NewGlobalRef(env, ctx);
 	self->later_ctx = (*env)->NewGlobalRef(env, ctx);
 
@@ -333,26 +286,32 @@ static GpteTrips* gpte_trips_new(GpteJvm* vm, jobject this, GpteProvider* provid
 	return g_object_new(GPTE_TYPE_TRIPS, "vm", vm, "object", this, "provider", provider, NULL);
 }
 
-static GpteLocation* gpte_trips_get_location_field(GpteTrips* self, const gchar* field) {
-	g_return_val_if_fail(GPTE_IS_TRIPS(self), NULL);
-
-	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 7);
+static GpteLocation* gpte_trips_get_location_field(GpteTrips* self, GpteJvm* vm, jfieldID field) {
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 1);
 	jobject this = gpte_java_object_get(GPTE_JAVA_OBJECT(self));
 
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/QueryTripsResult");
-	jfieldID field_id = (*env)->GetFieldID(env, class, field, "Lde/schildbach/pte/dto/Location;");
-	jobject location = (*env)->GetObjectField(env, this, field_id);
+	jobject location = (*env)->GetObjectField(env, this, field);
 	return location ? g_object_new(GPTE_TYPE_LOCATION, "vm", vm, "object", location, NULL) : NULL;
 }
 GpteLocation* gpte_trips_get_from(GpteTrips* self) {
-	return gpte_trips_get_location_field(self, "from");
+	g_return_val_if_fail(GPTE_IS_TRIPS(self), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trips_get_location_field(self, vm, vm->jni.query_trips_result.from);
 }
 GpteLocation* gpte_trips_get_via(GpteTrips* self) {
-	return gpte_trips_get_location_field(self, "via");
+	g_return_val_if_fail(GPTE_IS_TRIPS(self), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trips_get_location_field(self, vm, vm->jni.query_trips_result.via);
 }
 GpteLocation* gpte_trips_get_to(GpteTrips* self) {
-	return gpte_trips_get_location_field(self, "to");
+	g_return_val_if_fail(GPTE_IS_TRIPS(self), NULL);
+	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
+	return gpte_trips_get_location_field(self, vm, vm->jni.query_trips_result.to);
+}
+
+void gpte_trips_set_max_cached(GpteTrips* self, guint max_trips) {
+	g_return_if_fail(GPTE_IS_TRIPS(self));
+	gpte_list_set_max_cached(GPTE_LIST(self->trips), max_trips);
 }
 
 static void gpte_trips_acp_refresh(GpteTrips* self) {
@@ -363,18 +322,20 @@ static void gpte_trips_acp_refresh(GpteTrips* self) {
 	g_mutex_unlock(&self->acp_lock);
 }
 
-static jobject gpte_trips_query_more_query_obj(GpteTrips* self, GpteTripsQueryTime time, GError** err) {
+static jobject gpte_trips_query_more_query_obj_upstream(GpteTrips* self, GpteTripsQueryTime time, gboolean* reached, GError** err) {
+	g_autoptr(GpteLimiterSlot) slot = gpte_provider_acquire_slot(self->provider, err);
+	if (!slot)
+		return NULL;
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
 	GpteScopeGuard env = gpte_jvm_enter_scope(vm, 3);
 
 	jobject jprovider = gpte_java_object_get(GPTE_JAVA_OBJECT(self->provider));
-	jclass provider_class = (*env)->FindClass(env, "de/schildbach/pte/NetworkProvider");
-	jmethodID query_more = (*env)->GetMethodID(env, provider_class, "queryMoreTrips", "(Lde/schildbach/pte/dto/QueryTripsContext;Z)Lde/schildbach/pte/dto/QueryTripsResult;");
 
-	jobject new = (*env)->CallObjectMethod(env, jprovider, query_more,
+	*reached = TRUE;
+	jobject new = gpte_jvm_call_provider(vm, jprovider, vm->jni.network_provider.query_more_trips, 2, (jobject[]){
 		time == GPTE_TRIPS_QUERY_EARLIER ? self->earlier_ctx : self->later_ctx,
-		(jboolean)(time == GPTE_TRIPS_QUERY_LATER)
-	);
+		gpte_jvm_box_boolean(vm, time == GPTE_TRIPS_QUERY_LATER)
+	});
 
 	// TODO: error checking
 	if (gpte_jvm_error(vm, err)) {
@@ -384,15 +345,23 @@ static jobject gpte_trips_query_more_query_obj(GpteTrips* self, GpteTripsQueryTi
 
 	return gpte_scope_guard_leave_with_ref(&env, new);
 }
+static jobject gpte_trips_query_more_query_obj(GpteTrips* self, GpteTripsQueryTime time, GError** err) {
+	if (!gpte_provider_breaker_admit(self->provider, err))
+		return NULL;
+	GError* error = NULL;
+	gboolean reached = FALSE;
+	jobject ret = gpte_trips_query_more_query_obj_upstream(self, time, &reached, &error);
+	gpte_provider_breaker_report(self->provider, reached, error);
+	if (error)
+		g_propagate_error(err, error);
+	return ret;
+}
 static void gpte_trips_push_more_result(GpteTrips* self, GpteTripsQueryTime time, jobject result) {
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 5);
-	jclass class = (*env)->FindClass(env, "de/schildbach/pte/dto/QueryTripsResult");
+	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 2);
 
-	jfieldID ctx_id = (*env)->GetFieldID(env, class, "context", "Lde/schildbach/pte/dto/QueryTripsContext;");
-	jobject ctx = (*env)->GetObjectField(env, result, ctx_id);
-	jfieldID trips_id = (*env)->GetFieldID(env, class, "trips", "Ljava/util/List;");
-	jobject trips = (*env)->GetObjectField(env, result, trips_id);
+	jobject ctx = (*env)->GetObjectField(env, result, vm->jni.query_trips_result.context);
+	jobject trips = (*env)->GetObjectField(env, result, vm->jni.query_trips_result.trips);
 	if (time == GPTE_TRIPS_QUERY_EARLIER) {
 		(*env)->DeleteGlobalRef(env, self->earlier_ctx);
 		self->earlier_ctx = (*env)->NewGlobalRef(env, ctx);
@@ -424,13 +393,8 @@ typedef struct {
 static void gpte_trips_query_more_data_free(GpteTripsQueryMoreData* self) {
 	g_free(self);
 }
-static void gpte_trips_query_nearby_thread(GTask* task, GpteTrips* self, GpteTripsQueryMoreData* data, GCancellable*) {
+static void gpte_trips_query_more_thread(GTask* task, GpteTrips* self, GpteTripsQueryMoreData* data, GCancellable*) {
 	GpteJvm* vm = gpte_java_object_get_vm(GPTE_JAVA_OBJECT(self));
-	g_autoptr(GpteThreadGuard) guard = gpte_jvm_attach_thread(vm, "gpte-query-more-async");
-	if (!guard) {
-		g_task_return_error(task, g_error_new(GPTE_JAVA_ERROR, GPTE_JAVA_ERROR_JVM_THREADING, "Unable to attach thread"));
-		return;
-	}
 	g_auto(GpteScopeGuard) scope_guard = gpte_jvm_enter_scope(vm, 1);
 
 	GError* err = NULL;
@@ -451,7 +415,7 @@ void gpte_trips_query_more_async(GpteTrips* self, GpteTripsQueryTime time, GAsyn
 	GpteTripsQueryMoreData* data = g_new(GpteTripsQueryMoreData, 1);
 	data->query_time = time;
 	g_task_set_task_data(task, data, (GDestroyNotify)gpte_trips_query_more_data_free);
-	g_task_run_in_thread(task, (GTaskThreadFunc)gpte_trips_query_nearby_thread);
+	gpte_provider_run_task(self->provider, task, (GTaskThreadFunc)gpte_trips_query_more_thread);
 }
 gboolean gpte_trips_query_more_finish(GpteTrips* self, GAsyncResult* result, GError** error) {
 	g_return_val_if_fail(g_task_is_valid(result, self), FALSE);
@@ -464,8 +428,10 @@ gboolean gpte_trips_query_more_finish(GpteTrips* self, GAsyncResult* result, GEr
 	return TRUE;
 }
 
-GpteTripsResult* gpte_trips_result_new(GpteJvm* vm, jobject obj, GpteProvider* provider) {
+GpteTripsResult* gpte_trips_result_new(GpteJvm* vm, jobject obj, GpteProvider* provider, GpteTripFlags flags) {
 	GpteTripsResult* new = g_new(GpteTripsResult, 1);
 	new->inner = gpte_trips_new(vm, obj, provider);
+	if (flags & GPTE_TRIP_FLAG_EAGER)
+		gpte_list_set_pack_func(GPTE_LIST(new->inner->trips), gpte_trip_unpack_window);
 	return new;
 }
@@ -51,6 +51,10 @@ typedef enum {
 /**
  * GpteTripFlags:
  * @GPTE_TRIP_FLAG_BIKE: Bicycle transport required
+ * @GPTE_TRIP_FLAG_EAGER: Read the times, changes and products of all
+ *   trips, their legs and stops with a single call when the trips are
+ *   first accessed, instead of one call per getter. Not passed to the
+ *   provider.
  *
  * Additional query parameters for a trip request.
  */
@@ -59,7 +63,8 @@ typedef enum {
 GType gpte_trip_flags_get_type(void);
 
 typedef enum {
-	GPTE_TRIP_FLAG_BIKE = 1 << 0
+	GPTE_TRIP_FLAG_BIKE = 1 << 0,
+	GPTE_TRIP_FLAG_EAGER = 1 << 1
 } GpteTripFlags;
 
 
@@ -306,6 +311,16 @@ GpteLocation* gpte_trips_get_via(GpteTrips* self);
  */
 GpteLocation* gpte_trips_get_to(GpteTrips* self);
 
+/**
+ * gpte_trips_set_max_cached:
+ * @self: the trips model
+ * @max_trips: maximum number of trip objects kept alive, or 0 for no limit
+ *
+ * Bounds the memory used by a model that keeps growing through
+ * [method@Gpte.Trips.query_more]. See [method@Gpte.List.set_max_cached].
+ */
+void gpte_trips_set_max_cached(GpteTrips* self, guint max_trips);
+
 /**
  * gpte_trips_query_more:
  * @self: the trips model
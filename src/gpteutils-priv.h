@@ -27,6 +27,10 @@ G_BEGIN_DECLS
 jobject gpte_date_to_java(GpteJvm* vm, GDateTime* date);
 GDateTime* gpte_date_from_java(GpteJvm* vm, jobject date);
 
+// marks a missing value in the arrays packed by src/GpteBulk.java
+#define GPTE_PACKED_NULL G_MININT64
+GDateTime* gpte_date_from_packed(jlong millis);
+
 G_END_DECLS
 
 #endif // __GPTEUTILS_PRIV_H__
@@ -19,20 +19,22 @@
 #include "gpteutils-priv.h"
 
 jobject gpte_date_to_java(GpteJvm* vm, GDateTime* date) {
-	GpteScopeGuard env = gpte_jvm_enter_scope(vm, 3);
+	GpteScopeGuard env = gpte_jvm_enter_scope(vm, 1);
 
-	jclass date_class = (*env)->FindClass(env, "java/util/Date");
-	jmethodID constructor = (*env)->GetMethodID(env, date_class, "<init>", "(J)V");
-	jobject jdate = (*env)->NewObject(env, date_class, constructor, (jlong)(g_date_time_to_unix_usec(date) / 1000));
+	jobject jdate = (*env)->NewObject(env, vm->jni.date.class, vm->jni.date.init, (jlong)(g_date_time_to_unix_usec(date) / 1000));
 
 	return gpte_scope_guard_leave_with_ref(&env, jdate);
 }
 
 GDateTime* gpte_date_from_java(GpteJvm* vm, jobject date) {
-	g_auto(GpteScopeGuard) env = gpte_jvm_enter_scope(vm, 2);
+	JNIEnv* env = gpte_jvm_get_env(vm);
 
-	jclass class = (*env)->FindClass(env, "java/util/Date");
-	jmethodID get_time = (*env)->GetMethodID(env, class, "getTime", "()J");
-	jlong millis = (*env)->CallLongMethod(env, date, get_time);
+	jlong millis = (*env)->CallLongMethod(env, date, vm->jni.date.get_time);
+	return g_date_time_new_from_unix_utc_usec(millis * 1000);
+}
+
+GDateTime* gpte_date_from_packed(jlong millis) {
+	if (millis == GPTE_PACKED_NULL)
+		return NULL;
 	return g_date_time_new_from_unix_utc_usec(millis * 1000);
 }
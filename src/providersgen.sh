@@ -31,10 +31,57 @@ typedef enum {
 	GPTE_NEGENTWEE_LANG_NL_NL
 } GpteNegentweeLanguage;
 
+/**
+ * GpteProviderConstructor:
+ * @GPTE_PROVIDER_CONSTRUCTOR_PLAIN: no credentials are needed
+ * @GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION: an api authorization is
+ *   passed in [field@Gpte.ProviderCredentials.authorization]
+ * @GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION_SALT: an api authorization and
+ *   a request salt in [field@Gpte.ProviderCredentials.data]
+ * @GPTE_PROVIDER_CONSTRUCTOR_CLIENT_CERTIFICATE: a client certificate in
+ *   [field@Gpte.ProviderCredentials.data]
+ * @GPTE_PROVIDER_CONSTRUCTOR_LANGUAGE: a language in
+ *   [field@Gpte.ProviderCredentials.language]
+ *
+ * Credentials a provider needs to be constructed.
+ */
+
+#define GPTE_TYPE_PROVIDER_CONSTRUCTOR (gpte_provider_constructor_get_type())
+GType gpte_provider_constructor_get_type(void);
+
+typedef enum {
+	GPTE_PROVIDER_CONSTRUCTOR_PLAIN,
+	GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION,
+	GPTE_PROVIDER_CONSTRUCTOR_AUTHORIZATION_SALT,
+	GPTE_PROVIDER_CONSTRUCTOR_CLIENT_CERTIFICATE,
+	GPTE_PROVIDER_CONSTRUCTOR_LANGUAGE
+} GpteProviderConstructor;
+
+/**
+ * GpteProviderCredentials:
+ * @authorization: (nullable): api authorization
+ * @data: (array length=data_len) (nullable): salt or client certificate
+ * @data_len: length of @data
+ * @language: language of the provider
+ *
+ * Credentials passed to [func@Gpte.provider_registry_create]. Which
+ * fields are used depends on the [enum@Gpte.ProviderConstructor] of
+ * the provider, the others are ignored.
+ */
+typedef struct {
+	const gchar* authorization;
+	const guchar* data;
+	gsize data_len;
+	GpteNegentweeLanguage language;
+} GpteProviderCredentials;
+
 EOF
 
-awk '/BEGIN GPTE PROVIDERS SECTION/,/END GPTE PROVIDERS SECTION/' gpteproviders.c | \
-	sed -E 's$GPTE_CREATE_NAVITIA_PROVIDER_FUN\(([a-z_]*), .*\)$\
+echo '// BEGIN GPTE PROVIDERS SECTION'
+echo
+# one X(kind, id, class, icon) line per provider
+sed -n -E 's/^[[:space:]]*X\(([A-Z_]*), ([a-z_]*), .*$/\1 \2/p' gpteproviders.c | \
+	sed -E 's$^NAVITIA ([a-z_]*)$\
 /**\
  * gpte_create_\1_provider:\
  * @vm: the Java VM to create this provider in\
@@ -44,7 +91,7 @@ awk '/BEGIN GPTE PROVIDERS SECTION/,/END GPTE PROVIDERS SECTION/' gpteproviders.
  * Returns: (transfer full): the \1 provider\
  */\
 GpteProvider* gpte_create_\1_provider(GpteJvm* vm, const gchar* authorization);$' | \
-	sed -E 's$GPTE_CREATE_HAFAS_PROVIDER_FUN\(([a-z_]*), .*\)$\
+	sed -E 's$^HAFAS ([a-z_]*)$\
 /**\
  * gpte_create_\1_provider:\
  * @vm: the Java VM to create this provider in\
@@ -54,7 +101,7 @@ GpteProvider* gpte_create_\1_provider(GpteJvm* vm, const gchar* authorization);$
  * Returns: (transfer full): the \1 provider\
  */\
 GpteProvider* gpte_create_\1_provider(GpteJvm* vm, const gchar* api_authorization);$' | \
-	sed -E 's$GPTE_CREATE_EFA_PROVIDER_FUN\(([a-z_]*), .*\)$\
+	sed -E 's$^EFA ([a-z_]*)$\
 /**\
  * gpte_create_\1_provider:\
  * @vm: the Java VM to create this provider in\
@@ -63,7 +110,7 @@ GpteProvider* gpte_create_\1_provider(GpteJvm* vm, const gchar* api_authorizatio
  * Returns: (transfer full): the \1 provider\
  */\
 GpteProvider* gpte_create_\1_provider(GpteJvm* vm);$' | \
-	sed -E 's$GPTE_CREATE_HAFAS_COMPLEX_PROVIDER_FUN\(([a-z_]*), .*\)$\
+	sed -E 's$^HAFAS_COMPLEX ([a-z_]*)$\
 /**\
  * gpte_create_\1_provider:\
  * @vm: the Java VM to create this provider in\
@@ -75,7 +122,7 @@ GpteProvider* gpte_create_\1_provider(GpteJvm* vm);$' | \
  * Returns: (transfer full): the \1 provider\
  */\
 GpteProvider* gpte_create_\1_provider(GpteJvm* vm, const gchar* api_authorization, const guchar* salt, gsize salt_len);$' | \
-	sed -E 's$GPTE_CREATE_HAFAS_LEGACY_PROVIDER_FUN\(([a-z_]*), .*\)$\
+	sed -E 's$^HAFAS_LEGACY ([a-z_]*)$\
 /**\
  * gpte_create_\1_provider:\
  * @vm: the Java VM to create this provider in\
@@ -84,29 +131,88 @@ GpteProvider* gpte_create_\1_provider(GpteJvm* vm, const gchar* api_authorizatio
  * Returns: (transfer full): the \1 provider\
  */\
 GpteProvider* gpte_create_\1_provider(GpteJvm* vm);$' | \
-	perl -0777 -pe 's!(GpteProvider\* gpte_create_([a-z_]*)_provider\(GpteJvm\* vm, GpteNegentweeLanguage language\)) ?\{$(\n|.)*?^\}!\
+	sed -E 's$^LANGUAGE ([a-z_]*)$\
 /**\
- * gpte_create_\2_provider:\
- * \@vm: the Java VM to create this provider in\
- * \@language: [enum\@Gpte.NegentweeLanguage] that this provider is supposed to use\
+ * gpte_create_\1_provider:\
+ * @vm: the Java VM to create this provider in\
+ * @language: [enum@Gpte.NegentweeLanguage] that this provider is supposed to use\
  *\
- * Creates the \2 provider.\
- * Returns: (transfer full): the \2 provider\
+ * Creates the \1 provider.\
+ * Returns: (transfer full): the \1 provider\
  */\
-\1;!m' | \
-	perl -0777 -pe 's!(GpteProvider\* gpte_create_([a-z_]*)_provider\(GpteJvm\* vm, const guchar\* client_cert, gsize client_cert_len\)) ?\{$(\n|.)*?^\}!\
+GpteProvider* gpte_create_\1_provider(GpteJvm* vm, GpteNegentweeLanguage language);$' | \
+	sed -E 's$^CLIENT_CERTIFICATE ([a-z_]*)$\
 /**\
- * gpte_create_\2_provider:\
- * \@vm: the Java VM to create this provider in\
- * \@client_cert: (array length=client_cert_len): client certificate blob\
- * \@client_cert_len: length of @client_cert in bytes\
+ * gpte_create_\1_provider:\
+ * @vm: the Java VM to create this provider in\
+ * @client_cert: (array length=client_cert_len): client certificate blob\
+ * @client_cert_len: length of @client_cert in bytes\
  *\
- * Creates the \2 provider.\
- * Returns: (transfer full): the \2 provider\
+ * Creates the \1 provider.\
+ * Returns: (transfer full): the \1 provider\
  */\
-\1;!m'
+GpteProvider* gpte_create_\1_provider(GpteJvm* vm, const guchar* client_cert, gsize client_cert_len);$'
+echo
+echo '// END GPTE PROVIDERS SECTION'
 
-cat << EOF
+cat << 'EOF'
+
+/**
+ * gpte_providers_for_point:
+ * @lat: latitude in degrees
+ * @lon: longitude in degrees
+ *
+ * Looks up the providers whose area covers the given coordinate. This
+ * uses an index generated at build time and doesn't need a
+ * [class@Gpte.Jvm]. Providers that don't declare an area (or fetch it
+ * from the network, like the Navitia based ones) are never returned.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): identifiers of the
+ *   matching providers, as used by the `gpte_create` family of functions
+ */
+gchar** gpte_providers_for_point(gdouble lat, gdouble lon);
+
+/**
+ * gpte_provider_registry_list:
+ *
+ * Lists the identifiers of all providers known to the registry.
+ *
+ * Returns: (transfer none) (array zero-terminated=1): the identifiers
+ */
+const gchar* const* gpte_provider_registry_list(void);
+
+/**
+ * gpte_provider_registry_lookup:
+ * @id: identifier of the provider
+ * @constructor: (out) (optional): credentials the provider needs
+ * @icon: (out) (optional) (transfer none) (nullable): resource path of
+ *   the icon of the provider, if there is one
+ *
+ * Looks up a provider in the registry without creating it.
+ *
+ * Returns: %TRUE if the provider is known
+ */
+gboolean gpte_provider_registry_lookup(const gchar* id, GpteProviderConstructor* constructor, const gchar** icon);
+
+/**
+ * gpte_provider_registry_create:
+ * @vm: the JVM instance
+ * @id: identifier of the provider
+ * @credentials: (nullable): credentials of the provider
+ * @err: return location for a #GError
+ *
+ * Creates the provider @id. The Java class and constructor are only
+ * looked up the first time a provider is created on @vm.
+ *
+ * Creating the same provider with the same credentials again returns
+ * the existing instance for as long as it is alive.
+ *
+ * Fails with %GPTE_JAVA_ERROR_UNKNOWN_PROVIDER if there is no provider
+ * @id.
+ *
+ * Returns: (transfer full): the provider or %NULL on error
+ */
+GpteProvider* gpte_provider_registry_create(GpteJvm* vm, const gchar* id, const GpteProviderCredentials* credentials, GError** err);
 
 G_END_DECLS
 